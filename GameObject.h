@@ -1,82 +1,157 @@
-#pragma once
-#include <d3d11.h>
-#include <directxmath.h>
-#include <memory>
-#include "skinned_mesh.h"
-
-class GameObject
-{
-public:
-	// Wϊf[^
-	DirectX::XMFLOAT3 position = { 0, 0, 0 };
-	DirectX::XMFLOAT3 rotation = { 0, 0, 0 }; // x:Pitch, y:Yaw, z:Roll
-	DirectX::XMFLOAT3 scale = { 1, 1, 1 };
-
-	// `f[^
-	std::shared_ptr<skinned_mesh> mesh;
-	DirectX::XMFLOAT4 color = { 1, 1, 1, 1 };
-
-	// Aj[Vp
-	float animation_tick = 0.0f;
-	float animation_speed = 1.0f;
-
-	// RXgN^
-	GameObject(std::shared_ptr<skinned_mesh> m) : mesh(m) {}
-	virtual ~GameObject() = default;
-
-	// XV
-	virtual void update(float elapsed_time)
-	{
-		// Aj[VԂi߂
-		animation_tick += elapsed_time * animation_speed;
-	}
-
-	// `揈
-	virtual void render(ID3D11DeviceContext* context)
-	{
-		if (!mesh) return;
-
-		// [hs̍쐬 (Scale -> Rotate -> Translate)
-		DirectX::XMMATRIX S = DirectX::XMMatrixScaling(scale.x, scale.y, scale.z);
-		DirectX::XMMATRIX R = DirectX::XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
-		DirectX::XMMATRIX T = DirectX::XMMatrixTranslation(position.x, position.y, position.z);
-
-		// Wn̕␳iR[hɂj
-		const DirectX::XMFLOAT4X4 coordinate_system_transforms
-		{
-			-1, 0, 0, 0,
-			 0, 1, 0, 0,
-			 0, 0, 1, 0,
-			 0, 0, 0, 1
-		};
-		const float scale_factor = 0.01f;
-		DirectX::XMMATRIX C = DirectX::XMLoadFloat4x4(&coordinate_system_transforms) * DirectX::XMMatrixScaling(scale_factor, scale_factor, scale_factor);
-
-		// ŏIIȃ[hs
-		DirectX::XMFLOAT4X4 world;
-		DirectX::XMStoreFloat4x4(&world, C * S * R * T);
-
-		// Aj[VĐ
-		if (!mesh->animation_clips.empty())
-		{
-			// Ƃ肠0Ԗڂ̃NbvĐ
-			const auto& animation = mesh->animation_clips.at(0);
-			int frame_index = static_cast<int>(animation_tick * animation.sampling_rate);
-
-			// [v
-			if (frame_index > animation.sequence.size() - 1)
-			{
-				frame_index = 0;
-				animation_tick = 0;
-			}
-
-			const auto& keyframe = animation.sequence.at(frame_index);
-			mesh->render(context, world, color, &keyframe);
-		}
-		else
-		{
-			// Aj[VȂ
-			mesh->render(context, world, color, nullptr);
-		}
-	}
-};
+#pragma once
+#include <d3d11.h>
+#include <directxmath.h>
+#include <memory>
+#include <algorithm>
+#include "skinned_mesh.h"
+#include "draw_list.h"
+
+class GameObject
+{
+public:
+	// 座標変換データ
+	DirectX::XMFLOAT3 position = { 0, 0, 0 };
+	DirectX::XMFLOAT3 rotation = { 0, 0, 0 }; // x:Pitch, y:Yaw, z:Roll
+	DirectX::XMFLOAT3 scale = { 1, 1, 1 };
+
+	// 描画データ
+	std::shared_ptr<skinned_mesh> mesh;
+	DirectX::XMFLOAT4 color = { 1, 1, 1, 1 };
+
+	// アニメーション制御用
+	float animation_tick = 0.0f;
+	float animation_speed = 1.0f;
+
+	// 一つ前の固定ステップ終了時の状態。publish で現在の状態との間を補間して描画する
+	DirectX::XMFLOAT3 previous_position = { 0, 0, 0 };
+	DirectX::XMFLOAT3 previous_rotation = { 0, 0, 0 };
+	DirectX::XMFLOAT3 previous_scale = { 1, 1, 1 };
+	float previous_animation_tick = 0.0f;
+
+	// コンストラクタ
+	GameObject(std::shared_ptr<skinned_mesh> m) : mesh(m) {}
+	virtual ~GameObject() = default;
+
+	// 固定ステップの開始。現在の状態を previous_* へ退避する（update の前に毎ステップ呼ぶ）
+	void begin_step()
+	{
+		previous_position = position;
+		previous_rotation = rotation;
+		previous_scale = scale;
+		previous_animation_tick = animation_tick;
+	}
+
+	// 更新処理（elapsed_time は固定ステップの長さ）
+	virtual void update(float elapsed_time)
+	{
+		// アニメーション時間を進める
+		animation_tick += elapsed_time * animation_speed;
+		wrap_animation();
+	}
+
+	// ワールド行列（座標系の補正込み）
+	DirectX::XMFLOAT4X4 world_transform() const
+	{
+		return world_transform(position, rotation, scale);
+	}
+
+	// 前のステップと現在の状態の間を補間したワールド行列（interpolation: 0 で前のステップ、1 で現在）
+	DirectX::XMFLOAT4X4 interpolated_world_transform(float interpolation) const
+	{
+		DirectX::XMFLOAT3 t, r, s;
+		DirectX::XMStoreFloat3(&t, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&previous_position), DirectX::XMLoadFloat3(&position), interpolation));
+		DirectX::XMStoreFloat3(&r, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&previous_rotation), DirectX::XMLoadFloat3(&rotation), interpolation));
+		DirectX::XMStoreFloat3(&s, DirectX::XMVectorLerp(DirectX::XMLoadFloat3(&previous_scale), DirectX::XMLoadFloat3(&scale), interpolation));
+		return world_transform(t, r, s);
+	}
+
+	static DirectX::XMFLOAT4X4 world_transform(const DirectX::XMFLOAT3& position, const DirectX::XMFLOAT3& rotation, const DirectX::XMFLOAT3& scale)
+	{
+		// ワールド行列の作成 (Scale -> Rotate -> Translate)
+		DirectX::XMMATRIX S = DirectX::XMMatrixScaling(scale.x, scale.y, scale.z);
+		DirectX::XMMATRIX R = DirectX::XMMatrixRotationRollPitchYaw(rotation.x, rotation.y, rotation.z);
+		DirectX::XMMATRIX T = DirectX::XMMatrixTranslation(position.x, position.y, position.z);
+
+		// 座標系の補正（元コードにあった処理）
+		const DirectX::XMFLOAT4X4 coordinate_system_transforms
+		{
+			-1, 0, 0, 0,
+			 0, 1, 0, 0,
+			 0, 0, 1, 0,
+			 0, 0, 0, 1
+		};
+		const float scale_factor = 0.01f;
+		DirectX::XMMATRIX C = DirectX::XMLoadFloat4x4(&coordinate_system_transforms) * DirectX::XMMatrixScaling(scale_factor, scale_factor, scale_factor);
+
+		// 最終的なワールド行列
+		DirectX::XMFLOAT4X4 world;
+		DirectX::XMStoreFloat4x4(&world, C * S * R * T);
+		return world;
+	}
+
+	// 現在のアニメーションのキーフレーム（アニメーションがなければ nullptr）
+	const animation::keyframe* current_keyframe() const
+	{
+		return keyframe_at(animation_tick);
+	}
+
+	// 前のステップと現在の間を補間した時刻のキーフレーム。ループで先頭に戻ったステップは補間しない
+	const animation::keyframe* interpolated_keyframe(float interpolation) const
+	{
+		if (animation_tick < previous_animation_tick) return current_keyframe();
+		return keyframe_at(previous_animation_tick + (animation_tick - previous_animation_tick) * interpolation);
+	}
+
+	const animation::keyframe* keyframe_at(float tick) const
+	{
+		if (!mesh || mesh->animation_clips.empty()) return nullptr;
+		return sample_keyframe(mesh->animation_clips.at(0), tick);
+	}
+
+	// アニメーションのループ処理（最後のフレームを過ぎたら先頭に戻す）
+	void wrap_animation()
+	{
+		if (!mesh || mesh->animation_clips.empty()) return;
+		const auto& animation = mesh->animation_clips.at(0);
+		const size_t frame_index = static_cast<size_t>(animation_tick * animation.sampling_rate);
+		if (frame_index + 1 > animation.sequence.size())
+		{
+			animation_tick = 0;
+		}
+	}
+
+	// 描画用のスナップショット（二重バッファ）。update の最後に publish で片方へ書き出し、描画側はもう片方だけを読む
+	// パイプライン実行時は次のフレームの update と前のフレームの描画が別スレッドで同時に走るため、
+	// 描画側は position や animation_tick などの更新中のデータに触れないこと
+	struct render_state
+	{
+		DirectX::XMFLOAT4X4 world{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		DirectX::XMFLOAT4 color{ 1, 1, 1, 1 };
+		const animation::keyframe* keyframe{ nullptr };
+		DirectX::XMFLOAT3 bounding_box[2]{}; // 現在のポーズを囲むワールド空間の境界ボックス
+	};
+	render_state render_states[2];
+
+	// 前のステップと現在の状態の間を interpolation で補間して render_states[buffer] へ書き出す
+	virtual void publish(size_t buffer, float interpolation)
+	{
+		render_state& state = render_states[buffer];
+		state.world = interpolated_world_transform(interpolation);
+		state.color = color;
+		state.keyframe = interpolated_keyframe(interpolation);
+		if (mesh)
+		{
+			mesh->compute_animated_bounding_box(state.keyframe, state.world, state.bounding_box);
+		}
+	}
+
+	// 描画キューへの登録。render_states[buffer] の描画を draw_list に積み、まとめてソートしてから描く
+	// ワーカースレッドから呼ばれることがあるので、何も変更しないこと
+	virtual void enqueue(draw_list::recorder& recorder, size_t buffer) const
+	{
+		if (!mesh) return;
+
+		const render_state& state = render_states[buffer];
+		recorder.add(*mesh, state.world, state.color, state.keyframe);
+	}
+};
\ No newline at end of file
@@ -1,190 +1,465 @@
-#include "GameScene.h"
-#include "framework.h"
-#include "shader.h"
-#include "texture.h"
-#include "misc.h"
-
-#ifdef USE_IMGUI
-#include "imgui/imgui.h"
-#include "imgui/imgui_internal.h"
-#include "imgui/imgui_impl_dx11.h"
-#include "imgui/imgui_impl_win32.h"
-#endif
-
-using namespace DirectX;
-
-void GameScene::initialize(framework* fw)
-{
-	HRESULT hr{ S_OK };
-	ID3D11Device* device = fw->device.Get();
-
-	D3D11_BUFFER_DESC buffer_desc{};
-	buffer_desc.ByteWidth = sizeof(scene_constants);
-	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	buffer_desc.CPUAccessFlags = 0;
-	buffer_desc.MiscFlags = 0;
-	buffer_desc.StructureByteStride = 0;
-	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffers[0].GetAddressOf());
-	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
-
-	buffer_desc.ByteWidth = sizeof(parametric_constants);
-	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	buffer_desc.CPUAccessFlags = 0;
-	buffer_desc.MiscFlags = 0;
-	buffer_desc.StructureByteStride = 0;
-	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffers[1].GetAddressOf());
-	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
-
-	// \[X̓ǂݍ
-	sprite_batches[0] = std::make_unique<sprite_batch>(device, L".\\resources\\screenshot.jpg", 1);
-
-	//  \[X}l[W[găf[h
-	// ɂAʂ̃LfgĂĂA1ōς݂܂I
-	auto mesh = fw->resource_manager->load_skinned_mesh(".\\resources\\anis.fbx");
-	player = std::make_unique<GameObject>(mesh);
-
-	framebuffers[0] = std::make_unique<framebuffer>(device, 1280, 720);
-	framebuffers[1] = std::make_unique<framebuffer>(device, 1280 / 2, 720 / 2);
-	bit_block_transfer = std::make_unique<fullscreen_quad>(device);
-
-	create_ps_from_cso(device, "luminance_extraction_ps.cso", pixel_shaders[0].GetAddressOf());
-	create_ps_from_cso(device, "blur_ps.cso", pixel_shaders[1].GetAddressOf());
-}
-
-void GameScene::update(framework* fw, float elapsed_time)
-{
-	if (player)
-	{
-		player->update(elapsed_time);
-	}
-
-#ifdef USE_IMGUI
-	ImGui::Begin("ImGUI");
-
-	ImGui::SliderFloat("camera_position.x", &camera_position.x, -100.0f, +100.0f);
-	ImGui::SliderFloat("camera_position.y", &camera_position.y, -100.0f, +100.0f);
-	ImGui::SliderFloat("camera_position.z", &camera_position.z, -100.0f, -1.0f);
-
-	ImGui::SliderFloat("light_direction.x", &light_direction.x, -1.0f, +1.0f);
-	ImGui::SliderFloat("light_direction.y", &light_direction.y, -1.0f, +1.0f);
-	ImGui::SliderFloat("light_direction.z", &light_direction.z, -1.0f, +1.0f);
-
-	if (player)
-	{
-		ImGui::Text("Player Transform");
-		ImGui::SliderFloat("Translation X", &player->position.x, -10.0f, +10.0f);
-		ImGui::SliderFloat("Translation Y", &player->position.y, -10.0f, +10.0f);
-		ImGui::SliderFloat("Translation Z", &player->position.z, -10.0f, +10.0f);
-
-		ImGui::SliderFloat("Rotation X", &player->rotation.x, -10.0f, +10.0f);
-		ImGui::SliderFloat("Rotation Y", &player->rotation.y, -10.0f, +10.0f);
-		ImGui::SliderFloat("Rotation Z", &player->rotation.z, -10.0f, +10.0f);
-
-		ImGui::SliderFloat("Scale X", &player->scale.x, 0.1f, 5.0f);
-		ImGui::SliderFloat("Scale Y", &player->scale.y, 0.1f, 5.0f);
-		ImGui::SliderFloat("Scale Z", &player->scale.z, 0.1f, 5.0f);
-
-		ImGui::ColorEdit4("Material Color", reinterpret_cast<float*>(&player->color));
-	}
-
-	ImGui::Separator();
-	ImGui::SliderFloat("factors[0]", &factors[0], -1.5f, +1.5f);
-	ImGui::SliderFloat("factors[1]", &factors[1], +0.0f, +500.0f);
-	ImGui::SliderFloat("factors[2]", &factors[2], +0.0f, +1.0f);
-
-	ImGui::SliderFloat("extraction_threshold", &parametric_constants.extraction_threshold, +0.0f, +5.0f);
-	ImGui::SliderFloat("gaussian_sigma", &parametric_constants.gaussian_sigma, +0.0f, +10.0f);
-	ImGui::SliderFloat("bloom_intensity", &parametric_constants.bloom_intensity, +0.0f, +10.0f);
-	ImGui::SliderFloat("exposure", &parametric_constants.exposure, +0.0f, +10.0f);
-
-	ImGui::End();
-#endif
-}
-
-void GameScene::render(framework* fw, float elapsed_time)
-{
-	ID3D11DeviceContext* context = fw->immediate_context.Get();
-
-	ID3D11RenderTargetView* null_render_target_views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT]{};
-	context->OMSetRenderTargets(_countof(null_render_target_views), null_render_target_views, 0);
-	ID3D11ShaderResourceView* null_shader_resource_views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT]{};
-	context->VSSetShaderResources(0, _countof(null_shader_resource_views), null_shader_resource_views);
-	context->PSSetShaderResources(0, _countof(null_shader_resource_views), null_shader_resource_views);
-
-	FLOAT color[]{ 0.2f, 0.2f, 0.2f, 1.0f };
-	context->ClearRenderTargetView(fw->render_target_view.Get(), color);
-	context->OMSetRenderTargets(1, fw->render_target_view.GetAddressOf(), fw->depth_stencil_view.Get());
-
-	context->PSSetSamplers(0, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::POINT)].GetAddressOf());
-	context->PSSetSamplers(1, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::LINEAR)].GetAddressOf());
-	context->PSSetSamplers(2, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::ANISOTROPIC)].GetAddressOf());
-	context->PSSetSamplers(3, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::LINEAR_BORDER_BLACK)].GetAddressOf());
-	context->PSSetSamplers(4, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::LINEAR_BORDER_WHITE)].GetAddressOf());
-
-	context->OMSetBlendState(fw->blend_states[static_cast<size_t>(framework::BLEND_STATE::ALPHA)].Get(), nullptr, 0xFFFFFFFF);
-	context->OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_ON_ZW_ON)].Get(), 0);
-	context->RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::SOLID)].Get());
-
-	D3D11_VIEWPORT viewport;
-	UINT num_viewports{ 1 };
-	context->RSGetViewports(&num_viewports, &viewport);
-
-	float aspect_ratio{ viewport.Width / viewport.Height };
-	DirectX::XMMATRIX P{ DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(30), aspect_ratio, 0.1f, 100.0f) };
-
-	DirectX::XMVECTOR eye{ DirectX::XMLoadFloat4(&camera_position) };
-	DirectX::XMVECTOR focus{ DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f) };
-	DirectX::XMVECTOR up{ DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) };
-	DirectX::XMMATRIX V{ DirectX::XMMatrixLookAtLH(eye, focus, up) };
-
-	scene_constants data{};
-	DirectX::XMStoreFloat4x4(&data.view_projection, V * P);
-	data.light_direction = light_direction;
-	data.camera_position = camera_position;
-	context->UpdateSubresource(constant_buffers[0].Get(), 0, 0, &data, 0, 0);
-	context->VSSetConstantBuffers(1, 1, constant_buffers[0].GetAddressOf());
-	context->PSSetConstantBuffers(1, 1, constant_buffers[0].GetAddressOf());
-
-	context->UpdateSubresource(constant_buffers[1].Get(), 0, 0, &parametric_constants, 0, 0);
-	context->PSSetConstantBuffers(2, 1, constant_buffers[1].GetAddressOf());
-
-	// Framebuffer pass
-	framebuffers[0]->clear(context);
-	framebuffers[0]->activate(context);
-
-	context->OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_OFF_ZW_OFF)].Get(), 0);
-	context->RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::CULL_NONE)].Get());
-	sprite_batches[0]->begin(context);
-	sprite_batches[0]->render(context, 0, 0, 1280, 720);
-	sprite_batches[0]->end(context);
-
-	context->OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_ON_ZW_ON)].Get(), 0);
-	context->RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::SOLID)].Get());
-
-	// GameObject̕`
-	if (player)
-	{
-		player->render(context);
-	}
-
-	framebuffers[0]->deactivate(context);
-
-	// Post-processing
-	framebuffers[1]->clear(context);
-	framebuffers[1]->activate(context);
-	context->OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_OFF_ZW_OFF)].Get(), 0);
-	context->RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::CULL_NONE)].Get());
-	bit_block_transfer->blit(context, framebuffers[0]->shader_resource_views[0].GetAddressOf(), 0, 1, pixel_shaders[0].Get());
-	framebuffers[1]->deactivate(context);
-
-	context->OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_OFF_ZW_OFF)].Get(), 0);
-	context->RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::CULL_NONE)].Get());
-	ID3D11ShaderResourceView* shader_resource_views[2]{ framebuffers[0]->shader_resource_views[0].Get(), framebuffers[1]->shader_resource_views[0].Get() };
-	bit_block_transfer->blit(context, shader_resource_views, 0, 2, pixel_shaders[1].Get());
-}
-
-void GameScene::finalize(framework* fw)
-{
+#include "GameScene.h"
+#include "framework.h"
+#include "shader.h"
+#include "texture.h"
+#include "misc.h"
+#include "texture_residency.h"
+#include "frustum_culler.h"
+#include "profiler.h"
+#include "memory_tracker.h"
+
+#include <algorithm>
+
+#ifdef USE_IMGUI
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+#include "imgui/imgui_impl_dx11.h"
+#include "imgui/imgui_impl_win32.h"
+#endif
+
+using namespace DirectX;
+
+void GameScene::initialize(framework* fw)
+{
+	// Objects and buffers of the scene; the assets it loads tag their own memory.
+	memory_scope scene_memory(MEMORY_TAG::SCENE);
+
+	HRESULT hr{ S_OK };
+	ID3D11Device* device = fw->device.Get();
+
+	D3D11_BUFFER_DESC buffer_desc{};
+	buffer_desc.ByteWidth = sizeof(scene_constants);
+	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	buffer_desc.CPUAccessFlags = 0;
+	buffer_desc.MiscFlags = 0;
+	buffer_desc.StructureByteStride = 0;
+	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffers[0].GetAddressOf());
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+
+	buffer_desc.ByteWidth = sizeof(parametric_constants);
+	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	buffer_desc.CPUAccessFlags = 0;
+	buffer_desc.MiscFlags = 0;
+	buffer_desc.StructureByteStride = 0;
+	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffers[1].GetAddressOf());
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+
+	device_context = std::make_unique<d3d11_render_context>(fw->immediate_context.Get());
+	filtered_context = std::make_unique<state_filtering_context>(*device_context);
+	object_draws = std::make_unique<draw_list>(device);
+
+	// リソースの読み込み
+	sprite_batches[0] = std::make_unique<sprite_batch>(device, L".\\resources\\screenshot.jpg", 1);
+
+	// ★ リソースマネージャーを使ってモデルをロード
+	// これにより、もし別のキャラが同じモデルを使っていても、メモリは1つ分で済みます！
+	auto mesh = fw->resource_manager->load_skinned_mesh(".\\resources\\anis.fbx");
+	player = std::make_unique<GameObject>(mesh);
+	add_to_grid(player.get());
+
+	framebuffers[0] = std::make_unique<framebuffer>(device, 1280, 720);
+	framebuffers[1] = std::make_unique<framebuffer>(device, 1280 / 2, 720 / 2);
+	bit_block_transfer = std::make_unique<fullscreen_quad>(device);
+
+	create_ps_from_cso(device, "luminance_extraction_ps.cso", pixel_shaders[0].GetAddressOf());
+	create_ps_from_cso(device, "blur_ps.cso", pixel_shaders[1].GetAddressOf());
+}
+
+void GameScene::update(framework* fw, float elapsed_time)
+{
+	PROFILE_SCOPE("animation");
+	for (GameObject* object : grid_objects)
+	{
+		if (object)
+		{
+			object->begin_step();
+		}
+	}
+
+	if (player)
+	{
+		player->update(elapsed_time);
+	}
+}
+
+void GameScene::publish(framework* fw, float interpolation)
+{
+	PROFILE_SCOPE("publish");
+	// Objects moved and animated; publish them into the snapshot render is not reading and refresh their boxes there.
+	const size_t snapshot{ 1 - render_snapshot };
+	for (size_t id = 0; id < grid_objects.size(); ++id)
+	{
+		if (grid_objects.at(id))
+		{
+			grid_objects.at(id)->publish(snapshot, interpolation);
+			object_grids[snapshot].move(id, grid_objects.at(id)->render_states[snapshot].bounding_box);
+		}
+	}
+}
+
+void GameScene::swap_snapshots()
+{
+	render_snapshot = 1 - render_snapshot;
+}
+
+void GameScene::update_gui(framework* fw)
+{
+#ifdef USE_IMGUI
+	ImGui::Begin("ImGUI");
+
+	ImGui::SliderFloat("camera_position.x", &camera_position.x, -100.0f, +100.0f);
+	ImGui::SliderFloat("camera_position.y", &camera_position.y, -100.0f, +100.0f);
+	ImGui::SliderFloat("camera_position.z", &camera_position.z, -100.0f, -1.0f);
+
+	ImGui::SliderFloat("light_direction.x", &light_direction.x, -1.0f, +1.0f);
+	ImGui::SliderFloat("light_direction.y", &light_direction.y, -1.0f, +1.0f);
+	ImGui::SliderFloat("light_direction.z", &light_direction.z, -1.0f, +1.0f);
+
+	if (player)
+	{
+		ImGui::Text("Player Transform");
+		ImGui::SliderFloat("Translation X", &player->position.x, -10.0f, +10.0f);
+		ImGui::SliderFloat("Translation Y", &player->position.y, -10.0f, +10.0f);
+		ImGui::SliderFloat("Translation Z", &player->position.z, -10.0f, +10.0f);
+
+		ImGui::SliderFloat("Rotation X", &player->rotation.x, -10.0f, +10.0f);
+		ImGui::SliderFloat("Rotation Y", &player->rotation.y, -10.0f, +10.0f);
+		ImGui::SliderFloat("Rotation Z", &player->rotation.z, -10.0f, +10.0f);
+
+		ImGui::SliderFloat("Scale X", &player->scale.x, 0.1f, 5.0f);
+		ImGui::SliderFloat("Scale Y", &player->scale.y, 0.1f, 5.0f);
+		ImGui::SliderFloat("Scale Z", &player->scale.z, 0.1f, 5.0f);
+
+		ImGui::ColorEdit4("Material Color", reinterpret_cast<float*>(&player->color));
+	}
+
+	ImGui::Separator();
+	ImGui::Text("Visible objects: %zu / %zu", culling_statistics.visible, culling_statistics.tested);
+	ImGui::Text("Occluded objects: %zu", culling_statistics.occluded);
+	ImGui::Checkbox("State filtering", &state_filtering);
+	if (state_filtering)
+	{
+		ImGui::Text("State calls: %zu issued / %zu filtered", filtered_context->statistics.issued, filtered_context->statistics.filtered);
+	}
+	ImGui::Checkbox("Instancing", &object_draws->instancing);
+	ImGui::Checkbox("Parallel recording", &object_draws->parallel_recording);
+	ImGui::Checkbox("Deferred contexts", &deferred_submission);
+	ImGui::Checkbox("Pipelined frames", &fw->pipelined_frames);
+	ImGui::Text("Tick rate:");
+	const std::pair<const char*, float> tick_rates[]{ { "30 Hz", 30.0f }, { "60 Hz", 60.0f }, { "120 Hz", 120.0f } };
+	for (const auto& [label, tick_rate] : tick_rates)
+	{
+		ImGui::SameLine();
+		if (ImGui::RadioButton(label, fw->tick_rate == tick_rate))
+		{
+			fw->tick_rate = tick_rate;
+		}
+	}
+	int max_catch_up_steps{ static_cast<int>(fw->max_catch_up_steps) };
+	if (ImGui::SliderInt("Max catch-up steps", &max_catch_up_steps, 1, 10))
+	{
+		fw->max_catch_up_steps = static_cast<uint32_t>(max_catch_up_steps);
+	}
+	ImGui::Text("Frame: %.2f steps, update %.2f ms, render %.2f ms, wait %.2f ms, latency %.2f ms", fw->timings.steps, fw->timings.update, fw->timings.render, fw->timings.wait, fw->timings.latency);
+
+	if (ImGui::CollapsingHeader("Profiler"))
+	{
+		profiler& profiler{ default_profiler() };
+		bool profiling{ profiler.enabled };
+		if (ImGui::Checkbox("Record scopes", &profiling))
+		{
+			profiler.enabled = profiling;
+		}
+		ImGui::SameLine();
+		if (ImGui::Button("Save Chrome trace"))
+		{
+			profiler.write_chrome_trace("profile_trace.json");
+		}
+		std::vector<profiler::scope_statistics> statistics;
+		profiler.statistics(statistics);
+		ImGui::Text("Last %zu frames, %zu scopes dropped (ms per run)", profiler.frame_count(), profiler.dropped_events());
+		ImGui::Columns(6, "profiler_scopes");
+		for (const char* heading : { "scope", "runs", "min", "avg", "p95", "p99" })
+		{
+			ImGui::Text("%s", heading);
+			ImGui::NextColumn();
+		}
+		for (const profiler::scope_statistics& scope : statistics)
+		{
+			ImGui::Text("%s", scope.name.c_str()); ImGui::NextColumn();
+			ImGui::Text("%zu", scope.count); ImGui::NextColumn();
+			ImGui::Text("%.3f", scope.minimum); ImGui::NextColumn();
+			ImGui::Text("%.3f", scope.average); ImGui::NextColumn();
+			ImGui::Text("%.3f", scope.p95); ImGui::NextColumn();
+			ImGui::Text("%.3f", scope.p99); ImGui::NextColumn();
+		}
+		ImGui::Columns(1);
+	}
+
+	if (ImGui::CollapsingHeader("Memory"))
+	{
+		const memory_tracker& tracker{ default_memory_tracker() };
+		constexpr float mb{ 1.0f / (1024 * 1024) };
+		ImGui::Text("Tracked: %.2f MB, peak %.2f MB", tracker.current_total() * mb, tracker.peak_total() * mb);
+		for (uint32_t tag = 0; tag < static_cast<uint32_t>(MEMORY_TAG::COUNT); ++tag)
+		{
+			const MEMORY_TAG memory_tag{ static_cast<MEMORY_TAG>(tag) };
+			ImGui::Text("  %-15s %9.2f MB, peak %9.2f MB", memory_tag_name(memory_tag), tracker.current(memory_tag) * mb, tracker.peak(memory_tag) * mb);
+		}
+
+		ImGui::Separator();
+		std::vector<std::pair<std::string, memory_breakdown>> assets;
+		fw->resource_manager->memory_report(assets);
+		for (const auto& [filename, usage] : assets)
+		{
+			ImGui::Text("%s: %.2f MB (mesh %.2f, animation %.2f, scene %.2f, gpu buffers %.2f)", filename.c_str(), usage.total() * mb, usage[MEMORY_TAG::MESH_DATA] * mb,
+				usage[MEMORY_TAG::ANIMATION] * mb, usage[MEMORY_TAG::SCENE] * mb, usage[MEMORY_TAG::GPU_BUFFERS] * mb);
+		}
+		std::vector<std::pair<std::wstring, size_t>> textures;
+		texture_cache_usage(textures);
+		size_t texture_bytes{ 0 };
+		for (const auto& [filename, bytes] : textures)
+		{
+			texture_bytes += bytes;
+		}
+		ImGui::Text("Texture cache: %zu textures, %.2f MB", textures.size(), texture_bytes * mb);
+		if (fw->streamer)
+		{
+			ImGui::Text("Streamed textures: %.2f MB resident of %.2f MB budget", fw->streamer->residency().resident_bytes() * mb, fw->streamer->residency().budget() * mb);
+		}
+
+		// Retained and peak bytes of each load; the difference is what it needed only while it ran.
+		ImGui::Separator();
+		for (const memory_tracker::load_record& record : tracker.load_records())
+		{
+			ImGui::Text("%*s%s: %.2f MB kept, %.2f MB peak%s%s", static_cast<int>(record.depth * 2), "", record.name.c_str(), record.retained * mb, record.peak * mb,
+				record.detail.empty() ? "" : ", ", record.detail.c_str());
+		}
+	}
+	ImGui::Text("Draws: %zu (%zu instances), binds: %zu shader / %zu material / %zu mesh", object_draws->statistics.draws, object_draws->statistics.instances,
+		object_draws->statistics.shader_changes, object_draws->statistics.material_changes, object_draws->statistics.mesh_changes);
+
+	ImGui::Separator();
+	ImGui::SliderFloat("factors[0]", &factors[0], -1.5f, +1.5f);
+	ImGui::SliderFloat("factors[1]", &factors[1], +0.0f, +500.0f);
+	ImGui::SliderFloat("factors[2]", &factors[2], +0.0f, +1.0f);
+
+	ImGui::SliderFloat("extraction_threshold", &parametric_constants.extraction_threshold, +0.0f, +5.0f);
+	ImGui::SliderFloat("gaussian_sigma", &parametric_constants.gaussian_sigma, +0.0f, +10.0f);
+	ImGui::SliderFloat("bloom_intensity", &parametric_constants.bloom_intensity, +0.0f, +10.0f);
+	ImGui::SliderFloat("exposure", &parametric_constants.exposure, +0.0f, +10.0f);
+
+	ImGui::End();
+#endif
+}
+
+void GameScene::render(framework* fw, float elapsed_time)
+{
+	ID3D11DeviceContext* context = fw->immediate_context.Get();
+
+	ID3D11RenderTargetView* null_render_target_views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT]{};
+	context->OMSetRenderTargets(_countof(null_render_target_views), null_render_target_views, 0);
+	ID3D11ShaderResourceView* null_shader_resource_views[D3D11_COMMONSHADER_INPUT_RESOURCE_SLOT_COUNT]{};
+	context->VSSetShaderResources(0, _countof(null_shader_resource_views), null_shader_resource_views);
+	context->PSSetShaderResources(0, _countof(null_shader_resource_views), null_shader_resource_views);
+	filtered_context->reset_statistics();
+	if (state_filtering)
+	{
+		filtered_context->invalidate_bindings();
+	}
+	else
+	{
+		// The filter sees none of the calls while it is off, so it starts over when turned back on.
+		filtered_context->invalidate();
+	}
+	render_context& state_context{ state_filtering ? static_cast<render_context&>(*filtered_context) : *device_context };
+	object_draws->state_filtering = state_filtering;
+
+	FLOAT color[]{ 0.2f, 0.2f, 0.2f, 1.0f };
+	context->ClearRenderTargetView(fw->render_target_view.Get(), color);
+	context->OMSetRenderTargets(1, fw->render_target_view.GetAddressOf(), fw->depth_stencil_view.Get());
+
+	state_context.PSSetSamplers(0, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::POINT)].GetAddressOf());
+	state_context.PSSetSamplers(1, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::LINEAR)].GetAddressOf());
+	state_context.PSSetSamplers(2, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::ANISOTROPIC)].GetAddressOf());
+	state_context.PSSetSamplers(3, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::LINEAR_BORDER_BLACK)].GetAddressOf());
+	state_context.PSSetSamplers(4, 1, fw->sampler_states[static_cast<size_t>(framework::SAMPLER_STATE::LINEAR_BORDER_WHITE)].GetAddressOf());
+
+	state_context.OMSetBlendState(fw->blend_states[static_cast<size_t>(framework::BLEND_STATE::ALPHA)].Get(), nullptr, 0xFFFFFFFF);
+	state_context.OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_ON_ZW_ON)].Get(), 0);
+	state_context.RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::SOLID)].Get());
+
+	D3D11_VIEWPORT viewport;
+	UINT num_viewports{ 1 };
+	context->RSGetViewports(&num_viewports, &viewport);
+
+	float aspect_ratio{ viewport.Width / viewport.Height };
+	DirectX::XMMATRIX P{ DirectX::XMMatrixPerspectiveFovLH(DirectX::XMConvertToRadians(30), aspect_ratio, 0.1f, 100.0f) };
+
+	DirectX::XMVECTOR eye{ DirectX::XMLoadFloat4(&camera_position) };
+	DirectX::XMVECTOR focus{ DirectX::XMVectorSet(0.0f, 0.0f, 0.0f, 1.0f) };
+	DirectX::XMVECTOR up{ DirectX::XMVectorSet(0.0f, 1.0f, 0.0f, 0.0f) };
+	DirectX::XMMATRIX V{ DirectX::XMMatrixLookAtLH(eye, focus, up) };
+
+	scene_constants data{};
+	DirectX::XMStoreFloat4x4(&data.view_projection, V * P);
+	data.light_direction = light_direction;
+	data.camera_position = camera_position;
+	context->UpdateSubresource(constant_buffers[0].Get(), 0, 0, &data, 0, 0);
+	state_context.VSSetConstantBuffers(1, 1, constant_buffers[0].GetAddressOf());
+	state_context.PSSetConstantBuffers(1, 1, constant_buffers[0].GetAddressOf());
+
+	context->UpdateSubresource(constant_buffers[1].Get(), 0, 0, &parametric_constants, 0, 0);
+	state_context.PSSetConstantBuffers(2, 1, constant_buffers[1].GetAddressOf());
+
+	// Frustum culling through the grid: whole cells outside the view are skipped, then the boxes of the objects in the
+	// remaining cells are tested four at a time by the frustum_culler inside the query. Objects that pass are then tested
+	// against the depth of the registered occluders.
+	{
+		PROFILE_SCOPE("culling");
+		const spatial_grid& object_grid{ object_grids[render_snapshot] };
+		object_grid.query_frustum(data.view_projection, visible_objects);
+		culling_statistics.tested = object_grid.object_count();
+		culling_statistics.occluded = 0;
+		if (!occluders.empty())
+		{
+			PROFILE_SCOPE("occlusion");
+			occlusion.begin(data.view_projection);
+			for (const occluder& occluder : occluders)
+			{
+				const static_mesh& mesh{ *occluder.mesh };
+				occlusion.add_occluder(&mesh.vertices.data()->position, sizeof(static_mesh::vertex), mesh.vertices.size(), mesh.indices.data(), mesh.indices.size(), occluder.world);
+			}
+			occlusion.rasterize();
+
+			const size_t frustum_visible{ visible_objects.size() };
+			visible_objects.erase(std::remove_if(visible_objects.begin(), visible_objects.end(), [&](size_t id)
+			{
+				return !occlusion.is_visible(grid_objects.at(id)->render_states[render_snapshot].bounding_box);
+			}), visible_objects.end());
+			culling_statistics.occluded = frustum_visible - visible_objects.size();
+		}
+		culling_statistics.visible = visible_objects.size();
+	}
+
+	// Mip streaming: request the texture detail each visible object needs at its current size on screen.
+	// Objects sharing a mesh share its textures, and the largest of their requests wins.
+	if (fw->streamer)
+	{
+		DirectX::XMFLOAT4X4 projection;
+		DirectX::XMStoreFloat4x4(&projection, P);
+		for (size_t id : visible_objects)
+		{
+			const GameObject* object{ grid_objects.at(id) };
+			if (!object || !object->mesh)
+			{
+				continue;
+			}
+			const DirectX::XMFLOAT4X4& world{ object->render_states[render_snapshot].world };
+			float screen_diameter{ 0.0f };
+			for (const skinned_mesh::mesh& mesh : object->mesh->meshes)
+			{
+				DirectX::XMFLOAT4X4 mesh_world;
+				DirectX::XMStoreFloat4x4(&mesh_world, DirectX::XMLoadFloat4x4(&mesh.default_global_transform) * DirectX::XMLoadFloat4x4(&world));
+				screen_diameter = std::max<float>(screen_diameter, compute_screen_diameter(mesh.bounding_box, mesh_world, camera_position, projection._22, viewport.Height));
+			}
+			fw->streamer->request(object->mesh.get(), screen_diameter);
+		}
+		fw->streamer->update(context);
+	}
+
+	// Framebuffer pass
+	framebuffers[0]->clear(context);
+	framebuffers[0]->activate(context);
+
+	state_context.OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_OFF_ZW_OFF)].Get(), 0);
+	state_context.RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::CULL_NONE)].Get());
+	sprite_batches[0]->begin(context);
+	sprite_batches[0]->render(context, 0, 0, 1280, 720);
+	sprite_batches[0]->end(context);
+
+	state_context.OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_ON_ZW_ON)].Get(), 0);
+	state_context.RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::SOLID)].Get());
+
+	// GameObjectの描画（視錐台の中にあるものだけ）
+	object_draws->begin(camera_position);
+	object_draws->record(visible_objects.size(), [this](size_t index, draw_list::recorder& recorder)
+	{
+		grid_objects.at(visible_objects.at(index))->enqueue(recorder, render_snapshot);
+	});
+	filtered_context->invalidate_bindings();
+	if (deferred_submission)
+	{
+		object_draws->submit_deferred(context);
+	}
+	else
+	{
+		object_draws->submit(state_context);
+	}
+
+	framebuffers[0]->deactivate(context);
+
+	// Post-processing
+	framebuffers[1]->clear(context);
+	framebuffers[1]->activate(context);
+	state_context.OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_OFF_ZW_OFF)].Get(), 0);
+	state_context.RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::CULL_NONE)].Get());
+	bit_block_transfer->blit(context, framebuffers[0]->shader_resource_views[0].GetAddressOf(), 0, 1, pixel_shaders[0].Get());
+	framebuffers[1]->deactivate(context);
+
+	state_context.OMSetDepthStencilState(fw->depth_stencil_states[static_cast<size_t>(framework::DEPTH_STATE::ZT_OFF_ZW_OFF)].Get(), 0);
+	state_context.RSSetState(fw->rasterizer_states[static_cast<size_t>(framework::RASTER_STATE::CULL_NONE)].Get());
+	ID3D11ShaderResourceView* shader_resource_views[2]{ framebuffers[0]->shader_resource_views[0].Get(), framebuffers[1]->shader_resource_views[0].Get() };
+	bit_block_transfer->blit(context, shader_resource_views, 0, 2, pixel_shaders[1].Get());
+}
+
+void GameScene::finalize(framework* fw)
+{
+}
+
+void GameScene::add_occluder(const static_mesh& mesh, const XMFLOAT4X4& world)
+{
+	// The rasterizer reads the CPU copy of the geometry, which only 'retain_geometry' keeps.
+	_ASSERT_EXPR(!mesh.vertices.empty() && !mesh.indices.empty(), L"Occluders must be constructed with 'retain_geometry'");
+	occluders.push_back({ &mesh, world });
+}
+
+void GameScene::add_to_grid(GameObject* object)
+{
+	if (!object || !object->mesh)
+	{
+		return;
+	}
+	// Published into both snapshots so it is drawn from the next frame whichever one render reads.
+	object->begin_step();
+	object->publish(0, 1.0f);
+	object->publish(1, 1.0f);
+	const size_t id{ object_grids[0].add(object->render_states[0].bounding_box) };
+	const size_t other_id{ object_grids[1].add(object->render_states[1].bounding_box) };
+	_ASSERT_EXPR(id == other_id, L"Both snapshot grids must hand out the same ids");
+	if (id >= grid_objects.size())
+	{
+		grid_objects.resize(id + 1, nullptr);
+	}
+	grid_objects.at(id) = object;
+}
+
+void GameScene::find_objects(const DirectX::XMFLOAT3& center, float radius, std::vector<GameObject*>& found) const
+{
+	found.clear();
+	std::vector<size_t> ids;
+	object_grids[render_snapshot].query_sphere(center, radius, ids);
+	for (size_t id : ids)
+	{
+		found.push_back(grid_objects.at(id));
+	}
+}
+
+GameObject* GameScene::pick_object(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float max_distance) const
+{
+	std::vector<std::pair<float, size_t>> hits;
+	object_grids[render_snapshot].query_ray(origin, direction, max_distance, hits);
+	return hits.empty() ? nullptr : grid_objects.at(hits.front().second);
 }
\ No newline at end of file
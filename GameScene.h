@@ -1,72 +1,127 @@
-#pragma once
-#include "Scene.h"
-#include "GameObject.h" // ǉ
-
-#include <memory>
-#include <vector>
-#include <d3d11.h>
-#include <wrl.h>
-#include <directxmath.h>
-
-#include "sprite.h"
-#include "sprite_batch.h"
-#include "geometric_primitive.h"
-#include "static_mesh.h"
-#include "skinned_mesh.h"
-#include "framebuffer.h"
-#include "fullscreen_quad.h"
-
-class GameScene : public Scene
-{
-public:
-	GameScene() = default;
-	~GameScene() override = default;
-
-	void initialize(framework* fw) override;
-	void update(framework* fw, float elapsed_time) override;
-	void render(framework* fw, float elapsed_time) override;
-	void finalize(framework* fw) override;
-
-private:
-	struct scene_constants
-	{
-		DirectX::XMFLOAT4X4 view_projection;
-		DirectX::XMFLOAT4 light_direction;
-		DirectX::XMFLOAT4 camera_position;
-	};
-
-	struct parametric_constants
-	{
-		float extraction_threshold{ 0.8f };
-		float gaussian_sigma{ 1.0f };
-		float bloom_intensity{ 1.0f };
-		float exposure{ 1.0f };
-	};
-	parametric_constants parametric_constants;
-
-	Microsoft::WRL::ComPtr<ID3D11Buffer> constant_buffers[8];
-
-	DirectX::XMFLOAT4 camera_position{ 0.0f, 0.0f, -10.0f, 1.0f };
-	DirectX::XMFLOAT4 light_direction{ 0.0f, 0.0f, -1.0f, 0.0f };
-
-	//  ύX_FGameObject̓
-	std::unique_ptr<GameObject> player;
-	// Iɂ std::vector<std::unique_ptr<GameObject>> enemies; Ȃǂɒǉł܂
-
-	std::unique_ptr<sprite> sprites[8];
-	std::unique_ptr<sprite_batch> sprite_batches[8];
-
-	// static_mesh͕KvɉGameObject邩AwipƂĎc
-	std::unique_ptr<static_mesh> static_meshes[8];
-
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shaders[8];
-
-	// skinned_meshes  GameObject ŊǗ̂ł͍폜\łA
-	// \[XێpƂ ResourceManager ܂ł͈UcĂĂB
-	// ͊ȒP̂߁AGameObjectɒړǂݍ܂܂B
-
-	float factors[4]{ 0.0f, 121.438332f };
-
-	std::unique_ptr<framebuffer> framebuffers[8];
-	std::unique_ptr<fullscreen_quad> bit_block_transfer;
+#pragma once
+#include "Scene.h"
+#include "GameObject.h" // 追加
+
+#include <memory>
+#include <vector>
+#include <d3d11.h>
+#include <wrl.h>
+#include <directxmath.h>
+
+#include "sprite.h"
+#include "sprite_batch.h"
+#include "geometric_primitive.h"
+#include "static_mesh.h"
+#include "skinned_mesh.h"
+#include "framebuffer.h"
+#include "fullscreen_quad.h"
+#include "spatial_grid.h"
+#include "occlusion_buffer.h"
+#include "draw_list.h"
+#include "d3d11_render_context.h"
+
+class GameScene : public Scene
+{
+public:
+	GameScene() = default;
+	~GameScene() override = default;
+
+	void initialize(framework* fw) override;
+	void update(framework* fw, float elapsed_time) override;
+	void publish(framework* fw, float interpolation) override;
+	void swap_snapshots() override;
+	void update_gui(framework* fw) override;
+	void render(framework* fw, float elapsed_time) override;
+	void finalize(framework* fw) override;
+
+	// Gameplay queries against the world boxes of the objects as of the last swap_snapshots.
+	void find_objects(const DirectX::XMFLOAT3& center, float radius, std::vector<GameObject*>& found) const;
+	// The object whose box the ray enters first, or nullptr.
+	GameObject* pick_object(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float max_distance) const;
+
+	// Registers a low-poly mesh constructed with 'retain_geometry' as an occluder at 'world'. The mesh must outlive the scene.
+	void add_occluder(const static_mesh& mesh, const DirectX::XMFLOAT4X4& world);
+
+private:
+	struct scene_constants
+	{
+		DirectX::XMFLOAT4X4 view_projection;
+		DirectX::XMFLOAT4 light_direction;
+		DirectX::XMFLOAT4 camera_position;
+	};
+
+	struct parametric_constants
+	{
+		float extraction_threshold{ 0.8f };
+		float gaussian_sigma{ 1.0f };
+		float bloom_intensity{ 1.0f };
+		float exposure{ 1.0f };
+	};
+	parametric_constants parametric_constants;
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> constant_buffers[8];
+
+	DirectX::XMFLOAT4 camera_position{ 0.0f, 0.0f, -10.0f, 1.0f };
+	DirectX::XMFLOAT4 light_direction{ 0.0f, 0.0f, -1.0f, 0.0f };
+
+	// ★ ここが変更点：GameObjectの導入
+	std::unique_ptr<GameObject> player;
+	// 将来的には std::vector<std::unique_ptr<GameObject>> enemies; などもここに追加できます
+
+	// Every GameObject is kept in a loose grid by the world box of its current pose, and render culling and gameplay
+	// queries go through the grid. Grid ids index 'grid_objects'.
+	// Render state is double-buffered: publish writes every object and moves it in the grid of the snapshot that
+	// render is not reading, and swap_snapshots flips 'render_snapshot' to it. Both grids hold the same ids.
+	spatial_grid object_grids[2];
+	size_t render_snapshot{ 0 };
+	std::vector<GameObject*> grid_objects;
+	std::vector<size_t> visible_objects;
+	void add_to_grid(GameObject* object);
+	// Occluders are rasterized after frustum culling, and visible objects hidden behind them are dropped before the
+	// draw list is recorded. With no occluders the occlusion pass is skipped.
+	struct occluder
+	{
+		const static_mesh* mesh;
+		DirectX::XMFLOAT4X4 world;
+	};
+	std::vector<occluder> occluders;
+	occlusion_buffer occlusion;
+	struct culling_statistics
+	{
+		size_t tested{ 0 };
+		size_t visible{ 0 };
+		size_t occluded{ 0 };
+	};
+	culling_statistics culling_statistics;
+
+	// Visible objects are drawn through a sort-keyed queue so that draws sharing a pipeline, material or mesh are
+	// submitted together, as one instanced draw per run of the same mesh subset unless instancing is turned off.
+	std::unique_ptr<draw_list> object_draws;
+	// Replays the sorted draws on deferred contexts from the worker threads instead of on the immediate context.
+	bool deferred_submission{ false };
+
+	// With 'state_filtering', pipeline state set by this scene goes through a filter that drops calls which would not
+	// change anything. Samplers and output merger and rasterizer states are only set here, so they stay filtered
+	// across frames; the other bindings are forgotten whenever sprites or blits may have changed them on the raw
+	// context. Off by default: the filter has not yet been shown to save more in the driver than it costs.
+	bool state_filtering{ false };
+	std::unique_ptr<d3d11_render_context> device_context;
+	std::unique_ptr<state_filtering_context> filtered_context;
+
+	std::unique_ptr<sprite> sprites[8];
+	std::unique_ptr<sprite_batch> sprite_batches[8];
+
+	// static_mesh等は必要に応じてGameObject化するか、背景用として残す
+	std::unique_ptr<static_mesh> static_meshes[8];
+
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shaders[8];
+
+	// skinned_meshes は GameObject 内で管理されるのでここからは削除可能ですが、
+	// リソース保持用として ResourceManager を作るまでは一旦残しておいても可。
+	// 今回は簡単のため、GameObject生成時に直接読み込ませます。
+
+	float factors[4]{ 0.0f, 121.438332f };
+
+	std::unique_ptr<framebuffer> framebuffers[8];
+	std::unique_ptr<fullscreen_quad> bit_block_transfer;
 };
\ No newline at end of file
@@ -1,36 +1,47 @@
-#pragma once
-#include <map>
-#include <string>
-#include <memory>
-#include <d3d11.h>
-#include "skinned_mesh.h"
-
-class ResourceManager
-{
-public:
-	ResourceManager(ID3D11Device* device) : device(device) {}
-	~ResourceManager() = default;
-
-	// XLbV̓ǂݍ݁id[hh~@\tj
-	std::shared_ptr<skinned_mesh> load_skinned_mesh(const std::string& filename)
-	{
-		// łɓǂݍݍς݂`FbN
-		auto it = skinned_mesh_cache.find(filename);
-		if (it != skinned_mesh_cache.end())
-		{
-			// ǂݍݍς݂ȂAۑĂ|C^Ԃ
-			return it->second;
-		}
-
-		// ܂ȂVǂݍŁALbVɕۑ
-		auto mesh = std::make_shared<skinned_mesh>(device, filename.c_str());
-		skinned_mesh_cache[filename] = mesh;
-
-		return mesh;
-	}
-
-private:
-	ID3D11Device* device;
-	// t@CL[ɂăf[^ۑ鎫
-	std::map<std::string, std::shared_ptr<skinned_mesh>> skinned_mesh_cache;
-};
+#pragma once
+#include <map>
+#include <string>
+#include <memory>
+#include <vector>
+#include <d3d11.h>
+#include "skinned_mesh.h"
+
+class ResourceManager
+{
+public:
+	ResourceManager(ID3D11Device* device) : device(device) {}
+	~ResourceManager() = default;
+
+	// スキンメッシュの読み込み（重複ロード防止機能付き）
+	std::shared_ptr<skinned_mesh> load_skinned_mesh(const std::string& filename)
+	{
+		// すでに読み込み済みかチェック
+		auto it = skinned_mesh_cache.find(filename);
+		if (it != skinned_mesh_cache.end())
+		{
+			// 読み込み済みなら、保存しておいたポインタを返す
+			return it->second;
+		}
+
+		// まだなら新しく読み込んで、キャッシュに保存する
+		auto mesh = std::make_shared<skinned_mesh>(device, filename.c_str());
+		skinned_mesh_cache[filename] = mesh;
+
+		return mesh;
+	}
+
+	// 読み込み済みのアセットごとのメモリ内訳（ファイル名と内訳の組）。テクスチャはキャッシュ側で数える（texture_cache_usage）
+	void memory_report(std::vector<std::pair<std::string, memory_breakdown>>& assets) const
+	{
+		assets.clear();
+		for (const auto& [filename, mesh] : skinned_mesh_cache)
+		{
+			assets.emplace_back(filename, mesh->memory_usage());
+		}
+	}
+
+private:
+	ID3D11Device* device;
+	// ファイル名をキーにしてデータを保存する辞書
+	std::map<std::string, std::shared_ptr<skinned_mesh>> skinned_mesh_cache;
+};
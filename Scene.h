@@ -1,14 +1,24 @@
-#pragma once
-#include <d3d11.h>
-
-class framework;
-
-class Scene
-{
-public:
-	virtual ~Scene() = default;
-	virtual void initialize(framework* fw) = 0;
-	virtual void update(framework* fw, float elapsed_time) = 0;
-	virtual void render(framework* fw, float elapsed_time) = 0;
-	virtual void finalize(framework* fw) = 0;
-};
+#pragma once
+#include <d3d11.h>
+
+class framework;
+
+class Scene
+{
+public:
+	virtual ~Scene() = default;
+	virtual void initialize(framework* fw) = 0;
+	// 'update' advances the simulation by one fixed step of 'elapsed_time' (see framework::tick_rate) and runs as many
+	// times per frame as the frame time covers, possibly none. 'publish' then writes what 'render' reads into a
+	// snapshot, interpolated 'interpolation' (0 to 1) of the way from the state before the last step to the state after.
+	// With framework::pipelined_frames, 'update' and 'publish' of the next frame run on a job thread while 'render'
+	// draws the previous one, so they must not touch the device context or ImGui, and 'render' must only read the
+	// snapshot. 'swap_snapshots' hands the last published snapshot to 'render'; it and 'update_gui' run on the main
+	// thread while no 'update' is running, in the order update, publish, swap_snapshots, update_gui, render.
+	virtual void update(framework* fw, float elapsed_time) = 0;
+	virtual void publish(framework* fw, float interpolation) {}
+	virtual void swap_snapshots() {}
+	virtual void update_gui(framework* fw) {}
+	virtual void render(framework* fw, float elapsed_time) = 0;
+	virtual void finalize(framework* fw) = 0;
+};
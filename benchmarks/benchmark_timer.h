@@ -0,0 +1,12 @@
+#pragma once
+
+#include <chrono>
+
+// Wall-clock seconds one call of 'f' takes. Shared by the benchmark programs in this directory.
+template<class F>
+double seconds(F&& f)
+{
+	const std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+	f();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
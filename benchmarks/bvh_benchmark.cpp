@@ -0,0 +1,137 @@
+// Ray throughput of triangle_bvh in millions of rays per second, and the cost of a build and a refit.
+//
+// usage: bvh_benchmark [file.obj] [ray count]
+// Without an OBJ file a displaced sphere of about a million triangles is used. Rays start on a sphere around
+// the mesh and aim at random points inside its bounds, so most of them hit.
+
+#include "../triangle_bvh.h"
+#include "../obj_parser.h"
+#include "benchmark_timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	void make_sphere(uint32_t slices, uint32_t stacks, std::vector<XMFLOAT3>& positions, std::vector<uint32_t>& indices)
+	{
+		std::mt19937 random(7);
+		std::uniform_real_distribution<float> bump(0.95f, 1.05f);
+		for (uint32_t stack = 0; stack <= stacks; ++stack)
+		{
+			const float phi{ XM_PI * stack / stacks };
+			for (uint32_t slice = 0; slice <= slices; ++slice)
+			{
+				const float theta{ XM_2PI * slice / slices };
+				const float radius{ bump(random) };
+				positions.push_back({ radius * std::sin(phi) * std::cos(theta), radius * std::cos(phi), radius * std::sin(phi) * std::sin(theta) });
+			}
+		}
+		for (uint32_t stack = 0; stack < stacks; ++stack)
+		{
+			for (uint32_t slice = 0; slice < slices; ++slice)
+			{
+				const uint32_t a{ stack * (slices + 1) + slice };
+				const uint32_t b{ a + slices + 1 };
+				indices.insert(indices.end(), { a, b, a + 1, a + 1, b, b + 1 });
+			}
+		}
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	std::vector<XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+	size_t ray_count{ 1 << 20 };
+	if (argc > 1 && std::strstr(argv[1], ".obj"))
+	{
+		const std::wstring filename(argv[1], argv[1] + std::strlen(argv[1]));
+		obj_mesh mesh;
+		if (!parse_obj(filename.c_str(), false, mesh))
+		{
+			std::fprintf(stderr, "cannot open %s\n", argv[1]);
+			return 1;
+		}
+		for (const obj_mesh::vertex& vertex : mesh.vertices)
+		{
+			positions.push_back(vertex.position);
+		}
+		indices = std::move(mesh.indices);
+		if (argc > 2)
+		{
+			ray_count = std::strtoul(argv[2], nullptr, 10);
+		}
+	}
+	else
+	{
+		make_sphere(1024, 512, positions, indices);
+		if (argc > 1)
+		{
+			ray_count = std::strtoul(argv[1], nullptr, 10);
+		}
+	}
+
+	triangle_bvh bvh;
+	const double build_time{ seconds([&]() { bvh.build(positions.data(), sizeof(XMFLOAT3), positions.size(), indices.data(), indices.size()); }) };
+	std::printf("triangles %zu, nodes %zu, build %.1f ms\n", bvh.triangle_count(), bvh.node_count(), build_time * 1000.0);
+
+	// Refit cost, as paid every frame by an animated mesh: a twisted copy, then back to the original for the ray tests.
+	std::vector<XMFLOAT3> deformed(positions);
+	for (XMFLOAT3& position : deformed)
+	{
+		const float angle{ 0.3f * position.y };
+		position = { position.x * std::cos(angle) - position.z * std::sin(angle), position.y, position.x * std::sin(angle) + position.z * std::cos(angle) };
+	}
+	const double refit_time{ seconds([&]() { bvh.refit(deformed.data(), sizeof(XMFLOAT3), deformed.size()); }) };
+	bvh.refit(positions.data(), sizeof(XMFLOAT3), positions.size());
+	std::printf("refit %.2f ms (%.1f ns per triangle)\n", refit_time * 1000.0, refit_time * 1e9 / static_cast<double>(bvh.triangle_count()));
+
+	const triangle_bvh::node& root{ bvh.root() };
+	const XMVECTOR minimum{ XMLoadFloat3(&root.minimum) };
+	const XMVECTOR maximum{ XMLoadFloat3(&root.maximum) };
+	const XMVECTOR center{ XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f) };
+	const float radius{ XMVectorGetX(XMVector3Length(XMVectorSubtract(maximum, minimum))) };
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+	std::vector<triangle_bvh::ray> rays(ray_count);
+	for (triangle_bvh::ray& ray : rays)
+	{
+		const XMVECTOR outside{ XMVectorAdd(center, XMVectorScale(XMVector3Normalize(XMVectorSet(unit(random), unit(random), unit(random), 0)), radius)) };
+		const XMVECTOR target{ XMVectorAdd(center, XMVectorMultiply(XMVectorScale(XMVectorSubtract(maximum, minimum), 0.5f), XMVectorSet(unit(random), unit(random), unit(random), 0))) };
+		XMStoreFloat3(&ray.origin, outside);
+		XMStoreFloat3(&ray.direction, XMVector3Normalize(XMVectorSubtract(target, outside)));
+	}
+
+	std::vector<triangle_bvh::hit> single_hits(ray_count);
+	const double single_time{ seconds([&]() { for (size_t i = 0; i < ray_count; ++i) { bvh.intersect(rays[i], single_hits[i]); } }) };
+	std::vector<triangle_bvh::hit> packet_hits(ray_count);
+	const double packet_time{ seconds([&]() { bvh.intersect(rays.data(), packet_hits.data(), ray_count); }) };
+	std::vector<uint8_t> occluded(ray_count);
+	const double occluded_time{ seconds([&]() { bvh.occluded(rays.data(), occluded.data(), ray_count); }) };
+
+	size_t hit_count{ 0 }, mismatches{ 0 };
+	for (size_t i = 0; i < ray_count; ++i)
+	{
+		hit_count += single_hits[i].is_hit() ? 1 : 0;
+		if (single_hits[i].is_hit() != packet_hits[i].is_hit() || single_hits[i].is_hit() != (occluded[i] != 0) ||
+			(single_hits[i].is_hit() && std::fabs(single_hits[i].distance - packet_hits[i].distance) > 1e-4f * radius))
+		{
+			++mismatches;
+		}
+	}
+	const double mega_rays{ static_cast<double>(ray_count) / 1e6 };
+	std::printf("rays %zu, hits %zu, mismatches %zu\n", ray_count, hit_count, mismatches);
+	std::printf("closest hit, single ray    : %8.2f Mrays/s\n", mega_rays / single_time);
+	std::printf("closest hit, 4-ray packets : %8.2f Mrays/s\n", mega_rays / packet_time);
+	std::printf("any hit, 4-ray packets     : %8.2f Mrays/s\n", mega_rays / occluded_time);
+	return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,170 @@
+// Recording draws into per-thread command_buffers and merging them, against recording the same draws on one thread
+// and sorting. The merged queue, packets and gathered payload must be identical to the single-threaded ones.
+//
+// usage: command_buffer_benchmark [object count] [bones per object]
+// Every object is a skinned model with a pose: recording it computes a bone palette, which is most of the cost, as
+// in draw_list. Objects pick one of a thousand meshes, so many of them share a shader, material and mesh.
+
+#include "../command_buffer.h"
+#include "benchmark_timer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	struct matrix
+	{
+		float m[4][4];
+	};
+
+	struct object
+	{
+		uint32_t mesh;
+		float position[3];
+		float phase;
+	};
+
+	struct packet
+	{
+		uint32_t object;
+		uint32_t palette_offset;
+		uint32_t palette_size;
+	};
+
+	using buffer = command_buffer<packet, matrix>;
+
+	// Stands in for the shared models: only the addresses are used, as ids.
+	struct model
+	{
+		char shader[6];
+		char materials[300];
+		char meshes[1000];
+	};
+
+	// A chain of rotations about z, one per bone, as a pose walking down a skeleton.
+	void record(const object& object, uint32_t object_index, uint32_t bone_count, const model& model, buffer& buffer)
+	{
+		packet packet{ object_index, static_cast<uint32_t>(buffer.payload.size()), bone_count };
+		matrix transform{ { { 1, 0, 0, 0 }, { 0, 1, 0, 0 }, { 0, 0, 1, 0 }, { 0, 0, 0, 1 } } };
+		for (uint32_t bone = 0; bone < bone_count; ++bone)
+		{
+			const float angle{ object.phase + bone * 0.1f };
+			const float c{ std::cos(angle) }, s{ std::sin(angle) };
+			matrix next{};
+			for (int row = 0; row < 4; ++row)
+			{
+				next.m[row][0] = transform.m[row][0] * c - transform.m[row][1] * s;
+				next.m[row][1] = transform.m[row][0] * s + transform.m[row][1] * c;
+				next.m[row][2] = transform.m[row][2];
+				next.m[row][3] = transform.m[row][3];
+			}
+			next.m[3][1] += 0.1f;
+			transform = next;
+			buffer.payload.push_back(transform);
+		}
+
+		const uint32_t shader{ buffer.shader_ids.id(&model.shader[object.mesh % 6]) };
+		const uint32_t material{ buffer.material_ids.id(&model.materials[object.mesh % 300]) };
+		const uint32_t mesh{ buffer.mesh_ids.id(&model.meshes[object.mesh]) };
+		const float depth{ std::sqrt(object.position[0] * object.position[0] + object.position[1] * object.position[1] + object.position[2] * object.position[2]) };
+		buffer.push(render_queue::make_key(0, shader, material, mesh, depth), packet);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t object_count{ argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 20000 };
+	const uint32_t bone_count{ argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : 32 };
+
+	std::mt19937 random(11);
+	std::uniform_int_distribution<uint32_t> mesh_distribution(0, 999);
+	std::uniform_real_distribution<float> position_distribution(-200.0f, 200.0f), phase_distribution(0.0f, 6.28f);
+	std::vector<object> objects(object_count);
+	for (object& object : objects)
+	{
+		object.mesh = mesh_distribution(random);
+		object.position[0] = position_distribution(random);
+		object.position[1] = 0;
+		object.position[2] = position_distribution(random);
+		object.phase = phase_distribution(random);
+	}
+	const model model{};
+	const int repeat{ 10 };
+
+	// One thread records everything into one buffer, which is then sorted.
+	buffer serial;
+	double serial_time{ 0 };
+	for (int i = 0; i < repeat; ++i)
+	{
+		serial_time += seconds([&]()
+		{
+			serial.clear();
+			for (uint32_t object_index = 0; object_index < objects.size(); ++object_index)
+			{
+				record(objects.at(object_index), object_index, bone_count, model, serial);
+			}
+			serial.queue.sort();
+		});
+	}
+
+	// One contiguous slice of the objects per buffer, a buffer per worker plus the calling thread.
+	thread_pool pool;
+	std::vector<buffer> buffers(pool.thread_count() + 1);
+	std::vector<buffer*> buffer_pointers;
+	for (buffer& buffer : buffers)
+	{
+		buffer_pointers.push_back(&buffer);
+	}
+	buffer merged;
+	double record_time{ 0 }, merge_time{ 0 };
+	for (int i = 0; i < repeat; ++i)
+	{
+		record_time += seconds([&]()
+		{
+			pool.parallel_for(buffers.size(), [&](size_t slice)
+			{
+				buffer& buffer{ buffers.at(slice) };
+				buffer.clear();
+				const size_t first{ objects.size() * slice / buffers.size() }, last{ objects.size() * (slice + 1) / buffers.size() };
+				for (size_t object_index = first; object_index < last; ++object_index)
+				{
+					record(objects.at(object_index), static_cast<uint32_t>(object_index), bone_count, model, buffer);
+				}
+			});
+		});
+		merge_time += seconds([&]()
+		{
+			merged.merge(buffer_pointers.data(), buffer_pointers.size(), [](packet& packet, uint32_t payload_offset) { packet.palette_offset += payload_offset; }, pool);
+		});
+	}
+
+	double gather_time{ seconds([&]()
+	{
+		merged.payload.resize(buffer::payload_size(buffer_pointers.data(), buffer_pointers.size()));
+		buffer::gather_payload(buffer_pointers.data(), buffer_pointers.size(), merged.payload.data());
+	}) };
+
+	size_t mismatches{ merged.queue.size() == serial.queue.size() && merged.payload.size() == serial.payload.size() ? 0u : 1u };
+	for (size_t i = 0; mismatches == 0 && i < serial.queue.size(); ++i)
+	{
+		const render_queue::item& expected{ serial.queue.items().at(i) };
+		const render_queue::item& item{ merged.queue.items().at(i) };
+		const packet& expected_packet{ serial.packets.at(expected.draw) };
+		const packet& merged_packet{ merged.packets.at(item.draw) };
+		mismatches += item.key != expected.key || item.draw != expected.draw || merged_packet.object != expected_packet.object ? 1 : 0;
+		mismatches += std::memcmp(&merged.payload.at(merged_packet.palette_offset), &serial.payload.at(expected_packet.palette_offset), sizeof(matrix) * bone_count) != 0 ? 1 : 0;
+	}
+
+	std::printf("objects   : %zu, %u bones each, %zu distinct meshes\n", object_count, bone_count, serial.mesh_ids.size());
+	std::printf("serial    : %8.3f ms (record and sort)\n", serial_time * 1000.0 / repeat);
+	std::printf("parallel  : %8.3f ms (record %.3f ms on %zu buffers, merge %.3f ms)\n", (record_time + merge_time) * 1000.0 / repeat,
+		record_time * 1000.0 / repeat, buffers.size(), merge_time * 1000.0 / repeat);
+	std::printf("gather    : %8.3f ms (%zu payload bytes)\n", gather_time * 1000.0, merged.payload.size() * sizeof(matrix));
+	std::printf("mismatches against serial recording: %zu\n", mismatches);
+	return mismatches == 0 ? 0 : 1;
+}
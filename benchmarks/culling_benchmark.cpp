@@ -0,0 +1,102 @@
+// Frustum culling throughput of frustum_culler, checked against a plain one-box-at-a-time test.
+//
+// usage: culling_benchmark [box count]
+// Unit boxes with random rotations and scales are scattered over a 200 m square around a camera looking down +z,
+// so a fraction of them is visible, as in a level.
+
+#include "../frustum_culler.h"
+#include "benchmark_timer.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// The reference: all eight corners of the moved box against each plane.
+	bool visible_reference(const XMFLOAT4 planes[6], const XMFLOAT3 bounding_box[2], const XMFLOAT4X4& world)
+	{
+		const XMMATRIX W{ XMLoadFloat4x4(&world) };
+		XMVECTOR minimum{ XMVectorReplicate(FLT_MAX) };
+		XMVECTOR maximum{ XMVectorReplicate(-FLT_MAX) };
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			const XMVECTOR point{ XMVector3Transform(XMVectorSet(bounding_box[corner & 1].x, bounding_box[(corner >> 1) & 1].y, bounding_box[(corner >> 2) & 1].z, 1), W) };
+			minimum = XMVectorMin(minimum, point);
+			maximum = XMVectorMax(maximum, point);
+		}
+		XMFLOAT3 box[2];
+		XMStoreFloat3(&box[0], minimum);
+		XMStoreFloat3(&box[1], maximum);
+		for (int plane_index = 0; plane_index < 6; ++plane_index)
+		{
+			const XMFLOAT4& plane{ planes[plane_index] };
+			const float x{ plane.x >= 0 ? box[1].x : box[0].x };
+			const float y{ plane.y >= 0 ? box[1].y : box[0].y };
+			const float z{ plane.z >= 0 ? box[1].z : box[0].z };
+			if (plane.x * x + plane.y * y + plane.z * z + plane.w < 0)
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t box_count{ argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 100000 };
+
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> size(0.5f, 3.0f);
+	const XMFLOAT3 unit_box[2]{ { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	std::vector<XMFLOAT4X4> worlds(box_count);
+	for (XMFLOAT4X4& world : worlds)
+	{
+		XMStoreFloat4x4(&world, XMMatrixScaling(size(random), size(random), size(random)) *
+			XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+			XMMatrixTranslation(position(random), position(random) * 0.1f, position(random)));
+	}
+
+	XMFLOAT4X4 view_projection;
+	XMStoreFloat4x4(&view_projection, XMMatrixLookAtLH(XMVectorSet(0, 2, -10, 1), XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XMConvertToRadians(60), 16.0f / 9.0f, 0.1f, 100.0f));
+
+	frustum_culler culler;
+	culler.reserve(box_count);
+	const double add_time{ seconds([&]() { for (const XMFLOAT4X4& world : worlds) { culler.add(unit_box, world); } }) };
+
+	std::vector<uint32_t> visible;
+	visible.reserve(box_count);
+	const int repeat{ 20 };
+	size_t visible_count{ 0 };
+	const double cull_time{ seconds([&]() { for (int i = 0; i < repeat; ++i) { visible_count = culler.cull(view_projection, visible); } }) / repeat };
+
+	XMFLOAT4 planes[6];
+	extract_frustum_planes(view_projection, planes);
+	std::vector<uint32_t> expected;
+	const double reference_time{ seconds([&]()
+	{
+		for (size_t box_index = 0; box_index < box_count; ++box_index)
+		{
+			if (visible_reference(planes, unit_box, worlds[box_index]))
+			{
+				expected.push_back(static_cast<uint32_t>(box_index));
+			}
+		}
+	}) };
+
+	const bool same{ visible == expected };
+	std::printf("boxes %zu, visible %zu (reference %zu)%s\n", box_count, visible_count, expected.size(), same ? "" : " MISMATCH");
+	std::printf("add (world transform)   : %8.2f ns per box\n", add_time * 1e9 / static_cast<double>(box_count));
+	std::printf("cull, 4 boxes per vector: %8.2f ns per box\n", cull_time * 1e9 / static_cast<double>(box_count));
+	std::printf("corner-by-corner        : %8.2f ns per box\n", reference_time * 1e9 / static_cast<double>(box_count));
+	return same ? 0 : 1;
+}
@@ -0,0 +1,450 @@
+// Timings of the CPU hot paths of the engine on synthetic data, optionally checked against a baseline.
+//
+// usage: engine_benchmark [baseline file] [threshold percent] [runs]
+// Every case runs 'runs' times (default 15) and prints one line: its name, the median milliseconds of a run, and with a
+// baseline the baseline milliseconds, the change in percent and 'ok', 'REGRESSION' or 'new'. Lines starting with '#'
+// are comments. A baseline is the output of an earlier run; only the first two columns of each line are read, so
+//   engine_benchmark > baseline.txt
+// records one. A case slower than its baseline by more than the threshold (default 10) is a regression, and any
+// regression or failed check makes the exit code nonzero. Timings differ between machines and builds, so baselines are
+// recorded on the machine that compares against them.
+//
+// All data is generated from fixed seeds: no asset, window or device is needed. Cases that read FBX scenes through the
+// FBX SDK on the Windows build are measured on the same loops over plain arrays, with the same packing and vertex layout.
+
+#include "../skeletal_animation.h"
+#include "../sprite_vertices.h"
+#include "../geometric_shapes.h"
+#include "../obj_parser.h"
+#include "../frustum_culler.h"
+#include "../spatial_grid.h"
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include "../cereal_directxmath.h"
+#include "benchmark_timer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// A skeleton of 'node_count' nodes, each the child of the one half its index away, with one bone per node.
+	struct animated_scene
+	{
+		std::vector<int64_t> parent_indices;
+		skeleton bind_pose;
+		XMFLOAT4X4 default_global_transform{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+		std::vector<animation> animation_clips;
+	};
+	animated_scene make_animated_scene(size_t node_count, size_t clip_count, size_t keyframe_count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		animated_scene scene;
+		scene.parent_indices.resize(node_count);
+		scene.bind_pose.bones.resize(node_count);
+		for (size_t node_index = 0; node_index < node_count; ++node_index)
+		{
+			scene.parent_indices[node_index] = node_index == 0 ? -1 : static_cast<int64_t>((node_index - 1) / 2);
+			skeleton::bone& bone{ scene.bind_pose.bones[node_index] };
+			bone.unique_id = node_index + 1;
+			bone.name = "bone" + std::to_string(node_index);
+			bone.parent_index = scene.parent_indices[node_index];
+			bone.node_index = static_cast<int64_t>(node_index);
+			XMStoreFloat4x4(&bone.offset_transform, XMMatrixTranslation(unit(random), unit(random), unit(random)));
+		}
+		scene.animation_clips.resize(clip_count);
+		for (animation& clip : scene.animation_clips)
+		{
+			clip.name = "clip";
+			clip.sampling_rate = 24;
+			clip.sequence.resize(keyframe_count);
+			for (animation::keyframe& keyframe : clip.sequence)
+			{
+				keyframe.nodes.resize(node_count);
+				for (animation::keyframe::node& node : keyframe.nodes)
+				{
+					node.scaling = { 1.0f + unit(random) * 0.1f, 1.0f + unit(random) * 0.1f, 1.0f + unit(random) * 0.1f };
+					XMStoreFloat4(&node.rotation, XMQuaternionRotationRollPitchYaw(unit(random), unit(random), unit(random)));
+					node.translation = { unit(random), unit(random), unit(random) };
+				}
+			}
+		}
+		return scene;
+	}
+
+	// A grid of quads with positions, texcoords and normals, as an exporter writes a terrain.
+	std::string make_obj_text(size_t quads_per_side)
+	{
+		std::string text;
+		text.reserve(quads_per_side * quads_per_side * 96);
+		char line[128];
+		const size_t side{ quads_per_side + 1 };
+		for (size_t z = 0; z < side; ++z)
+		{
+			for (size_t x = 0; x < side; ++x)
+			{
+				text.append(line, std::snprintf(line, sizeof(line), "v %.4f %.4f %.4f\n", static_cast<float>(x), std::sin(x * 0.1f) * std::cos(z * 0.1f), static_cast<float>(z)));
+				text.append(line, std::snprintf(line, sizeof(line), "vt %.4f %.4f\n", static_cast<float>(x) / quads_per_side, static_cast<float>(z) / quads_per_side));
+			}
+		}
+		text += "vn 0 1 0\nusemtl ground\n";
+		for (size_t z = 0; z < quads_per_side; ++z)
+		{
+			for (size_t x = 0; x < quads_per_side; ++x)
+			{
+				const size_t a{ z * side + x + 1 }, b{ a + 1 }, c{ a + side + 1 }, d{ a + side };
+				text.append(line, std::snprintf(line, sizeof(line), "f %zu/%zu/1 %zu/%zu/1 %zu/%zu/1 %zu/%zu/1\n", a, a, b, b, c, c, d, d));
+			}
+		}
+		return text;
+	}
+
+	// What fetch_meshes reads from an FbxMesh: control points with their bone influences, and per polygon corner the
+	// control point, normal, texcoord and tangent, and per polygon the material.
+	struct fbx_like_mesh
+	{
+		std::vector<XMFLOAT3> control_points;
+		std::vector<std::vector<bone_influence>> bone_influences;
+		std::vector<int> polygon_vertices;
+		std::vector<XMFLOAT3> normals;
+		std::vector<XMFLOAT2> texcoords;
+		std::vector<XMFLOAT4> tangents;
+		std::vector<int> polygon_materials;
+		int material_count{ 0 };
+	};
+	fbx_like_mesh make_fbx_like_mesh(size_t control_point_count, size_t polygon_count, uint32_t bone_count, std::mt19937& random)
+	{
+		std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+		std::uniform_int_distribution<int> influence_count(1, 6);
+		std::uniform_int_distribution<uint32_t> bone(0, bone_count - 1);
+		std::uniform_int_distribution<int> control_point(0, static_cast<int>(control_point_count) - 1);
+		fbx_like_mesh mesh;
+		mesh.material_count = 3;
+		mesh.control_points.resize(control_point_count);
+		mesh.bone_influences.resize(control_point_count);
+		for (size_t index = 0; index < control_point_count; ++index)
+		{
+			mesh.control_points[index] = { unit(random), unit(random), unit(random) };
+			const int count{ influence_count(random) };
+			for (int influence = 0; influence < count; ++influence)
+			{
+				mesh.bone_influences[index].push_back({ bone(random), unit(random) * 0.5f + 0.5f + 0.01f });
+			}
+		}
+		mesh.polygon_vertices.resize(polygon_count * 3);
+		mesh.normals.resize(polygon_count * 3);
+		mesh.texcoords.resize(polygon_count * 3);
+		mesh.tangents.resize(polygon_count * 3);
+		for (size_t corner = 0; corner < polygon_count * 3; ++corner)
+		{
+			mesh.polygon_vertices[corner] = control_point(random);
+			mesh.normals[corner] = { unit(random), unit(random), unit(random) };
+			mesh.texcoords[corner] = { unit(random) * 0.5f + 0.5f, unit(random) * 0.5f + 0.5f };
+			mesh.tangents[corner] = { unit(random), unit(random), unit(random), 1 };
+		}
+		mesh.polygon_materials.resize(polygon_count);
+		for (int& material : mesh.polygon_materials)
+		{
+			material = control_point(random) % mesh.material_count;
+		}
+		return mesh;
+	}
+
+	// The vertex loop of skinned_mesh::fetch_meshes over 'source', into one vertex per polygon corner and indices grouped by material.
+	void build_skinned_vertices(const fbx_like_mesh& source, std::vector<skinned_vertex>& vertices, std::vector<uint32_t>& indices, XMFLOAT3 bounding_box[2])
+	{
+		const size_t polygon_count{ source.polygon_materials.size() };
+		std::vector<uint32_t> start_index_locations(source.material_count, 0), index_counts(source.material_count, 0);
+		for (int material : source.polygon_materials)
+		{
+			index_counts[material] += 3;
+		}
+		for (int material = 1; material < source.material_count; ++material)
+		{
+			start_index_locations[material] = start_index_locations[material - 1] + index_counts[material - 1];
+		}
+		std::fill(index_counts.begin(), index_counts.end(), 0);
+
+		vertices.resize(polygon_count * 3);
+		indices.resize(polygon_count * 3);
+		for (size_t polygon_index = 0; polygon_index < polygon_count; ++polygon_index)
+		{
+			const int material_index{ source.polygon_materials[polygon_index] };
+			const uint32_t offset{ start_index_locations[material_index] + index_counts[material_index] };
+			for (int position_in_polygon = 0; position_in_polygon < 3; ++position_in_polygon)
+			{
+				const size_t vertex_index{ polygon_index * 3 + position_in_polygon };
+				const int polygon_vertex{ source.polygon_vertices[vertex_index] };
+
+				skinned_vertex vertex;
+				vertex.position = source.control_points[polygon_vertex];
+				const std::vector<bone_influence>& influences{ source.bone_influences[polygon_vertex] };
+				pack_bone_influences(influences.data(), influences.size(), vertex);
+				vertex.normal = source.normals[vertex_index];
+				vertex.texcoord = { source.texcoords[vertex_index].x, 1.0f - source.texcoords[vertex_index].y };
+				vertex.tangent = source.tangents[vertex_index];
+
+				vertices[vertex_index] = vertex;
+				indices[offset + position_in_polygon] = static_cast<uint32_t>(vertex_index);
+				index_counts[material_index]++;
+			}
+		}
+		bounding_box[0] = { +FLT_MAX, +FLT_MAX, +FLT_MAX };
+		bounding_box[1] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		for (const skinned_vertex& v : vertices)
+		{
+			bounding_box[0].x = std::min<float>(bounding_box[0].x, v.position.x);
+			bounding_box[0].y = std::min<float>(bounding_box[0].y, v.position.y);
+			bounding_box[0].z = std::min<float>(bounding_box[0].z, v.position.z);
+			bounding_box[1].x = std::max<float>(bounding_box[1].x, v.position.x);
+			bounding_box[1].y = std::max<float>(bounding_box[1].y, v.position.y);
+			bounding_box[1].z = std::max<float>(bounding_box[1].z, v.position.z);
+		}
+	}
+
+	struct benchmark_case
+	{
+		const char* name;
+		std::function<void()> run;
+	};
+
+	// Name to milliseconds. Returns false if the file can't be read.
+	bool read_baseline(const char* filename, std::map<std::string, double>& baseline)
+	{
+		std::ifstream ifs(filename);
+		if (!ifs)
+		{
+			return false;
+		}
+		std::string line;
+		while (std::getline(ifs, line))
+		{
+			std::istringstream columns(line);
+			std::string name;
+			double milliseconds;
+			if (line.empty() || line[0] == '#' || !(columns >> name >> milliseconds))
+			{
+				continue;
+			}
+			baseline[name] = milliseconds;
+		}
+		return true;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* baseline_filename{ argc > 1 ? argv[1] : nullptr };
+	const double threshold{ argc > 2 ? std::strtod(argv[2], nullptr) : 10.0 };
+	const size_t run_count{ std::max<size_t>(1, argc > 3 ? std::strtoul(argv[3], nullptr, 10) : 15) };
+
+	std::map<std::string, double> baseline;
+	if (baseline_filename && !read_baseline(baseline_filename, baseline))
+	{
+		std::fprintf(stderr, "cannot read baseline %s\n", baseline_filename);
+		return 1;
+	}
+
+	std::mt19937 random(49);
+	size_t errors{ 0 };
+
+	// The parts of a skinned_mesh cache that grow with the asset: skeleton, vertices, indices and animation clips.
+	animated_scene scene{ make_animated_scene(128, 4, 240, random) };
+	fbx_like_mesh fbx_mesh{ make_fbx_like_mesh(20000, 40000, 128, random) };
+	std::vector<skinned_vertex> skinned_vertices;
+	std::vector<uint32_t> skinned_indices;
+	XMFLOAT3 skinned_bounding_box[2];
+	build_skinned_vertices(fbx_mesh, skinned_vertices, skinned_indices, skinned_bounding_box);
+	std::string cache;
+	{
+		std::ostringstream oss(std::ios::binary);
+		cereal::BinaryOutputArchive serialization(oss);
+		serialization(scene.bind_pose, skinned_vertices, skinned_indices, scene.animation_clips);
+		cache = oss.str();
+	}
+
+	const std::string obj_text{ make_obj_text(300) };
+	obj_mesh parsed_obj;
+
+	animation::keyframe blended;
+	std::vector<XMFLOAT4X4> bone_transforms(scene.bind_pose.bones.size());
+	volatile size_t sink{ 0 };
+
+	// Reserved once, as sprite_batch does.
+	const size_t sprite_count{ 20000 };
+	std::vector<sprite_vertex> sprite_vertices;
+	sprite_vertices.reserve(sprite_count * SPRITE_VERTEX_COUNT);
+
+	std::vector<geometric_vertex> shape_vertices;
+	std::vector<uint32_t> shape_indices;
+
+	std::uniform_real_distribution<float> position(-100.0f, 100.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> size(0.5f, 3.0f);
+	const XMFLOAT3 unit_box[2]{ { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } };
+	const size_t box_count{ 100000 };
+	frustum_culler culler;
+	culler.reserve(box_count);
+	std::unique_ptr<XMFLOAT3[][2]> world_boxes{ std::make_unique<XMFLOAT3[][2]>(box_count) };
+	for (size_t box_index = 0; box_index < box_count; ++box_index)
+	{
+		XMFLOAT4X4 world;
+		XMStoreFloat4x4(&world, XMMatrixScaling(size(random), size(random), size(random)) *
+			XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+			XMMatrixTranslation(position(random), position(random) * 0.1f, position(random)));
+		culler.add(unit_box, world);
+		transform_bounding_box(unit_box, world, world_boxes[box_index]);
+	}
+	spatial_grid grid;
+	grid.rebuild(world_boxes.get(), box_count);
+	XMFLOAT4X4 view_projection;
+	XMStoreFloat4x4(&view_projection, XMMatrixLookAtLH(XMVectorSet(0, 2, -10, 1), XMVectorSet(0, 0, 0, 1), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XMConvertToRadians(60), 16.0f / 9.0f, 0.1f, 100.0f));
+	std::vector<uint32_t> visible;
+	std::vector<size_t> visible_ids;
+
+	const benchmark_case cases[]
+	{
+		{ "fbx_cache_load", [&]()
+		{
+			std::istringstream iss(cache, std::ios::binary);
+			cereal::BinaryInputArchive deserialization(iss);
+			skeleton bind_pose;
+			std::vector<skinned_vertex> vertices;
+			std::vector<uint32_t> indices;
+			std::vector<animation> animation_clips;
+			deserialization(bind_pose, vertices, indices, animation_clips);
+			errors += vertices.size() == skinned_vertices.size() && animation_clips.size() == scene.animation_clips.size() ? 0 : 1;
+		} },
+		{ "obj_parse", [&]()
+		{
+			parse_obj(obj_text.data(), obj_text.size(), false, parsed_obj);
+			errors += parsed_obj.indices.size() == 300 * 300 * 6 ? 0 : 1;
+		} },
+		{ "fetch_meshes_vertex_build", [&]()
+		{
+			std::vector<skinned_vertex> vertices;
+			std::vector<uint32_t> indices;
+			XMFLOAT3 bounding_box[2];
+			build_skinned_vertices(fbx_mesh, vertices, indices, bounding_box);
+			errors += vertices.size() == fbx_mesh.polygon_vertices.size() ? 0 : 1;
+		} },
+		{ "update_animation", [&]()
+		{
+			for (animation& clip : scene.animation_clips)
+			{
+				for (animation::keyframe& keyframe : clip.sequence)
+				{
+					update_global_transforms(keyframe, scene.parent_indices.data(), sizeof(int64_t));
+				}
+			}
+		} },
+		{ "blend_animations", [&]()
+		{
+			const animation& from{ scene.animation_clips[0] };
+			const animation& to{ scene.animation_clips[1] };
+			for (size_t frame = 0; frame < from.sequence.size(); ++frame)
+			{
+				const animation::keyframe* keyframes[2]{ &from.sequence[frame], &to.sequence[frame] };
+				blend_keyframes(keyframes, static_cast<float>(frame) / from.sequence.size(), blended);
+			}
+			errors += blended.nodes.size() == from.sequence.front().nodes.size() ? 0 : 1;
+		} },
+		{ "keyframe_sampling", [&]()
+		{
+			const animation& clip{ scene.animation_clips[0] };
+			size_t frames{ 0 };
+			for (size_t sample = 0; sample < 1000000; ++sample)
+			{
+				frames += sample_keyframe(clip, sample * 0.0007f) - clip.sequence.data();
+			}
+			sink = frames;
+		} },
+		{ "bone_palette", [&]()
+		{
+			for (const animation& clip : scene.animation_clips)
+			{
+				for (const animation::keyframe& keyframe : clip.sequence)
+				{
+					errors += compute_bone_palette(scene.bind_pose, scene.default_global_transform, keyframe, bone_transforms.data(), bone_transforms.size()) == bone_transforms.size() ? 0 : 1;
+				}
+			}
+		} },
+		{ "sprite_batch_vertices", [&]()
+		{
+			sprite_vertices.clear();
+			for (size_t sprite = 0; sprite < sprite_count; ++sprite)
+			{
+				const float x{ static_cast<float>(sprite % 160) * 8.0f }, y{ static_cast<float>(sprite / 160) * 6.0f };
+				append_sprite_vertices(sprite_vertices, x, y, 16, 16, 1, 1, 1, 1, static_cast<float>(sprite % 360), 0, 0, 64, 64, 1280, 720, 256, 256);
+			}
+			errors += sprite_vertices.size() == sprite_count * SPRITE_VERTEX_COUNT ? 0 : 1;
+		} },
+		{ "geometric_primitives", [&]()
+		{
+			for (int repeat = 0; repeat < 20; ++repeat)
+			{
+				build_cube(shape_vertices, shape_indices);
+				build_cylinder(64, shape_vertices, shape_indices);
+				build_sphere(64, 32, shape_vertices, shape_indices);
+				build_capsule(1.0f, { 0.5f, 0.5f, 0.5f }, 32, 16, 4, shape_vertices, shape_indices);
+			}
+			errors += shape_indices.size() % 3 == 0 ? 0 : 1;
+		} },
+		{ "frustum_culling", [&]()
+		{
+			culler.cull(view_projection, visible);
+		} },
+		{ "grid_frustum_query", [&]()
+		{
+			grid.query_frustum(view_projection, visible_ids);
+		} },
+	};
+
+	std::printf("# engine_benchmark: median milliseconds of %zu runs\n", run_count);
+	size_t regressions{ 0 };
+	std::vector<double> times(run_count);
+	for (const benchmark_case& benchmark : cases)
+	{
+		for (double& time : times)
+		{
+			time = seconds(benchmark.run) * 1000.0;
+		}
+		std::nth_element(times.begin(), times.begin() + run_count / 2, times.end());
+		const double median{ times[run_count / 2] };
+
+		const std::map<std::string, double>::const_iterator expected{ baseline.find(benchmark.name) };
+		if (!baseline_filename)
+		{
+			std::printf("%-28s %12.4f\n", benchmark.name, median);
+		}
+		else if (expected == baseline.end())
+		{
+			std::printf("%-28s %12.4f %12s %8s new\n", benchmark.name, median, "-", "-");
+		}
+		else
+		{
+			const double change{ (median / expected->second - 1.0) * 100.0 };
+			const bool regressed{ change > threshold };
+			regressions += regressed ? 1 : 0;
+			std::printf("%-28s %12.4f %12.4f %+7.1f%% %s\n", benchmark.name, median, expected->second, change, regressed ? "REGRESSION" : "ok");
+		}
+	}
+	std::printf("# regressions: %zu, errors: %zu\n", regressions, errors);
+	return regressions == 0 && errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,91 @@
+// Cost of counting heap allocations, and a check that tagged allocations, explicit device bytes and load scopes are
+// accounted as expected. Build with USE_MEMORY_TRACKING defined for the heap side; without it only the explicit
+// counters are checked.
+//
+// usage: memory_tracker_benchmark [allocations]
+// The load scope builds a decoded copy of a mesh as a temporary, keeps a smaller final copy and frees the temporary,
+// so its peak must exceed what it retains by the size of the temporary.
+
+#include "../memory_tracker.h"
+#include "benchmark_timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+int main(int argc, char* argv[])
+{
+	const size_t allocation_count{ argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000 };
+	memory_tracker& tracker{ default_memory_tracker() };
+	size_t errors{ 0 };
+
+	// new and delete of small blocks, as containers of the loaders do.
+	std::vector<void*> blocks(allocation_count);
+	const double allocation_time{ seconds([&]()
+	{
+		for (void*& block : blocks)
+		{
+			block = ::operator new(48);
+		}
+		for (void* block : blocks)
+		{
+			::operator delete(block);
+		}
+	}) };
+
+	const size_t vertex_bytes{ 1 << 20 }, keyframe_bytes{ 3 << 20 }, temporary_bytes{ 8 << 20 };
+	const int64_t mesh_before{ tracker.current(MEMORY_TAG::MESH_DATA) };
+	const int64_t animation_before{ tracker.current(MEMORY_TAG::ANIMATION) };
+	std::vector<char> vertices, keyframes;
+	{
+		memory_load_scope load("mesh");
+		std::vector<char> decoded;
+		{
+			memory_scope tag(MEMORY_TAG::LOAD_TEMPORARY);
+			decoded.resize(temporary_bytes);
+		}
+		{
+			memory_scope tag(MEMORY_TAG::MESH_DATA);
+			vertices.resize(vertex_bytes);
+		}
+		{
+			memory_scope tag(MEMORY_TAG::ANIMATION);
+			keyframes.resize(keyframe_bytes);
+		}
+	}
+
+	tracker.allocate(MEMORY_TAG::GPU_BUFFERS, 4096);
+	errors += tracker.current(MEMORY_TAG::GPU_BUFFERS) == 4096 ? 0 : 1;
+	tracker.release(MEMORY_TAG::GPU_BUFFERS, 4096);
+	errors += tracker.current(MEMORY_TAG::GPU_BUFFERS) == 0 && tracker.peak(MEMORY_TAG::GPU_BUFFERS) == 4096 ? 0 : 1;
+
+	const std::vector<memory_tracker::load_record> records{ tracker.load_records() };
+	errors += records.size() == 1 && records.front().finished ? 0 : 1;
+#ifdef USE_MEMORY_TRACKING
+	// Small allocations of the scope itself and of the record come on top of the vectors.
+	const int64_t slack{ 4096 };
+	errors += tracker.current(MEMORY_TAG::MESH_DATA) - mesh_before == static_cast<int64_t>(vertex_bytes) ? 0 : 1;
+	errors += tracker.current(MEMORY_TAG::ANIMATION) - animation_before == static_cast<int64_t>(keyframe_bytes) ? 0 : 1;
+	errors += tracker.current(MEMORY_TAG::LOAD_TEMPORARY) == 0 && tracker.peak(MEMORY_TAG::LOAD_TEMPORARY) >= static_cast<int64_t>(temporary_bytes) ? 0 : 1;
+	if (!records.empty())
+	{
+		const memory_tracker::load_record& record{ records.front() };
+		errors += std::llabs(record.retained - static_cast<int64_t>(vertex_bytes + keyframe_bytes)) < slack ? 0 : 1;
+		errors += std::llabs(record.peak - static_cast<int64_t>(vertex_bytes + keyframe_bytes + temporary_bytes)) < slack ? 0 : 1;
+		std::printf("load      : %lld bytes retained, %lld bytes peak\n", static_cast<long long>(record.retained), static_cast<long long>(record.peak));
+	}
+#else
+	(void)mesh_before;
+	(void)animation_before;
+#endif
+
+	for (size_t tag = 0; tag < static_cast<size_t>(MEMORY_TAG::COUNT); ++tag)
+	{
+		std::printf("%-15s: %12lld current, %12lld peak, %10llu allocations\n", memory_tag_name(static_cast<MEMORY_TAG>(tag)), static_cast<long long>(tracker.current(static_cast<MEMORY_TAG>(tag))),
+			static_cast<long long>(tracker.peak(static_cast<MEMORY_TAG>(tag))), static_cast<unsigned long long>(tracker.allocations(static_cast<MEMORY_TAG>(tag))));
+	}
+	std::printf("new/delete: %8.2f ns per pair\n", allocation_time * 1e9 / allocation_count);
+	std::printf("errors: %zu\n", errors);
+	return errors == 0 ? 0 : 1;
+}
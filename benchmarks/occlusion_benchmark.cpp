@@ -0,0 +1,181 @@
+// Software occlusion culling with occlusion_buffer: rasterization time, box test throughput, and a check of the
+// depth buffer against a golden image.
+//
+// usage: occlusion_benchmark [--golden file.pgm | --write-golden file.pgm]
+// The scene is a street between rows of buildings seen from eye height, with small boxes scattered behind them.
+// The depth buffer is compared with (or written to) a 16-bit binary PGM, depth 0..1 mapped to 0..65535.
+// benchmarks/golden/occlusion_depth.pgm is the expected image.
+
+#include "../occlusion_buffer.h"
+#include "benchmark_timer.h"
+
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	// A closed box of 12 triangles.
+	void append_box(const XMFLOAT3& minimum, const XMFLOAT3& maximum, std::vector<XMFLOAT3>& positions, std::vector<uint32_t>& indices)
+	{
+		const uint32_t base{ static_cast<uint32_t>(positions.size()) };
+		for (int corner = 0; corner < 8; ++corner)
+		{
+			positions.push_back({ corner & 1 ? maximum.x : minimum.x, corner & 2 ? maximum.y : minimum.y, corner & 4 ? maximum.z : minimum.z });
+		}
+		const uint32_t faces[6][4]{ { 0, 1, 3, 2 }, { 4, 6, 7, 5 }, { 0, 4, 5, 1 }, { 2, 3, 7, 6 }, { 0, 2, 6, 4 }, { 1, 5, 7, 3 } };
+		for (const uint32_t (&face)[4] : faces)
+		{
+			indices.insert(indices.end(), { base + face[0], base + face[1], base + face[2], base + face[0], base + face[2], base + face[3] });
+		}
+	}
+
+	bool write_pgm(const char* filename, const occlusion_buffer& buffer)
+	{
+		FILE* file{ std::fopen(filename, "wb") };
+		if (!file)
+		{
+			return false;
+		}
+		std::fprintf(file, "P5\n%u %u\n65535\n", buffer.width(), buffer.height());
+		for (float depth : buffer.depth())
+		{
+			const uint32_t value{ static_cast<uint32_t>(std::lround(std::fmin(std::fmax(depth, 0.0f), 1.0f) * 65535.0f)) };
+			const unsigned char bytes[2]{ static_cast<unsigned char>(value >> 8), static_cast<unsigned char>(value & 0xff) };
+			std::fwrite(bytes, 1, 2, file);
+		}
+		std::fclose(file);
+		return true;
+	}
+
+	bool read_pgm(const char* filename, uint32_t& width, uint32_t& height, std::vector<uint16_t>& values)
+	{
+		FILE* file{ std::fopen(filename, "rb") };
+		if (!file)
+		{
+			return false;
+		}
+		unsigned int maximum{ 0 };
+		const bool header{ std::fscanf(file, "P5 %u %u %u", &width, &height, &maximum) == 3 && maximum == 65535 && std::fgetc(file) != EOF };
+		values.resize(static_cast<size_t>(width) * height);
+		bool complete{ header };
+		for (size_t i = 0; complete && i < values.size(); ++i)
+		{
+			const int high{ std::fgetc(file) };
+			const int low{ std::fgetc(file) };
+			complete = high != EOF && low != EOF;
+			values[i] = static_cast<uint16_t>((high << 8) | low);
+		}
+		std::fclose(file);
+		return complete;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const char* golden{ nullptr };
+	const char* write_golden{ nullptr };
+	for (int i = 1; i + 1 < argc; ++i)
+	{
+		if (std::strcmp(argv[i], "--golden") == 0)
+		{
+			golden = argv[++i];
+		}
+		else if (std::strcmp(argv[i], "--write-golden") == 0)
+		{
+			write_golden = argv[++i];
+		}
+	}
+
+	// Occluders: the ground and two rows of buildings along the street, as one mesh.
+	std::vector<XMFLOAT3> positions;
+	std::vector<uint32_t> indices;
+	append_box({ -200, -1, -200 }, { 200, 0, 200 }, positions, indices);
+	for (int block = 0; block < 20; ++block)
+	{
+		const float z{ block * 12.0f };
+		const float height{ 8.0f + static_cast<float>((block * 7) % 5) * 4.0f };
+		append_box({ -16, 0, z }, { -6, height, z + 10 }, positions, indices);
+		append_box({ 6, 0, z }, { 16, height + 2.0f, z + 10 }, positions, indices);
+	}
+	const XMFLOAT4X4 identity{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+	// Objects: small boxes everywhere around the street; those behind the buildings are hidden.
+	std::mt19937 random(3);
+	std::uniform_real_distribution<float> x(-60.0f, 60.0f), z(0.0f, 240.0f), size(0.3f, 2.0f);
+	const size_t object_count{ 20000 };
+	std::vector<XMFLOAT3> boxes(object_count * 2);
+	for (size_t object = 0; object < object_count; ++object)
+	{
+		const XMFLOAT3 center{ x(random), 0.0f, z(random) };
+		const float half{ size(random) };
+		boxes.at(object * 2 + 0) = { center.x - half, 0.0f, center.z - half };
+		boxes.at(object * 2 + 1) = { center.x + half, half * 2.0f, center.z + half };
+	}
+
+	XMFLOAT4X4 view_projection;
+	XMStoreFloat4x4(&view_projection, XMMatrixLookAtLH(XMVectorSet(0, 1.7f, -5, 1), XMVectorSet(2, 1.7f, 10, 1), XMVectorSet(0, 1, 0, 0)) *
+		XMMatrixPerspectiveFovLH(XMConvertToRadians(60), 2.0f, 0.1f, 300.0f));
+
+	occlusion_buffer buffer;
+	const int repeat{ 20 };
+	const double raster_time{ seconds([&]()
+	{
+		for (int i = 0; i < repeat; ++i)
+		{
+			buffer.begin(view_projection);
+			buffer.add_occluder(positions.data(), sizeof(XMFLOAT3), positions.size(), indices.data(), indices.size(), identity);
+			buffer.rasterize();
+		}
+	}) / repeat };
+
+	std::vector<uint8_t> visible(object_count);
+	const double test_time{ seconds([&]() { buffer.test(reinterpret_cast<const XMFLOAT3(*)[2]>(boxes.data()), object_count, visible.data()); }) };
+	size_t visible_count{ 0 };
+	for (uint8_t flag : visible)
+	{
+		visible_count += flag;
+	}
+
+	std::printf("buffer %ux%u, occluder triangles %zu (rasterized %zu, binned %zu)\n", buffer.width(), buffer.height(),
+		buffer.statistics.occluder_triangles, buffer.statistics.rasterized_triangles, buffer.statistics.binned_triangles);
+	std::printf("rasterize : %8.3f ms\n", raster_time * 1000.0);
+	std::printf("box test  : %8.2f ns per box, %zu of %zu visible\n", test_time * 1e9 / static_cast<double>(object_count), visible_count, object_count);
+
+	if (write_golden)
+	{
+		if (!write_pgm(write_golden, buffer))
+		{
+			std::fprintf(stderr, "cannot write %s\n", write_golden);
+			return 1;
+		}
+		std::printf("wrote %s\n", write_golden);
+	}
+	if (golden)
+	{
+		uint32_t width{ 0 }, height{ 0 };
+		std::vector<uint16_t> expected;
+		if (!read_pgm(golden, width, height, expected) || width != buffer.width() || height != buffer.height())
+		{
+			std::fprintf(stderr, "cannot read %s or its size differs\n", golden);
+			return 1;
+		}
+		// Different compilers and math libraries round differently, which moves a few pixels on triangle edges;
+		// everything else must match to a couple of units.
+		size_t differing{ 0 };
+		for (size_t i = 0; i < expected.size(); ++i)
+		{
+			const long value{ std::lround(std::fmin(std::fmax(buffer.depth()[i], 0.0f), 1.0f) * 65535.0f) };
+			differing += std::labs(value - static_cast<long>(expected[i])) > 2 ? 1 : 0;
+		}
+		const bool same{ differing <= expected.size() / 1000 };
+		std::printf("golden %s: %zu pixels differ%s\n", golden, differing, same ? "" : " FAILED");
+		return same ? 0 : 1;
+	}
+	return 0;
+}
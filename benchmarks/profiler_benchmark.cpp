@@ -0,0 +1,110 @@
+// Cost of a profile_scope, and a check that scopes recorded from many threads at once all come out of 'collect' with
+// the right nesting and statistics.
+//
+// usage: profiler_benchmark [frames] [scopes per frame] [trace file]
+// Every frame records 'scopes per frame' outer scopes spread over the thread pool, each with two nested inner scopes,
+// then collects. The window is written as a Chrome trace when a file is given.
+
+#include "../profiler.h"
+#include "../thread_pool.h"
+#include "benchmark_timer.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+	volatile uint32_t sink;
+	void work(uint32_t amount)
+	{
+		uint32_t value{ amount };
+		for (uint32_t i = 0; i < amount; ++i)
+		{
+			value = value * 1664525u + 1013904223u;
+		}
+		sink = value;
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t frame_count{ argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 60 };
+	const size_t scope_count{ argc > 2 ? std::strtoul(argv[2], nullptr, 10) : 2000 };
+	const char* trace_filename{ argc > 3 ? argv[3] : nullptr };
+
+	// Overhead of an empty scope on one thread.
+	const size_t overhead_repeat{ 1000000 };
+	profiler overhead_profiler(overhead_repeat + 1, 1);
+	const double scope_time{ seconds([&]()
+	{
+		for (size_t i = 0; i < overhead_repeat; ++i)
+		{
+			profile_scope scope("empty", overhead_profiler);
+		}
+	}) };
+	overhead_profiler.enabled = false;
+	const double disabled_time{ seconds([&]()
+	{
+		for (size_t i = 0; i < overhead_repeat; ++i)
+		{
+			profile_scope scope("empty", overhead_profiler);
+		}
+	}) };
+
+	thread_pool pool;
+	profiler profiler(scope_count * 3 + 16, frame_count);
+	double frame_time{ 0 };
+	for (size_t frame = 0; frame < frame_count; ++frame)
+	{
+		frame_time += seconds([&]()
+		{
+			profile_scope frame_scope("frame", profiler);
+			pool.parallel_for(scope_count, [&](size_t index)
+			{
+				profile_scope outer("outer", profiler);
+				{
+					profile_scope inner("inner a", profiler);
+					work(200 + static_cast<uint32_t>(index % 7) * 50);
+				}
+				{
+					profile_scope inner("inner b", profiler);
+					work(100);
+				}
+			}, 16);
+		});
+		profiler.collect();
+	}
+
+	std::vector<profiler::scope_statistics> statistics;
+	profiler.statistics(statistics);
+	size_t errors{ profiler.dropped_events() };
+	auto expect = [&](const char* name, size_t count)
+	{
+		for (const profiler::scope_statistics& scope : statistics)
+		{
+			if (scope.name == name)
+			{
+				errors += scope.count != count ? 1 : 0;
+				errors += scope.minimum <= scope.average && scope.average <= scope.maximum && scope.p95 <= scope.p99 && scope.p99 <= scope.maximum ? 0 : 1;
+				std::printf("%-8s: %8zu runs, min %.4f avg %.4f p95 %.4f p99 %.4f max %.4f ms\n", name, scope.count, scope.minimum, scope.average, scope.p95, scope.p99, scope.maximum);
+				return;
+			}
+		}
+		++errors;
+	};
+	expect("frame", frame_count);
+	expect("outer", frame_count * scope_count);
+	expect("inner a", frame_count * scope_count);
+	expect("inner b", frame_count * scope_count);
+
+	if (trace_filename)
+	{
+		errors += profiler.write_chrome_trace(trace_filename) ? 0 : 1;
+	}
+
+	std::printf("scope     : %8.2f ns enabled, %.2f ns disabled\n", scope_time * 1e9 / overhead_repeat, disabled_time * 1e9 / overhead_repeat);
+	std::printf("frames    : %8.3f ms each, %zu scopes on %zu threads\n", frame_time * 1000.0 / frame_count, scope_count * 3 + 1, pool.thread_count() + 1);
+	std::printf("errors: %zu\n", errors);
+	return errors == 0 ? 0 : 1;
+}
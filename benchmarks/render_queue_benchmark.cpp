@@ -0,0 +1,144 @@
+// Building, sorting and replaying a render_queue, with the radix sort checked against std::stable_sort and the binds
+// counted against submitting the same draws in the order they were recorded. The sorted queue is also cut into
+// instance groups, which are checked to cover every draw once with the same mesh and state.
+//
+// usage: render_queue_benchmark [draw count]
+// Draws are spread over a few shaders, a few hundred materials and a thousand meshes, as objects of a level that are
+// visited in scene order.
+
+#include "../render_queue.h"
+#include "benchmark_timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Stands in for the device context: binds and draws are only counted.
+	struct counting_backend
+	{
+		size_t calls{ 0 };
+		void bind_pass(const render_queue::item&) { ++calls; }
+		void bind_shader(const render_queue::item&) { ++calls; }
+		void bind_material(const render_queue::item&) { ++calls; }
+		void bind_mesh(const render_queue::item&) { ++calls; }
+		void draw(const render_queue::item&) { ++calls; }
+		void draw_instanced(const render_queue::instance_group&) { ++calls; }
+	};
+
+	struct draw
+	{
+		uint32_t pass, shader, material, mesh;
+		float depth;
+	};
+
+	void print(const char* label, const render_queue::submit_statistics& statistics)
+	{
+		std::printf("%-9s: %zu draws, %zu pass / %zu shader / %zu material / %zu mesh binds\n", label, statistics.draws,
+			statistics.pass_changes, statistics.shader_changes, statistics.material_changes, statistics.mesh_changes);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t draw_count{ argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 100000 };
+
+	// Every mesh has its own shader and a material of that shader, as a model loaded once and drawn many times.
+	std::mt19937 random(7);
+	std::uniform_int_distribution<uint32_t> mesh_distribution(0, 999), pass_distribution(0, 9);
+	std::uniform_real_distribution<float> depth_distribution(0.1f, 500.0f);
+	std::vector<draw> draws(draw_count);
+	for (draw& draw : draws)
+	{
+		draw.mesh = mesh_distribution(random);
+		draw.shader = draw.mesh % 6;
+		draw.material = draw.mesh % 300;
+		draw.pass = pass_distribution(random) == 0 ? 1 : 0;
+		draw.depth = depth_distribution(random);
+	}
+
+	render_queue queue;
+	queue.reserve(draw_count);
+	const int repeat{ 20 };
+	double build_time{ 0 }, sort_time{ 0 };
+	for (int i = 0; i < repeat; ++i)
+	{
+		build_time += seconds([&]()
+		{
+			queue.clear();
+			for (size_t draw_index = 0; draw_index < draws.size(); ++draw_index)
+			{
+				const draw& draw{ draws.at(draw_index) };
+				queue.push(render_queue::make_key(draw.pass, draw.shader, draw.material, draw.mesh, draw.depth, draw.pass == 1), static_cast<uint32_t>(draw_index));
+			}
+		});
+		if (i == 0)
+		{
+			counting_backend backend;
+			print("unsorted", queue.submit(backend));
+		}
+		sort_time += seconds([&]() { queue.sort(); });
+	}
+
+	// The reference order. Both sorts are stable, so the draw indices must match too.
+	std::vector<render_queue::item> reference;
+	for (size_t draw_index = 0; draw_index < draws.size(); ++draw_index)
+	{
+		const draw& draw{ draws.at(draw_index) };
+		reference.push_back({ render_queue::make_key(draw.pass, draw.shader, draw.material, draw.mesh, draw.depth, draw.pass == 1), static_cast<uint32_t>(draw_index) });
+	}
+	const double std_sort_time{ seconds([&]()
+	{
+		std::stable_sort(reference.begin(), reference.end(), [](const render_queue::item& a, const render_queue::item& b) { return a.key < b.key; });
+	}) };
+	size_t mismatches{ 0 };
+	for (size_t i = 0; i < reference.size(); ++i)
+	{
+		mismatches += queue.items().at(i).key != reference.at(i).key || queue.items().at(i).draw != reference.at(i).draw ? 1 : 0;
+	}
+
+	counting_backend backend;
+	render_queue::submit_statistics statistics;
+	const double submit_time{ seconds([&]() { statistics = queue.submit(backend); }) };
+	print("sorted", statistics);
+
+	std::printf("build     : %8.3f ms\n", build_time * 1000.0 / repeat);
+	std::printf("sort      : %8.3f ms (std::stable_sort %.3f ms)\n", sort_time * 1000.0 / repeat, std_sort_time * 1000.0);
+	std::printf("submit    : %8.3f ms (%zu backend calls)\n", submit_time * 1000.0, backend.calls);
+	std::printf("order mismatches against std::stable_sort: %zu\n", mismatches);
+
+	// A mesh's geometry is named by the address of its slot in 'meshes'; the few draws of mesh 0 stay single.
+	const std::vector<char> meshes(1000);
+	const uint32_t max_instances{ 256 };
+	std::vector<render_queue::instance_group> groups;
+	const double group_time{ seconds([&]()
+	{
+		queue.group_instances([&](const render_queue::item& item) -> const void*
+		{
+			const uint32_t mesh{ draws.at(item.draw).mesh };
+			return mesh == 0 ? nullptr : &meshes.at(mesh);
+		}, max_instances, groups);
+	}) };
+	size_t group_errors{ 0 }, covered{ 0 };
+	for (const render_queue::instance_group& group : groups)
+	{
+		group_errors += group.first != covered || group.count == 0 || group.count > max_instances ? 1 : 0;
+		const draw& first{ draws.at(queue.items().at(group.first).draw) };
+		for (uint32_t index = group.first; index < group.first + group.count; ++index)
+		{
+			const draw& draw{ draws.at(queue.items().at(index).draw) };
+			group_errors += draw.pass != first.pass || draw.shader != first.shader || draw.material != first.material || draw.mesh != first.mesh ? 1 : 0;
+		}
+		group_errors += first.mesh == 0 && group.count != 1 ? 1 : 0;
+		covered += group.count;
+	}
+	group_errors += covered != queue.size() ? 1 : 0;
+
+	counting_backend instanced_backend;
+	print("instanced", queue.submit(instanced_backend, groups));
+	std::printf("grouping  : %8.3f ms (%zu groups, %zu backend calls, errors %zu)\n", group_time * 1000.0, groups.size(), instanced_backend.calls, group_errors);
+	return mismatches == 0 && group_errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,240 @@
+// state_filtering_context against a mock context: random call streams are sent both straight to one mock and through
+// the filter to another, and the state each mock ends up with must be the same after every call. Then the call pattern
+// of drawing models subset by subset is replayed to count how many calls the filter drops and what that costs.
+//
+// usage: state_filter_benchmark [call count]
+
+#include "../render_context.h"
+#include "benchmark_timer.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace
+{
+	// Keeps what a device context would have bound and counts the calls it receives.
+	class mock_context : public render_context
+	{
+	public:
+		struct state
+		{
+			const void* input_layout{ nullptr };
+			uint32_t topology{ 0 };
+			const void* vertex_buffers[32]{};
+			uint32_t strides[32]{};
+			uint32_t offsets[32]{};
+			const void* index_buffer{ nullptr };
+			uint32_t index_format{ 0 };
+			uint32_t index_offset{ 0 };
+			const void* vertex_shader{ nullptr };
+			const void* pixel_shader{ nullptr };
+			const void* vs_constant_buffers[14]{};
+			const void* ps_constant_buffers[14]{};
+			const void* vs_shader_resources[128]{};
+			const void* ps_shader_resources[128]{};
+			const void* ps_samplers[16]{};
+			const void* blend_state{ nullptr };
+			float blend_factor[4]{ 1, 1, 1, 1 };
+			uint32_t sample_mask{ 0xffffffff };
+			const void* depth_stencil_state{ nullptr };
+			uint32_t stencil_ref{ 0 };
+			const void* rasterizer_state{ nullptr };
+		};
+		state state;
+		size_t calls{ 0 };
+		size_t draws{ 0 };
+
+		void IASetInputLayout(ID3D11InputLayout* input_layout) override { ++calls; state.input_layout = input_layout; }
+		void IASetPrimitiveTopology(uint32_t topology) override { ++calls; state.topology = topology; }
+		void IASetVertexBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* vertex_buffers, const uint32_t* strides, const uint32_t* offsets) override
+		{
+			++calls;
+			for (uint32_t index = 0; index < num_buffers; ++index)
+			{
+				state.vertex_buffers[start_slot + index] = vertex_buffers[index];
+				state.strides[start_slot + index] = strides[index];
+				state.offsets[start_slot + index] = offsets[index];
+			}
+		}
+		void IASetIndexBuffer(ID3D11Buffer* index_buffer, uint32_t format, uint32_t offset) override
+		{
+			++calls;
+			state.index_buffer = index_buffer;
+			state.index_format = format;
+			state.index_offset = offset;
+		}
+		void VSSetShader(ID3D11VertexShader* vertex_shader) override { ++calls; state.vertex_shader = vertex_shader; }
+		void PSSetShader(ID3D11PixelShader* pixel_shader) override { ++calls; state.pixel_shader = pixel_shader; }
+		void VSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) override { ++calls; copy(state.vs_constant_buffers, start_slot, num_buffers, constant_buffers); }
+		void PSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) override { ++calls; copy(state.ps_constant_buffers, start_slot, num_buffers, constant_buffers); }
+		void VSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) override { ++calls; copy(state.vs_shader_resources, start_slot, num_views, shader_resource_views); }
+		void PSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) override { ++calls; copy(state.ps_shader_resources, start_slot, num_views, shader_resource_views); }
+		void PSSetSamplers(uint32_t start_slot, uint32_t num_samplers, ID3D11SamplerState* const* sampler_states) override { ++calls; copy(state.ps_samplers, start_slot, num_samplers, sampler_states); }
+		void OMSetBlendState(ID3D11BlendState* blend_state, const float blend_factor[4], uint32_t sample_mask) override
+		{
+			++calls;
+			state.blend_state = blend_state;
+			const float white[4]{ 1, 1, 1, 1 };
+			std::memcpy(state.blend_factor, blend_factor ? blend_factor : white, sizeof(state.blend_factor));
+			state.sample_mask = sample_mask;
+		}
+		void OMSetDepthStencilState(ID3D11DepthStencilState* depth_stencil_state, uint32_t stencil_ref) override
+		{
+			++calls;
+			state.depth_stencil_state = depth_stencil_state;
+			state.stencil_ref = stencil_ref;
+		}
+		void RSSetState(ID3D11RasterizerState* rasterizer_state) override { ++calls; state.rasterizer_state = rasterizer_state; }
+		void UpdateSubresource(ID3D11Resource*, uint32_t, const D3D11_BOX*, const void*, uint32_t, uint32_t) override { ++calls; }
+		long Map(ID3D11Resource*, uint32_t, uint32_t, uint32_t, D3D11_MAPPED_SUBRESOURCE*) override { ++calls; return -1; }
+		void Unmap(ID3D11Resource*, uint32_t) override { ++calls; }
+		void DrawIndexed(uint32_t, uint32_t, int32_t) override { ++calls; ++draws; }
+		void DrawIndexedInstanced(uint32_t, uint32_t, uint32_t, int32_t, uint32_t) override { ++calls; ++draws; }
+
+	private:
+		template<class T, size_t N>
+		static void copy(const void* (&slots)[N], uint32_t start_slot, uint32_t count, T* const* values)
+		{
+			for (uint32_t index = 0; index < count; ++index)
+			{
+				slots[start_slot + index] = values[index];
+			}
+		}
+	};
+
+	// Fake object addresses; only their identity matters.
+	template<class T>
+	T* handle(uint32_t value)
+	{
+		return reinterpret_cast<T*>(static_cast<uintptr_t>(value + 1) * 16);
+	}
+
+	// One random call with arguments from a small set, so that many are redundant.
+	void random_call(render_context& context, std::mt19937& random)
+	{
+		std::uniform_int_distribution<uint32_t> value(0, 2), slot(0, 20), count(1, 4);
+		const uint32_t start{ slot(random) };
+		const uint32_t slot_count{ count(random) };
+		ID3D11Buffer* buffers[4]{ handle<ID3D11Buffer>(value(random)), handle<ID3D11Buffer>(value(random)), handle<ID3D11Buffer>(value(random)), handle<ID3D11Buffer>(value(random)) };
+		switch (std::uniform_int_distribution<int>(0, 13)(random))
+		{
+		case 0: context.IASetInputLayout(handle<ID3D11InputLayout>(value(random))); break;
+		case 1: context.IASetPrimitiveTopology(value(random)); break;
+		case 2:
+		{
+			const uint32_t strides[4]{ 32, 32, value(random) * 16, 32 };
+			const uint32_t offsets[4]{};
+			context.IASetVertexBuffers(start % 12, slot_count, buffers, strides, offsets);
+			break;
+		}
+		case 3: context.IASetIndexBuffer(buffers[0], value(random), 0); break;
+		case 4: context.VSSetShader(handle<ID3D11VertexShader>(value(random))); break;
+		case 5: context.PSSetShader(handle<ID3D11PixelShader>(value(random))); break;
+		case 6: context.VSSetConstantBuffers(start % 11, slot_count, buffers); break;
+		case 7: context.PSSetConstantBuffers(start % 11, slot_count, buffers); break;
+		case 8:
+		{
+			ID3D11ShaderResourceView* views[4]{ handle<ID3D11ShaderResourceView>(value(random)), handle<ID3D11ShaderResourceView>(value(random)), nullptr, nullptr };
+			context.PSSetShaderResources(start, slot_count, views);
+			break;
+		}
+		case 9:
+		{
+			ID3D11SamplerState* samplers[4]{ handle<ID3D11SamplerState>(value(random)), handle<ID3D11SamplerState>(value(random)), nullptr, nullptr };
+			context.PSSetSamplers(start % 12, slot_count, samplers);
+			break;
+		}
+		case 10:
+		{
+			const float factor[4]{ 1, 1, 1, static_cast<float>(value(random)) };
+			context.OMSetBlendState(handle<ID3D11BlendState>(value(random)), value(random) == 0 ? nullptr : factor, 0xffffffff);
+			break;
+		}
+		case 12:
+		{
+			ID3D11ShaderResourceView* views[4]{ handle<ID3D11ShaderResourceView>(value(random)), nullptr, handle<ID3D11ShaderResourceView>(value(random)), nullptr };
+			context.VSSetShaderResources(start, slot_count, views);
+			break;
+		}
+		case 11: context.OMSetDepthStencilState(handle<ID3D11DepthStencilState>(value(random)), value(random)); break;
+		default: context.RSSetState(handle<ID3D11RasterizerState>(value(random))); break;
+		}
+	}
+
+	// The calls skinned_mesh::render made for every subset before the draw list: the whole pipeline, then the material.
+	void draw_subset(render_context& context, uint32_t model, uint32_t mesh, uint32_t material)
+	{
+		const uint32_t stride{ 32 }, offset{ 0 };
+		ID3D11Buffer* vertex_buffer{ handle<ID3D11Buffer>(100 + mesh) };
+		ID3D11Buffer* constant_buffer{ handle<ID3D11Buffer>(200 + model) };
+		ID3D11ShaderResourceView* views[2]{ handle<ID3D11ShaderResourceView>(material * 2), handle<ID3D11ShaderResourceView>(material * 2 + 1) };
+		context.IASetVertexBuffers(0, 1, &vertex_buffer, &stride, &offset);
+		context.IASetIndexBuffer(handle<ID3D11Buffer>(300 + mesh), 42, 0);
+		context.IASetPrimitiveTopology(4);
+		context.IASetInputLayout(handle<ID3D11InputLayout>(model));
+		context.VSSetShader(handle<ID3D11VertexShader>(model));
+		context.PSSetShader(handle<ID3D11PixelShader>(model));
+		context.UpdateSubresource(nullptr, 0, nullptr, nullptr, 0, 0);
+		context.VSSetConstantBuffers(0, 1, &constant_buffer);
+		context.PSSetShaderResources(0, 1, &views[0]);
+		context.PSSetShaderResources(1, 1, &views[1]);
+		context.DrawIndexed(36, 0, 0);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t call_count{ argc > 1 ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : 200000 };
+
+	// Correctness: both mocks must hold the same state after every call, including after invalidation.
+	mock_context direct, behind_filter;
+	state_filtering_context filter(behind_filter);
+	std::mt19937 random_direct(11), random_filtered(11);
+	size_t mismatches{ 0 };
+	for (size_t call = 0; call < call_count; ++call)
+	{
+		random_call(direct, random_direct);
+		random_call(filter, random_filtered);
+		if (call % 5000 == 4999)
+		{
+			filter.invalidate();
+		}
+		mismatches += std::memcmp(&direct.state, &behind_filter.state, sizeof(mock_context::state)) != 0 ? 1 : 0;
+	}
+	std::printf("random calls: %zu, forwarded %zu, filtered %zu, state mismatches %zu\n", call_count, behind_filter.calls, filter.statistics.filtered, mismatches);
+
+	// The subset pattern: 50 objects of 4 models, 3 meshes of 2 subsets each, visited model by model as a sorted list would.
+	mock_context unfiltered, counted;
+	state_filtering_context subset_filter(counted);
+	const int frames{ 2000 };
+	const auto frame = [](render_context& context)
+	{
+		for (uint32_t object = 0; object < 50; ++object)
+		{
+			const uint32_t model{ object / 13 };
+			for (uint32_t mesh = 0; mesh < 3; ++mesh)
+			{
+				for (uint32_t subset = 0; subset < 2; ++subset)
+				{
+					draw_subset(context, model, model * 3 + mesh, model * 6 + mesh * 2 + subset);
+				}
+			}
+		}
+	};
+	const double unfiltered_time{ seconds([&]() { for (int i = 0; i < frames; ++i) frame(unfiltered); }) };
+	const double filtered_time{ seconds([&]() { for (int i = 0; i < frames; ++i) { subset_filter.invalidate(); frame(subset_filter); } }) };
+	std::printf("subset pattern per frame: %zu calls unfiltered, %zu after filtering (%zu state calls filtered)\n",
+		unfiltered.calls / frames, counted.calls / frames, subset_filter.statistics.filtered / frames);
+	std::printf("time per frame: %.3f us unfiltered, %.3f us through the filter\n", unfiltered_time * 1e6 / frames, filtered_time * 1e6 / frames);
+	// A mock takes no time per call, so here the filter can only cost. On a device each dropped call saves its driver
+	// work; the filter pays for itself once that work is above this.
+	const double dropped_calls{ static_cast<double>(subset_filter.statistics.filtered) };
+	std::printf("break-even driver cost: %.2f ns per dropped state call\n", std::max<double>(filtered_time - unfiltered_time, 0.0) * 1e9 / dropped_calls);
+	const bool same_state{ std::memcmp(&unfiltered.state, &counted.state, sizeof(mock_context::state)) == 0 && unfiltered.draws == counted.draws };
+	std::printf("final state %s\n", same_state ? "matches" : "DIFFERS");
+	return mismatches == 0 && same_state ? 0 : 1;
+}
@@ -0,0 +1,257 @@
+// Static batching with merge_static_batch, checked against a naive instance-by-instance transform.
+//
+// usage: static_batch_benchmark [instance count] [chunk size]
+// A few patch meshes with several material ranges each (one of them empty) are scattered over a 400 m square with
+// random rotations and scales. The check rebuilds what every chunk should hold from the sources alone: which
+// instances fall in it, one draw per material in increasing order, the indices of each draw rebased by the
+// position of their instance in the merged vertex array, and the world bounds of its instances.
+
+#include "../static_batcher.h"
+#include "benchmark_timer.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <random>
+#include <tuple>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	struct patch
+	{
+		std::vector<batch_vertex> vertices;
+		std::vector<uint32_t> indices;
+		std::vector<batch_source::range> ranges;
+	};
+
+	// A 'size' x 'size' quad grid in the xz plane whose rows of quads are split into bands, one range per band.
+	// A band with no rows gives an empty range.
+	patch make_patch(uint32_t size, const std::vector<std::pair<uint32_t, uint32_t>>& bands /* material, rows */)
+	{
+		patch patch;
+		for (uint32_t z = 0; z <= size; ++z)
+		{
+			for (uint32_t x = 0; x <= size; ++x)
+			{
+				const float u{ static_cast<float>(x) / size }, v{ static_cast<float>(z) / size };
+				patch.vertices.push_back({ { u - 0.5f, 0.1f * std::sin(u * 6.0f), v - 0.5f }, { 0.0f, 1.0f, 0.0f }, { u, v } });
+			}
+		}
+		uint32_t row{ 0 };
+		for (const std::pair<uint32_t, uint32_t>& band : bands)
+		{
+			batch_source::range range;
+			range.material = band.first;
+			range.index_start = static_cast<uint32_t>(patch.indices.size());
+			for (uint32_t last_row = std::min<uint32_t>(row + band.second, size); row < last_row; ++row)
+			{
+				for (uint32_t x = 0; x < size; ++x)
+				{
+					const uint32_t i{ row * (size + 1) + x };
+					const uint32_t quad[6]{ i, i + size + 1, i + 1, i + 1, i + size + 1, i + size + 2 };
+					patch.indices.insert(patch.indices.end(), quad, quad + 6);
+				}
+			}
+			range.index_count = static_cast<uint32_t>(patch.indices.size()) - range.index_start;
+			patch.ranges.push_back(range);
+		}
+		return patch;
+	}
+
+	// The reference transform: plain row-vector arithmetic, one vertex at a time.
+	XMFLOAT3 transform_point(const XMFLOAT3& p, const XMFLOAT4X4& m)
+	{
+		const float w{ p.x * m._14 + p.y * m._24 + p.z * m._34 + m._44 };
+		return { (p.x * m._11 + p.y * m._21 + p.z * m._31 + m._41) / w, (p.x * m._12 + p.y * m._22 + p.z * m._32 + m._42) / w, (p.x * m._13 + p.y * m._23 + p.z * m._33 + m._43) / w };
+	}
+	XMFLOAT3 transform_normal(const XMFLOAT3& n, const XMFLOAT4X4& m)
+	{
+		const XMFLOAT3 t{ n.x * m._11 + n.y * m._21 + n.z * m._31, n.x * m._12 + n.y * m._22 + n.z * m._32, n.x * m._13 + n.y * m._23 + n.z * m._33 };
+		const float length{ std::sqrt(t.x * t.x + t.y * t.y + t.z * t.z) };
+		return { t.x / length, t.y / length, t.z / length };
+	}
+	bool nearly_equal(const XMFLOAT3& a, const XMFLOAT3& b)
+	{
+		auto close = [](float x, float y) { return std::fabs(x - y) <= 1e-4f * (1.0f + std::fabs(y)); };
+		return close(a.x, b.x) && close(a.y, b.y) && close(a.z, b.z);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	const size_t instance_count{ argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 5000 };
+	const float chunk_size{ argc > 2 ? static_cast<float>(std::atof(argv[2])) : 32.0f };
+
+	const patch patches[3]
+	{
+		make_patch(8, { { 0, 4 }, { 1, 4 } }),
+		make_patch(16, { { 3, 5 }, { 1, 6 }, { 3, 5 } }),
+		make_patch(4, { { 2, 4 }, { 0, 0 } }),
+	};
+
+	std::mt19937 random(11);
+	std::uniform_real_distribution<float> position(-200.0f, 200.0f);
+	std::uniform_real_distribution<float> angle(-XM_PI, XM_PI);
+	std::uniform_real_distribution<float> size(0.5f, 6.0f);
+	std::vector<batch_source> sources(instance_count);
+	for (batch_source& source : sources)
+	{
+		const patch& patch{ patches[random() % 3] };
+		source.vertices = patch.vertices.data();
+		source.vertex_count = patch.vertices.size();
+		source.indices = patch.indices.data();
+		source.ranges = patch.ranges;
+		XMStoreFloat4x4(&source.world, XMMatrixScaling(size(random), size(random), size(random)) *
+			XMMatrixRotationRollPitchYaw(angle(random), angle(random), angle(random)) *
+			XMMatrixTranslation(position(random), position(random) * 0.05f, position(random)));
+	}
+
+	batch_geometry geometry;
+	const int repeat{ 5 };
+	const double merge_time{ seconds([&]() { for (int i = 0; i < repeat; ++i) { merge_static_batch(sources.data(), sources.size(), chunk_size, geometry); } }) / repeat };
+
+	// Reference: every instance transformed on its own, with its world bounds and chunk.
+	std::vector<std::vector<batch_vertex>> transformed(instance_count);
+	std::vector<XMFLOAT3> bounds(instance_count * 2);
+	std::map<std::tuple<int32_t, int32_t, int32_t>, std::vector<size_t>> expected_chunks;
+	const double naive_time{ seconds([&]()
+	{
+		for (size_t source_index = 0; source_index < instance_count; ++source_index)
+		{
+			const batch_source& source{ sources[source_index] };
+			XMFLOAT3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX }, maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+			for (size_t vertex_index = 0; vertex_index < source.vertex_count; ++vertex_index)
+			{
+				const batch_vertex& vertex{ source.vertices[vertex_index] };
+				const XMFLOAT3 p{ transform_point(vertex.position, source.world) };
+				transformed[source_index].push_back({ p, transform_normal(vertex.normal, source.world), vertex.texcoord });
+				minimum = { std::min<float>(minimum.x, p.x), std::min<float>(minimum.y, p.y), std::min<float>(minimum.z, p.z) };
+				maximum = { std::max<float>(maximum.x, p.x), std::max<float>(maximum.y, p.y), std::max<float>(maximum.z, p.z) };
+			}
+			bounds[source_index * 2 + 0] = minimum;
+			bounds[source_index * 2 + 1] = maximum;
+		}
+	}) };
+	for (size_t source_index = 0; source_index < instance_count; ++source_index)
+	{
+		const XMFLOAT3& minimum{ bounds[source_index * 2 + 0] };
+		const XMFLOAT3& maximum{ bounds[source_index * 2 + 1] };
+		auto cell = [chunk_size](float a, float b) { return static_cast<int32_t>(std::floor((a + b) * 0.5f / chunk_size)); };
+		expected_chunks[std::make_tuple(cell(minimum.x, maximum.x), cell(minimum.y, maximum.y), cell(minimum.z, maximum.z))].push_back(source_index);
+	}
+
+	size_t errors{ 0 };
+	auto fail = [&errors](const char* what, size_t chunk_index)
+	{
+		if (errors++ < 10)
+		{
+			std::printf("chunk %zu: %s\n", chunk_index, what);
+		}
+	};
+
+	// Chunk assignment: chunks come in cell order and hold their instances' vertices in input order.
+	if (geometry.chunks.size() != expected_chunks.size())
+	{
+		fail("chunk count differs", geometry.chunks.size());
+	}
+	std::vector<uint32_t> first_vertices(instance_count, 0);
+	uint32_t vertex_count{ 0 };
+	uint32_t index_count{ 0 };
+	size_t chunk_index{ 0 };
+	for (const std::pair<const std::tuple<int32_t, int32_t, int32_t>, std::vector<size_t>>& expected : expected_chunks)
+	{
+		if (chunk_index >= geometry.chunks.size())
+		{
+			break;
+		}
+		const batch_geometry::chunk& chunk{ geometry.chunks[chunk_index] };
+
+		XMFLOAT3 minimum{ FLT_MAX, FLT_MAX, FLT_MAX }, maximum{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		std::map<uint32_t, std::vector<uint32_t>> material_indices;
+		for (size_t source_index : expected.second)
+		{
+			const batch_source& source{ sources[source_index] };
+			first_vertices[source_index] = vertex_count;
+			for (size_t vertex_index = 0; vertex_index < source.vertex_count; ++vertex_index)
+			{
+				const batch_vertex& merged{ geometry.vertices.at(vertex_count + vertex_index) };
+				const batch_vertex& reference{ transformed[source_index][vertex_index] };
+				if (!nearly_equal(merged.position, reference.position) || !nearly_equal(merged.normal, reference.normal) ||
+					merged.texcoord.x != reference.texcoord.x || merged.texcoord.y != reference.texcoord.y)
+				{
+					fail("vertex of an instance is not in its chunk's place", chunk_index);
+					break;
+				}
+			}
+			vertex_count += static_cast<uint32_t>(source.vertex_count);
+
+			// Index rebasing: each range moves by where its instance starts in the merged vertex array.
+			for (const batch_source::range& range : source.ranges)
+			{
+				std::vector<uint32_t>& indices{ material_indices[range.material] };
+				for (uint32_t index = 0; index < range.index_count; ++index)
+				{
+					indices.push_back(source.indices[range.index_start + index] + first_vertices[source_index]);
+				}
+			}
+
+			const XMFLOAT3& source_minimum{ bounds[source_index * 2 + 0] };
+			const XMFLOAT3& source_maximum{ bounds[source_index * 2 + 1] };
+			minimum = { std::min<float>(minimum.x, source_minimum.x), std::min<float>(minimum.y, source_minimum.y), std::min<float>(minimum.z, source_minimum.z) };
+			maximum = { std::max<float>(maximum.x, source_maximum.x), std::max<float>(maximum.y, source_maximum.y), std::max<float>(maximum.z, source_maximum.z) };
+		}
+
+		// Per-chunk bounds.
+		if (!nearly_equal(chunk.bounding_box[0], minimum) || !nearly_equal(chunk.bounding_box[1], maximum))
+		{
+			fail("bounds differ from the bounds of its instances", chunk_index);
+		}
+
+		// Material merging: one draw per material with indices, in increasing material order, packed back to back.
+		size_t draw_index{ chunk.first_draw };
+		for (const std::pair<const uint32_t, std::vector<uint32_t>>& material : material_indices)
+		{
+			if (material.second.empty())
+			{
+				continue;
+			}
+			if (draw_index >= chunk.first_draw + chunk.draw_count || draw_index >= geometry.draws.size())
+			{
+				fail("a material has no draw", chunk_index);
+				break;
+			}
+			const batch_geometry::draw& draw{ geometry.draws[draw_index++] };
+			if (draw.material != material.first || draw.index_start != index_count || draw.index_count != material.second.size())
+			{
+				fail("draws are not one per material in order", chunk_index);
+			}
+			else if (!std::equal(material.second.begin(), material.second.end(), geometry.indices.begin() + draw.index_start))
+			{
+				fail("indices are not rebased to the instance's vertices", chunk_index);
+			}
+			index_count += static_cast<uint32_t>(material.second.size());
+		}
+		if (draw_index != chunk.first_draw + chunk.draw_count)
+		{
+			fail("draw count differs from its material count", chunk_index);
+		}
+		++chunk_index;
+	}
+	if (geometry.vertices.size() != vertex_count || geometry.indices.size() != index_count)
+	{
+		fail("merged arrays have a different size", geometry.chunks.size());
+	}
+
+	std::printf("instances %zu, chunk size %.1f: chunks %zu, draws %zu, vertices %zu, indices %zu\n", instance_count, chunk_size,
+		geometry.chunks.size(), geometry.draws.size(), geometry.vertices.size(), geometry.indices.size());
+	std::printf("merge_static_batch          : %8.2f ms\n", merge_time * 1e3);
+	std::printf("per-instance naive transform: %8.2f ms\n", naive_time * 1e3);
+	std::printf("errors: %zu\n", errors);
+	return errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <vector>
+
+#include "render_queue.h"
+#include "thread_pool.h"
+
+// The draws recorded by one thread: packets of the caller's type, a side array of payload that packets refer into by
+// offset (bone matrices, constants), and render_queue keys whose shader, material and mesh fields are ids from the
+// buffer's own tables, so that threads never share anything while they record. 'merge' joins the buffers of a frame.
+// No Direct3D dependency.
+template<class Packet, class Payload>
+class command_buffer
+{
+public:
+	std::vector<Packet> packets;
+	std::vector<Payload> payload;
+	render_queue queue;
+	render_id_table shader_ids;
+	render_id_table material_ids;
+	render_id_table mesh_ids;
+
+	void clear()
+	{
+		packets.clear();
+		payload.clear();
+		queue.clear();
+		shader_ids.clear();
+		material_ids.clear();
+		mesh_ids.clear();
+	}
+	bool empty() const { return packets.empty(); }
+
+	void push(uint64_t key, const Packet& packet)
+	{
+		queue.push(key, static_cast<uint32_t>(packets.size()));
+		packets.push_back(packet);
+	}
+
+	// Replaces this buffer by 'buffers' joined as if everything had been recorded here in buffer order: ids are
+	// renumbered in order of first use over all of them and the queue comes out sorted, equal keys in recording
+	// order. The payload is not copied, since it usually goes straight to the GPU: packets refer to the payload of
+	// all buffers one after the other, which 'gather_payload' writes out. 'rebase(packet, payload_offset)' moves
+	// the payload references of a copied packet by the offset of its buffer's payload. The buffers are re-keyed
+	// and sorted in place, one task per buffer on 'pool'.
+	template<class Rebase>
+	void merge(command_buffer* const* buffers, size_t buffer_count, Rebase&& rebase, thread_pool& pool)
+	{
+		clear();
+
+		// Renumbering visits the distinct states of each buffer, not its draws, so it stays on this thread.
+		struct id_map
+		{
+			std::vector<uint32_t> shaders;
+			std::vector<uint32_t> materials;
+			std::vector<uint32_t> meshes;
+			uint32_t packet_offset;
+			uint32_t payload_offset;
+		};
+		std::vector<id_map> id_maps(buffer_count);
+		size_t packet_count{ 0 };
+		size_t payload_count{ 0 };
+		for (size_t buffer_index = 0; buffer_index < buffer_count; ++buffer_index)
+		{
+			const command_buffer& buffer{ *buffers[buffer_index] };
+			id_map& id_map{ id_maps.at(buffer_index) };
+			renumber(buffer.shader_ids, shader_ids, id_map.shaders);
+			renumber(buffer.material_ids, material_ids, id_map.materials);
+			renumber(buffer.mesh_ids, mesh_ids, id_map.meshes);
+			id_map.packet_offset = static_cast<uint32_t>(packet_count);
+			id_map.payload_offset = static_cast<uint32_t>(payload_count);
+			packet_count += buffer.packets.size();
+			payload_count += buffer.payload.size();
+		}
+
+		packets.resize(packet_count);
+		pool.parallel_for(buffer_count, [&](size_t buffer_index)
+		{
+			command_buffer& buffer{ *buffers[buffer_index] };
+			const id_map& id_map{ id_maps.at(buffer_index) };
+			buffer.queue.transform_keys([&id_map](uint64_t key)
+			{
+				return render_queue::replace_ids(key, id_map.shaders[render_queue::shader_of(key)], id_map.materials[render_queue::material_of(key)], id_map.meshes[render_queue::mesh_of(key)]);
+			});
+			buffer.queue.sort();
+
+			for (size_t packet_index = 0; packet_index < buffer.packets.size(); ++packet_index)
+			{
+				Packet& packet{ packets[id_map.packet_offset + packet_index] };
+				packet = buffer.packets[packet_index];
+				rebase(packet, id_map.payload_offset);
+			}
+		});
+
+		std::vector<const render_queue*> queues;
+		std::vector<uint32_t> draw_offsets;
+		for (size_t buffer_index = 0; buffer_index < buffer_count; ++buffer_index)
+		{
+			queues.push_back(&buffers[buffer_index]->queue);
+			draw_offsets.push_back(id_maps.at(buffer_index).packet_offset);
+		}
+		queue.merge(queues.data(), draw_offsets.data(), queues.size());
+	}
+
+	// The payload of 'buffers' one after the other, as merged packets refer to it. 'destination' must have room for
+	// payload_size elements.
+	static size_t payload_size(const command_buffer* const* buffers, size_t buffer_count)
+	{
+		size_t size{ 0 };
+		for (size_t buffer_index = 0; buffer_index < buffer_count; ++buffer_index)
+		{
+			size += buffers[buffer_index]->payload.size();
+		}
+		return size;
+	}
+	static void gather_payload(const command_buffer* const* buffers, size_t buffer_count, Payload* destination)
+	{
+		for (size_t buffer_index = 0; buffer_index < buffer_count; ++buffer_index)
+		{
+			destination = std::copy(buffers[buffer_index]->payload.begin(), buffers[buffer_index]->payload.end(), destination);
+		}
+	}
+
+private:
+	static void renumber(const render_id_table& local_ids, render_id_table& ids, std::vector<uint32_t>& map)
+	{
+		map.resize(local_ids.size());
+		for (uint32_t local_id = 0; local_id < local_ids.size(); ++local_id)
+		{
+			const std::pair<const void*, const void*>& state{ local_ids.state(local_id) };
+			map[local_id] = ids.id(state.first, state.second);
+		}
+	}
+};
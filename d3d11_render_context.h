@@ -0,0 +1,55 @@
+#pragma once
+
+#include <d3d11.h>
+
+#include "render_context.h"
+
+// render_context over a real device context; every call is forwarded as it is.
+class d3d11_render_context : public render_context
+{
+public:
+	explicit d3d11_render_context(ID3D11DeviceContext* immediate_context) : immediate_context(immediate_context) {}
+
+	// State calls forwarded to the device context so far. Updates, maps and draws are not counted.
+	size_t state_calls{ 0 };
+
+	void IASetInputLayout(ID3D11InputLayout* input_layout) override { ++state_calls; immediate_context->IASetInputLayout(input_layout); }
+	void IASetPrimitiveTopology(uint32_t topology) override { ++state_calls; immediate_context->IASetPrimitiveTopology(static_cast<D3D11_PRIMITIVE_TOPOLOGY>(topology)); }
+	void IASetVertexBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* vertex_buffers, const uint32_t* strides, const uint32_t* offsets) override
+	{
+		++state_calls;
+		immediate_context->IASetVertexBuffers(start_slot, num_buffers, vertex_buffers, strides, offsets);
+	}
+	void IASetIndexBuffer(ID3D11Buffer* index_buffer, uint32_t format, uint32_t offset) override { ++state_calls; immediate_context->IASetIndexBuffer(index_buffer, static_cast<DXGI_FORMAT>(format), offset); }
+
+	void VSSetShader(ID3D11VertexShader* vertex_shader) override { ++state_calls; immediate_context->VSSetShader(vertex_shader, nullptr, 0); }
+	void PSSetShader(ID3D11PixelShader* pixel_shader) override { ++state_calls; immediate_context->PSSetShader(pixel_shader, nullptr, 0); }
+	void VSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) override { ++state_calls; immediate_context->VSSetConstantBuffers(start_slot, num_buffers, constant_buffers); }
+	void PSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) override { ++state_calls; immediate_context->PSSetConstantBuffers(start_slot, num_buffers, constant_buffers); }
+	void VSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) override { ++state_calls; immediate_context->VSSetShaderResources(start_slot, num_views, shader_resource_views); }
+	void PSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) override { ++state_calls; immediate_context->PSSetShaderResources(start_slot, num_views, shader_resource_views); }
+	void PSSetSamplers(uint32_t start_slot, uint32_t num_samplers, ID3D11SamplerState* const* sampler_states) override { ++state_calls; immediate_context->PSSetSamplers(start_slot, num_samplers, sampler_states); }
+
+	void OMSetBlendState(ID3D11BlendState* blend_state, const float blend_factor[4], uint32_t sample_mask) override { ++state_calls; immediate_context->OMSetBlendState(blend_state, blend_factor, sample_mask); }
+	void OMSetDepthStencilState(ID3D11DepthStencilState* depth_stencil_state, uint32_t stencil_ref) override { ++state_calls; immediate_context->OMSetDepthStencilState(depth_stencil_state, stencil_ref); }
+	void RSSetState(ID3D11RasterizerState* rasterizer_state) override { ++state_calls; immediate_context->RSSetState(rasterizer_state); }
+
+	void UpdateSubresource(ID3D11Resource* resource, uint32_t subresource, const D3D11_BOX* box, const void* data, uint32_t row_pitch, uint32_t depth_pitch) override
+	{
+		immediate_context->UpdateSubresource(resource, subresource, box, data, row_pitch, depth_pitch);
+	}
+	long Map(ID3D11Resource* resource, uint32_t subresource, uint32_t map_type, uint32_t map_flags, D3D11_MAPPED_SUBRESOURCE* mapped_subresource) override
+	{
+		return immediate_context->Map(resource, subresource, static_cast<D3D11_MAP>(map_type), map_flags, mapped_subresource);
+	}
+	void Unmap(ID3D11Resource* resource, uint32_t subresource) override { immediate_context->Unmap(resource, subresource); }
+	void DrawIndexed(uint32_t index_count, uint32_t start_index_location, int32_t base_vertex_location) override { immediate_context->DrawIndexed(index_count, start_index_location, base_vertex_location); }
+
+	void DrawIndexedInstanced(uint32_t index_count_per_instance, uint32_t instance_count, uint32_t start_index_location, int32_t base_vertex_location, uint32_t start_instance_location) override
+	{
+		immediate_context->DrawIndexedInstanced(index_count_per_instance, instance_count, start_index_location, base_vertex_location, start_instance_location);
+	}
+
+private:
+	ID3D11DeviceContext* immediate_context;
+};
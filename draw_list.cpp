@@ -0,0 +1,430 @@
+#include "draw_list.h"
+
+#include "misc.h"
+#include "d3d11_render_context.h"
+#include "thread_pool.h"
+#include "profiler.h"
+
+#include <algorithm>
+#include <initializer_list>
+
+using namespace DirectX;
+
+draw_list::draw_list(ID3D11Device* device) : device(device), recorders(default_thread_pool().thread_count() + 1), skinned_constants(std::make_unique<skinned_mesh::constants>())
+{
+}
+
+void draw_list::begin(const XMFLOAT4& camera_position)
+{
+	for (recorder& recorder : recorders)
+	{
+		recorder.camera_position = camera_position;
+		recorder.buffer.clear();
+	}
+}
+
+void draw_list::record(size_t count, const std::function<void(size_t, recorder&)>& record)
+{
+	PROFILE_SCOPE("record draws");
+	if (!parallel_recording)
+	{
+		for (size_t index = 0; index < count; ++index)
+		{
+			record(index, serial_recorder());
+		}
+		return;
+	}
+	default_thread_pool().parallel_for(recorders.size(), [&](size_t slice)
+	{
+		const size_t first{ count * slice / recorders.size() };
+		const size_t last{ count * (slice + 1) / recorders.size() };
+		PROFILE_SCOPE("record draw slice");
+		for (size_t index = first; index < last; ++index)
+		{
+			record(index, recorders.at(slice));
+		}
+	});
+}
+
+size_t draw_list::size() const
+{
+	size_t size{ 0 };
+	for (const recorder& recorder : recorders)
+	{
+		size += recorder.buffer.packets.size();
+	}
+	return size;
+}
+
+void draw_list::recorder::add(const skinned_mesh& model, const XMFLOAT4X4& world, const XMFLOAT4& material_color, const animation::keyframe* keyframe, PASS pass)
+{
+	std::vector<XMFLOAT4X4>& bone_palettes{ buffer.payload };
+	const bool posed{ keyframe && keyframe->nodes.size() > 0 };
+	const uint32_t shader{ buffer.shader_ids.id(&model) };
+	for (size_t mesh_index = 0; mesh_index < model.meshes.size(); ++mesh_index)
+	{
+		const skinned_mesh::mesh& mesh{ model.meshes.at(mesh_index) };
+
+		packet packet;
+		packet.skinned_model = &model;
+		packet.part = static_cast<uint32_t>(mesh_index);
+		const XMFLOAT4X4& mesh_transform{ posed ? keyframe->nodes.at(mesh.node_index).global_transform : mesh.default_global_transform };
+		XMStoreFloat4x4(&packet.world, XMLoadFloat4x4(&mesh_transform) * XMLoadFloat4x4(&world));
+
+		// The palette is shared by the subsets of the mesh. A mesh without bones still reads bone 0.
+		packet.palette_offset = static_cast<uint32_t>(bone_palettes.size());
+		const size_t bone_count{ std::max<size_t>(std::min<size_t>(mesh.bind_pose.bones.size(), skinned_mesh::MAX_BONES), 1) };
+		bone_palettes.resize(bone_palettes.size() + bone_count, { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 });
+		if (posed)
+		{
+			skinned_mesh::compute_bone_transforms(mesh, *keyframe, bone_palettes.data() + packet.palette_offset);
+		}
+		packet.palette_size = static_cast<uint32_t>(bone_count);
+
+		const uint32_t mesh_id{ buffer.mesh_ids.id(&mesh) };
+		for (size_t subset_index = 0; subset_index < mesh.subsets.size(); ++subset_index)
+		{
+			const skinned_mesh::mesh::subset& subset{ mesh.subsets.at(subset_index) };
+			packet.subset = static_cast<uint32_t>(subset_index);
+			packet.skinned_material = &model.materials.at(subset.material_unique_id);
+			XMStoreFloat4(&packet.material_color, XMLoadFloat4(&material_color) * XMLoadFloat4(&packet.skinned_material->Kd));
+			push(packet, pass, shader, buffer.material_ids.id(packet.skinned_material), mesh_id);
+		}
+	}
+}
+
+void draw_list::recorder::add(const static_mesh& model, const XMFLOAT4X4& world, const XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader, PASS pass)
+{
+	packet packet;
+	packet.static_model = &model;
+	packet.replaced_pixel_shader = replaced_pixel_shader;
+	packet.world = world;
+
+	const uint32_t shader{ buffer.shader_ids.id(&model, replaced_pixel_shader) };
+	const uint32_t mesh{ buffer.mesh_ids.id(&model) };
+	const std::vector<static_mesh::draw_range>& draw_ranges{ model.draws() };
+	for (size_t draw_index = 0; draw_index < draw_ranges.size(); ++draw_index)
+	{
+		packet.part = static_cast<uint32_t>(draw_index);
+		const static_mesh::material& material{ model.materials.at(draw_ranges.at(draw_index).material_index) };
+		XMStoreFloat4(&packet.material_color, XMLoadFloat4(&material_color) * XMLoadFloat4(&material.Kd));
+		push(packet, pass, shader, buffer.material_ids.id(&material), mesh);
+	}
+}
+
+void draw_list::recorder::add(const geometric_primitive& model, const XMFLOAT4X4& world, const XMFLOAT4& material_color, PASS pass)
+{
+	packet packet;
+	packet.primitive_model = &model;
+	packet.world = world;
+	packet.material_color = material_color;
+	push(packet, pass, buffer.shader_ids.id(&model), buffer.material_ids.id(nullptr), buffer.mesh_ids.id(&model));
+}
+
+void draw_list::recorder::push(const packet& packet, PASS pass, uint32_t shader, uint32_t material, uint32_t mesh)
+{
+	// A truncated id would let two states share a key field and skip a bind that is needed.
+	_ASSERT_EXPR(shader < (1u << render_queue::SHADER_BITS) && material < (1u << render_queue::MATERIAL_BITS) && mesh < (1u << render_queue::MESH_BITS), L"Too many distinct states in one draw_list");
+
+	const float depth{ XMVectorGetX(XMVector3Length(XMVectorSet(packet.world._41, packet.world._42, packet.world._43, 1) - XMLoadFloat4(&camera_position))) };
+	const bool back_to_front{ pass == PASS::BLENDED_OBJECTS };
+	buffer.push(render_queue::make_key(static_cast<uint32_t>(pass), shader, material, mesh, depth, back_to_front), packet);
+}
+
+const void* draw_list::geometry(const packet& packet)
+{
+	if (packet.skinned_model)
+	{
+		return &packet.skinned_model->meshes.at(packet.part).subsets.at(packet.subset);
+	}
+	if (packet.static_model)
+	{
+		return &packet.static_model->draws().at(packet.part);
+	}
+	return nullptr;
+}
+
+// Binds and draws the packets that render_queue::submit hands over. With 'instanced', meshes use their instanced
+// pipelines and read world, color and bones from the instance and palette buffers.
+struct draw_list::backend
+{
+	draw_list& list;
+	render_context& context;
+	const std::function<void(PASS, render_context&)>& begin_pass;
+	bool instanced;
+
+	void bind_pass(const render_queue::item& item)
+	{
+		if (begin_pass)
+		{
+			begin_pass(static_cast<PASS>(render_queue::pass_of(item.key)), context);
+		}
+	}
+	void bind_shader(const render_queue::item& item)
+	{
+		const packet& packet{ list.merged.packets.at(item.draw) };
+		if (packet.skinned_model)
+		{
+			instanced ? packet.skinned_model->bind_instanced_pipeline(context) : packet.skinned_model->bind_pipeline(context);
+		}
+		else if (packet.static_model)
+		{
+			instanced ? packet.static_model->bind_instanced_pipeline(context, packet.replaced_pixel_shader) : packet.static_model->bind_pipeline(context, packet.replaced_pixel_shader);
+		}
+		else
+		{
+			packet.primitive_model->bind_pipeline(context);
+		}
+	}
+	void bind_material(const render_queue::item& item)
+	{
+		const packet& packet{ list.merged.packets.at(item.draw) };
+		if (packet.skinned_model)
+		{
+			packet.skinned_model->bind_material(context, *packet.skinned_material);
+		}
+		else if (packet.static_model)
+		{
+			packet.static_model->bind_material(context, packet.static_model->draws().at(packet.part).material_index);
+		}
+	}
+	void bind_mesh(const render_queue::item& item)
+	{
+		const packet& packet{ list.merged.packets.at(item.draw) };
+		if (packet.skinned_model)
+		{
+			packet.skinned_model->bind_mesh(context, packet.skinned_model->meshes.at(packet.part));
+		}
+		else if (packet.static_model)
+		{
+			packet.static_model->bind_mesh(context);
+		}
+		else
+		{
+			packet.primitive_model->bind_mesh(context);
+		}
+	}
+	void draw(const render_queue::item& item)
+	{
+		const packet& packet{ list.merged.packets.at(item.draw) };
+		if (packet.skinned_model)
+		{
+			skinned_mesh::constants& data{ *list.skinned_constants };
+			data.world = packet.world;
+			data.material_color = packet.material_color;
+			std::copy_n(list.merged.payload.data() + packet.palette_offset, packet.palette_size, data.bone_transforms);
+			const skinned_mesh::mesh& mesh{ packet.skinned_model->meshes.at(packet.part) };
+			packet.skinned_model->draw(context, mesh.subsets.at(packet.subset), data);
+		}
+		else if (packet.static_model)
+		{
+			packet.static_model->draw(context, packet.static_model->draws().at(packet.part), packet.world, packet.material_color);
+		}
+		else
+		{
+			packet.primitive_model->draw(context, packet.world, packet.material_color);
+		}
+	}
+	void draw_instanced(const render_queue::instance_group& group)
+	{
+		const render_queue::item& item{ list.merged.queue.items().at(group.first) };
+		const packet& packet{ list.merged.packets.at(item.draw) };
+		if (packet.skinned_model)
+		{
+			const skinned_mesh::mesh& mesh{ packet.skinned_model->meshes.at(packet.part) };
+			packet.skinned_model->draw_instanced(context, mesh.subsets.at(packet.subset), group.count, group.first);
+		}
+		else if (packet.static_model)
+		{
+			packet.static_model->draw_instanced(context, packet.static_model->draws().at(packet.part), group.count, group.first);
+		}
+		else
+		{
+			draw(item);
+		}
+	}
+};
+
+void draw_list::prepare(render_context& context)
+{
+	PROFILE_SCOPE("merge draws");
+	std::vector<packet_buffer*> buffers;
+	for (recorder& recorder : recorders)
+	{
+		buffers.push_back(&recorder.buffer);
+	}
+	merged.merge(buffers.data(), buffers.size(), [](packet& packet, uint32_t payload_offset) { packet.palette_offset += payload_offset; }, default_thread_pool());
+	_ASSERT_EXPR(merged.shader_ids.size() <= (1u << render_queue::SHADER_BITS) && merged.material_ids.size() <= (1u << render_queue::MATERIAL_BITS) && merged.mesh_ids.size() <= (1u << render_queue::MESH_BITS), L"Too many distinct states in one draw_list");
+
+	const size_t palette_size{ packet_buffer::payload_size(buffers.data(), buffers.size()) };
+	if (!instancing)
+	{
+		// Each draw copies its palette into the constant buffer.
+		merged.payload.resize(palette_size);
+		packet_buffer::gather_payload(buffers.data(), buffers.size(), merged.payload.data());
+		return;
+	}
+
+	merged.queue.group_instances([this](const render_queue::item& item) { return geometry(merged.packets.at(item.draw)); }, max_instances, instance_groups);
+
+	instances.clear();
+	instances.reserve(merged.queue.size());
+	for (const render_queue::item& item : merged.queue.items())
+	{
+		const packet& packet{ merged.packets.at(item.draw) };
+		instances.push_back({ packet.world, packet.material_color, packet.palette_offset });
+	}
+	instance_buffer.upload(device.Get(), context, instances.data(), instances.size());
+	// The palettes go from the recorders straight to the GPU.
+	if (void* palettes{ palette_buffer.map(device.Get(), context, palette_size) })
+	{
+		packet_buffer::gather_payload(buffers.data(), buffers.size(), static_cast<XMFLOAT4X4*>(palettes));
+		palette_buffer.unmap(context);
+	}
+}
+
+void draw_list::bind_instance_buffers(render_context& context)
+{
+	uint32_t stride{ sizeof(draw_instance) };
+	uint32_t offset{ 0 };
+	context.IASetVertexBuffers(1, 1, instance_buffer.buffer.GetAddressOf(), &stride, &offset);
+	context.VSSetShaderResources(0, 1, palette_buffer.shader_resource_view.GetAddressOf());
+}
+
+void draw_list::submit(render_context& context, const std::function<void(PASS, render_context&)>& begin_pass)
+{
+	PROFILE_SCOPE("submit draws");
+	prepare(context);
+	backend backend{ *this, context, begin_pass, instancing };
+	if (!instancing)
+	{
+		statistics = merged.queue.submit(backend);
+		return;
+	}
+	bind_instance_buffers(context);
+	statistics = merged.queue.submit(backend, instance_groups);
+}
+
+// The state a deferred context starts from: what the immediate context has bound when submit_deferred is called.
+// The getters add a reference to every object they return, released when this goes away.
+struct draw_list::frame_state
+{
+	ID3D11RenderTargetView* render_target_views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT]{};
+	ID3D11DepthStencilView* depth_stencil_view{ nullptr };
+	D3D11_VIEWPORT viewports[D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE]{};
+	UINT viewport_count{ D3D11_VIEWPORT_AND_SCISSORRECT_OBJECT_COUNT_PER_PIPELINE };
+	ID3D11Buffer* vs_constant_buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT]{};
+	ID3D11Buffer* ps_constant_buffers[D3D11_COMMONSHADER_CONSTANT_BUFFER_API_SLOT_COUNT]{};
+	ID3D11SamplerState* ps_samplers[D3D11_COMMONSHADER_SAMPLER_SLOT_COUNT]{};
+	ID3D11BlendState* blend_state{ nullptr };
+	FLOAT blend_factor[4]{};
+	UINT sample_mask{ 0 };
+	ID3D11DepthStencilState* depth_stencil_state{ nullptr };
+	UINT stencil_ref{ 0 };
+	ID3D11RasterizerState* rasterizer_state{ nullptr };
+
+	explicit frame_state(ID3D11DeviceContext* immediate_context)
+	{
+		immediate_context->OMGetRenderTargets(ARRAYSIZE(render_target_views), render_target_views, &depth_stencil_view);
+		immediate_context->RSGetViewports(&viewport_count, viewports);
+		immediate_context->VSGetConstantBuffers(0, ARRAYSIZE(vs_constant_buffers), vs_constant_buffers);
+		immediate_context->PSGetConstantBuffers(0, ARRAYSIZE(ps_constant_buffers), ps_constant_buffers);
+		immediate_context->PSGetSamplers(0, ARRAYSIZE(ps_samplers), ps_samplers);
+		immediate_context->OMGetBlendState(&blend_state, blend_factor, &sample_mask);
+		immediate_context->OMGetDepthStencilState(&depth_stencil_state, &stencil_ref);
+		immediate_context->RSGetState(&rasterizer_state);
+	}
+	~frame_state()
+	{
+		release(render_target_views);
+		release(vs_constant_buffers);
+		release(ps_constant_buffers);
+		release(ps_samplers);
+		for (IUnknown* object : std::initializer_list<IUnknown*>{ depth_stencil_view, blend_state, depth_stencil_state, rasterizer_state })
+		{
+			if (object) object->Release();
+		}
+	}
+	frame_state(const frame_state&) = delete;
+	frame_state& operator=(const frame_state&) = delete;
+
+	void apply(ID3D11DeviceContext* deferred_context) const
+	{
+		deferred_context->OMSetRenderTargets(ARRAYSIZE(render_target_views), render_target_views, depth_stencil_view);
+		deferred_context->RSSetViewports(viewport_count, viewports);
+		deferred_context->VSSetConstantBuffers(0, ARRAYSIZE(vs_constant_buffers), vs_constant_buffers);
+		deferred_context->PSSetConstantBuffers(0, ARRAYSIZE(ps_constant_buffers), ps_constant_buffers);
+		deferred_context->PSSetSamplers(0, ARRAYSIZE(ps_samplers), ps_samplers);
+		deferred_context->OMSetBlendState(blend_state, blend_factor, sample_mask);
+		deferred_context->OMSetDepthStencilState(depth_stencil_state, stencil_ref);
+		deferred_context->RSSetState(rasterizer_state);
+	}
+
+	template<class T, size_t N>
+	static void release(T* (&objects)[N])
+	{
+		for (T* object : objects)
+		{
+			if (object) object->Release();
+		}
+	}
+};
+
+void draw_list::submit_deferred(ID3D11DeviceContext* immediate_context, const std::function<void(PASS, render_context&)>& begin_pass)
+{
+	d3d11_render_context context{ immediate_context };
+	if (!instancing)
+	{
+		submit(context, begin_pass);
+		return;
+	}
+	PROFILE_SCOPE("submit draws deferred");
+	prepare(context);
+
+	HRESULT hr{ S_OK };
+	const size_t range_count{ std::min<size_t>(recorders.size(), instance_groups.size()) };
+	deferred_contexts.resize(std::max<size_t>(deferred_contexts.size(), range_count));
+	for (size_t range = 0; range < range_count; ++range)
+	{
+		if (!deferred_contexts.at(range).context)
+		{
+			hr = device->CreateDeferredContext(0, deferred_contexts.at(range).context.GetAddressOf());
+			_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+		}
+	}
+
+	const frame_state state{ immediate_context };
+	default_thread_pool().parallel_for(range_count, [&](size_t range)
+	{
+		PROFILE_SCOPE("replay draw range");
+		deferred_context& deferred{ deferred_contexts.at(range) };
+		state.apply(deferred.context.Get());
+
+		d3d11_render_context deferred_render_context{ deferred.context.Get() };
+		state_filtering_context filtered_context{ deferred_render_context };
+		render_context& replay_context{ state_filtering ? static_cast<render_context&>(filtered_context) : deferred_render_context };
+		bind_instance_buffers(replay_context);
+		backend backend{ *this, replay_context, begin_pass, true };
+		const size_t first{ instance_groups.size() * range / range_count };
+		const size_t last{ instance_groups.size() * (range + 1) / range_count };
+		deferred.statistics = merged.queue.submit(backend, instance_groups.data() + first, last - first);
+
+		HRESULT hr{ deferred.context->FinishCommandList(FALSE, deferred.command_list.ReleaseAndGetAddressOf()) };
+		_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+	});
+
+	statistics = {};
+	for (size_t range = 0; range < range_count; ++range)
+	{
+		deferred_context& deferred{ deferred_contexts.at(range) };
+		immediate_context->ExecuteCommandList(deferred.command_list.Get(), TRUE);
+		deferred.command_list.Reset();
+
+		statistics.draws += deferred.statistics.draws;
+		statistics.instances += deferred.statistics.instances;
+		statistics.pass_changes += deferred.statistics.pass_changes;
+		statistics.shader_changes += deferred.statistics.shader_changes;
+		statistics.material_changes += deferred.statistics.material_changes;
+		statistics.mesh_changes += deferred.statistics.mesh_changes;
+	}
+}
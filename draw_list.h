@@ -0,0 +1,152 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl.h>
+#include <directxmath.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "render_queue.h"
+#include "command_buffer.h"
+#include "skinned_mesh.h"
+#include "static_mesh.h"
+#include "geometric_primitive.h"
+#include "instance_buffer.h"
+
+// Draws of skinned meshes, static meshes and geometric primitives recorded through render_queue instead of going
+// straight to the context. Each draw becomes a packet with everything it needs (world matrix, color, bone palette),
+// and 'submit' sorts the keys and replays the packets, binding pipelines, buffers and textures only where they change.
+// With 'instancing', sorted draws of the same mesh subset in the same state are drawn as one instanced draw: worlds and
+// colors go to a per-instance vertex buffer and bone palettes to a structured buffer, both rewritten by 'submit'.
+// Geometric primitives are always drawn one by one.
+// Draws are recorded into one command buffer per thread of default_thread_pool (see 'record'), which 'submit' merges
+// in sort-key order into a single submission.
+class draw_list
+{
+private:
+	struct packet
+	{
+		// Exactly one of the models is set.
+		const skinned_mesh* skinned_model{ nullptr };
+		const static_mesh* static_model{ nullptr };
+		const geometric_primitive* primitive_model{ nullptr };
+
+		uint32_t part{ 0 }; // mesh index of a skinned_mesh, draws() index of a static_mesh
+		uint32_t subset{ 0 }; // subset index within the mesh of a skinned_mesh
+		const skinned_mesh::material* skinned_material{ nullptr };
+		ID3D11PixelShader* replaced_pixel_shader{ nullptr };
+
+		DirectX::XMFLOAT4X4 world; // for a skinned_mesh, already multiplied by the global transform of its mesh
+		DirectX::XMFLOAT4 material_color; // for a skinned_mesh or static_mesh, already multiplied by the Kd of its material
+
+		uint32_t palette_offset{ 0 }; // first bone transform in the payload of the command buffer
+		uint32_t palette_size{ 0 };
+	};
+	using packet_buffer = command_buffer<packet, DirectX::XMFLOAT4X4>;
+
+public:
+	// Passes are drawn in this order. 'submit' calls 'begin_pass' before the first draw of each so the caller can set
+	// its blend, depth and rasterizer states on the context it is given.
+	enum class PASS : uint32_t { OPAQUE_OBJECTS, BLENDED_OBJECTS };
+
+	// Adds draws to one command buffer. Each thread recording at the same time needs its own.
+	class recorder
+	{
+	public:
+		// One draw per subset of every mesh, in the pose of 'keyframe' (nullptr: bind pose).
+		void add(const skinned_mesh& model, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, const animation::keyframe* keyframe, PASS pass = PASS::OPAQUE_OBJECTS);
+		// One draw per entry of the draw list of the mesh.
+		void add(const static_mesh& model, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader = nullptr, PASS pass = PASS::OPAQUE_OBJECTS);
+		void add(const geometric_primitive& model, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, PASS pass = PASS::OPAQUE_OBJECTS);
+
+	private:
+		friend class draw_list;
+		packet_buffer buffer;
+		DirectX::XMFLOAT4 camera_position{ 0, 0, 0, 1 };
+
+		void push(const packet& packet, PASS pass, uint32_t shader, uint32_t material, uint32_t mesh);
+	};
+
+	explicit draw_list(ID3D11Device* device);
+
+	bool instancing{ true };
+	// Longer runs of the same subset are split into several instanced draws.
+	uint32_t max_instances{ 1024 };
+	// Without it 'record' calls back on the calling thread only.
+	bool parallel_recording{ true };
+	// Whether 'submit_deferred' replays through a state_filtering_context; 'submit' uses the context it is given.
+	bool state_filtering{ false };
+
+	// Forgets the previous frame. The depth of a draw is the distance from 'camera_position' to its origin.
+	void begin(const DirectX::XMFLOAT4& camera_position);
+
+	// Records on the calling thread, into the first command buffer.
+	recorder& serial_recorder() { return recorders.front(); }
+	void add(const skinned_mesh& model, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, const animation::keyframe* keyframe, PASS pass = PASS::OPAQUE_OBJECTS)
+	{
+		serial_recorder().add(model, world, material_color, keyframe, pass);
+	}
+	void add(const static_mesh& model, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader = nullptr, PASS pass = PASS::OPAQUE_OBJECTS)
+	{
+		serial_recorder().add(model, world, material_color, replaced_pixel_shader, pass);
+	}
+	void add(const geometric_primitive& model, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, PASS pass = PASS::OPAQUE_OBJECTS)
+	{
+		serial_recorder().add(model, world, material_color, pass);
+	}
+
+	// Calls 'record(index, recorder)' for every index in [0, count), splitting the range into one contiguous slice per
+	// command buffer and recording the slices on the thread pool. 'record' must only touch what belongs to its index.
+	// Since slices are merged in order, the frame comes out as if 'record' had been called for every index here.
+	void record(size_t count, const std::function<void(size_t, recorder&)>& record);
+
+	// Merges, sorts and draws everything recorded since 'begin'. With 'instancing', vertex buffer slot 1 and vertex
+	// shader resource slot t0 are left bound to the instance and palette buffers.
+	void submit(render_context& context, const std::function<void(PASS, render_context&)>& begin_pass = nullptr);
+	// The same, with the draws split into one contiguous range per command buffer, each replayed on a deferred
+	// context on the thread pool and then executed on 'immediate_context' in order. A deferred context starts from
+	// the render targets, viewports, constant buffers, samplers and output merger and rasterizer states bound to
+	// 'immediate_context' now, whose state is kept. Without 'instancing' this is 'submit' on 'immediate_context'.
+	void submit_deferred(ID3D11DeviceContext* immediate_context, const std::function<void(PASS, render_context&)>& begin_pass = nullptr);
+
+	size_t size() const;
+	// What the last submit bound and drew.
+	render_queue::submit_statistics statistics;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+
+	std::vector<recorder> recorders;
+	// The recorders joined by 'submit'. Its payload is only gathered when bone palettes are read on the CPU.
+	packet_buffer merged;
+
+	// skinned_mesh::constants is too large for the stack of every draw.
+	std::unique_ptr<skinned_mesh::constants> skinned_constants;
+
+	// Instance i is the packet of sorted item i, so each group's instances start at its first item.
+	std::vector<render_queue::instance_group> instance_groups;
+	std::vector<draw_instance> instances;
+	dynamic_buffer instance_buffer{ D3D11_BIND_VERTEX_BUFFER, sizeof(draw_instance) };
+	dynamic_buffer palette_buffer{ D3D11_BIND_SHADER_RESOURCE, sizeof(DirectX::XMFLOAT4X4) };
+
+	struct deferred_context
+	{
+		Microsoft::WRL::ComPtr<ID3D11DeviceContext> context;
+		Microsoft::WRL::ComPtr<ID3D11CommandList> command_list;
+		render_queue::submit_statistics statistics;
+	};
+	std::vector<deferred_context> deferred_contexts;
+
+	// What an instanced draw of 'packet' covers; nullptr for packets that are never instanced.
+	static const void* geometry(const packet& packet);
+
+	// Merges the recorders into 'merged' and, with 'instancing', groups and uploads the instances and palettes.
+	void prepare(render_context& context);
+	void bind_instance_buffers(render_context& context);
+
+	struct backend;
+	struct frame_state;
+};
@@ -1,187 +1,246 @@
-#pragma once
-
-#include <windows.h>
-#include <tchar.h>
-#include <sstream>
-#include <memory>
-
-#include "misc.h"
-#include "high_resolution_timer.h"
-#include "Scene.h"
-#include "ResourceManager.h" // ǉ
-
-#ifdef USE_IMGUI
-#include "imgui/imgui.h"
-#include "imgui/imgui_internal.h"
-#include "imgui/imgui_impl_dx11.h"
-#include "imgui/imgui_impl_win32.h"
-extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
-extern ImWchar glyphRangesJapanese[];
-#endif
-
-#include <d3d11.h>
-#include <wrl.h>
-
-CONST LONG SCREEN_WIDTH{ 1280 };
-CONST LONG SCREEN_HEIGHT{ 720 };
-CONST BOOL FULLSCREEN{ FALSE };
-CONST LPWSTR APPLICATION_NAME{ L"X3DGP" };
-
-class framework
-{
-public:
-	CONST HWND hwnd;
-
-	Microsoft::WRL::ComPtr<ID3D11Device> device;
-	Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate_context;
-	Microsoft::WRL::ComPtr<IDXGISwapChain> swap_chain;
-	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> render_target_view;
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depth_stencil_view;
-
-	enum class SAMPLER_STATE { POINT, LINEAR, ANISOTROPIC, LINEAR_BORDER_BLACK, LINEAR_BORDER_WHITE };
-	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler_states[5];
-
-	enum class DEPTH_STATE { ZT_ON_ZW_ON, ZT_ON_ZW_OFF, ZT_OFF_ZW_ON, ZT_OFF_ZW_OFF };
-	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depth_stencil_states[4];
-
-	enum class BLEND_STATE { NONE, ALPHA, ADD, MULTIPLY };
-	Microsoft::WRL::ComPtr<ID3D11BlendState> blend_states[4];
-
-	enum class RASTER_STATE { SOLID, WIREFRAME, CULL_NONE, WIREFRAME_CULL_NONE };
-	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer_states[4];
-
-	std::unique_ptr<Scene> current_scene;
-	std::unique_ptr<ResourceManager> resource_manager; // ǉ
-
-	framework(HWND hwnd);
-	~framework();
-
-	template <typename T>
-	void change_scene()
-	{
-		if (current_scene)
-		{
-			current_scene->finalize(this);
-		}
-		current_scene = std::make_unique<T>();
-		current_scene->initialize(this);
-	}
-
-	framework(const framework&) = delete;
-	framework& operator=(const framework&) = delete;
-	framework(framework&&) noexcept = delete;
-	framework& operator=(framework&&) noexcept = delete;
-
-	int run()
-	{
-		MSG msg{};
-
-		if (!initialize())
-		{
-			return 0;
-		}
-
-#ifdef USE_IMGUI
-		IMGUI_CHECKVERSION();
-		ImGui::CreateContext();
-		ImGui::GetIO().Fonts->AddFontFromFileTTF("C:\\Windows\\Fonts\\consola.ttf", 14.0f, nullptr, glyphRangesJapanese);
-		ImGui_ImplWin32_Init(hwnd);
-		ImGui_ImplDX11_Init(device.Get(), immediate_context.Get());
-		ImGui::StyleColorsDark();
-#endif
-
-		while (WM_QUIT != msg.message)
-		{
-			if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
-			{
-				TranslateMessage(&msg);
-				DispatchMessage(&msg);
-			}
-			else
-			{
-				tictoc.tick();
-				calculate_frame_stats();
-				update(tictoc.time_interval());
-				render(tictoc.time_interval());
-			}
-		}
-
-#ifdef USE_IMGUI
-		ImGui_ImplDX11_Shutdown();
-		ImGui_ImplWin32_Shutdown();
-		ImGui::DestroyContext();
-#endif
-
-		BOOL fullscreen{};
-		swap_chain->GetFullscreenState(&fullscreen, 0);
-		if (fullscreen)
-		{
-			swap_chain->SetFullscreenState(FALSE, 0);
-		}
-
-		return uninitialize() ? static_cast<int>(msg.wParam) : 0;
-	}
-
-	LRESULT CALLBACK handle_message(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
-	{
-#ifdef USE_IMGUI
-		if (ImGui_ImplWin32_WndProcHandler(hwnd, msg, wparam, lparam)) { return true; }
-#endif
-		switch (msg)
-		{
-		case WM_PAINT:
-		{
-			PAINTSTRUCT ps;
-			BeginPaint(hwnd, &ps);
-
-			EndPaint(hwnd, &ps);
-			break;
-		}
-		case WM_DESTROY:
-			PostQuitMessage(0);
-			break;
-		case WM_CREATE:
-			break;
-		case WM_KEYDOWN:
-			if (wparam == VK_ESCAPE)
-			{
-				PostMessage(hwnd, WM_CLOSE, 0, 0);
-			}
-			break;
-		case WM_ENTERSIZEMOVE:
-			tictoc.stop();
-			break;
-		case WM_EXITSIZEMOVE:
-			tictoc.start();
-			break;
-		default:
-			return DefWindowProc(hwnd, msg, wparam, lparam);
-		}
-		return 0;
-	}
-
-private:
-	bool initialize();
-	void update(float elapsed_time);
-	void render(float elapsed_time);
-	bool uninitialize();
-
-private:
-	high_resolution_timer tictoc;
-	uint32_t frames{ 0 };
-	float elapsed_time{ 0.0f };
-	void calculate_frame_stats()
-	{
-		if (++frames, (tictoc.time_stamp() - elapsed_time) >= 1.0f)
-		{
-			float fps = static_cast<float>(frames);
-			std::wostringstream outs;
-			outs.precision(6);
-			outs << APPLICATION_NAME << L" : FPS : " << fps << L" / " << L"Frame Time : " << 1000.0f / fps << L" (ms)";
-			SetWindowTextW(hwnd, outs.str().c_str());
-
-			frames = 0;
-			elapsed_time += 1.0f;
-		}
-	}
+#pragma once
+
+#include <windows.h>
+#include <tchar.h>
+#include <sstream>
+#include <memory>
+#include <chrono>
+#include <future>
+
+#include "misc.h"
+#include "high_resolution_timer.h"
+#include "Scene.h"
+#include "ResourceManager.h" // 追加
+#include "texture_streamer.h"
+
+#ifdef USE_IMGUI
+#include "imgui/imgui.h"
+#include "imgui/imgui_internal.h"
+#include "imgui/imgui_impl_dx11.h"
+#include "imgui/imgui_impl_win32.h"
+extern LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
+extern ImWchar glyphRangesJapanese[];
+#endif
+
+#include <d3d11.h>
+#include <wrl.h>
+
+CONST LONG SCREEN_WIDTH{ 1280 };
+CONST LONG SCREEN_HEIGHT{ 720 };
+CONST BOOL FULLSCREEN{ FALSE };
+CONST LPWSTR APPLICATION_NAME{ L"X3DGP" };
+
+class framework
+{
+public:
+	CONST HWND hwnd;
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	Microsoft::WRL::ComPtr<ID3D11DeviceContext> immediate_context;
+	Microsoft::WRL::ComPtr<IDXGISwapChain> swap_chain;
+	Microsoft::WRL::ComPtr<ID3D11RenderTargetView> render_target_view;
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilView> depth_stencil_view;
+
+	enum class SAMPLER_STATE { POINT, LINEAR, ANISOTROPIC, LINEAR_BORDER_BLACK, LINEAR_BORDER_WHITE };
+	Microsoft::WRL::ComPtr<ID3D11SamplerState> sampler_states[5];
+
+	enum class DEPTH_STATE { ZT_ON_ZW_ON, ZT_ON_ZW_OFF, ZT_OFF_ZW_ON, ZT_OFF_ZW_OFF };
+	Microsoft::WRL::ComPtr<ID3D11DepthStencilState> depth_stencil_states[4];
+
+	enum class BLEND_STATE { NONE, ALPHA, ADD, MULTIPLY };
+	Microsoft::WRL::ComPtr<ID3D11BlendState> blend_states[4];
+
+	enum class RASTER_STATE { SOLID, WIREFRAME, CULL_NONE, WIREFRAME_CULL_NONE };
+	Microsoft::WRL::ComPtr<ID3D11RasterizerState> rasterizer_states[4];
+
+	// Declared before the scene and the resource manager so that it outlives every mesh whose textures it streams.
+	std::unique_ptr<texture_streamer> streamer;
+	std::unique_ptr<Scene> current_scene;
+	std::unique_ptr<ResourceManager> resource_manager; // 追加
+
+	// In pipelined mode the update of the next frame runs on default_thread_pool while this frame renders and presents
+	// (see Scene), which hides update time behind rendering at the cost of one more frame between input and display.
+	bool pipelined_frames{ false };
+
+	// Scene::update runs in fixed steps of 1 / 'tick_rate' seconds however fast frames come, so simulation cost is set
+	// by the tick rate rather than the frame rate. A frame runs as many steps as the time it adds covers, at most
+	// 'max_catch_up_steps'; time beyond that is dropped so that one slow frame does not make the next ones slower.
+	// Scene::publish is given how far the time left over reaches into the next step to interpolate what it draws.
+	float tick_rate{ 60.0f };
+	uint32_t max_catch_up_steps{ 5 };
+
+	// Averages over the last second: fixed steps per frame, and times in milliseconds. 'update' may have run on a job
+	// thread; 'wait' is how long the main thread then waited for it, and 'latency' runs from the start of a frame's
+	// update to its Present returning.
+	struct frame_timings
+	{
+		float steps{ 0 };
+		float update{ 0 };
+		float render{ 0 };
+		float wait{ 0 };
+		float latency{ 0 };
+	};
+	frame_timings timings;
+
+	framework(HWND hwnd);
+	~framework();
+
+	template <typename T>
+	void change_scene()
+	{
+		finish_update();
+		if (current_scene)
+		{
+			current_scene->finalize(this);
+		}
+		current_scene = std::make_unique<T>();
+		current_scene->initialize(this);
+	}
+
+	framework(const framework&) = delete;
+	framework& operator=(const framework&) = delete;
+	framework(framework&&) noexcept = delete;
+	framework& operator=(framework&&) noexcept = delete;
+
+	int run()
+	{
+		MSG msg{};
+
+		if (!initialize())
+		{
+			return 0;
+		}
+
+#ifdef USE_IMGUI
+		IMGUI_CHECKVERSION();
+		ImGui::CreateContext();
+		ImGui::GetIO().Fonts->AddFontFromFileTTF("C:\\Windows\\Fonts\\consola.ttf", 14.0f, nullptr, glyphRangesJapanese);
+		ImGui_ImplWin32_Init(hwnd);
+		ImGui_ImplDX11_Init(device.Get(), immediate_context.Get());
+		ImGui::StyleColorsDark();
+#endif
+
+		while (WM_QUIT != msg.message)
+		{
+			if (PeekMessage(&msg, NULL, 0, 0, PM_REMOVE))
+			{
+				TranslateMessage(&msg);
+				DispatchMessage(&msg);
+			}
+			else
+			{
+				tictoc.tick();
+				calculate_frame_stats();
+				frame(tictoc.time_interval());
+			}
+		}
+		finish_update();
+
+#ifdef USE_IMGUI
+		ImGui_ImplDX11_Shutdown();
+		ImGui_ImplWin32_Shutdown();
+		ImGui::DestroyContext();
+#endif
+
+		BOOL fullscreen{};
+		swap_chain->GetFullscreenState(&fullscreen, 0);
+		if (fullscreen)
+		{
+			swap_chain->SetFullscreenState(FALSE, 0);
+		}
+
+		return uninitialize() ? static_cast<int>(msg.wParam) : 0;
+	}
+
+	LRESULT CALLBACK handle_message(HWND hwnd, UINT msg, WPARAM wparam, LPARAM lparam)
+	{
+#ifdef USE_IMGUI
+		if (ImGui_ImplWin32_WndProcHandler(hwnd, msg, wparam, lparam)) { return true; }
+#endif
+		switch (msg)
+		{
+		case WM_PAINT:
+		{
+			PAINTSTRUCT ps;
+			BeginPaint(hwnd, &ps);
+
+			EndPaint(hwnd, &ps);
+			break;
+		}
+		case WM_DESTROY:
+			PostQuitMessage(0);
+			break;
+		case WM_CREATE:
+			break;
+		case WM_KEYDOWN:
+			if (wparam == VK_ESCAPE)
+			{
+				PostMessage(hwnd, WM_CLOSE, 0, 0);
+			}
+			break;
+		case WM_ENTERSIZEMOVE:
+			tictoc.stop();
+			break;
+		case WM_EXITSIZEMOVE:
+			tictoc.start();
+			break;
+		default:
+			return DefWindowProc(hwnd, msg, wparam, lparam);
+		}
+		return 0;
+	}
+
+private:
+	bool initialize();
+	void frame(float elapsed_time);
+	// Waits for an update left running by a pipelined frame.
+	void finish_update();
+	void update(float elapsed_time);
+	void render(float elapsed_time);
+	bool uninitialize();
+
+private:
+	high_resolution_timer tictoc;
+	uint32_t frames{ 0 };
+	float elapsed_time{ 0.0f };
+
+	using frame_clock = std::chrono::steady_clock;
+	static float milliseconds(frame_clock::duration duration)
+	{
+		return std::chrono::duration<float, std::milli>(duration).count();
+	}
+	std::future<void> pending_update;
+	// Written by the update, possibly on the job thread, and read by the main thread once it has finished.
+	frame_clock::time_point pending_update_start;
+	float pending_update_time{ 0 };
+	uint32_t pending_update_steps{ 0 };
+	// Simulation time not yet covered by a fixed step.
+	float step_accumulator{ 0 };
+	// When the update that produced the snapshot being rendered started.
+	frame_clock::time_point rendered_update_start;
+	// Sums since the last calculate_frame_stats.
+	frame_timings frame_totals;
+
+	void calculate_frame_stats()
+	{
+		if (++frames, (tictoc.time_stamp() - elapsed_time) >= 1.0f)
+		{
+			float fps = static_cast<float>(frames);
+			timings.steps = frame_totals.steps / fps;
+			timings.update = frame_totals.update / fps;
+			timings.render = frame_totals.render / fps;
+			timings.wait = frame_totals.wait / fps;
+			timings.latency = frame_totals.latency / fps;
+			frame_totals = {};
+
+			std::wostringstream outs;
+			outs.precision(6);
+			outs << APPLICATION_NAME << L" : FPS : " << fps << L" / " << L"Frame Time : " << 1000.0f / fps << L" (ms)";
+			outs << L" / Latency : " << timings.latency << L" (ms)" << (pipelined_frames ? L" pipelined" : L"");
+			SetWindowTextW(hwnd, outs.str().c_str());
+
+			frames = 0;
+			elapsed_time += 1.0f;
+		}
+	}
 };
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "frustum_culler.h"
+
+#include <cmath>
+
+using namespace DirectX;
+
+void extract_frustum_planes(const XMFLOAT4X4& view_projection, XMFLOAT4 planes[6])
+{
+	// A point p is inside when -w <= x <= w, -w <= y <= w and 0 <= z <= w with (x, y, z, w) = p * view_projection,
+	// so each plane is a sum or difference of columns of the matrix.
+	const XMFLOAT4X4& m{ view_projection };
+	const XMVECTOR column[4]
+	{
+		XMVectorSet(m._11, m._21, m._31, m._41),
+		XMVectorSet(m._12, m._22, m._32, m._42),
+		XMVectorSet(m._13, m._23, m._33, m._43),
+		XMVectorSet(m._14, m._24, m._34, m._44),
+	};
+	const XMVECTOR unnormalized[6]
+	{
+		XMVectorAdd(column[3], column[0]),
+		XMVectorSubtract(column[3], column[0]),
+		XMVectorAdd(column[3], column[1]),
+		XMVectorSubtract(column[3], column[1]),
+		column[2],
+		XMVectorSubtract(column[3], column[2]),
+	};
+	for (size_t plane_index = 0; plane_index < 6; ++plane_index)
+	{
+		XMStoreFloat4(&planes[plane_index], XMPlaneNormalize(unnormalized[plane_index]));
+	}
+}
+
+void transform_bounding_box(const XMFLOAT3 bounding_box[2], const XMFLOAT4X4& world, XMFLOAT3 transformed[2])
+{
+	// A box moved by W is the box around its moved center, with the extent spread over the axes by |W|.
+	const XMMATRIX W{ XMLoadFloat4x4(&world) };
+	const XMVECTOR minimum{ XMLoadFloat3(&bounding_box[0]) };
+	const XMVECTOR maximum{ XMLoadFloat3(&bounding_box[1]) };
+	const XMVECTOR extent{ XMVectorScale(XMVectorSubtract(maximum, minimum), 0.5f) };
+	const XMVECTOR center{ XMVector3Transform(XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f), W) };
+	const XMVECTOR moved_extent{ XMVectorMultiplyAdd(XMVectorSplatX(extent), XMVectorAbs(W.r[0]),
+		XMVectorMultiplyAdd(XMVectorSplatY(extent), XMVectorAbs(W.r[1]), XMVectorMultiply(XMVectorSplatZ(extent), XMVectorAbs(W.r[2])))) };
+	XMStoreFloat3(&transformed[0], XMVectorSubtract(center, moved_extent));
+	XMStoreFloat3(&transformed[1], XMVectorAdd(center, moved_extent));
+}
+
+void frustum_culler::clear()
+{
+	center_x.clear();
+	center_y.clear();
+	center_z.clear();
+	extent_x.clear();
+	extent_y.clear();
+	extent_z.clear();
+	count = 0;
+}
+
+void frustum_culler::reserve(size_t capacity)
+{
+	const size_t padded{ (capacity + 3) & ~static_cast<size_t>(3) };
+	for (std::vector<float>* lanes : { &center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z })
+	{
+		lanes->reserve(padded);
+	}
+}
+
+uint32_t frustum_culler::add(const XMFLOAT3 bounding_box[2], const XMFLOAT4X4& world)
+{
+	XMFLOAT3 world_box[2];
+	transform_bounding_box(bounding_box, world, world_box);
+	const XMFLOAT3 world_center{ (world_box[0].x + world_box[1].x) * 0.5f, (world_box[0].y + world_box[1].y) * 0.5f, (world_box[0].z + world_box[1].z) * 0.5f };
+	const XMFLOAT3 world_extent{ (world_box[1].x - world_box[0].x) * 0.5f, (world_box[1].y - world_box[0].y) * 0.5f, (world_box[1].z - world_box[0].z) * 0.5f };
+	return add(world_center, world_extent);
+}
+
+uint32_t frustum_culler::add(const XMFLOAT3& center, const XMFLOAT3& extent)
+{
+	if (count == center_x.size())
+	{
+		for (std::vector<float>* lanes : { &center_x, &center_y, &center_z, &extent_x, &extent_y, &extent_z })
+		{
+			lanes->resize(count + 4, 0.0f);
+		}
+	}
+	center_x[count] = center.x;
+	center_y[count] = center.y;
+	center_z[count] = center.z;
+	extent_x[count] = extent.x;
+	extent_y[count] = extent.y;
+	extent_z[count] = extent.z;
+	return static_cast<uint32_t>(count++);
+}
+
+size_t frustum_culler::cull(const XMFLOAT4X4& view_projection, std::vector<uint32_t>& visible) const
+{
+	visible.clear();
+	XMFLOAT4 planes[6];
+	extract_frustum_planes(view_projection, planes);
+
+	// Plane coefficients splatted across the lanes, and their absolute values for the projected extent.
+	XMVECTOR normal[6][3], absolute_normal[6][3], distance[6];
+	for (size_t plane_index = 0; plane_index < 6; ++plane_index)
+	{
+		const XMFLOAT4& plane{ planes[plane_index] };
+		normal[plane_index][0] = XMVectorReplicate(plane.x);
+		normal[plane_index][1] = XMVectorReplicate(plane.y);
+		normal[plane_index][2] = XMVectorReplicate(plane.z);
+		absolute_normal[plane_index][0] = XMVectorReplicate(std::fabs(plane.x));
+		absolute_normal[plane_index][1] = XMVectorReplicate(std::fabs(plane.y));
+		absolute_normal[plane_index][2] = XMVectorReplicate(std::fabs(plane.z));
+		distance[plane_index] = XMVectorReplicate(plane.w);
+	}
+
+	const XMVECTOR zero{ XMVectorZero() };
+	for (size_t first = 0; first < count; first += 4)
+	{
+		const XMVECTOR cx{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(center_x.data() + first)) };
+		const XMVECTOR cy{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(center_y.data() + first)) };
+		const XMVECTOR cz{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(center_z.data() + first)) };
+		const XMVECTOR ex{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(extent_x.data() + first)) };
+		const XMVECTOR ey{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(extent_y.data() + first)) };
+		const XMVECTOR ez{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(extent_z.data() + first)) };
+
+		// Inside a plane while the signed distance of the center plus the extent projected on the normal is not negative.
+		XMVECTOR inside{ XMVectorTrueInt() };
+		for (size_t plane_index = 0; plane_index < 6; ++plane_index)
+		{
+			const XMVECTOR d{ XMVectorMultiplyAdd(cx, normal[plane_index][0], XMVectorMultiplyAdd(cy, normal[plane_index][1], XMVectorMultiplyAdd(cz, normal[plane_index][2], distance[plane_index]))) };
+			const XMVECTOR r{ XMVectorMultiplyAdd(ex, absolute_normal[plane_index][0], XMVectorMultiplyAdd(ey, absolute_normal[plane_index][1], XMVectorMultiply(ez, absolute_normal[plane_index][2]))) };
+			inside = XMVectorAndInt(inside, XMVectorGreaterOrEqual(XMVectorAdd(d, r), zero));
+		}
+
+		uint32_t lanes[4];
+		XMStoreInt4(lanes, inside);
+		for (size_t lane = 0; lane < 4 && first + lane < count; ++lane)
+		{
+			if (lanes[lane])
+			{
+				visible.push_back(static_cast<uint32_t>(first + lane));
+			}
+		}
+	}
+	return visible.size();
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Planes of the view frustum of a view-projection matrix (row vectors, clip z in [0, 1] as Direct3D), pointing inwards
+// and normalized: left, right, bottom, top, near, far.
+void extract_frustum_planes(const DirectX::XMFLOAT4X4& view_projection, DirectX::XMFLOAT4 planes[6]);
+
+// The smallest axis-aligned box around bounding_box[0]..bounding_box[1] moved by 'world'. A rotation makes it larger
+// but it never misses anything.
+void transform_bounding_box(const DirectX::XMFLOAT3 bounding_box[2], const DirectX::XMFLOAT4X4& world, DirectX::XMFLOAT3 transformed[2]);
+
+// Tests many axis-aligned boxes against a view frustum at once.
+// Boxes are added in model space with their world matrix and kept in world space as separate arrays of centers and
+// extents (structure of arrays), so the test runs on four boxes per vector instruction.
+// No Direct3D dependency.
+class frustum_culler
+{
+public:
+	void clear();
+	void reserve(size_t count);
+
+	// Adds the box bounding_box[0]..bounding_box[1] moved by 'world' (see transform_bounding_box) and returns its index.
+	uint32_t add(const DirectX::XMFLOAT3 bounding_box[2], const DirectX::XMFLOAT4X4& world);
+	// Adds a box that is already in world space, given by its center and half extent.
+	uint32_t add(const DirectX::XMFLOAT3& center, const DirectX::XMFLOAT3& extent);
+
+	// Writes the indices of the boxes that are at least partly inside the frustum of 'view_projection' to 'visible'
+	// (in increasing order) and returns how many there are. A box is dropped only when it is wholly outside one plane.
+	size_t cull(const DirectX::XMFLOAT4X4& view_projection, std::vector<uint32_t>& visible) const;
+
+	size_t box_count() const { return count; }
+
+private:
+	// Padded to a multiple of four; the padding is never reported.
+	std::vector<float> center_x, center_y, center_z;
+	std::vector<float> extent_x, extent_y, extent_z;
+	size_t count{ 0 };
+};
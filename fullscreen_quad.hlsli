@@ -1,5 +1,5 @@
-struct VS_OUT
-{
-	float4 position : SV_POSITION;
-	float2 texcoord : TEXCOORD;
-};
+struct VS_OUT
+{
+	float4 position : SV_POSITION;
+	float2 texcoord : TEXCOORD;
+};
@@ -1,6 +1,6 @@
-#include "geometric_primitive.hlsli"
-
-float4 main(VS_OUT pin) : SV_TARGET
-{
-	return pin.color;
-}
+#include "geometric_primitive.hlsli"
+
+float4 main(VS_OUT pin) : SV_TARGET
+{
+	return pin.color;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstdint>
+#include <vector>
+
+// The meshes of geometric_primitive: unit sized shapes centred on the origin, as triangle lists.
+// No Direct3D dependency; geometric_primitive uploads them.
+struct geometric_vertex
+{
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 normal;
+};
+
+// Each replaces the contents of 'vertices' and 'indices'.
+void build_cube(std::vector<geometric_vertex>& vertices, std::vector<uint32_t>& indices);
+void build_cylinder(uint32_t slices, std::vector<geometric_vertex>& vertices, std::vector<uint32_t>& indices);
+void build_sphere(uint32_t slices, uint32_t stacks, std::vector<geometric_vertex>& vertices, std::vector<uint32_t>& indices);
+void build_capsule(float mantle_height, const DirectX::XMFLOAT3& radius, uint32_t slices, uint32_t ellipsoid_stacks, uint32_t mantle_stacks, std::vector<geometric_vertex>& vertices, std::vector<uint32_t>& indices);
@@ -0,0 +1,76 @@
+#include "instance_buffer.h"
+
+#include "misc.h"
+
+#include <algorithm>
+#include <cstring>
+
+std::vector<D3D11_INPUT_ELEMENT_DESC> append_draw_instance_elements(const D3D11_INPUT_ELEMENT_DESC* elements, size_t element_count)
+{
+	std::vector<D3D11_INPUT_ELEMENT_DESC> input_element_desc(elements, elements + element_count);
+	input_element_desc.insert(input_element_desc.end(),
+	{
+		{ "INSTANCE_WORLD", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_WORLD", 1, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_WORLD", 2, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_WORLD", 3, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_COLOR", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+		{ "INSTANCE_PALETTE", 0, DXGI_FORMAT_R32_UINT, 1, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_INSTANCE_DATA, 1 },
+	});
+	return input_element_desc;
+}
+
+void* dynamic_buffer::map(ID3D11Device* device, render_context& context, size_t element_count)
+{
+	if (element_count == 0)
+	{
+		return nullptr;
+	}
+
+	HRESULT hr{ S_OK };
+	if (element_count > capacity)
+	{
+		capacity = std::max<size_t>(element_count, capacity * 2);
+
+		const bool structured{ (bind_flags & D3D11_BIND_SHADER_RESOURCE) != 0 };
+		D3D11_BUFFER_DESC buffer_desc{};
+		buffer_desc.ByteWidth = static_cast<UINT>(element_size * capacity);
+		buffer_desc.Usage = D3D11_USAGE_DYNAMIC;
+		buffer_desc.BindFlags = bind_flags;
+		buffer_desc.CPUAccessFlags = D3D11_CPU_ACCESS_WRITE;
+		buffer_desc.MiscFlags = structured ? D3D11_RESOURCE_MISC_BUFFER_STRUCTURED : 0;
+		buffer_desc.StructureByteStride = structured ? element_size : 0;
+		hr = device->CreateBuffer(&buffer_desc, nullptr, buffer.ReleaseAndGetAddressOf());
+		_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+
+		if (structured)
+		{
+			D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc{};
+			shader_resource_view_desc.Format = DXGI_FORMAT_UNKNOWN;
+			shader_resource_view_desc.ViewDimension = D3D11_SRV_DIMENSION_BUFFER;
+			shader_resource_view_desc.Buffer.FirstElement = 0;
+			shader_resource_view_desc.Buffer.NumElements = static_cast<UINT>(capacity);
+			hr = device->CreateShaderResourceView(buffer.Get(), &shader_resource_view_desc, shader_resource_view.ReleaseAndGetAddressOf());
+			_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+		}
+	}
+
+	D3D11_MAPPED_SUBRESOURCE mapped_subresource{};
+	hr = context.Map(buffer.Get(), 0, D3D11_MAP_WRITE_DISCARD, 0, &mapped_subresource);
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+	return mapped_subresource.pData;
+}
+
+void dynamic_buffer::unmap(render_context& context)
+{
+	context.Unmap(buffer.Get(), 0);
+}
+
+void dynamic_buffer::upload(ID3D11Device* device, render_context& context, const void* elements, size_t element_count)
+{
+	if (void* data{ map(device, context, element_count) })
+	{
+		std::memcpy(data, elements, element_size * element_count);
+		unmap(context);
+	}
+}
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl.h>
+#include <directxmath.h>
+
+#include <cstdint>
+#include <vector>
+
+#include "render_context.h"
+
+// One instance of an instanced mesh draw, as skinned_mesh_instanced_vs and static_mesh_instanced_vs read it from
+// vertex buffer slot 1.
+struct draw_instance
+{
+	DirectX::XMFLOAT4X4 world;
+	DirectX::XMFLOAT4 material_color;
+	uint32_t palette_offset; // first bone transform of the instance in the bone palette buffer (t0)
+	uint32_t padding[3];
+};
+
+// 'elements' (the per-vertex elements of a mesh) followed by those of draw_instance, in slot 1 and stepping once per instance.
+std::vector<D3D11_INPUT_ELEMENT_DESC> append_draw_instance_elements(const D3D11_INPUT_ELEMENT_DESC* elements, size_t element_count);
+
+// A buffer the CPU rewrites every frame. 'upload' discards the old contents and is the only way to fill it; the buffer is
+// recreated twice as large when they do not fit. A buffer bound as a shader resource is structured, with one element
+// per 'element_size' bytes and a view over all of it.
+class dynamic_buffer
+{
+public:
+	dynamic_buffer(UINT bind_flags, UINT element_size) : bind_flags(bind_flags), element_size(element_size) {}
+
+	// Discards the contents and returns where to write 'element_count' elements, to be followed by 'unmap'.
+	// Returns nullptr for no elements, leaving the previous contents in place and nothing to unmap.
+	void* map(ID3D11Device* device, render_context& context, size_t element_count);
+	void unmap(render_context& context);
+	// 'map', copy and 'unmap'.
+	void upload(ID3D11Device* device, render_context& context, const void* elements, size_t element_count);
+
+	Microsoft::WRL::ComPtr<ID3D11Buffer> buffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+
+private:
+	UINT bind_flags;
+	UINT element_size;
+	size_t capacity{ 0 };
+};
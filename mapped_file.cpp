@@ -0,0 +1,132 @@
+#include "mapped_file.h"
+
+#include <cstring>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+mapped_file::mapped_file(const wchar_t* filename)
+{
+	HANDLE file{ CreateFileW(filename, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr) };
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		return;
+	}
+	file_handle = file;
+
+	LARGE_INTEGER file_size{};
+	if (!GetFileSizeEx(file, &file_size))
+	{
+		return;
+	}
+	opened = true;
+	if (file_size.QuadPart == 0)
+	{
+		// An empty file cannot be mapped, but it is still a valid (empty) view.
+		return;
+	}
+	mapping_handle = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_handle == nullptr)
+	{
+		opened = false;
+		return;
+	}
+	view = MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0);
+	if (view == nullptr)
+	{
+		opened = false;
+		return;
+	}
+	view_size = static_cast<size_t>(file_size.QuadPart);
+}
+
+mapped_file::~mapped_file()
+{
+	if (view)
+	{
+		UnmapViewOfFile(view);
+	}
+	if (mapping_handle)
+	{
+		CloseHandle(mapping_handle);
+	}
+	if (file_handle)
+	{
+		CloseHandle(file_handle);
+	}
+}
+#else
+mapped_file::mapped_file(const wchar_t* filename)
+{
+	file_descriptor = open(std::filesystem::path(filename).c_str(), O_RDONLY);
+	if (file_descriptor < 0)
+	{
+		return;
+	}
+	struct stat status {};
+	if (fstat(file_descriptor, &status) != 0)
+	{
+		return;
+	}
+	opened = true;
+	if (status.st_size == 0)
+	{
+		return;
+	}
+	void* address{ mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file_descriptor, 0) };
+	if (address == MAP_FAILED)
+	{
+		opened = false;
+		return;
+	}
+	madvise(address, static_cast<size_t>(status.st_size), MADV_SEQUENTIAL);
+	view = address;
+	view_size = static_cast<size_t>(status.st_size);
+}
+
+mapped_file::~mapped_file()
+{
+	if (view)
+	{
+		munmap(const_cast<void*>(view), view_size);
+	}
+	if (file_descriptor >= 0)
+	{
+		close(file_descriptor);
+	}
+}
+#endif
+
+uint64_t hash_file(const wchar_t* filename)
+{
+	mapped_file file(filename);
+	if (!file.is_open())
+	{
+		return 0;
+	}
+	constexpr uint64_t prime{ 0x100000001B3ull };
+	uint64_t hash{ 0xCBF29CE484222325ull };
+	const char* data{ file.data() };
+	const size_t size{ file.size() };
+	size_t offset{ 0 };
+	for (; offset + sizeof(uint64_t) <= size; offset += sizeof(uint64_t))
+	{
+		uint64_t word;
+		std::memcpy(&word, data + offset, sizeof(word));
+		hash = (hash ^ word) * prime;
+	}
+	for (; offset < size; ++offset)
+	{
+		hash = (hash ^ static_cast<uint8_t>(data[offset])) * prime;
+	}
+	// 0 is reserved for a missing file.
+	return hash == 0 ? 1 : hash;
+}
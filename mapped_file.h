@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// A read-only view of a whole file. The file is mapped into memory where the platform allows it.
+// This header does not depend on any Windows header so the parsers built on it can run anywhere.
+class mapped_file
+{
+public:
+	explicit mapped_file(const wchar_t* filename);
+	virtual ~mapped_file();
+	mapped_file(const mapped_file&) = delete;
+	mapped_file& operator=(const mapped_file&) = delete;
+	mapped_file(mapped_file&&) noexcept = delete;
+	mapped_file& operator=(mapped_file&&) noexcept = delete;
+
+	bool is_open() const { return opened; }
+	const char* data() const { return static_cast<const char*>(view); }
+	size_t size() const { return view_size; }
+
+private:
+	bool opened{ false };
+	const void* view{ nullptr };
+	size_t view_size{ 0 };
+#ifdef _WIN32
+	void* file_handle{ nullptr };
+	void* mapping_handle{ nullptr };
+#else
+	int file_descriptor{ -1 };
+#endif
+};
+
+// A 64-bit FNV-1a style hash of the file contents, taken eight bytes at a time. 0 if the file cannot be opened.
+// Used to tell whether a cache built from the file is still valid.
+uint64_t hash_file(const wchar_t* filename);
@@ -0,0 +1,203 @@
+#include "memory_tracker.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+	thread_local MEMORY_TAG current_tag{ MEMORY_TAG::UNTAGGED };
+	thread_local uint32_t load_depth{ 0 };
+
+	void raise(std::atomic<int64_t>& peak, int64_t value)
+	{
+		int64_t observed{ peak.load(std::memory_order_relaxed) };
+		while (observed < value && !peak.compare_exchange_weak(observed, value, std::memory_order_relaxed))
+		{
+		}
+	}
+}
+
+const char* memory_tag_name(MEMORY_TAG tag)
+{
+	switch (tag)
+	{
+	case MEMORY_TAG::UNTAGGED: return "untagged";
+	case MEMORY_TAG::MESH_DATA: return "mesh data";
+	case MEMORY_TAG::ANIMATION: return "animation";
+	case MEMORY_TAG::SCENE: return "scene";
+	case MEMORY_TAG::TEXTURES: return "textures";
+	case MEMORY_TAG::GPU_BUFFERS: return "gpu buffers";
+	case MEMORY_TAG::LOAD_TEMPORARY: return "load temporary";
+	default: return "?";
+	}
+}
+
+size_t memory_breakdown::total() const
+{
+	size_t sum{ 0 };
+	for (size_t tag_bytes : bytes)
+	{
+		sum += tag_bytes;
+	}
+	return sum;
+}
+
+memory_breakdown& memory_breakdown::operator+=(const memory_breakdown& other)
+{
+	for (size_t tag = 0; tag < static_cast<size_t>(MEMORY_TAG::COUNT); ++tag)
+	{
+		bytes[tag] += other.bytes[tag];
+	}
+	return *this;
+}
+
+void memory_tracker::allocate(MEMORY_TAG tag, size_t bytes)
+{
+	counter& counter{ counters[static_cast<size_t>(tag)] };
+	raise(counter.peak, counter.current.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes));
+	counter.allocations.fetch_add(1, std::memory_order_relaxed);
+
+	const int64_t new_total{ total.fetch_add(static_cast<int64_t>(bytes), std::memory_order_relaxed) + static_cast<int64_t>(bytes) };
+	raise(total_peak, new_total);
+	raise(window_peak, new_total);
+}
+
+void memory_tracker::release(MEMORY_TAG tag, size_t bytes)
+{
+	counters[static_cast<size_t>(tag)].current.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+	total.fetch_sub(static_cast<int64_t>(bytes), std::memory_order_relaxed);
+}
+
+std::vector<memory_tracker::load_record> memory_tracker::load_records() const
+{
+	std::lock_guard<std::mutex> lock(records_mutex);
+	return records;
+}
+
+memory_tracker& default_memory_tracker()
+{
+	// Placed in static storage rather than allocated, since operator new itself reports here.
+	alignas(memory_tracker) static unsigned char storage[sizeof(memory_tracker)];
+	static memory_tracker* tracker{ new (storage) memory_tracker };
+	return *tracker;
+}
+
+memory_scope::memory_scope(MEMORY_TAG tag) : previous(current_tag)
+{
+	current_tag = tag;
+}
+
+memory_scope::~memory_scope()
+{
+	current_tag = previous;
+}
+
+MEMORY_TAG memory_scope::current()
+{
+	return current_tag;
+}
+
+memory_load_scope::memory_load_scope(std::string name)
+{
+	memory_tracker& tracker{ default_memory_tracker() };
+	{
+		std::lock_guard<std::mutex> lock(tracker.records_mutex);
+		memory_tracker::load_record started;
+		started.name = std::move(name);
+		started.depth = load_depth++;
+		started.finished = false;
+		started.retained = 0;
+		started.peak = 0;
+		record = tracker.records.size();
+		tracker.records.push_back(std::move(started));
+	}
+	begin = tracker.total.load(std::memory_order_relaxed);
+	outer_window_peak = tracker.window_peak.exchange(begin, std::memory_order_relaxed);
+}
+
+void memory_load_scope::describe(std::string detail)
+{
+	memory_tracker& tracker{ default_memory_tracker() };
+	std::lock_guard<std::mutex> lock(tracker.records_mutex);
+	tracker.records.at(record).detail = std::move(detail);
+}
+
+memory_load_scope::~memory_load_scope()
+{
+	memory_tracker& tracker{ default_memory_tracker() };
+	const int64_t end{ tracker.total.load(std::memory_order_relaxed) };
+	const int64_t peak{ tracker.window_peak.load(std::memory_order_relaxed) };
+	// The enclosing scope's window includes this one.
+	raise(tracker.window_peak, outer_window_peak);
+	--load_depth;
+
+	std::lock_guard<std::mutex> lock(tracker.records_mutex);
+	memory_tracker::load_record& record{ tracker.records.at(this->record) };
+	record.finished = true;
+	record.retained = end - begin;
+	record.peak = peak - begin;
+}
+
+#ifdef USE_MEMORY_TRACKING
+// Every block carries the size and tag it was counted under, in front of the pointer handed out.
+namespace
+{
+	struct alignas(alignof(std::max_align_t)) allocation_header
+	{
+		size_t size;
+		MEMORY_TAG tag;
+	};
+
+	void* tracked_allocate(size_t size) noexcept
+	{
+		allocation_header* header{ static_cast<allocation_header*>(std::malloc(sizeof(allocation_header) + size)) };
+		if (!header)
+		{
+			return nullptr;
+		}
+		header->size = size;
+		header->tag = current_tag;
+		default_memory_tracker().allocate(header->tag, size);
+		return header + 1;
+	}
+
+	void tracked_free(void* pointer) noexcept
+	{
+		if (!pointer)
+		{
+			return;
+		}
+		allocation_header* header{ static_cast<allocation_header*>(pointer) - 1 };
+		default_memory_tracker().release(header->tag, header->size);
+		std::free(header);
+	}
+
+	void* tracked_allocate_or_throw(size_t size)
+	{
+		for (;;)
+		{
+			if (void* pointer = tracked_allocate(size ? size : 1))
+			{
+				return pointer;
+			}
+			std::new_handler handler{ std::get_new_handler() };
+			if (!handler)
+			{
+				throw std::bad_alloc();
+			}
+			handler();
+		}
+	}
+}
+
+void* operator new(std::size_t size) { return tracked_allocate_or_throw(size); }
+void* operator new[](std::size_t size) { return tracked_allocate_or_throw(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return tracked_allocate(size ? size : 1); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return tracked_allocate(size ? size : 1); }
+void operator delete(void* pointer) noexcept { tracked_free(pointer); }
+void operator delete[](void* pointer) noexcept { tracked_free(pointer); }
+void operator delete(void* pointer, std::size_t) noexcept { tracked_free(pointer); }
+void operator delete[](void* pointer, std::size_t) noexcept { tracked_free(pointer); }
+void operator delete(void* pointer, const std::nothrow_t&) noexcept { tracked_free(pointer); }
+void operator delete[](void* pointer, const std::nothrow_t&) noexcept { tracked_free(pointer); }
+#endif
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// What memory is spent on.
+enum class MEMORY_TAG : uint32_t
+{
+	UNTAGGED,
+	MESH_DATA, // vertices, indices, subsets and bone boxes of meshes on the CPU
+	ANIMATION, // keyframes of animation clips
+	SCENE, // scene graph nodes, materials and scene objects
+	TEXTURES, // textures on the device
+	GPU_BUFFERS, // vertex, index and constant buffers on the device
+	LOAD_TEMPORARY, // what loaders decode into before building the assets
+	COUNT
+};
+const char* memory_tag_name(MEMORY_TAG tag);
+
+// Bytes by tag, as in the breakdown of one asset.
+struct memory_breakdown
+{
+	size_t bytes[static_cast<size_t>(MEMORY_TAG::COUNT)]{};
+
+	size_t& operator[](MEMORY_TAG tag) { return bytes[static_cast<size_t>(tag)]; }
+	size_t operator[](MEMORY_TAG tag) const { return bytes[static_cast<size_t>(tag)]; }
+	size_t total() const;
+	memory_breakdown& operator+=(const memory_breakdown& other);
+};
+
+// Current and peak bytes per MEMORY_TAG.
+// Built with USE_MEMORY_TRACKING, memory_tracker.cpp replaces the global operator new and delete so that every heap
+// allocation is counted under the tag of the innermost memory_scope of the thread making it (UNTAGGED outside any),
+// and taken off that tag again when freed. Over-aligned allocations keep the default operators and are not counted.
+// Memory outside the heap, such as buffers and textures on the device, is counted with 'allocate' and 'release'
+// whether or not USE_MEMORY_TRACKING is defined.
+// No Direct3D dependency.
+class memory_tracker
+{
+public:
+	memory_tracker() = default;
+	virtual ~memory_tracker() = default;
+	memory_tracker(const memory_tracker&) = delete;
+	memory_tracker& operator=(const memory_tracker&) = delete;
+	memory_tracker(memory_tracker&&) noexcept = delete;
+	memory_tracker& operator=(memory_tracker&&) noexcept = delete;
+
+	void allocate(MEMORY_TAG tag, size_t bytes);
+	void release(MEMORY_TAG tag, size_t bytes);
+
+	int64_t current(MEMORY_TAG tag) const { return counters[static_cast<size_t>(tag)].current.load(std::memory_order_relaxed); }
+	int64_t peak(MEMORY_TAG tag) const { return counters[static_cast<size_t>(tag)].peak.load(std::memory_order_relaxed); }
+	uint64_t allocations(MEMORY_TAG tag) const { return counters[static_cast<size_t>(tag)].allocations.load(std::memory_order_relaxed); }
+	int64_t current_total() const { return total.load(std::memory_order_relaxed); }
+	int64_t peak_total() const { return total_peak.load(std::memory_order_relaxed); }
+
+	// What a memory_load_scope measured, in bytes of every tag together.
+	struct load_record
+	{
+		std::string name;
+		uint32_t depth{ 0 }; // load scopes open around it on the same thread
+		bool finished{ false };
+		int64_t retained{ 0 }; // still held when the scope ended
+		int64_t peak{ 0 }; // most held at any time while it ran; 'peak - retained' is what the load needed only transiently
+		std::string detail; // what the load reported about its result, if anything (see memory_load_scope::describe)
+	};
+	// In the order the scopes started.
+	std::vector<load_record> load_records() const;
+
+private:
+	friend class memory_load_scope;
+
+	struct counter
+	{
+		std::atomic<int64_t> current{ 0 };
+		std::atomic<int64_t> peak{ 0 };
+		std::atomic<uint64_t> allocations{ 0 };
+	};
+	counter counters[static_cast<size_t>(MEMORY_TAG::COUNT)];
+	std::atomic<int64_t> total{ 0 };
+	std::atomic<int64_t> total_peak{ 0 };
+	// Highest total since the innermost memory_load_scope started.
+	std::atomic<int64_t> window_peak{ 0 };
+
+	mutable std::mutex records_mutex;
+	std::vector<load_record> records;
+};
+
+// The tracker the global operator new reports to. It is created on first use and never destroyed, so that memory
+// freed during static destruction can still be counted.
+memory_tracker& default_memory_tracker();
+
+// Heap allocations of this thread are counted under 'tag' until the scope ends.
+class memory_scope
+{
+public:
+	explicit memory_scope(MEMORY_TAG tag);
+	~memory_scope();
+	memory_scope(const memory_scope&) = delete;
+	memory_scope& operator=(const memory_scope&) = delete;
+	memory_scope(memory_scope&&) noexcept = delete;
+	memory_scope& operator=(memory_scope&&) noexcept = delete;
+
+	static MEMORY_TAG current();
+
+private:
+	MEMORY_TAG previous;
+};
+
+// Adds a load_record of 'name' to default_memory_tracker: the peak above what was held when the scope started, and
+// what is still held when it ends. Scopes nest. The totals are process wide, so loads on other threads at the same time
+// are counted too.
+class memory_load_scope
+{
+public:
+	explicit memory_load_scope(std::string name);
+	~memory_load_scope();
+	memory_load_scope(const memory_load_scope&) = delete;
+	memory_load_scope& operator=(const memory_load_scope&) = delete;
+	memory_load_scope(memory_load_scope&&) noexcept = delete;
+	memory_load_scope& operator=(memory_load_scope&&) noexcept = delete;
+
+	// Attaches a line about what was loaded, shown with the record.
+	void describe(std::string detail);
+
+private:
+	size_t record;
+	int64_t begin;
+	int64_t outer_window_peak;
+};
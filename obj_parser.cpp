@@ -0,0 +1,488 @@
+#include "obj_parser.h"
+#include "mapped_file.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <stdexcept>
+
+using namespace DirectX;
+
+namespace
+{
+	// A face corner as written in the file, 1-based. A negative (relative) reference is stored as a 0-based index
+	// counted from the first element of its chunk, which may be negative; the 'relative' bits tell them apart.
+	// 0 means an absent reference.
+	struct obj_corner
+	{
+		int32_t v{ 0 };
+		int32_t vt{ 0 };
+		int32_t vn{ 0 };
+		uint32_t relative{ 0 }; // bit 0:v, bit 1:vt, bit 2:vn
+	};
+
+	// A corner with every reference resolved to a 0-based index into the stitched arrays. -1 means absent.
+	struct obj_triple
+	{
+		int32_t v{ -1 };
+		int32_t vt{ -1 };
+		int32_t vn{ -1 };
+		bool operator==(const obj_triple& rhs) const { return v == rhs.v && vt == rhs.vt && vn == rhs.vn; }
+	};
+
+	struct obj_chunk
+	{
+		const char* begin{ nullptr };
+		const char* end{ nullptr };
+
+		std::vector<XMFLOAT3> positions;
+		std::vector<XMFLOAT3> normals;
+		std::vector<XMFLOAT2> texcoords;
+		std::vector<obj_corner> corners;
+		std::vector<uint32_t> face_sizes; // in corners, at least 3
+		size_t index_count{ 0 }; // after triangulation
+		// 'usemtl' statements, with the number of indices of this chunk that precede them.
+		std::vector<std::pair<std::wstring, size_t>> usemtls;
+		std::vector<std::wstring> mtl_filenames;
+	};
+
+	inline bool is_blank(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+	}
+	inline const char* skip_blanks(const char* p, const char* end)
+	{
+		while (p < end && is_blank(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+	inline const char* skip_token(const char* p, const char* end)
+	{
+		while (p < end && !is_blank(*p) && *p != '\n')
+		{
+			++p;
+		}
+		return p;
+	}
+
+	// std::from_chars does not accept a leading '+'. A missing number leaves 'value' untouched.
+	template<class T>
+	const char* parse_number(const char* p, const char* end, T& value)
+	{
+		p = skip_blanks(p, end);
+		if (p < end && *p == '+')
+		{
+			++p;
+		}
+		const std::from_chars_result result{ std::from_chars(p, end, value) };
+		return result.ptr;
+	}
+
+	// Names are widened byte by byte, which is what std::wifstream did in the "C" locale.
+	std::wstring widen(const char* begin, const char* end)
+	{
+		std::wstring name(static_cast<size_t>(end - begin), L'\0');
+		std::transform(begin, end, name.begin(), [](char c) { return static_cast<wchar_t>(static_cast<unsigned char>(c)); });
+		return name;
+	}
+
+	// 'element_count' is the number of elements of the referenced kind already read in this chunk.
+	inline void make_chunk_relative(int32_t& reference, size_t element_count, uint32_t bit, uint32_t& relative)
+	{
+		if (reference < 0)
+		{
+			reference += static_cast<int32_t>(element_count);
+			relative |= bit;
+		}
+	}
+
+	const char* parse_corner(const char* p, const char* end, const obj_chunk& chunk, obj_corner& corner)
+	{
+		p = parse_number(p, end, corner.v);
+		if (p < end && *p == '/')
+		{
+			++p;
+			if (p < end && *p != '/')
+			{
+				p = parse_number(p, end, corner.vt);
+			}
+			if (p < end && *p == '/')
+			{
+				++p;
+				p = parse_number(p, end, corner.vn);
+			}
+		}
+		make_chunk_relative(corner.v, chunk.positions.size(), 1, corner.relative);
+		make_chunk_relative(corner.vt, chunk.texcoords.size(), 2, corner.relative);
+		make_chunk_relative(corner.vn, chunk.normals.size(), 4, corner.relative);
+		return p;
+	}
+
+	void parse_chunk(obj_chunk& chunk, bool flipping_v_coordinates)
+	{
+		const char* end{ chunk.end };
+		for (const char* line = chunk.begin; line < end;)
+		{
+			const char* line_end{ std::find(line, end, '\n') };
+			const char* p{ skip_blanks(line, line_end) };
+			const char* keyword_end{ skip_token(p, line_end) };
+			const size_t keyword_length{ static_cast<size_t>(keyword_end - p) };
+
+			if (keyword_length == 1 && p[0] == 'v')
+			{
+				XMFLOAT3 position{ 0, 0, 0 };
+				p = parse_number(keyword_end, line_end, position.x);
+				p = parse_number(p, line_end, position.y);
+				parse_number(p, line_end, position.z);
+				chunk.positions.push_back(position);
+			}
+			else if (keyword_length == 2 && p[0] == 'v' && p[1] == 't')
+			{
+				float u{ 0 }, v{ 0 };
+				p = parse_number(keyword_end, line_end, u);
+				parse_number(p, line_end, v);
+				chunk.texcoords.push_back({ u, flipping_v_coordinates ? 1.0f - v : v });
+			}
+			else if (keyword_length == 2 && p[0] == 'v' && p[1] == 'n')
+			{
+				XMFLOAT3 normal{ 0, 0, 0 };
+				p = parse_number(keyword_end, line_end, normal.x);
+				p = parse_number(p, line_end, normal.y);
+				parse_number(p, line_end, normal.z);
+				chunk.normals.push_back(normal);
+			}
+			else if (keyword_length == 1 && p[0] == 'f')
+			{
+				// Every corner is kept; polygons are triangulated once the positions are known.
+				uint32_t corner_count{ 0 };
+				p = skip_blanks(keyword_end, line_end);
+				while (p < line_end)
+				{
+					obj_corner corner;
+					const char* next{ parse_corner(p, line_end, chunk, corner) };
+					if (next == p || (corner.v == 0 && !(corner.relative & 1)))
+					{
+						break;
+					}
+					chunk.corners.push_back(corner);
+					++corner_count;
+					p = skip_blanks(skip_token(next, line_end), line_end);
+				}
+				if (corner_count < 3)
+				{
+					// Points and lines are not drawn.
+					chunk.corners.resize(chunk.corners.size() - corner_count);
+				}
+				else
+				{
+					chunk.face_sizes.push_back(corner_count);
+					chunk.index_count += (corner_count - 2) * 3;
+				}
+			}
+			else if (keyword_length == 6 && std::equal(p, keyword_end, "mtllib"))
+			{
+				const char* name{ skip_blanks(keyword_end, line_end) };
+				chunk.mtl_filenames.push_back(widen(name, skip_token(name, line_end)));
+			}
+			else if (keyword_length == 6 && std::equal(p, keyword_end, "usemtl"))
+			{
+				const char* name{ skip_blanks(keyword_end, line_end) };
+				chunk.usemtls.push_back(std::make_pair(widen(name, skip_token(name, line_end)), chunk.index_count));
+			}
+			line = line_end < end ? line_end + 1 : end;
+		}
+	}
+
+	// Turns a reference of 'corner' into an index into the stitched array of 'element_count' elements,
+	// 'first_element' of which were read before the chunk.
+	inline int32_t resolve(int32_t reference, bool relative, size_t first_element, size_t element_count)
+	{
+		if (!relative && reference == 0)
+		{
+			return -1;
+		}
+		const int64_t index{ relative ? static_cast<int64_t>(first_element) + reference : static_cast<int64_t>(reference) - 1 };
+		if (index < 0 || index >= static_cast<int64_t>(element_count))
+		{
+			throw std::out_of_range("OBJ face refers to a missing element.");
+		}
+		return static_cast<int32_t>(index);
+	}
+
+	inline uint64_t hash(const obj_triple& triple)
+	{
+		uint64_t h{ static_cast<uint32_t>(triple.v) * 0x9E3779B97F4A7C15ull };
+		h ^= (static_cast<uint64_t>(static_cast<uint32_t>(triple.vt)) + 0x632BE59BD9B4E019ull + (h << 6) + (h >> 2));
+		h ^= (static_cast<uint64_t>(static_cast<uint32_t>(triple.vn)) + 0x85157AF5ull + (h << 6) + (h >> 2));
+		return h ^ (h >> 29);
+	}
+
+	// Ear clipping in the plane that the polygon faces most. The winding of the face is kept.
+	// A polygon with no ear left (self intersecting or degenerate) is finished as a fan.
+	void triangulate(const XMFLOAT3* positions, const uint32_t* vertices, uint32_t corner_count, uint32_t* indices)
+	{
+		uint32_t* index{ indices };
+		auto emit = [&index, vertices](uint32_t a, uint32_t b, uint32_t c)
+		{
+			*index++ = vertices[a];
+			*index++ = vertices[b];
+			*index++ = vertices[c];
+		};
+		if (corner_count == 3)
+		{
+			emit(0, 1, 2);
+			return;
+		}
+
+		// Newell's method gives a normal that is stable for non planar polygons too.
+		XMFLOAT3 normal{ 0, 0, 0 };
+		for (uint32_t i = 0; i < corner_count; ++i)
+		{
+			const XMFLOAT3& a{ positions[i] };
+			const XMFLOAT3& b{ positions[(i + 1) % corner_count] };
+			normal.x += (a.y - b.y) * (a.z + b.z);
+			normal.y += (a.z - b.z) * (a.x + b.x);
+			normal.z += (a.x - b.x) * (a.y + b.y);
+		}
+		const float ax{ std::fabs(normal.x) }, ay{ std::fabs(normal.y) }, az{ std::fabs(normal.z) };
+		const int dropped_axis{ ax > ay && ax > az ? 0 : ay > az ? 1 : 2 };
+		const float orientation{ dropped_axis == 0 ? normal.x : dropped_axis == 1 ? normal.y : normal.z };
+		std::vector<XMFLOAT2> points(corner_count);
+		for (uint32_t i = 0; i < corner_count; ++i)
+		{
+			const XMFLOAT3& p{ positions[i] };
+			// Projected so that the polygon is counterclockwise.
+			points[i] = dropped_axis == 0 ? XMFLOAT2{ p.y, p.z } : dropped_axis == 1 ? XMFLOAT2{ p.z, p.x } : XMFLOAT2{ p.x, p.y };
+			if (orientation < 0)
+			{
+				std::swap(points[i].x, points[i].y);
+			}
+		}
+		auto cross = [&points](uint32_t a, uint32_t b, uint32_t c)
+		{
+			return (points[b].x - points[a].x) * (points[c].y - points[a].y) - (points[b].y - points[a].y) * (points[c].x - points[a].x);
+		};
+
+		bool convex{ true };
+		for (uint32_t i = 0; i < corner_count && convex; ++i)
+		{
+			convex = cross(i, (i + 1) % corner_count, (i + 2) % corner_count) >= 0;
+		}
+		if (convex)
+		{
+			for (uint32_t i = 1; i + 1 < corner_count; ++i)
+			{
+				emit(0, i, i + 1);
+			}
+			return;
+		}
+
+		std::vector<uint32_t> remaining(corner_count);
+		for (uint32_t i = 0; i < corner_count; ++i)
+		{
+			remaining[i] = i;
+		}
+		while (remaining.size() > 3)
+		{
+			const size_t count{ remaining.size() };
+			bool clipped{ false };
+			for (size_t i = 0; i < count && !clipped; ++i)
+			{
+				const uint32_t a{ remaining[(i + count - 1) % count] }, b{ remaining[i] }, c{ remaining[(i + 1) % count] };
+				if (cross(a, b, c) <= 0)
+				{
+					continue;
+				}
+				bool ear{ true };
+				for (size_t j = 0; j < count && ear; ++j)
+				{
+					const uint32_t p{ remaining[j] };
+					if (p != a && p != b && p != c)
+					{
+						ear = !(cross(a, b, p) >= 0 && cross(b, c, p) >= 0 && cross(c, a, p) >= 0);
+					}
+				}
+				if (ear)
+				{
+					emit(a, b, c);
+					remaining.erase(remaining.begin() + i);
+					clipped = true;
+				}
+			}
+			if (!clipped)
+			{
+				break;
+			}
+		}
+		for (size_t i = 1; i + 1 < remaining.size(); ++i)
+		{
+			emit(remaining[0], remaining[i], remaining[i + 1]);
+		}
+	}
+}
+
+void parse_obj(const char* text, size_t size, bool flipping_v_coordinates, obj_mesh& mesh)
+{
+	mesh = {};
+
+	// Several chunks per thread keep the threads busy when the statements are unevenly spread over the file.
+	thread_pool& pool{ default_thread_pool() };
+	constexpr size_t minimum_chunk_size{ 256 * 1024 };
+	const size_t chunk_count{ std::max<size_t>(1, std::min<size_t>(size / minimum_chunk_size, (pool.thread_count() + 1) * 4)) };
+
+	std::vector<obj_chunk> chunks;
+	chunks.reserve(chunk_count);
+	const char* const end{ text + size };
+	const char* begin{ text };
+	for (size_t chunk_index = 0; chunk_index < chunk_count && begin < end; ++chunk_index)
+	{
+		const char* chunk_end{ chunk_index + 1 == chunk_count ? end : std::max(begin, text + size / chunk_count * (chunk_index + 1)) };
+		chunk_end = std::find(chunk_end, end, '\n');
+		chunk_end = chunk_end < end ? chunk_end + 1 : end;
+
+		obj_chunk chunk;
+		chunk.begin = begin;
+		chunk.end = chunk_end;
+		chunks.push_back(std::move(chunk));
+		begin = chunk_end;
+	}
+	pool.parallel_for(chunks.size(), [&chunks, flipping_v_coordinates](size_t chunk_index)
+	{
+		parse_chunk(chunks.at(chunk_index), flipping_v_coordinates);
+	});
+
+	// Stitching. The first element, corner and index of every chunk are prefix sums over the chunks before it.
+	struct chunk_offsets
+	{
+		size_t position{ 0 };
+		size_t texcoord{ 0 };
+		size_t normal{ 0 };
+		size_t corner{ 0 };
+		size_t index{ 0 };
+	};
+	std::vector<chunk_offsets> offsets(chunks.size() + 1);
+	std::vector<XMFLOAT3> positions;
+	std::vector<XMFLOAT3> normals;
+	std::vector<XMFLOAT2> texcoords;
+	for (size_t chunk_index = 0; chunk_index < chunks.size(); ++chunk_index)
+	{
+		const obj_chunk& chunk{ chunks.at(chunk_index) };
+		const chunk_offsets& first{ offsets.at(chunk_index) };
+		positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+		normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+		texcoords.insert(texcoords.end(), chunk.texcoords.begin(), chunk.texcoords.end());
+		offsets.at(chunk_index + 1) = { positions.size(), texcoords.size(), normals.size(), first.corner + chunk.corners.size(), first.index + chunk.index_count };
+
+		for (const std::pair<std::wstring, size_t>& usemtl : chunk.usemtls)
+		{
+			mesh.subsets.push_back({ usemtl.first, static_cast<uint32_t>(first.index + usemtl.second), 0 });
+		}
+		mesh.mtl_filenames.insert(mesh.mtl_filenames.end(), chunk.mtl_filenames.begin(), chunk.mtl_filenames.end());
+	}
+
+	std::vector<obj_triple> triples(offsets.back().corner);
+	pool.parallel_for(chunks.size(), [&](size_t chunk_index)
+	{
+		const std::vector<obj_corner>& corners{ chunks.at(chunk_index).corners };
+		const chunk_offsets& first{ offsets.at(chunk_index) };
+		for (size_t corner_index = 0; corner_index < corners.size(); ++corner_index)
+		{
+			const obj_corner& corner{ corners.at(corner_index) };
+			obj_triple& triple{ triples.at(first.corner + corner_index) };
+			triple.v = resolve(corner.v, corner.relative & 1, first.position, positions.size());
+			triple.vt = resolve(corner.vt, corner.relative & 2, first.texcoord, texcoords.size());
+			triple.vn = resolve(corner.vn, corner.relative & 4, first.normal, normals.size());
+		}
+	});
+
+	// Corners that share a position, texcoord and normal share a vertex. Vertices are numbered in order of first use.
+	std::vector<uint32_t> corner_vertices(triples.size());
+	std::vector<obj_triple> unique_triples;
+	{
+		size_t capacity{ 16 };
+		while (capacity < triples.size() * 2)
+		{
+			capacity <<= 1;
+		}
+		constexpr uint32_t empty{ ~0u };
+		std::vector<uint32_t> slots(capacity, empty);
+		for (size_t corner_index = 0; corner_index < triples.size(); ++corner_index)
+		{
+			const obj_triple& triple{ triples.at(corner_index) };
+			size_t slot{ static_cast<size_t>(hash(triple)) & (capacity - 1) };
+			while (slots.at(slot) != empty && !(unique_triples.at(slots.at(slot)) == triple))
+			{
+				slot = (slot + 1) & (capacity - 1);
+			}
+			if (slots.at(slot) == empty)
+			{
+				slots.at(slot) = static_cast<uint32_t>(unique_triples.size());
+				unique_triples.push_back(triple);
+			}
+			corner_vertices.at(corner_index) = slots.at(slot);
+		}
+	}
+
+	mesh.corner_count = triples.size();
+	mesh.vertices.resize(unique_triples.size());
+	pool.parallel_for(unique_triples.size(), [&](size_t vertex_index)
+	{
+		const obj_triple& triple{ unique_triples.at(vertex_index) };
+		obj_mesh::vertex& vertex{ mesh.vertices.at(vertex_index) };
+		vertex.position = positions.at(triple.v);
+		if (triple.vt >= 0)
+		{
+			vertex.texcoord = texcoords.at(triple.vt);
+		}
+		if (triple.vn >= 0)
+		{
+			vertex.normal = normals.at(triple.vn);
+		}
+	}, 4096);
+
+	mesh.indices.resize(offsets.back().index);
+	pool.parallel_for(chunks.size(), [&](size_t chunk_index)
+	{
+		const obj_chunk& chunk{ chunks.at(chunk_index) };
+		const chunk_offsets& first{ offsets.at(chunk_index) };
+		size_t corner{ first.corner };
+		uint32_t* indices{ mesh.indices.data() + first.index };
+		std::vector<XMFLOAT3> polygon;
+		for (uint32_t face_size : chunk.face_sizes)
+		{
+			polygon.resize(face_size);
+			for (uint32_t i = 0; i < face_size; ++i)
+			{
+				polygon.at(i) = mesh.vertices.at(corner_vertices.at(corner + i)).position;
+			}
+			triangulate(polygon.data(), corner_vertices.data() + corner, face_size, indices);
+			indices += (face_size - 2) * 3;
+			corner += face_size;
+		}
+	});
+
+	if (mesh.subsets.empty() && !mesh.indices.empty())
+	{
+		// A file without 'usemtl' is drawn as a single subset.
+		mesh.subsets.push_back({ L"", 0, 0 });
+	}
+	for (size_t subset_index = 0; subset_index < mesh.subsets.size(); ++subset_index)
+	{
+		const uint32_t next_start{ subset_index + 1 < mesh.subsets.size() ? mesh.subsets.at(subset_index + 1).index_start : static_cast<uint32_t>(mesh.indices.size()) };
+		mesh.subsets.at(subset_index).index_count = next_start - mesh.subsets.at(subset_index).index_start;
+	}
+}
+
+bool parse_obj(const wchar_t* obj_filename, bool flipping_v_coordinates, obj_mesh& mesh)
+{
+	mapped_file file(obj_filename);
+	if (!file.is_open())
+	{
+		return false;
+	}
+	parse_obj(file.data(), file.size(), flipping_v_coordinates, mesh);
+	return true;
+}
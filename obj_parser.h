@@ -0,0 +1,44 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// A byte oriented Wavefront OBJ reader. The file is mapped into memory, cut into chunks at line boundaries,
+// the chunks are parsed in parallel on default_thread_pool() and the results are stitched in file order.
+// Faces of any size are triangulated, relative (negative) references are resolved and corners with the same
+// position/texcoord/normal references share a vertex.
+// No Direct3D dependency; static_mesh turns the result into its buffers.
+struct obj_mesh
+{
+	// The same layout as static_mesh::vertex.
+	struct vertex
+	{
+		DirectX::XMFLOAT3 position{ 0, 0, 0 };
+		DirectX::XMFLOAT3 normal{ 0, 0, 0 };
+		DirectX::XMFLOAT2 texcoord{ 0, 0 };
+	};
+	struct subset
+	{
+		std::wstring usemtl;
+		uint32_t index_start{ 0 };
+		uint32_t index_count{ 0 };
+	};
+
+	std::vector<vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<subset> subsets;
+	std::vector<std::wstring> mtl_filenames;
+
+	// Face corners in the file. Without vertex sharing there would be one vertex per corner.
+	size_t corner_count{ 0 };
+	float vertex_reuse_ratio() const { return vertices.empty() ? 1.0f : static_cast<float>(corner_count) / static_cast<float>(vertices.size()); }
+};
+
+// Returns false if the file cannot be opened. An index that refers to a missing position, texcoord or normal throws std::out_of_range.
+bool parse_obj(const wchar_t* obj_filename, bool flipping_v_coordinates, obj_mesh& mesh);
+// The same for an OBJ text already in memory.
+void parse_obj(const char* text, size_t size, bool flipping_v_coordinates, obj_mesh& mesh);
@@ -0,0 +1,313 @@
+#include "occlusion_buffer.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+occlusion_buffer::occlusion_buffer(uint32_t width, uint32_t height)
+{
+	tile_columns = std::max<uint32_t>((width + TILE_WIDTH - 1) / TILE_WIDTH, 1);
+	tile_rows = std::max<uint32_t>((height + TILE_HEIGHT - 1) / TILE_HEIGHT, 1);
+	buffer_width = tile_columns * TILE_WIDTH;
+	buffer_height = tile_rows * TILE_HEIGHT;
+	depth_buffer.assign(static_cast<size_t>(buffer_width) * buffer_height, 1.0f);
+	block_max_depth.assign(static_cast<size_t>(buffer_width / BLOCK_SIZE) * (buffer_height / BLOCK_SIZE), 1.0f);
+}
+
+void occlusion_buffer::begin(const XMFLOAT4X4& view_projection)
+{
+	this->view_projection = view_projection;
+	std::fill(depth_buffer.begin(), depth_buffer.end(), 1.0f);
+	std::fill(block_max_depth.begin(), block_max_depth.end(), 1.0f);
+	triangles.clear();
+	statistics = {};
+}
+
+void occlusion_buffer::add_occluder(const void* positions, size_t stride, size_t vertex_count, const uint32_t* indices, size_t index_count, const XMFLOAT4X4& world)
+{
+	if (vertex_count == 0)
+	{
+		return;
+	}
+	const XMMATRIX M{ XMLoadFloat4x4(&world) * XMLoadFloat4x4(&view_projection) };
+	std::vector<XMFLOAT4> clip(vertex_count);
+	for (size_t vertex_index = 0; vertex_index < vertex_count; ++vertex_index)
+	{
+		const XMFLOAT3* position{ reinterpret_cast<const XMFLOAT3*>(static_cast<const uint8_t*>(positions) + stride * vertex_index) };
+		XMStoreFloat4(&clip.at(vertex_index), XMVector3Transform(XMLoadFloat3(position), M));
+	}
+
+	for (size_t first = 0; first + 2 < index_count; first += 3)
+	{
+		++statistics.occluder_triangles;
+		const XMFLOAT4 corners[3]
+		{
+			clip.at(std::min<size_t>(indices[first + 0], vertex_count - 1)),
+			clip.at(std::min<size_t>(indices[first + 1], vertex_count - 1)),
+			clip.at(std::min<size_t>(indices[first + 2], vertex_count - 1)),
+		};
+
+		// Wholly outside one side of the frustum.
+		auto all = [&corners](auto outside) { return outside(corners[0]) && outside(corners[1]) && outside(corners[2]); };
+		if (all([](const XMFLOAT4& c) { return c.x > c.w; }) || all([](const XMFLOAT4& c) { return c.x < -c.w; }) ||
+			all([](const XMFLOAT4& c) { return c.y > c.w; }) || all([](const XMFLOAT4& c) { return c.y < -c.w; }) ||
+			all([](const XMFLOAT4& c) { return c.z > c.w; }) || all([](const XMFLOAT4& c) { return c.z < 0.0f; }))
+		{
+			continue;
+		}
+		if (corners[0].z >= 0.0f && corners[1].z >= 0.0f && corners[2].z >= 0.0f)
+		{
+			setup_triangle(corners);
+			continue;
+		}
+
+		// Crosses the near plane (z = 0 in clip space): keep the part in front of it, a triangle or a quad.
+		XMFLOAT4 polygon[4];
+		size_t polygon_size{ 0 };
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			const XMFLOAT4& a{ corners[corner] };
+			const XMFLOAT4& b{ corners[(corner + 1) % 3] };
+			if (a.z >= 0.0f)
+			{
+				polygon[polygon_size++] = a;
+			}
+			if ((a.z >= 0.0f) != (b.z >= 0.0f))
+			{
+				const float t{ a.z / (a.z - b.z) };
+				XMStoreFloat4(&polygon[polygon_size++], XMVectorLerp(XMLoadFloat4(&a), XMLoadFloat4(&b), t));
+			}
+		}
+		for (size_t corner = 2; corner < polygon_size; ++corner)
+		{
+			const XMFLOAT4 fan[3]{ polygon[0], polygon[corner - 1], polygon[corner] };
+			setup_triangle(fan);
+		}
+	}
+}
+
+void occlusion_buffer::setup_triangle(const XMFLOAT4 clip[3])
+{
+	screen_triangle triangle;
+	float z[3];
+	for (size_t corner = 0; corner < 3; ++corner)
+	{
+		const float inverse_w{ 1.0f / clip[corner].w };
+		triangle.x[corner] = (clip[corner].x * inverse_w * 0.5f + 0.5f) * buffer_width;
+		triangle.y[corner] = (0.5f - clip[corner].y * inverse_w * 0.5f) * buffer_height;
+		z[corner] = clip[corner].z * inverse_w;
+	}
+	float area{ (triangle.x[1] - triangle.x[0]) * (triangle.y[2] - triangle.y[0]) - (triangle.x[2] - triangle.x[0]) * (triangle.y[1] - triangle.y[0]) };
+	if (std::fabs(area) < 1e-8f)
+	{
+		return;
+	}
+	if (area < 0.0f)
+	{
+		// Both windings are drawn; order the corners so that the edge functions are positive inside.
+		std::swap(triangle.x[1], triangle.x[2]);
+		std::swap(triangle.y[1], triangle.y[2]);
+		std::swap(z[1], z[2]);
+		area = -area;
+	}
+	triangle.min_x = std::max<float>(std::min<float>(triangle.x[0], std::min<float>(triangle.x[1], triangle.x[2])), 0.0f);
+	triangle.min_y = std::max<float>(std::min<float>(triangle.y[0], std::min<float>(triangle.y[1], triangle.y[2])), 0.0f);
+	triangle.max_x = std::min<float>(std::max<float>(triangle.x[0], std::max<float>(triangle.x[1], triangle.x[2])), static_cast<float>(buffer_width));
+	triangle.max_y = std::min<float>(std::max<float>(triangle.y[0], std::max<float>(triangle.y[1], triangle.y[2])), static_cast<float>(buffer_height));
+	if (triangle.min_x >= triangle.max_x || triangle.min_y >= triangle.max_y)
+	{
+		return;
+	}
+	const float dx1{ triangle.x[1] - triangle.x[0] }, dy1{ triangle.y[1] - triangle.y[0] }, dz1{ z[1] - z[0] };
+	const float dx2{ triangle.x[2] - triangle.x[0] }, dy2{ triangle.y[2] - triangle.y[0] }, dz2{ z[2] - z[0] };
+	triangle.depth_dx = (dz1 * dy2 - dz2 * dy1) / area;
+	triangle.depth_dy = (dz2 * dx1 - dz1 * dx2) / area;
+	triangle.depth_c = z[0] - triangle.depth_dx * triangle.x[0] - triangle.depth_dy * triangle.y[0];
+	triangles.push_back(triangle);
+}
+
+void occlusion_buffer::rasterize()
+{
+	const uint32_t tile_count{ tile_columns * tile_rows };
+	std::vector<std::vector<uint32_t>> bins(tile_count);
+	for (uint32_t triangle_index = 0; triangle_index < triangles.size(); ++triangle_index)
+	{
+		const screen_triangle& triangle{ triangles[triangle_index] };
+		const uint32_t column0{ static_cast<uint32_t>(triangle.min_x) / TILE_WIDTH };
+		const uint32_t column1{ std::min<uint32_t>(static_cast<uint32_t>(triangle.max_x) / TILE_WIDTH, tile_columns - 1) };
+		const uint32_t row0{ static_cast<uint32_t>(triangle.min_y) / TILE_HEIGHT };
+		const uint32_t row1{ std::min<uint32_t>(static_cast<uint32_t>(triangle.max_y) / TILE_HEIGHT, tile_rows - 1) };
+		for (uint32_t row = row0; row <= row1; ++row)
+		{
+			for (uint32_t column = column0; column <= column1; ++column)
+			{
+				bins[row * tile_columns + column].push_back(triangle_index);
+				++statistics.binned_triangles;
+			}
+		}
+	}
+	statistics.rasterized_triangles = triangles.size();
+
+	default_thread_pool().parallel_for(tile_count, [&](size_t tile_index)
+	{
+		rasterize_tile(static_cast<uint32_t>(tile_index), bins[tile_index]);
+	});
+}
+
+void occlusion_buffer::rasterize_tile(uint32_t tile_index, const std::vector<uint32_t>& bin)
+{
+	const uint32_t tile_x{ (tile_index % tile_columns) * TILE_WIDTH };
+	const uint32_t tile_y{ (tile_index / tile_columns) * TILE_HEIGHT };
+	const XMVECTOR lane_offsets{ XMVectorSet(0.5f, 1.5f, 2.5f, 3.5f) };
+	const XMVECTOR zero{ XMVectorZero() };
+
+	for (uint32_t triangle_index : bin)
+	{
+		const screen_triangle& triangle{ triangles[triangle_index] };
+		// Pixels whose centers may lie inside, limited to the tile; columns start on a multiple of four.
+		const uint32_t x0{ std::max<uint32_t>(static_cast<uint32_t>(triangle.min_x), tile_x) & ~3u };
+		const uint32_t x1{ std::min<uint32_t>(static_cast<uint32_t>(std::ceil(triangle.max_x)), tile_x + TILE_WIDTH) };
+		const uint32_t y0{ std::max<uint32_t>(static_cast<uint32_t>(triangle.min_y), tile_y) };
+		const uint32_t y1{ std::min<uint32_t>(static_cast<uint32_t>(std::ceil(triangle.max_y)), tile_y + TILE_HEIGHT) };
+		if (x0 >= x1 || y0 >= y1)
+		{
+			continue;
+		}
+
+		// Edge function of the edge from corner i to corner i + 1: a x + b y + c, positive on the inner side.
+		XMVECTOR a[3], step[3];
+		float b[3], c[3];
+		for (size_t edge = 0; edge < 3; ++edge)
+		{
+			const size_t next{ (edge + 1) % 3 };
+			const float ea{ -(triangle.y[next] - triangle.y[edge]) };
+			b[edge] = triangle.x[next] - triangle.x[edge];
+			c[edge] = -(ea * triangle.x[edge] + b[edge] * triangle.y[edge]);
+			a[edge] = XMVectorReplicate(ea);
+			step[edge] = XMVectorReplicate(ea * 4.0f);
+		}
+		const XMVECTOR depth_dx{ XMVectorReplicate(triangle.depth_dx) };
+		const XMVECTOR depth_step{ XMVectorReplicate(triangle.depth_dx * 4.0f) };
+		const XMVECTOR first_x{ XMVectorAdd(XMVectorReplicate(static_cast<float>(x0)), lane_offsets) };
+
+		for (uint32_t y = y0; y < y1; ++y)
+		{
+			const float center_y{ y + 0.5f };
+			XMVECTOR edges[3];
+			for (size_t edge = 0; edge < 3; ++edge)
+			{
+				edges[edge] = XMVectorMultiplyAdd(a[edge], first_x, XMVectorReplicate(b[edge] * center_y + c[edge]));
+			}
+			XMVECTOR depth{ XMVectorMultiplyAdd(depth_dx, first_x, XMVectorReplicate(triangle.depth_dy * center_y + triangle.depth_c)) };
+			float* row{ depth_buffer.data() + static_cast<size_t>(y) * buffer_width };
+			for (uint32_t x = x0; x < x1; x += 4)
+			{
+				// Strictly inside only: a pixel on an edge is left to the neighbour or to nobody, never wrongly occluded.
+				const XMVECTOR inside{ XMVectorAndInt(XMVectorGreater(edges[0], zero), XMVectorAndInt(XMVectorGreater(edges[1], zero), XMVectorGreater(edges[2], zero))) };
+				if (!XMVector4EqualInt(inside, XMVectorFalseInt()))
+				{
+					const XMVECTOR current{ XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x)) };
+					XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(row + x), XMVectorSelect(current, XMVectorMin(current, depth), inside));
+				}
+				for (size_t edge = 0; edge < 3; ++edge)
+				{
+					edges[edge] = XMVectorAdd(edges[edge], step[edge]);
+				}
+				depth = XMVectorAdd(depth, depth_step);
+			}
+		}
+	}
+
+	// The farthest depth of each block of this tile.
+	const uint32_t blocks_per_row{ buffer_width / BLOCK_SIZE };
+	for (uint32_t block_y = tile_y; block_y < tile_y + TILE_HEIGHT; block_y += BLOCK_SIZE)
+	{
+		for (uint32_t block_x = tile_x; block_x < tile_x + TILE_WIDTH; block_x += BLOCK_SIZE)
+		{
+			XMVECTOR farthest{ zero };
+			for (uint32_t y = block_y; y < block_y + BLOCK_SIZE; ++y)
+			{
+				const float* row{ depth_buffer.data() + static_cast<size_t>(y) * buffer_width + block_x };
+				for (uint32_t x = 0; x < BLOCK_SIZE; x += 4)
+				{
+					farthest = XMVectorMax(farthest, XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(row + x)));
+				}
+			}
+			XMFLOAT4 lanes;
+			XMStoreFloat4(&lanes, farthest);
+			block_max_depth[(block_y / BLOCK_SIZE) * blocks_per_row + block_x / BLOCK_SIZE] = std::max<float>(std::max<float>(lanes.x, lanes.y), std::max<float>(lanes.z, lanes.w));
+		}
+	}
+}
+
+bool occlusion_buffer::is_visible(const XMFLOAT3 bounding_box[2]) const
+{
+	const XMMATRIX M{ XMLoadFloat4x4(&view_projection) };
+	float min_x{ FLT_MAX }, min_y{ FLT_MAX }, max_x{ -FLT_MAX }, max_y{ -FLT_MAX };
+	float nearest{ FLT_MAX };
+	for (int corner = 0; corner < 8; ++corner)
+	{
+		XMFLOAT4 clip;
+		XMStoreFloat4(&clip, XMVector3Transform(XMVectorSet(bounding_box[corner & 1].x, bounding_box[(corner >> 1) & 1].y, bounding_box[(corner >> 2) & 1].z, 1.0f), M));
+		if (clip.z < 0.0f)
+		{
+			// Reaches in front of the near plane; the camera may be inside or right next to it.
+			return true;
+		}
+		const float inverse_w{ 1.0f / clip.w };
+		const float x{ (clip.x * inverse_w * 0.5f + 0.5f) * buffer_width };
+		const float y{ (0.5f - clip.y * inverse_w * 0.5f) * buffer_height };
+		min_x = std::min<float>(min_x, x);
+		max_x = std::max<float>(max_x, x);
+		min_y = std::min<float>(min_y, y);
+		max_y = std::max<float>(max_y, y);
+		nearest = std::min<float>(nearest, clip.z * inverse_w);
+	}
+
+	// Every pixel the screen rectangle of the box touches.
+	if (max_x <= 0.0f || max_y <= 0.0f || min_x >= buffer_width || min_y >= buffer_height)
+	{
+		return false;
+	}
+	const uint32_t x0{ static_cast<uint32_t>(std::max<float>(min_x, 0.0f)) };
+	const uint32_t y0{ static_cast<uint32_t>(std::max<float>(min_y, 0.0f)) };
+	const uint32_t x1{ std::min<uint32_t>(static_cast<uint32_t>(std::ceil(max_x)), buffer_width) };
+	const uint32_t y1{ std::min<uint32_t>(static_cast<uint32_t>(std::ceil(max_y)), buffer_height) };
+
+	const uint32_t blocks_per_row{ buffer_width / BLOCK_SIZE };
+	for (uint32_t block_y = y0 / BLOCK_SIZE; block_y * BLOCK_SIZE < y1; ++block_y)
+	{
+		for (uint32_t block_x = x0 / BLOCK_SIZE; block_x * BLOCK_SIZE < x1; ++block_x)
+		{
+			if (block_max_depth[block_y * blocks_per_row + block_x] < nearest)
+			{
+				continue; // the whole block is in front of the box
+			}
+			const uint32_t px0{ std::max<uint32_t>(block_x * BLOCK_SIZE, x0) }, px1{ std::min<uint32_t>((block_x + 1) * BLOCK_SIZE, x1) };
+			const uint32_t py0{ std::max<uint32_t>(block_y * BLOCK_SIZE, y0) }, py1{ std::min<uint32_t>((block_y + 1) * BLOCK_SIZE, y1) };
+			for (uint32_t y = py0; y < py1; ++y)
+			{
+				const float* row{ depth_buffer.data() + static_cast<size_t>(y) * buffer_width };
+				for (uint32_t x = px0; x < px1; ++x)
+				{
+					if (row[x] >= nearest)
+					{
+						return true;
+					}
+				}
+			}
+		}
+	}
+	return false;
+}
+
+void occlusion_buffer::test(const XMFLOAT3 (*bounding_boxes)[2], size_t count, uint8_t* visible) const
+{
+	default_thread_pool().parallel_for(count, [&](size_t box_index)
+	{
+		visible[box_index] = is_visible(bounding_boxes[box_index]) ? 1 : 0;
+	}, 64);
+}
@@ -0,0 +1,73 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Software occlusion culling. A few occluder meshes (simplified level geometry) are rasterized on the CPU into a small
+// depth buffer, then object boxes are tested against it before they are submitted for drawing.
+// The screen is cut into tiles that are rasterized in parallel on default_thread_pool(), four pixels per DirectXMath
+// vector. A second level keeps the farthest depth of each 8x8 block so most box tests never touch single pixels.
+// Depth is z/w as Direct3D writes it: 0 at the near plane, 1 at the far plane and where nothing was drawn.
+// No Direct3D dependency.
+class occlusion_buffer
+{
+public:
+	static constexpr uint32_t TILE_WIDTH{ 32 };
+	static constexpr uint32_t TILE_HEIGHT{ 32 };
+	static constexpr uint32_t BLOCK_SIZE{ 8 };
+
+	// Width and height are rounded up to whole tiles.
+	explicit occlusion_buffer(uint32_t width = 256, uint32_t height = 128);
+
+	// Starts a frame: clears the depth and forgets the occluders.
+	void begin(const DirectX::XMFLOAT4X4& view_projection);
+	// Queues the triangles of an occluder. 'positions' points at the first position and 'stride' is the distance in
+	// bytes between two vertices, as for triangle_bvh. Triangles are clipped against the near plane here.
+	void add_occluder(const void* positions, size_t stride, size_t vertex_count, const uint32_t* indices, size_t index_count, const DirectX::XMFLOAT4X4& world);
+	// Rasterizes the queued occluders and builds the block level. Call once, after the last add_occluder.
+	void rasterize();
+
+	// False only if the world space box is certainly hidden behind the occluders (or wholly off screen).
+	bool is_visible(const DirectX::XMFLOAT3 bounding_box[2]) const;
+	// is_visible for many boxes, spread over the thread pool. visible[i] is 1 or 0.
+	void test(const DirectX::XMFLOAT3 (*bounding_boxes)[2], size_t count, uint8_t* visible) const;
+
+	uint32_t width() const { return buffer_width; }
+	uint32_t height() const { return buffer_height; }
+	// Row-major, 'width()' floats per row.
+	const std::vector<float>& depth() const { return depth_buffer; }
+
+	struct rasterize_statistics
+	{
+		size_t occluder_triangles{ 0 };
+		size_t rasterized_triangles{ 0 }; // after clipping, culling of off-screen and empty triangles
+		size_t binned_triangles{ 0 }; // sum over tiles
+	};
+	rasterize_statistics statistics;
+
+private:
+	uint32_t buffer_width;
+	uint32_t buffer_height;
+	uint32_t tile_columns;
+	uint32_t tile_rows;
+	DirectX::XMFLOAT4X4 view_projection{};
+
+	std::vector<float> depth_buffer;
+	std::vector<float> block_max_depth; // farthest depth of each BLOCK_SIZE x BLOCK_SIZE block
+
+	// A triangle in pixel coordinates, with counter-clockwise winding on screen and depth as a plane z = a x + b y + c.
+	struct screen_triangle
+	{
+		float x[3];
+		float y[3];
+		float depth_dx, depth_dy, depth_c;
+		float min_x, min_y, max_x, max_y;
+	};
+	std::vector<screen_triangle> triangles;
+
+	void setup_triangle(const DirectX::XMFLOAT4 clip[3]);
+	void rasterize_tile(uint32_t tile_index, const std::vector<uint32_t>& bin);
+};
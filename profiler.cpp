@@ -0,0 +1,219 @@
+#include "profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <map>
+
+namespace
+{
+	int64_t clock_nanoseconds()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	uint64_t next_generation()
+	{
+		static std::atomic<uint64_t> generation{ 0 };
+		return ++generation;
+	}
+
+	uint64_t ring_size(size_t capacity)
+	{
+		uint64_t size{ 1 };
+		while (size < capacity)
+		{
+			size <<= 1;
+		}
+		return size;
+	}
+
+	// Nearest-rank percentile of sorted durations.
+	double percentile(const std::vector<double>& sorted, double fraction)
+	{
+		const size_t rank{ static_cast<size_t>(std::ceil(fraction * sorted.size())) };
+		return sorted.at(std::min<size_t>(std::max<size_t>(rank, 1), sorted.size()) - 1);
+	}
+
+	void write_json_string(std::ofstream& stream, const char* text)
+	{
+		stream << '"';
+		for (const char* c = text; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				stream << '\\' << *c;
+			}
+			else if (static_cast<unsigned char>(*c) < 0x20)
+			{
+				stream << ' ';
+			}
+			else
+			{
+				stream << *c;
+			}
+		}
+		stream << '"';
+	}
+}
+
+profiler::profiler(size_t ring_capacity, size_t window_frames) : ring_mask(ring_size(std::max<size_t>(ring_capacity, 2)) - 1), window_frames(std::max<size_t>(window_frames, 1)), epoch(clock_nanoseconds()), generation(next_generation())
+{
+}
+
+int64_t profiler::now() const
+{
+	return clock_nanoseconds() - epoch;
+}
+
+profiler::thread_ring& profiler::ring()
+{
+	struct cached_ring
+	{
+		uint64_t generation{ 0 };
+		thread_ring* ring{ nullptr };
+	};
+	thread_local cached_ring cached;
+	if (cached.generation != generation)
+	{
+		std::unique_ptr<thread_ring> ring{ std::make_unique<thread_ring>() };
+		ring->events = std::make_unique<event[]>(ring_mask + 1);
+
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		ring->thread = static_cast<uint32_t>(rings.size());
+		cached.ring = ring.get();
+		cached.generation = generation;
+		rings.emplace_back(std::move(ring));
+	}
+	return *cached.ring;
+}
+
+void profiler::open_scope()
+{
+	++ring().depth;
+}
+
+void profiler::close_scope(const char* name, int64_t begin)
+{
+	const int64_t end{ now() };
+	thread_ring& ring{ this->ring() };
+	--ring.depth;
+
+	const uint64_t written{ ring.written.load(std::memory_order_relaxed) };
+	if (written - ring.read.load(std::memory_order_acquire) > ring_mask)
+	{
+		ring.dropped.fetch_add(1, std::memory_order_relaxed);
+		return;
+	}
+	ring.events[written & ring_mask] = { name, begin, end, ring.depth, ring.thread };
+	ring.written.store(written + 1, std::memory_order_release);
+}
+
+void profiler::collect()
+{
+	std::vector<event> frame;
+	{
+		std::lock_guard<std::mutex> lock(rings_mutex);
+		for (const std::unique_ptr<thread_ring>& ring : rings)
+		{
+			const uint64_t read{ ring->read.load(std::memory_order_relaxed) };
+			const uint64_t written{ ring->written.load(std::memory_order_acquire) };
+			for (uint64_t index = read; index < written; ++index)
+			{
+				frame.push_back(ring->events[index & ring_mask]);
+			}
+			ring->read.store(written, std::memory_order_release);
+		}
+	}
+	frames.emplace_back(std::move(frame));
+	while (frames.size() > window_frames)
+	{
+		frames.pop_front();
+	}
+}
+
+void profiler::statistics(std::vector<scope_statistics>& statistics) const
+{
+	std::map<std::string, std::vector<double>> durations;
+	for (const std::vector<event>& frame : frames)
+	{
+		for (const event& event : frame)
+		{
+			durations[event.name].push_back(static_cast<double>(event.end - event.begin) * 1e-6);
+		}
+	}
+
+	statistics.clear();
+	for (auto& [name, scope_durations] : durations)
+	{
+		std::sort(scope_durations.begin(), scope_durations.end());
+		scope_statistics scope;
+		scope.name = name;
+		scope.count = scope_durations.size();
+		for (double duration : scope_durations)
+		{
+			scope.total += duration;
+		}
+		scope.minimum = scope_durations.front();
+		scope.maximum = scope_durations.back();
+		scope.average = scope.total / scope.count;
+		scope.p95 = percentile(scope_durations, 0.95);
+		scope.p99 = percentile(scope_durations, 0.99);
+		statistics.push_back(std::move(scope));
+	}
+	std::sort(statistics.begin(), statistics.end(), [](const scope_statistics& a, const scope_statistics& b) { return a.total > b.total; });
+}
+
+bool profiler::write_chrome_trace(const char* filename) const
+{
+	std::ofstream stream(filename);
+	if (!stream)
+	{
+		return false;
+	}
+	stream.setf(std::ios::fixed);
+	stream.precision(3);
+
+	stream << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+	bool first{ true };
+	uint32_t thread_count{ 0 };
+	for (const std::vector<event>& frame : frames)
+	{
+		for (const event& event : frame)
+		{
+			stream << (first ? "\n" : ",\n") << "{\"name\":";
+			write_json_string(stream, event.name);
+			// Timestamps are in microseconds; complete events on one thread nest by their extents.
+			stream << ",\"cat\":\"cpu\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+				<< ",\"ts\":" << static_cast<double>(event.begin) * 1e-3 << ",\"dur\":" << static_cast<double>(event.end - event.begin) * 1e-3
+				<< ",\"args\":{\"depth\":" << event.depth << "}}";
+			first = false;
+			thread_count = std::max<uint32_t>(thread_count, event.thread + 1);
+		}
+	}
+	for (uint32_t thread = 0; thread < thread_count; ++thread)
+	{
+		stream << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << thread << ",\"args\":{\"name\":\"thread " << thread << "\"}}";
+		first = false;
+	}
+	stream << "\n]}\n";
+	return static_cast<bool>(stream);
+}
+
+size_t profiler::dropped_events() const
+{
+	std::lock_guard<std::mutex> lock(rings_mutex);
+	size_t dropped{ 0 };
+	for (const std::unique_ptr<thread_ring>& ring : rings)
+	{
+		dropped += ring->dropped.load(std::memory_order_relaxed);
+	}
+	return dropped;
+}
+
+profiler& default_profiler()
+{
+	static profiler profiler;
+	return profiler;
+}
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Named, nestable CPU scopes. A scope is timed with std::chrono::steady_clock from construction to destruction of a
+// profile_scope (see PROFILE_SCOPE) and written to a ring buffer owned by the thread that ran it, without locking.
+// 'collect' drains every thread's ring once per frame into a window of the last 'window_frames' frames, from which
+// per-scope statistics are computed and a Chrome trace (chrome://tracing, Perfetto) is written.
+// A ring that fills up before it is collected drops its newest scopes and counts them.
+// No Direct3D dependency.
+class profiler
+{
+public:
+	struct event
+	{
+		const char* name; // must outlive the profiler, usually a string literal
+		int64_t begin; // nanoseconds since the profiler was created
+		int64_t end;
+		uint32_t depth; // how many scopes of the same thread were open around it
+		uint32_t thread; // registration order of the thread, 0 for the first one to record
+	};
+
+	struct scope_statistics
+	{
+		std::string name;
+		size_t count{ 0 }; // times the scope ran in the window
+		// Durations of single runs, in milliseconds.
+		double minimum{ 0 };
+		double average{ 0 };
+		double p95{ 0 };
+		double p99{ 0 };
+		double maximum{ 0 };
+		double total{ 0 };
+	};
+
+	explicit profiler(size_t ring_capacity = 16384/*events per thread, rounded up to a power of two*/, size_t window_frames = 120);
+	virtual ~profiler() = default;
+	profiler(const profiler&) = delete;
+	profiler& operator=(const profiler&) = delete;
+	profiler(profiler&&) noexcept = delete;
+	profiler& operator=(profiler&&) noexcept = delete;
+
+	// Scopes opened while disabled are not recorded.
+	std::atomic<bool> enabled{ true };
+
+	int64_t now() const;
+
+	// Called by profile_scope on the thread that ran the scope.
+	void open_scope();
+	void close_scope(const char* name, int64_t begin);
+
+	// Ends a frame of the window with everything recorded since the last call. Call from one thread at a time.
+	void collect();
+
+	// Per-scope statistics over the window, by name, longest total first.
+	void statistics(std::vector<scope_statistics>& statistics) const;
+	// Writes the window as complete events of the Chrome trace event format. Returns false if the file can't be written.
+	bool write_chrome_trace(const char* filename) const;
+
+	size_t dropped_events() const;
+	size_t frame_count() const { return frames.size(); }
+
+private:
+	struct thread_ring
+	{
+		std::unique_ptr<event[]> events;
+		// Only the owning thread advances 'written' and only 'collect' advances 'read'.
+		std::atomic<uint64_t> written{ 0 };
+		std::atomic<uint64_t> read{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		uint32_t thread{ 0 };
+		uint32_t depth{ 0 };
+	};
+	thread_ring& ring();
+
+	const uint64_t ring_mask;
+	const size_t window_frames;
+	const int64_t epoch;
+	// Tells this profiler apart from one created later at the same address in the ring each thread caches. A thread
+	// caches the ring of one profiler, so recording into several in turn registers a new ring on every switch.
+	const uint64_t generation;
+
+	// Locked only when a thread records for the first time and by 'collect'.
+	mutable std::mutex rings_mutex;
+	std::vector<std::unique_ptr<thread_ring>> rings;
+
+	std::deque<std::vector<event>> frames;
+};
+
+// The profiler the engine is instrumented with. It is created on first use.
+profiler& default_profiler();
+
+// Times its own lifetime as a scope of 'name'.
+class profile_scope
+{
+public:
+	explicit profile_scope(const char* name, profiler& profiler = default_profiler()) : name(name), owner(profiler.enabled.load(std::memory_order_relaxed) ? &profiler : nullptr)
+	{
+		if (owner)
+		{
+			owner->open_scope();
+			begin = owner->now();
+		}
+	}
+	~profile_scope()
+	{
+		if (owner)
+		{
+			owner->close_scope(name, begin);
+		}
+	}
+	profile_scope(const profile_scope&) = delete;
+	profile_scope& operator=(const profile_scope&) = delete;
+	profile_scope(profile_scope&&) noexcept = delete;
+	profile_scope& operator=(profile_scope&&) noexcept = delete;
+
+private:
+	const char* name;
+	profiler* owner;
+	int64_t begin{ 0 };
+};
+
+#define PROFILE_SCOPE_JOIN_(a, b) a##b
+#define PROFILE_SCOPE_JOIN(a, b) PROFILE_SCOPE_JOIN_(a, b)
+// Times the rest of the enclosing block as a scope of 'name' on default_profiler.
+#define PROFILE_SCOPE(name) profile_scope PROFILE_SCOPE_JOIN(profile_scope_, __LINE__){ name }
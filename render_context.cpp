@@ -0,0 +1,222 @@
+#include "render_context.h"
+
+#include <algorithm>
+
+template<class T>
+bool state_filtering_context::update(shadow<T>& shadow, const T& value)
+{
+	const bool differs{ !shadow.known || !(shadow.value == value) };
+	shadow.value = value;
+	shadow.known = true;
+	return differs;
+}
+
+template<class T, size_t N>
+bool state_filtering_context::update(slot_shadows<T, N>& shadows, uint32_t start_slot, uint32_t slot_count, const T* values)
+{
+	const uint32_t mask{ slot_mask(start_slot, start_slot + slot_count, N) };
+	bool differs{ start_slot + slot_count > N || (shadows.known & mask) != mask };
+	for (uint32_t slot = start_slot; slot < start_slot + slot_count && slot < N; ++slot)
+	{
+		const T& value{ values[slot - start_slot] };
+		differs = differs || !(shadows.values[slot] == value);
+		shadows.values[slot] = value;
+	}
+	shadows.known |= mask;
+	return differs;
+}
+
+uint32_t state_filtering_context::slot_mask(uint32_t start_slot, uint32_t end_slot, uint32_t slot_count)
+{
+	end_slot = std::min<uint32_t>(end_slot, slot_count);
+	if (start_slot >= end_slot)
+	{
+		return 0;
+	}
+	const uint32_t below_end{ end_slot >= 32 ? ~0u : (1u << end_slot) - 1 };
+	return below_end & ~((1u << start_slot) - 1);
+}
+
+bool state_filtering_context::count(bool issue)
+{
+	++(issue ? statistics.issued : statistics.filtered);
+	return issue;
+}
+
+void state_filtering_context::invalidate()
+{
+	invalidate_bindings();
+	ps_samplers.known = 0;
+	blend_state.known = false;
+	depth_stencil_state.known = false;
+	rasterizer_state.known = false;
+}
+
+void state_filtering_context::invalidate_bindings()
+{
+	input_layout.known = false;
+	topology.known = false;
+	vertex_buffers.known = 0;
+	index_buffer.known = false;
+	vertex_shader.known = false;
+	pixel_shader.known = false;
+	vs_constant_buffers.known = 0;
+	ps_constant_buffers.known = 0;
+	vs_shader_resources.known = 0;
+	ps_shader_resources.known = 0;
+}
+
+void state_filtering_context::IASetInputLayout(ID3D11InputLayout* input_layout)
+{
+	if (count(update(this->input_layout, input_layout)))
+	{
+		context.IASetInputLayout(input_layout);
+	}
+}
+
+void state_filtering_context::IASetPrimitiveTopology(uint32_t topology)
+{
+	if (count(update(this->topology, topology)))
+	{
+		context.IASetPrimitiveTopology(topology);
+	}
+}
+
+void state_filtering_context::IASetVertexBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* vertex_buffers, const uint32_t* strides, const uint32_t* offsets)
+{
+	const uint32_t mask{ slot_mask(start_slot, start_slot + num_buffers, VERTEX_BUFFER_SLOTS) };
+	bool differs{ start_slot + num_buffers > VERTEX_BUFFER_SLOTS || (this->vertex_buffers.known & mask) != mask };
+	for (uint32_t slot = start_slot; slot < start_slot + num_buffers && slot < VERTEX_BUFFER_SLOTS; ++slot)
+	{
+		const uint32_t index{ slot - start_slot };
+		const vertex_buffer_binding binding{ vertex_buffers[index], strides[index], offsets[index] };
+		differs = differs || !(this->vertex_buffers.values[slot] == binding);
+		this->vertex_buffers.values[slot] = binding;
+	}
+	this->vertex_buffers.known |= mask;
+	if (count(differs))
+	{
+		context.IASetVertexBuffers(start_slot, num_buffers, vertex_buffers, strides, offsets);
+	}
+}
+
+void state_filtering_context::IASetIndexBuffer(ID3D11Buffer* index_buffer, uint32_t format, uint32_t offset)
+{
+	if (count(update(this->index_buffer, { index_buffer, format, offset })))
+	{
+		context.IASetIndexBuffer(index_buffer, format, offset);
+	}
+}
+
+void state_filtering_context::VSSetShader(ID3D11VertexShader* vertex_shader)
+{
+	if (count(update(this->vertex_shader, vertex_shader)))
+	{
+		context.VSSetShader(vertex_shader);
+	}
+}
+
+void state_filtering_context::PSSetShader(ID3D11PixelShader* pixel_shader)
+{
+	if (count(update(this->pixel_shader, pixel_shader)))
+	{
+		context.PSSetShader(pixel_shader);
+	}
+}
+
+void state_filtering_context::VSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers)
+{
+	if (count(update(vs_constant_buffers, start_slot, num_buffers, constant_buffers)))
+	{
+		context.VSSetConstantBuffers(start_slot, num_buffers, constant_buffers);
+	}
+}
+
+void state_filtering_context::PSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers)
+{
+	if (count(update(ps_constant_buffers, start_slot, num_buffers, constant_buffers)))
+	{
+		context.PSSetConstantBuffers(start_slot, num_buffers, constant_buffers);
+	}
+}
+
+void state_filtering_context::VSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views)
+{
+	if (count(update(vs_shader_resources, start_slot, num_views, shader_resource_views)))
+	{
+		context.VSSetShaderResources(start_slot, num_views, shader_resource_views);
+	}
+}
+
+void state_filtering_context::PSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views)
+{
+	if (count(update(ps_shader_resources, start_slot, num_views, shader_resource_views)))
+	{
+		context.PSSetShaderResources(start_slot, num_views, shader_resource_views);
+	}
+}
+
+void state_filtering_context::PSSetSamplers(uint32_t start_slot, uint32_t num_samplers, ID3D11SamplerState* const* sampler_states)
+{
+	if (count(update(ps_samplers, start_slot, num_samplers, sampler_states)))
+	{
+		context.PSSetSamplers(start_slot, num_samplers, sampler_states);
+	}
+}
+
+void state_filtering_context::OMSetBlendState(ID3D11BlendState* blend_state, const float blend_factor[4], uint32_t sample_mask)
+{
+	blend_binding binding{ blend_state, { 1, 1, 1, 1 }, sample_mask };
+	if (blend_factor)
+	{
+		for (int component = 0; component < 4; ++component)
+		{
+			binding.factor[component] = blend_factor[component];
+		}
+	}
+	if (count(update(this->blend_state, binding)))
+	{
+		context.OMSetBlendState(blend_state, blend_factor, sample_mask);
+	}
+}
+
+void state_filtering_context::OMSetDepthStencilState(ID3D11DepthStencilState* depth_stencil_state, uint32_t stencil_ref)
+{
+	if (count(update(this->depth_stencil_state, { depth_stencil_state, stencil_ref })))
+	{
+		context.OMSetDepthStencilState(depth_stencil_state, stencil_ref);
+	}
+}
+
+void state_filtering_context::RSSetState(ID3D11RasterizerState* rasterizer_state)
+{
+	if (count(update(this->rasterizer_state, rasterizer_state)))
+	{
+		context.RSSetState(rasterizer_state);
+	}
+}
+
+void state_filtering_context::UpdateSubresource(ID3D11Resource* resource, uint32_t subresource, const D3D11_BOX* box, const void* data, uint32_t row_pitch, uint32_t depth_pitch)
+{
+	context.UpdateSubresource(resource, subresource, box, data, row_pitch, depth_pitch);
+}
+
+long state_filtering_context::Map(ID3D11Resource* resource, uint32_t subresource, uint32_t map_type, uint32_t map_flags, D3D11_MAPPED_SUBRESOURCE* mapped_subresource)
+{
+	return context.Map(resource, subresource, map_type, map_flags, mapped_subresource);
+}
+
+void state_filtering_context::Unmap(ID3D11Resource* resource, uint32_t subresource)
+{
+	context.Unmap(resource, subresource);
+}
+
+void state_filtering_context::DrawIndexed(uint32_t index_count, uint32_t start_index_location, int32_t base_vertex_location)
+{
+	context.DrawIndexed(index_count, start_index_location, base_vertex_location);
+}
+
+void state_filtering_context::DrawIndexedInstanced(uint32_t index_count_per_instance, uint32_t instance_count, uint32_t start_index_location, int32_t base_vertex_location, uint32_t start_instance_location)
+{
+	context.DrawIndexedInstanced(index_count_per_instance, instance_count, start_index_location, base_vertex_location, start_instance_location);
+}
@@ -0,0 +1,181 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct ID3D11Resource;
+struct ID3D11Buffer;
+struct ID3D11InputLayout;
+struct ID3D11VertexShader;
+struct ID3D11PixelShader;
+struct ID3D11ShaderResourceView;
+struct ID3D11SamplerState;
+struct ID3D11BlendState;
+struct ID3D11DepthStencilState;
+struct ID3D11RasterizerState;
+struct D3D11_BOX;
+struct D3D11_MAPPED_SUBRESOURCE;
+
+// The part of ID3D11DeviceContext that the renderers use, as an interface so that calls can be filtered, counted or
+// recorded. Methods keep the Direct3D names and arguments; enumerations (topology, index format) are passed as their
+// values, HRESULT as long, and shader class instances are not supported. d3d11_render_context forwards to a real context.
+// No Direct3D dependency: the types are only declared.
+class render_context
+{
+public:
+	virtual ~render_context() = default;
+
+	virtual void IASetInputLayout(ID3D11InputLayout* input_layout) = 0;
+	virtual void IASetPrimitiveTopology(uint32_t topology) = 0;
+	virtual void IASetVertexBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* vertex_buffers, const uint32_t* strides, const uint32_t* offsets) = 0;
+	virtual void IASetIndexBuffer(ID3D11Buffer* index_buffer, uint32_t format, uint32_t offset) = 0;
+
+	virtual void VSSetShader(ID3D11VertexShader* vertex_shader) = 0;
+	virtual void PSSetShader(ID3D11PixelShader* pixel_shader) = 0;
+	virtual void VSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) = 0;
+	virtual void PSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) = 0;
+	virtual void VSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) = 0;
+	virtual void PSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) = 0;
+	virtual void PSSetSamplers(uint32_t start_slot, uint32_t num_samplers, ID3D11SamplerState* const* sampler_states) = 0;
+
+	// 'blend_factor' may be nullptr, which Direct3D takes as 1, 1, 1, 1.
+	virtual void OMSetBlendState(ID3D11BlendState* blend_state, const float blend_factor[4], uint32_t sample_mask) = 0;
+	virtual void OMSetDepthStencilState(ID3D11DepthStencilState* depth_stencil_state, uint32_t stencil_ref) = 0;
+	virtual void RSSetState(ID3D11RasterizerState* rasterizer_state) = 0;
+
+	virtual void UpdateSubresource(ID3D11Resource* resource, uint32_t subresource, const D3D11_BOX* box, const void* data, uint32_t row_pitch, uint32_t depth_pitch) = 0;
+	virtual long Map(ID3D11Resource* resource, uint32_t subresource, uint32_t map_type, uint32_t map_flags, D3D11_MAPPED_SUBRESOURCE* mapped_subresource) = 0;
+	virtual void Unmap(ID3D11Resource* resource, uint32_t subresource) = 0;
+	virtual void DrawIndexed(uint32_t index_count, uint32_t start_index_location, int32_t base_vertex_location) = 0;
+	virtual void DrawIndexedInstanced(uint32_t index_count_per_instance, uint32_t instance_count, uint32_t start_index_location, int32_t base_vertex_location, uint32_t start_instance_location) = 0;
+};
+
+// Keeps a copy of the bindings last passed to 'context' and drops the calls that would not change them. A call that
+// sets several slots is forwarded whole if any slot changes. Updates, maps and draws are always forwarded.
+// Anything that sets state on the real context behind this object's back must be followed by 'invalidate' (or
+// 'invalidate_bindings' if it left samplers and output merger and rasterizer states alone), after which every
+// binding is issued again once.
+// No Direct3D dependency.
+class state_filtering_context : public render_context
+{
+public:
+	// Slots past these are never filtered.
+	static constexpr uint32_t VERTEX_BUFFER_SLOTS{ 8 };
+	static constexpr uint32_t CONSTANT_BUFFER_SLOTS{ 14 };
+	static constexpr uint32_t SHADER_RESOURCE_SLOTS{ 16 };
+	static constexpr uint32_t SAMPLER_SLOTS{ 16 };
+
+	explicit state_filtering_context(render_context& context) : context(context) {}
+
+	void invalidate();
+	// Forgets the input assembler, shader, constant buffer and shader resource bindings.
+	void invalidate_bindings();
+
+	struct call_statistics
+	{
+		size_t issued{ 0 };
+		size_t filtered{ 0 };
+	};
+	// State calls since the last reset, usually one frame. Updates, maps and draws are not counted.
+	call_statistics statistics;
+	void reset_statistics() { statistics = {}; }
+
+	void IASetInputLayout(ID3D11InputLayout* input_layout) override;
+	void IASetPrimitiveTopology(uint32_t topology) override;
+	void IASetVertexBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* vertex_buffers, const uint32_t* strides, const uint32_t* offsets) override;
+	void IASetIndexBuffer(ID3D11Buffer* index_buffer, uint32_t format, uint32_t offset) override;
+
+	void VSSetShader(ID3D11VertexShader* vertex_shader) override;
+	void PSSetShader(ID3D11PixelShader* pixel_shader) override;
+	void VSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) override;
+	void PSSetConstantBuffers(uint32_t start_slot, uint32_t num_buffers, ID3D11Buffer* const* constant_buffers) override;
+	void VSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) override;
+	void PSSetShaderResources(uint32_t start_slot, uint32_t num_views, ID3D11ShaderResourceView* const* shader_resource_views) override;
+	void PSSetSamplers(uint32_t start_slot, uint32_t num_samplers, ID3D11SamplerState* const* sampler_states) override;
+
+	void OMSetBlendState(ID3D11BlendState* blend_state, const float blend_factor[4], uint32_t sample_mask) override;
+	void OMSetDepthStencilState(ID3D11DepthStencilState* depth_stencil_state, uint32_t stencil_ref) override;
+	void RSSetState(ID3D11RasterizerState* rasterizer_state) override;
+
+	void UpdateSubresource(ID3D11Resource* resource, uint32_t subresource, const D3D11_BOX* box, const void* data, uint32_t row_pitch, uint32_t depth_pitch) override;
+	long Map(ID3D11Resource* resource, uint32_t subresource, uint32_t map_type, uint32_t map_flags, D3D11_MAPPED_SUBRESOURCE* mapped_subresource) override;
+	void Unmap(ID3D11Resource* resource, uint32_t subresource) override;
+	void DrawIndexed(uint32_t index_count, uint32_t start_index_location, int32_t base_vertex_location) override;
+	void DrawIndexedInstanced(uint32_t index_count_per_instance, uint32_t instance_count, uint32_t start_index_location, int32_t base_vertex_location, uint32_t start_instance_location) override;
+
+private:
+	render_context& context;
+
+	template<class T>
+	struct shadow
+	{
+		T value{};
+		bool known{ false };
+	};
+	// One value per slot and a bit per slot that holds a known value, so that forgetting them is a single store.
+	template<class T, size_t N>
+	struct slot_shadows
+	{
+		static_assert(N <= 32, "one bit per slot");
+		T values[N]{};
+		uint32_t known{ 0 };
+	};
+
+	struct vertex_buffer_binding
+	{
+		ID3D11Buffer* buffer;
+		uint32_t stride;
+		uint32_t offset;
+		bool operator==(const vertex_buffer_binding& other) const { return buffer == other.buffer && stride == other.stride && offset == other.offset; }
+	};
+	struct index_buffer_binding
+	{
+		ID3D11Buffer* buffer;
+		uint32_t format;
+		uint32_t offset;
+		bool operator==(const index_buffer_binding& other) const { return buffer == other.buffer && format == other.format && offset == other.offset; }
+	};
+	struct blend_binding
+	{
+		ID3D11BlendState* state;
+		float factor[4];
+		uint32_t sample_mask;
+		bool operator==(const blend_binding& other) const
+		{
+			return state == other.state && factor[0] == other.factor[0] && factor[1] == other.factor[1] && factor[2] == other.factor[2] && factor[3] == other.factor[3] && sample_mask == other.sample_mask;
+		}
+	};
+	struct depth_stencil_binding
+	{
+		ID3D11DepthStencilState* state;
+		uint32_t stencil_ref;
+		bool operator==(const depth_stencil_binding& other) const { return state == other.state && stencil_ref == other.stencil_ref; }
+	};
+
+	shadow<ID3D11InputLayout*> input_layout;
+	shadow<uint32_t> topology;
+	slot_shadows<vertex_buffer_binding, VERTEX_BUFFER_SLOTS> vertex_buffers;
+	shadow<index_buffer_binding> index_buffer;
+	shadow<ID3D11VertexShader*> vertex_shader;
+	shadow<ID3D11PixelShader*> pixel_shader;
+	slot_shadows<ID3D11Buffer*, CONSTANT_BUFFER_SLOTS> vs_constant_buffers;
+	slot_shadows<ID3D11Buffer*, CONSTANT_BUFFER_SLOTS> ps_constant_buffers;
+	slot_shadows<ID3D11ShaderResourceView*, SHADER_RESOURCE_SLOTS> vs_shader_resources;
+	slot_shadows<ID3D11ShaderResourceView*, SHADER_RESOURCE_SLOTS> ps_shader_resources;
+	slot_shadows<ID3D11SamplerState*, SAMPLER_SLOTS> ps_samplers;
+	shadow<blend_binding> blend_state;
+	shadow<depth_stencil_binding> depth_stencil_state;
+	shadow<ID3D11RasterizerState*> rasterizer_state;
+
+	// Records 'value' and returns whether it differs from what was bound (or nothing is known).
+	template<class T>
+	static bool update(shadow<T>& shadow, const T& value);
+	// The same for 'slot_count' slots from 'start_slot'; only the slots written are compared. Slots past the end of
+	// 'shadows' always differ.
+	template<class T, size_t N>
+	static bool update(slot_shadows<T, N>& shadows, uint32_t start_slot, uint32_t slot_count, const T* values);
+	// Bits of the slots from 'start_slot' to 'end_slot' (exclusive) that exist in a table of 'slot_count' slots.
+	static uint32_t slot_mask(uint32_t start_slot, uint32_t end_slot, uint32_t slot_count);
+	// Counts one call as issued or filtered and returns 'issue'.
+	bool count(bool issue);
+};
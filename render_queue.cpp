@@ -0,0 +1,118 @@
+#include "render_queue.h"
+
+#include <cstring>
+#include <functional>
+
+uint64_t render_queue::make_key(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth, bool back_to_front)
+{
+	// The bits of a non-negative float compare like the float, so its top bits are a depth that needs no far plane.
+	uint32_t bits{ 0 };
+	depth = depth > 0.0f ? depth : 0.0f;
+	std::memcpy(&bits, &depth, sizeof(bits));
+	uint64_t quantized_depth{ bits >> (31 - DEPTH_BITS) };
+	const uint64_t depth_mask{ (1ull << DEPTH_BITS) - 1 };
+	quantized_depth = back_to_front ? depth_mask - quantized_depth : quantized_depth;
+
+	uint64_t key{ pass & ((1ull << PASS_BITS) - 1) };
+	key = (key << SHADER_BITS) | (shader & ((1ull << SHADER_BITS) - 1));
+	key = (key << MATERIAL_BITS) | (material & ((1ull << MATERIAL_BITS) - 1));
+	key = (key << MESH_BITS) | (mesh & ((1ull << MESH_BITS) - 1));
+	key = (key << DEPTH_BITS) | (quantized_depth & depth_mask);
+	return key;
+}
+
+uint64_t render_queue::replace_ids(uint64_t key, uint32_t shader, uint32_t material, uint32_t mesh)
+{
+	const uint64_t pass_and_depth{ key & ((~0ull << (64 - PASS_BITS)) | ((1ull << DEPTH_BITS) - 1)) };
+	uint64_t ids{ shader & ((1ull << SHADER_BITS) - 1) };
+	ids = (ids << MATERIAL_BITS) | (material & ((1ull << MATERIAL_BITS) - 1));
+	ids = (ids << MESH_BITS) | (mesh & ((1ull << MESH_BITS) - 1));
+	return pass_and_depth | (ids << DEPTH_BITS);
+}
+
+void render_queue::sort()
+{
+	const size_t count{ queued_items.size() };
+	if (count < 2)
+	{
+		return;
+	}
+
+	// All eight histograms in one pass over the keys.
+	size_t histograms[8][256]{};
+	for (const item& item : queued_items)
+	{
+		for (int digit = 0; digit < 8; ++digit)
+		{
+			++histograms[digit][(item.key >> (digit * 8)) & 0xff];
+		}
+	}
+
+	sorted_items.resize(count);
+	for (int digit = 0; digit < 8; ++digit)
+	{
+		size_t(&histogram)[256]{ histograms[digit] };
+		if (histogram[(queued_items.front().key >> (digit * 8)) & 0xff] == count)
+		{
+			continue;
+		}
+
+		size_t offset{ 0 };
+		for (size_t& bucket : histogram)
+		{
+			const size_t bucket_count{ bucket };
+			bucket = offset;
+			offset += bucket_count;
+		}
+		for (const item& item : queued_items)
+		{
+			sorted_items[histogram[(item.key >> (digit * 8)) & 0xff]++] = item;
+		}
+		queued_items.swap(sorted_items);
+	}
+}
+
+void render_queue::merge(const render_queue* const* queues, const uint32_t* draw_offsets, size_t queue_count)
+{
+	size_t count{ 0 };
+	for (size_t queue_index = 0; queue_index < queue_count; ++queue_index)
+	{
+		count += queues[queue_index]->size();
+	}
+	queued_items.clear();
+	queued_items.reserve(count);
+
+	// There is one queue per recording thread, few enough that scanning every head beats a heap.
+	std::vector<size_t> heads(queue_count, 0);
+	while (queued_items.size() < count)
+	{
+		size_t next{ queue_count };
+		for (size_t queue_index = 0; queue_index < queue_count; ++queue_index)
+		{
+			const std::vector<item>& items{ queues[queue_index]->queued_items };
+			if (heads[queue_index] < items.size() && (next == queue_count || items[heads[queue_index]].key < queues[next]->queued_items[heads[next]].key))
+			{
+				next = queue_index;
+			}
+		}
+		item item{ queues[next]->queued_items[heads[next]++] };
+		item.draw += draw_offsets[next];
+		queued_items.push_back(item);
+	}
+}
+
+uint32_t render_id_table::id(const void* first, const void* second)
+{
+	const std::pair<std::unordered_map<std::pair<const void*, const void*>, uint32_t, pair_hash>::iterator, bool> inserted{ ids.emplace(std::make_pair(first, second), static_cast<uint32_t>(states.size())) };
+	if (inserted.second)
+	{
+		states.push_back(inserted.first->first);
+	}
+	return inserted.first->second;
+}
+
+size_t render_id_table::pair_hash::operator()(const std::pair<const void*, const void*>& key) const
+{
+	const size_t first{ std::hash<const void*>()(key.first) };
+	return first ^ (std::hash<const void*>()(key.second) + 0x9e3779b97f4a7c15ull + (first << 6) + (first >> 2));
+}
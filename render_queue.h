@@ -0,0 +1,192 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Draws recorded during the frame as small items with a 64-bit sort key, sorted so that draws sharing a pass, shader,
+// material and mesh end up next to each other, then replayed with a bind only where one of those changes.
+// Key layout from the most significant bit: pass, shader, material, mesh, depth. What an item draws is up to the
+// caller: 'draw' indexes its own array of draw data.
+// No Direct3D dependency.
+class render_queue
+{
+public:
+	static constexpr uint32_t PASS_BITS{ 4 };
+	static constexpr uint32_t SHADER_BITS{ 8 };
+	static constexpr uint32_t MATERIAL_BITS{ 16 };
+	static constexpr uint32_t MESH_BITS{ 16 };
+	static constexpr uint32_t DEPTH_BITS{ 20 };
+
+	// 'depth' is a non-negative view distance. Within the same pass, shader, material and mesh, items are ordered near to
+	// far, or far to near with 'back_to_front' (for blended passes). Ids wider than their field are truncated.
+	static uint64_t make_key(uint32_t pass, uint32_t shader, uint32_t material, uint32_t mesh, float depth, bool back_to_front = false);
+	static uint32_t pass_of(uint64_t key) { return static_cast<uint32_t>(key >> (64 - PASS_BITS)); }
+	static uint32_t shader_of(uint64_t key) { return static_cast<uint32_t>(key >> (MATERIAL_BITS + MESH_BITS + DEPTH_BITS)) & ((1u << SHADER_BITS) - 1); }
+	static uint32_t material_of(uint64_t key) { return static_cast<uint32_t>(key >> (MESH_BITS + DEPTH_BITS)) & ((1u << MATERIAL_BITS) - 1); }
+	static uint32_t mesh_of(uint64_t key) { return static_cast<uint32_t>(key >> DEPTH_BITS) & ((1u << MESH_BITS) - 1); }
+	// 'key' with other shader, material and mesh ids, keeping its pass and depth.
+	static uint64_t replace_ids(uint64_t key, uint32_t shader, uint32_t material, uint32_t mesh);
+
+	struct item
+	{
+		uint64_t key;
+		uint32_t draw;
+	};
+
+	void clear() { queued_items.clear(); }
+	void reserve(size_t count) { queued_items.reserve(count); }
+	void push(uint64_t key, uint32_t draw) { queued_items.push_back({ key, draw }); }
+
+	// Stable LSD radix sort on the key, eight bits per pass. Bytes that are the same in every key are skipped.
+	void sort();
+	// Replaces every key by 'transform(key)'. The queue must be sorted again.
+	template<class Transform>
+	void transform_keys(Transform&& transform)
+	{
+		for (item& item : queued_items)
+		{
+			item.key = transform(item.key);
+		}
+	}
+	// Replaces the items by those of 'queues', each already sorted, merged by key. Equal keys keep the order of
+	// 'queues', so merging the sorted parts of a recording gives the same order as sorting all of it. The draw of an
+	// item from queues[i] is offset by draw_offsets[i].
+	void merge(const render_queue* const* queues, const uint32_t* draw_offsets, size_t queue_count);
+
+	const std::vector<item>& items() const { return queued_items; }
+	size_t size() const { return queued_items.size(); }
+
+	// A run of sorted items that one instanced draw can cover: 'count' items from 'first'.
+	struct instance_group
+	{
+		uint32_t first;
+		uint32_t count;
+	};
+	// Cuts the sorted items into runs whose keys differ only in depth and whose 'geometry(item)' (a const void*
+	// naming what the draw covers, e.g. a subset of a mesh) is the same. Items whose geometry is nullptr are never
+	// grouped. Runs are cut at 'max_instances' items.
+	template<class Geometry>
+	void group_instances(Geometry&& geometry, uint32_t max_instances, std::vector<instance_group>& groups) const
+	{
+		groups.clear();
+		const uint64_t state_mask{ ~((1ull << DEPTH_BITS) - 1) };
+		const void* group_geometry{ nullptr };
+		for (uint32_t index = 0; index < queued_items.size(); ++index)
+		{
+			const void* item_geometry{ geometry(queued_items[index]) };
+			if (!groups.empty() && item_geometry && item_geometry == group_geometry && groups.back().count < max_instances &&
+				((queued_items[index].key ^ queued_items[groups.back().first].key) & state_mask) == 0)
+			{
+				++groups.back().count;
+				continue;
+			}
+			groups.push_back({ index, 1 });
+			group_geometry = item_geometry;
+		}
+	}
+
+	struct submit_statistics
+	{
+		size_t draws{ 0 };
+		size_t instances{ 0 };
+		size_t pass_changes{ 0 };
+		size_t shader_changes{ 0 };
+		size_t material_changes{ 0 };
+		size_t mesh_changes{ 0 };
+	};
+	// Replays the items in their current order. For each item, backend.bind_pass(item), bind_shader(item),
+	// bind_material(item) and bind_mesh(item) are called for the key fields that differ from the previous item
+	// (all of them for the first one), then backend.draw(item).
+	template<class Backend>
+	submit_statistics submit(Backend& backend) const
+	{
+		submit_statistics statistics;
+		const item* previous{ nullptr };
+		for (const item& item : queued_items)
+		{
+			bind_changes(backend, item, previous, statistics);
+			backend.draw(item);
+			++statistics.draws;
+			++statistics.instances;
+			previous = &item;
+		}
+		return statistics;
+	}
+	// The same for the groups of group_instances: binds follow the first item of each group, and
+	// backend.draw_instanced(group) draws all of its items.
+	template<class Backend>
+	submit_statistics submit(Backend& backend, const std::vector<instance_group>& groups) const
+	{
+		return submit(backend, groups.data(), groups.size());
+	}
+	// A range of the groups, e.g. one part of a frame replayed on its own context. Everything is bound for the first group.
+	template<class Backend>
+	submit_statistics submit(Backend& backend, const instance_group* groups, size_t group_count) const
+	{
+		submit_statistics statistics;
+		const item* previous{ nullptr };
+		for (size_t group_index = 0; group_index < group_count; ++group_index)
+		{
+			const instance_group& group{ groups[group_index] };
+			const item& item{ queued_items[group.first] };
+			bind_changes(backend, item, previous, statistics);
+			backend.draw_instanced(group);
+			++statistics.draws;
+			statistics.instances += group.count;
+			previous = &item;
+		}
+		return statistics;
+	}
+
+private:
+	std::vector<item> queued_items;
+	std::vector<item> sorted_items;
+
+	template<class Backend>
+	static void bind_changes(Backend& backend, const item& item, const render_queue::item* previous, submit_statistics& statistics)
+	{
+		if (!previous || pass_of(item.key) != pass_of(previous->key))
+		{
+			backend.bind_pass(item);
+			++statistics.pass_changes;
+		}
+		if (!previous || shader_of(item.key) != shader_of(previous->key))
+		{
+			backend.bind_shader(item);
+			++statistics.shader_changes;
+		}
+		if (!previous || material_of(item.key) != material_of(previous->key))
+		{
+			backend.bind_material(item);
+			++statistics.material_changes;
+		}
+		if (!previous || mesh_of(item.key) != mesh_of(previous->key))
+		{
+			backend.bind_mesh(item);
+			++statistics.mesh_changes;
+		}
+	}
+};
+
+// Small dense ids for the key fields, handed out in order of first use. A state is identified by one or two
+// addresses, e.g. a renderer and the pixel shader that replaces its own.
+class render_id_table
+{
+public:
+	uint32_t id(const void* first, const void* second = nullptr);
+	// The addresses that were given 'id'.
+	const std::pair<const void*, const void*>& state(uint32_t id) const { return states.at(id); }
+	size_t size() const { return states.size(); }
+	void clear() { ids.clear(); states.clear(); }
+
+private:
+	struct pair_hash
+	{
+		size_t operator()(const std::pair<const void*, const void*>& key) const;
+	};
+	std::unordered_map<std::pair<const void*, const void*>, uint32_t, pair_hash> ids;
+	std::vector<std::pair<const void*, const void*>> states;
+};
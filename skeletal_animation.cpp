@@ -0,0 +1,108 @@
+#include "skeletal_animation.h"
+
+#include <algorithm>
+#include <cfloat>
+
+using namespace DirectX;
+
+// UNIT.22
+void pack_bone_influences(const bone_influence* influences, size_t influence_count, skinned_vertex& vertex)
+{
+	for (size_t influence_index = 0; influence_index < influence_count; ++influence_index)
+	{
+		if (influence_index < skinned_vertex::MAX_BONE_INFLUENCES)
+		{
+			vertex.bone_weights[influence_index] = influences[influence_index].bone_weight;
+			vertex.bone_indices[influence_index] = influences[influence_index].bone_index;
+		}
+		else
+		{
+			size_t minimum_value_index = 0;
+			float minimum_value = FLT_MAX;
+			for (size_t i = 0; i < skinned_vertex::MAX_BONE_INFLUENCES; ++i)
+			{
+				if (minimum_value > vertex.bone_weights[i])
+				{
+					minimum_value = vertex.bone_weights[i];
+					minimum_value_index = i;
+				}
+			}
+			vertex.bone_weights[minimum_value_index] += influences[influence_index].bone_weight;
+			vertex.bone_indices[minimum_value_index] = influences[influence_index].bone_index;
+		}
+	}
+
+	float total_weight = 0;
+	for (size_t i = 0; i < skinned_vertex::MAX_BONE_INFLUENCES; ++i)
+	{
+		total_weight += vertex.bone_weights[i];
+	}
+
+	for (size_t i = 0; i < skinned_vertex::MAX_BONE_INFLUENCES; ++i)
+	{
+		vertex.bone_weights[i] /= total_weight;
+	}
+}
+
+// UNIT.27
+void update_global_transforms(animation::keyframe& keyframe, const int64_t* parent_indices, size_t parent_index_stride)
+{
+	const size_t node_count{ keyframe.nodes.size() };
+	for (size_t node_index = 0; node_index < node_count; ++node_index)
+	{
+		animation::keyframe::node& node{ keyframe.nodes[node_index] };
+		XMMATRIX S{ XMMatrixScaling(node.scaling.x, node.scaling.y, node.scaling.z) };
+		XMMATRIX R{ XMMatrixRotationQuaternion(XMLoadFloat4(&node.rotation)) };
+		XMMATRIX T{ XMMatrixTranslation(node.translation.x, node.translation.y, node.translation.z) };
+
+		const int64_t parent_index{ *reinterpret_cast<const int64_t*>(reinterpret_cast<const char*>(parent_indices) + node_index * parent_index_stride) };
+		XMMATRIX P{ parent_index < 0 ? XMMatrixIdentity() : XMLoadFloat4x4(&keyframe.nodes.at(parent_index).global_transform) };
+
+		XMStoreFloat4x4(&node.global_transform, S * R * T * P);
+	}
+}
+
+// UNIT.28
+void blend_keyframes(const animation::keyframe* keyframes[2], float factor, animation::keyframe& keyframe)
+{
+	size_t node_count{ keyframes[0]->nodes.size() };
+	keyframe.nodes.resize(node_count);
+	for (size_t node_index = 0; node_index < node_count; ++node_index)
+	{
+		XMVECTOR S[2]{ XMLoadFloat3(&keyframes[0]->nodes.at(node_index).scaling), XMLoadFloat3(&keyframes[1]->nodes.at(node_index).scaling) };
+		XMStoreFloat3(&keyframe.nodes.at(node_index).scaling, XMVectorLerp(S[0], S[1], factor));
+
+		XMVECTOR R[2]{ XMLoadFloat4(&keyframes[0]->nodes.at(node_index).rotation), XMLoadFloat4(&keyframes[1]->nodes.at(node_index).rotation) };
+		XMStoreFloat4(&keyframe.nodes.at(node_index).rotation, XMQuaternionSlerp(R[0], R[1], factor));
+
+		XMVECTOR T[2]{ XMLoadFloat3(&keyframes[0]->nodes.at(node_index).translation), XMLoadFloat3(&keyframes[1]->nodes.at(node_index).translation) };
+		XMStoreFloat3(&keyframe.nodes.at(node_index).translation, XMVectorLerp(T[0], T[1], factor));
+	}
+}
+
+const animation::keyframe* sample_keyframe(const animation& animation, float tick)
+{
+	if (animation.sequence.empty())
+	{
+		return nullptr;
+	}
+	const size_t frame_index{ static_cast<size_t>(tick * animation.sampling_rate) };
+	return &animation.sequence.at(std::min<size_t>(frame_index, animation.sequence.size() - 1));
+}
+
+size_t compute_bone_palette(const skeleton& bind_pose, const XMFLOAT4X4& default_global_transform, const animation::keyframe& keyframe, XMFLOAT4X4* bone_transforms, size_t max_bones)
+{
+	const size_t bone_count{ std::min<size_t>(bind_pose.bones.size(), max_bones) };
+	const XMMATRIX inverse_default_global_transform{ XMMatrixInverse(nullptr, XMLoadFloat4x4(&default_global_transform)) };
+	for (size_t bone_index = 0; bone_index < bone_count; ++bone_index)
+	{
+		const skeleton::bone& bone{ bind_pose.bones.at(bone_index) };
+		const animation::keyframe::node& bone_node{ keyframe.nodes.at(bone.node_index) };
+		XMStoreFloat4x4(&bone_transforms[bone_index],
+			XMLoadFloat4x4(&bone.offset_transform) *
+			XMLoadFloat4x4(&bone_node.global_transform) *
+			inverse_default_global_transform
+		);
+	}
+	return bone_count;
+}
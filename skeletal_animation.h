@@ -0,0 +1,159 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// The skeleton, animation and skinned vertex data of skinned_mesh, and the per-frame work on them that needs no FBX
+// scene or device: global transforms of a pose, blending, sampling a clip, bone palettes and packing bone influences.
+// No Direct3D dependency; skinned_mesh loads, caches and draws these.
+// UNIT.24
+struct skeleton
+{
+	struct bone
+	{
+		uint64_t unique_id{ 0 };
+		std::string name;
+		// 'parent_index' is index that refers to the parent bone's position in the array that contains itself.
+		int64_t parent_index{ -1 }; // -1 : the bone is orphan
+		// 'node_index' is an index that refers to the node array of the scene.
+		int64_t node_index{ 0 };
+
+		// 'offset_transform' is used to convert from model(mesh) space to bone(node) scene.
+		DirectX::XMFLOAT4X4 offset_transform{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+
+		bool is_orphan() const { return parent_index < 0; };
+
+		// UNIT.30
+		template<class T>
+		void serialize(T& archive)
+		{
+			archive(unique_id, name, parent_index, node_index, offset_transform);
+		}
+	};
+	std::vector<bone> bones;
+	int64_t indexof(uint64_t unique_id) const
+	{
+		int64_t index{ 0 };
+		for (const bone& bone : bones)
+		{
+			if (bone.unique_id == unique_id)
+			{
+				return index;
+			}
+			++index;
+		}
+		return -1;
+	}
+#if 0
+	int64_t indexof(string name) const
+	{
+		int64_t index{ 0 };
+		for (const bone& bone : bones)
+		{
+			if (bone.name == name)
+			{
+				return index;
+			}
+			++index;
+		}
+		return -1;
+	}
+#endif
+	// UNIT.30
+	template<class T>
+	void serialize(T& archive)
+	{
+		archive(bones);
+	}
+};
+// UNIT.25
+struct animation
+{
+	std::string name;
+	float sampling_rate{ 0 };
+
+	struct keyframe
+	{
+		struct node
+		{
+			// 'global_transform' is used to convert from local space of node to global space of scene.
+			DirectX::XMFLOAT4X4 global_transform{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+			// UNIT.27
+			// The transformation data of a node includes its translation, rotation and scaling vectors with respect to its parent. 
+			DirectX::XMFLOAT3 scaling{ 1, 1, 1 };
+			DirectX::XMFLOAT4 rotation{ 0, 0, 0, 1 }; // Rotation quaternion
+			DirectX::XMFLOAT3 translation{ 0, 0, 0 };
+
+			// UNIT.30
+			template<class T>
+			void serialize(T& archive)
+			{
+				archive(global_transform, scaling, rotation, translation);
+			}
+		};
+		std::vector<node> nodes;
+
+		// UNIT.30
+		template<class T>
+		void serialize(T& archive)
+		{
+			archive(nodes);
+		}
+	};
+	std::vector<keyframe> sequence;
+
+	// UNIT.30
+	template<class T>
+	void serialize(T& archive)
+	{
+		archive(name, sampling_rate, sequence);
+	}
+};
+// UNIT.17
+struct skinned_vertex
+{
+	static const int MAX_BONE_INFLUENCES{ 4 }; // UNIT.22
+
+	DirectX::XMFLOAT3 position;
+	DirectX::XMFLOAT3 normal;
+	DirectX::XMFLOAT4 tangent; // UNIT.29
+	DirectX::XMFLOAT2 texcoord;
+	// UNIT.22
+	float bone_weights[MAX_BONE_INFLUENCES]{ 1, 0, 0, 0 };
+	uint32_t bone_indices[MAX_BONE_INFLUENCES]{};
+
+	// UNIT.30
+	template<class T>
+	void serialize(T& archive)
+	{
+		archive(position, normal, tangent, texcoord, bone_weights, bone_indices);
+	}
+};
+
+// UNIT.22
+struct bone_influence
+{
+	uint32_t bone_index;
+	float bone_weight;
+};
+// Writes the influences of a control point to the bone weights and indices of 'vertex'. Beyond MAX_BONE_INFLUENCES each
+// further influence is added to the lightest slot so far, then the weights are normalized.
+void pack_bone_influences(const bone_influence* influences, size_t influence_count, skinned_vertex& vertex);
+
+// UNIT.27
+// Global transforms of every node of 'keyframe' from its scaling, rotation and translation. A parent must come before
+// its children; 'parent_indices' holds one index per node (-1 for a root), 'parent_index_stride' bytes apart.
+void update_global_transforms(animation::keyframe& keyframe, const int64_t* parent_indices, size_t parent_index_stride);
+// UNIT.28
+// Scaling, rotation and translation of every node interpolated from keyframes[0] to keyframes[1] by 'factor'. Global
+// transforms are left as they were.
+void blend_keyframes(const animation::keyframe* keyframes[2], float factor, animation::keyframe& keyframe);
+// The keyframe of 'animation' at 'tick' seconds, held at the last one past the end. nullptr if it has none.
+const animation::keyframe* sample_keyframe(const animation& animation, float tick);
+// The matrices that skin a mesh bound to 'bind_pose' into the pose of 'keyframe' (whose global transforms must be up to
+// date). Writes one per bone, at most 'max_bones', and returns how many were written.
+size_t compute_bone_palette(const skeleton& bind_pose, const DirectX::XMFLOAT4X4& default_global_transform, const animation::keyframe& keyframe, DirectX::XMFLOAT4X4* bone_transforms, size_t max_bones);
@@ -0,0 +1,123 @@
+#include "skinned_bvh.h"
+#include "thread_pool.h"
+#include "misc.h"
+
+#include <algorithm>
+
+using namespace DirectX;
+
+skinned_bvh::skinned_bvh(const skinned_mesh& model) : model(&model)
+{
+	uint32_t vertex_count{ 0 };
+	uint32_t triangle_count{ 0 };
+	for (const skinned_mesh::mesh& mesh : model.meshes)
+	{
+		_ASSERT_EXPR(mesh.vertices.size() > 0 || mesh.subsets.size() == 0, L"skinned_bvh needs a skinned_mesh constructed with retain_geometry.");
+		first_vertices.push_back(vertex_count);
+		first_triangles.push_back(triangle_count);
+		vertex_count += static_cast<uint32_t>(mesh.vertices.size());
+		triangle_count += static_cast<uint32_t>(mesh.indices.size() / 3);
+	}
+	positions.resize(vertex_count);
+
+	const XMFLOAT4X4 identity{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	update(nullptr, identity);
+	rebuild();
+}
+
+void skinned_bvh::update(const animation::keyframe* keyframe, const XMFLOAT4X4& world)
+{
+	if (keyframe && keyframe->nodes.size() == 0)
+	{
+		keyframe = nullptr;
+	}
+	std::vector<XMFLOAT4X4> bone_transforms;
+	for (size_t mesh_index = 0; mesh_index < model->meshes.size(); ++mesh_index)
+	{
+		const skinned_mesh::mesh& mesh{ model->meshes.at(mesh_index) };
+
+		// Same matrices as skinned_mesh::render. Each bone matrix is followed by the world matrix of the mesh, which is
+		// the same as transforming the blended position because the weights of a vertex add up to one.
+		const XMMATRIX W{ XMLoadFloat4x4(keyframe ? &keyframe->nodes.at(mesh.node_index).global_transform : &mesh.default_global_transform) * XMLoadFloat4x4(&world) };
+		size_t bone_count{ 0 };
+		if (keyframe)
+		{
+			bone_transforms.resize(std::min<size_t>(mesh.bind_pose.bones.size(), skinned_mesh::MAX_BONES));
+			bone_count = skinned_mesh::compute_bone_transforms(mesh, *keyframe, bone_transforms.data());
+		}
+		for (size_t bone_index = 0; bone_index < bone_count; ++bone_index)
+		{
+			XMStoreFloat4x4(&bone_transforms.at(bone_index), XMLoadFloat4x4(&bone_transforms.at(bone_index)) * W);
+		}
+
+		XMFLOAT3* destination{ positions.data() + first_vertices.at(mesh_index) };
+		default_thread_pool().parallel_for(mesh.vertices.size(), [&](size_t vertex_index)
+		{
+			const skinned_mesh::vertex& vertex{ mesh.vertices[vertex_index] };
+			const XMVECTOR position{ XMLoadFloat3(&vertex.position) };
+			if (bone_count == 0)
+			{
+				XMStoreFloat3(&destination[vertex_index], XMVector3TransformCoord(position, W));
+				return;
+			}
+			XMVECTOR blended{ XMVectorZero() };
+			for (size_t influence = 0; influence < skinned_mesh::MAX_BONE_INFLUENCES; ++influence)
+			{
+				const float weight{ vertex.bone_weights[influence] };
+				if (weight == 0.0f)
+				{
+					continue;
+				}
+				// An index past the skeleton has no matrix; its weight stays on the mesh placement.
+				const uint32_t bone_index{ vertex.bone_indices[influence] };
+				const XMMATRIX B{ bone_index < bone_count ? XMLoadFloat4x4(&bone_transforms[bone_index]) : W };
+				blended = XMVectorMultiplyAdd(XMVectorReplicate(weight), XMVector3Transform(position, B), blended);
+			}
+			XMStoreFloat3(&destination[vertex_index], blended);
+		}, 1024);
+	}
+	bvh.refit(positions.data(), sizeof(XMFLOAT3), positions.size());
+}
+
+void skinned_bvh::update(skinned_bvh* const* instances, const animation::keyframe* const* keyframes, const XMFLOAT4X4* worlds, size_t count)
+{
+	default_thread_pool().parallel_for(count, [&](size_t instance_index)
+	{
+		instances[instance_index]->update(keyframes[instance_index], worlds[instance_index]);
+	});
+}
+
+void skinned_bvh::rebuild()
+{
+	std::vector<uint32_t> indices;
+	for (size_t mesh_index = 0; mesh_index < model->meshes.size(); ++mesh_index)
+	{
+		const skinned_mesh::mesh& mesh{ model->meshes.at(mesh_index) };
+		for (size_t index = 0; index < mesh.indices.size() / 3 * 3; ++index)
+		{
+			indices.push_back(mesh.indices.at(index) + first_vertices.at(mesh_index));
+		}
+	}
+	bvh.build(positions.data(), sizeof(XMFLOAT3), positions.size(), indices.data(), indices.size());
+}
+
+bool skinned_bvh::raycast(const XMFLOAT3& origin, const XMFLOAT3& direction, float max_distance, triangle_bvh::hit& hit) const
+{
+	triangle_bvh::ray ray;
+	ray.origin = origin;
+	ray.direction = direction;
+	ray.max_distance = max_distance;
+	return bvh.intersect(ray, hit);
+}
+
+bool skinned_bvh::overlaps(const XMFLOAT3& center, float radius, std::vector<uint32_t>* triangles) const
+{
+	return bvh.overlaps(center, radius, triangles);
+}
+
+void skinned_bvh::locate(uint32_t triangle, size_t& mesh_index, uint32_t& mesh_triangle) const
+{
+	// The last mesh whose first triangle is not past 'triangle'; empty meshes share their first triangle with the next one.
+	mesh_index = static_cast<size_t>(std::upper_bound(first_triangles.begin(), first_triangles.end(), triangle) - first_triangles.begin()) - 1;
+	mesh_triangle = triangle - first_triangles.at(mesh_index);
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <vector>
+
+#include "skinned_mesh.h"
+#include "triangle_bvh.h"
+
+// A triangle BVH over one animated instance of a skinned_mesh, for hit detection against the pose it is drawn in.
+// The tree is built once and refit whenever the pose changes: every vertex is skinned on the CPU with the matrices
+// skinned_mesh_vs uses, moved to world space, and the boxes are recomputed bottom-up.
+// The skinned_mesh must be constructed with 'retain_geometry' and must outlive this object.
+class skinned_bvh
+{
+public:
+	// Starts in the bind pose at the origin; call update before the first query.
+	explicit skinned_bvh(const skinned_mesh& model);
+
+	// Skins the vertices for 'keyframe' (nullptr: bind pose, as skinned_mesh::render draws it) placed at 'world', then refits.
+	void update(const animation::keyframe* keyframe, const DirectX::XMFLOAT4X4& world);
+	// Updates many instances at once, one per task on default_thread_pool(). keyframes[i] may be nullptr.
+	static void update(skinned_bvh* const* instances, const animation::keyframe* const* keyframes, const DirectX::XMFLOAT4X4* worlds, size_t count);
+	// Rebuilds the tree for the current positions. Refitting keeps the tree built for the bind pose; when a pose is far
+	// from it (a character lying down) queries get slower, and a rebuild restores them.
+	void rebuild();
+
+	// World space queries. Triangles are numbered over all meshes of the model in order; see locate.
+	bool raycast(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float max_distance, triangle_bvh::hit& hit) const;
+	bool overlaps(const DirectX::XMFLOAT3& center, float radius, std::vector<uint32_t>* triangles = nullptr) const;
+
+	// The mesh a triangle belongs to, and its number within that mesh (its first index is mesh_triangle * 3).
+	void locate(uint32_t triangle, size_t& mesh_index, uint32_t& mesh_triangle) const;
+
+	const std::vector<DirectX::XMFLOAT3>& world_positions() const { return positions; }
+
+private:
+	const skinned_mesh* model;
+	// Per mesh, where its vertices and triangles start in 'positions' and in the tree.
+	std::vector<uint32_t> first_vertices;
+	std::vector<uint32_t> first_triangles;
+	std::vector<DirectX::XMFLOAT3> positions;
+	triangle_bvh bvh;
+};
@@ -1,38 +1,38 @@
-// UNIT.18
-struct VS_IN
-{
-	float4 position : POSITION;
-	float4 normal : NORMAL;
-	float4 tangent : TANGENT; // UNIT.29
-	float2 texcoord : TEXCOORD;
-	// UNIT.22
-	float4 bone_weights : WEIGHTS;
-	uint4 bone_indices : BONES;
-};
-
-struct VS_OUT
-{
-	float4 position : SV_POSITION;
-	float4 world_position : POSITION;
-	float4 world_normal : NORMAL;
-	float4 world_tangent : TANGENT; // UNIT.29
-	float2 texcoord : TEXCOORD;
-	float4 color : COLOR;
-};
-
-static const int MAX_BONES = 256; // UNIT.23
-cbuffer OBJECT_CONSTANT_BUFFER : register(b0)
-{
-	row_major float4x4 world;
-	float4 material_color;
-	// UNIT.23
-	row_major float4x4 bone_transforms[MAX_BONES];
-};
-
-cbuffer SCENE_CONSTANT_BUFFER : register(b1)
-{
-	row_major float4x4 view_projection;
-	float4 light_direction;
-	float4 camera_position;
-};
-
+// UNIT.18
+struct VS_IN
+{
+	float4 position : POSITION;
+	float4 normal : NORMAL;
+	float4 tangent : TANGENT; // UNIT.29
+	float2 texcoord : TEXCOORD;
+	// UNIT.22
+	float4 bone_weights : WEIGHTS;
+	uint4 bone_indices : BONES;
+};
+
+struct VS_OUT
+{
+	float4 position : SV_POSITION;
+	float4 world_position : POSITION;
+	float4 world_normal : NORMAL;
+	float4 world_tangent : TANGENT; // UNIT.29
+	float2 texcoord : TEXCOORD;
+	float4 color : COLOR;
+};
+
+static const int MAX_BONES = 256; // UNIT.23
+cbuffer OBJECT_CONSTANT_BUFFER : register(b0)
+{
+	row_major float4x4 world;
+	float4 material_color;
+	// UNIT.23
+	row_major float4x4 bone_transforms[MAX_BONES];
+};
+
+cbuffer SCENE_CONSTANT_BUFFER : register(b1)
+{
+	row_major float4x4 view_projection;
+	float4 light_direction;
+	float4 camera_position;
+};
+
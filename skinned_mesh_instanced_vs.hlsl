@@ -0,0 +1,51 @@
+#include "skinned_mesh.hlsli"
+
+// draw_instance (instance_buffer.h), from vertex buffer slot 1. Replaces 'world' and 'material_color' of
+// OBJECT_CONSTANT_BUFFER.
+struct INSTANCE_IN
+{
+	row_major float4x4 world : INSTANCE_WORLD;
+	float4 color : INSTANCE_COLOR;
+	uint palette_offset : INSTANCE_PALETTE;
+};
+
+// The bone transforms of every instance drawn this frame. An instance's bones start at its palette_offset.
+struct bone
+{
+	row_major float4x4 transform;
+};
+StructuredBuffer<bone> bone_palettes : register(t0);
+
+VS_OUT main(VS_IN vin, INSTANCE_IN instance)
+{
+	vin.normal.w = 0;
+	float sigma = vin.tangent.w;
+	vin.tangent.w = 0;
+
+	float4 blended_position = { 0, 0, 0, 1 };
+	float4 blended_normal = { 0, 0, 0, 0 };
+	float4 blended_tangent = { 0, 0, 0, 0 };
+	for (int bone_index = 0; bone_index < 4; ++bone_index)
+	{
+		row_major float4x4 bone_transform = bone_palettes[instance.palette_offset + vin.bone_indices[bone_index]].transform;
+		blended_position += vin.bone_weights[bone_index] * mul(vin.position, bone_transform);
+		blended_normal += vin.bone_weights[bone_index] * mul(vin.normal, bone_transform);
+		blended_tangent += vin.bone_weights[bone_index] * mul(vin.tangent, bone_transform);
+	}
+	vin.position = float4(blended_position.xyz, 1.0f);
+	vin.normal = float4(blended_normal.xyz, 0.0f);
+	vin.tangent = float4(blended_tangent.xyz, 0.0f);
+
+	VS_OUT vout;
+	vout.position = mul(vin.position, mul(instance.world, view_projection));
+
+	vout.world_position = mul(vin.position, instance.world);
+	vout.world_normal = normalize(mul(vin.normal, instance.world));
+	vout.world_tangent = normalize(mul(vin.tangent, instance.world));
+	vout.world_tangent.w = sigma;
+
+	vout.texcoord = vin.texcoord;
+	vout.color = instance.color;
+
+	return vout;
+}
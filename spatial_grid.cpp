@@ -0,0 +1,371 @@
+#include "spatial_grid.h"
+#include "frustum_culler.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr int32_t COORDINATE_BIAS{ 1 << 20 };
+	constexpr uint64_t COORDINATE_MASK{ (1ull << 21) - 1 };
+
+	inline int32_t coordinate(float value, float cell_size)
+	{
+		const float cell{ std::floor(value / cell_size) };
+		return static_cast<int32_t>(std::min<float>(std::max<float>(cell, -COORDINATE_BIAS), COORDINATE_BIAS - 1));
+	}
+	inline uint64_t pack(int32_t x, int32_t y, int32_t z)
+	{
+		return (static_cast<uint64_t>(x + COORDINATE_BIAS) & COORDINATE_MASK) |
+			((static_cast<uint64_t>(y + COORDINATE_BIAS) & COORDINATE_MASK) << 21) |
+			((static_cast<uint64_t>(z + COORDINATE_BIAS) & COORDINATE_MASK) << 42);
+	}
+	inline void unpack(uint64_t key, int32_t& x, int32_t& y, int32_t& z)
+	{
+		x = static_cast<int32_t>(key & COORDINATE_MASK) - COORDINATE_BIAS;
+		y = static_cast<int32_t>((key >> 21) & COORDINATE_MASK) - COORDINATE_BIAS;
+		z = static_cast<int32_t>((key >> 42) & COORDINATE_MASK) - COORDINATE_BIAS;
+	}
+
+	// Entry distance of the ray into the box, or a negative value if it misses it within 'max_distance'.
+	inline float enter_box(const XMFLOAT3& origin, const XMFLOAT3& inverse_direction, const XMFLOAT3& minimum, const XMFLOAT3& maximum, float max_distance)
+	{
+		float entry{ 0.0f };
+		float exit{ max_distance };
+		const float o[3]{ origin.x, origin.y, origin.z };
+		const float d[3]{ inverse_direction.x, inverse_direction.y, inverse_direction.z };
+		const float lo[3]{ minimum.x, minimum.y, minimum.z };
+		const float hi[3]{ maximum.x, maximum.y, maximum.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			float t0{ (lo[axis] - o[axis]) * d[axis] };
+			float t1{ (hi[axis] - o[axis]) * d[axis] };
+			if (t0 > t1)
+			{
+				std::swap(t0, t1);
+			}
+			// A ray parallel to the slab gives NaN when it starts on its side; keep the current interval then.
+			entry = t0 > entry ? t0 : entry;
+			exit = t1 < exit ? t1 : exit;
+		}
+		return entry <= exit ? entry : -1.0f;
+	}
+}
+
+spatial_grid::spatial_grid(float cell_size) : cell_size(cell_size)
+{
+}
+
+uint64_t spatial_grid::cell_of(const object& object) const
+{
+	if (std::max<float>(object.extent.x, std::max<float>(object.extent.y, object.extent.z)) * 2.0f > cell_size)
+	{
+		return OVERSIZED;
+	}
+	return pack(coordinate(object.center.x, cell_size), coordinate(object.center.y, cell_size), coordinate(object.center.z, cell_size));
+}
+
+void spatial_grid::link(size_t id)
+{
+	object& object{ objects.at(id) };
+	std::vector<size_t>& list{ object.cell == OVERSIZED ? oversized : cells[object.cell] };
+	object.slot = static_cast<uint32_t>(list.size());
+	list.push_back(id);
+}
+
+void spatial_grid::unlink(size_t id)
+{
+	const object& object{ objects.at(id) };
+	std::vector<size_t>& list{ object.cell == OVERSIZED ? oversized : cells.at(object.cell) };
+	// The last id of the list takes the freed slot.
+	list.at(object.slot) = list.back();
+	objects.at(list.back()).slot = object.slot;
+	list.pop_back();
+	if (list.empty() && object.cell != OVERSIZED)
+	{
+		cells.erase(object.cell);
+	}
+}
+
+size_t spatial_grid::add(const XMFLOAT3 bounding_box[2])
+{
+	size_t id{ objects.size() };
+	if (free_ids.size() > 0)
+	{
+		id = free_ids.back();
+		free_ids.pop_back();
+	}
+	else
+	{
+		objects.emplace_back();
+	}
+	object& object{ objects.at(id) };
+	object.center = { (bounding_box[0].x + bounding_box[1].x) * 0.5f, (bounding_box[0].y + bounding_box[1].y) * 0.5f, (bounding_box[0].z + bounding_box[1].z) * 0.5f };
+	object.extent = { (bounding_box[1].x - bounding_box[0].x) * 0.5f, (bounding_box[1].y - bounding_box[0].y) * 0.5f, (bounding_box[1].z - bounding_box[0].z) * 0.5f };
+	object.cell = cell_of(object);
+	object.alive = true;
+	link(id);
+	return id;
+}
+
+void spatial_grid::remove(size_t id)
+{
+	if (!objects.at(id).alive)
+	{
+		return;
+	}
+	unlink(id);
+	objects.at(id).alive = false;
+	free_ids.push_back(id);
+}
+
+void spatial_grid::move(size_t id, const XMFLOAT3 bounding_box[2])
+{
+	object& object{ objects.at(id) };
+	if (!object.alive)
+	{
+		return;
+	}
+	object.center = { (bounding_box[0].x + bounding_box[1].x) * 0.5f, (bounding_box[0].y + bounding_box[1].y) * 0.5f, (bounding_box[0].z + bounding_box[1].z) * 0.5f };
+	object.extent = { (bounding_box[1].x - bounding_box[0].x) * 0.5f, (bounding_box[1].y - bounding_box[0].y) * 0.5f, (bounding_box[1].z - bounding_box[0].z) * 0.5f };
+	const uint64_t cell{ cell_of(object) };
+	if (cell != object.cell)
+	{
+		unlink(id);
+		object.cell = cell;
+		link(id);
+	}
+}
+
+void spatial_grid::clear()
+{
+	objects.clear();
+	free_ids.clear();
+	cells.clear();
+	oversized.clear();
+}
+
+void spatial_grid::rebuild(const XMFLOAT3 (*boxes)[2], size_t count)
+{
+	clear();
+	objects.resize(count);
+	std::vector<std::pair<uint64_t, size_t>> keys(count);
+	default_thread_pool().parallel_for(count, [&](size_t id)
+	{
+		object& object{ objects[id] };
+		const XMFLOAT3* bounding_box{ boxes[id] };
+		object.center = { (bounding_box[0].x + bounding_box[1].x) * 0.5f, (bounding_box[0].y + bounding_box[1].y) * 0.5f, (bounding_box[0].z + bounding_box[1].z) * 0.5f };
+		object.extent = { (bounding_box[1].x - bounding_box[0].x) * 0.5f, (bounding_box[1].y - bounding_box[0].y) * 0.5f, (bounding_box[1].z - bounding_box[0].z) * 0.5f };
+		object.cell = cell_of(object);
+		object.alive = true;
+		keys[id] = { object.cell, id };
+	}, 1024);
+
+	// Sorting by cell makes each cell one run, so the table sees one insertion per cell instead of one per object.
+	std::sort(keys.begin(), keys.end());
+	cells.reserve(count / 4 + 1);
+	for (size_t first = 0; first < count;)
+	{
+		size_t last{ first };
+		while (last < count && keys[last].first == keys[first].first)
+		{
+			++last;
+		}
+		std::vector<size_t>& list{ keys[first].first == OVERSIZED ? oversized : cells[keys[first].first] };
+		list.reserve(last - first);
+		for (size_t i = first; i < last; ++i)
+		{
+			objects[keys[i].second].slot = static_cast<uint32_t>(list.size());
+			list.push_back(keys[i].second);
+		}
+		first = last;
+	}
+}
+
+template<class F>
+void spatial_grid::for_each_candidate(const XMFLOAT3& minimum, const XMFLOAT3& maximum, F&& visit) const
+{
+	// A cell reaches half a cell past its sides, so any cell within half a cell of the range may hold a candidate.
+	const float margin{ cell_size * 0.5f };
+	const int32_t x0{ coordinate(minimum.x - margin, cell_size) }, x1{ coordinate(maximum.x + margin, cell_size) };
+	const int32_t y0{ coordinate(minimum.y - margin, cell_size) }, y1{ coordinate(maximum.y + margin, cell_size) };
+	const int32_t z0{ coordinate(minimum.z - margin, cell_size) }, z1{ coordinate(maximum.z + margin, cell_size) };
+	const double range_cells{ (static_cast<double>(x1) - x0 + 1) * (static_cast<double>(y1) - y0 + 1) * (static_cast<double>(z1) - z0 + 1) };
+	if (range_cells <= static_cast<double>(cells.size()))
+	{
+		for (int32_t z = z0; z <= z1; ++z)
+		{
+			for (int32_t y = y0; y <= y1; ++y)
+			{
+				for (int32_t x = x0; x <= x1; ++x)
+				{
+					const std::unordered_map<uint64_t, std::vector<size_t>>::const_iterator cell{ cells.find(pack(x, y, z)) };
+					if (cell != cells.end())
+					{
+						for (size_t id : cell->second)
+						{
+							visit(id);
+						}
+					}
+				}
+			}
+		}
+	}
+	else
+	{
+		// Fewer cells exist than the range covers: walk them instead.
+		for (const std::pair<const uint64_t, std::vector<size_t>>& cell : cells)
+		{
+			int32_t x, y, z;
+			unpack(cell.first, x, y, z);
+			if (x < x0 || x > x1 || y < y0 || y > y1 || z < z0 || z > z1)
+			{
+				continue;
+			}
+			for (size_t id : cell.second)
+			{
+				visit(id);
+			}
+		}
+	}
+	for (size_t id : oversized)
+	{
+		visit(id);
+	}
+}
+
+size_t spatial_grid::query_frustum(const XMFLOAT4X4& view_projection, std::vector<size_t>& ids) const
+{
+	ids.clear();
+	XMFLOAT4 planes[6];
+	extract_frustum_planes(view_projection, planes);
+	// Outside when the center is further behind some plane than the extent reaches along its normal.
+	auto inside = [&planes](const XMFLOAT3& center, const XMFLOAT3& extent)
+	{
+		for (const XMFLOAT4& plane : planes)
+		{
+			const float distance{ plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w };
+			const float reach{ std::fabs(plane.x) * extent.x + std::fabs(plane.y) * extent.y + std::fabs(plane.z) * extent.z };
+			if (distance + reach < 0.0f)
+			{
+				return false;
+			}
+		}
+		return true;
+	};
+
+	// Cells are tested one by one; the objects of the cells that pass are gathered into a frustum_culler and tested
+	// four at a time. The scratch is per thread so that queries on a const grid may run concurrently.
+	thread_local frustum_culler candidates;
+	thread_local std::vector<size_t> candidate_ids;
+	thread_local std::vector<uint32_t> visible_candidates;
+	candidates.clear();
+	candidate_ids.clear();
+	auto gather = [&](size_t id)
+	{
+		candidates.add(objects[id].center, objects[id].extent);
+		candidate_ids.push_back(id);
+	};
+
+	const XMFLOAT3 loose_extent{ cell_size, cell_size, cell_size };
+	for (const std::pair<const uint64_t, std::vector<size_t>>& cell : cells)
+	{
+		int32_t x, y, z;
+		unpack(cell.first, x, y, z);
+		const XMFLOAT3 cell_center{ (x + 0.5f) * cell_size, (y + 0.5f) * cell_size, (z + 0.5f) * cell_size };
+		if (!inside(cell_center, loose_extent))
+		{
+			continue;
+		}
+		for (size_t id : cell.second)
+		{
+			gather(id);
+		}
+	}
+	for (size_t id : oversized)
+	{
+		gather(id);
+	}
+
+	candidates.cull(view_projection, visible_candidates);
+	ids.reserve(visible_candidates.size());
+	for (uint32_t candidate : visible_candidates)
+	{
+		ids.push_back(candidate_ids[candidate]);
+	}
+	return ids.size();
+}
+
+size_t spatial_grid::query_sphere(const XMFLOAT3& center, float radius, std::vector<size_t>& ids) const
+{
+	ids.clear();
+	const XMFLOAT3 minimum{ center.x - radius, center.y - radius, center.z - radius };
+	const XMFLOAT3 maximum{ center.x + radius, center.y + radius, center.z + radius };
+	for_each_candidate(minimum, maximum, [&](size_t id)
+	{
+		// Squared distance from the sphere center to the box.
+		const object& object{ objects[id] };
+		const float dx{ std::max<float>(std::fabs(center.x - object.center.x) - object.extent.x, 0.0f) };
+		const float dy{ std::max<float>(std::fabs(center.y - object.center.y) - object.extent.y, 0.0f) };
+		const float dz{ std::max<float>(std::fabs(center.z - object.center.z) - object.extent.z, 0.0f) };
+		if (dx * dx + dy * dy + dz * dz <= radius * radius)
+		{
+			ids.push_back(id);
+		}
+	});
+	return ids.size();
+}
+
+size_t spatial_grid::query_ray(const XMFLOAT3& origin, const XMFLOAT3& direction, float max_distance, std::vector<std::pair<float, size_t>>& hits) const
+{
+	hits.clear();
+	const XMFLOAT3 inverse_direction{ 1.0f / direction.x, 1.0f / direction.y, 1.0f / direction.z };
+	auto test = [&](size_t id)
+	{
+		const object& object{ objects[id] };
+		const XMFLOAT3 minimum{ object.center.x - object.extent.x, object.center.y - object.extent.y, object.center.z - object.extent.z };
+		const XMFLOAT3 maximum{ object.center.x + object.extent.x, object.center.y + object.extent.y, object.center.z + object.extent.z };
+		const float entry{ enter_box(origin, inverse_direction, minimum, maximum, max_distance) };
+		if (entry >= 0.0f)
+		{
+			hits.push_back({ entry, id });
+		}
+	};
+
+	if (max_distance < FLT_MAX)
+	{
+		// The candidates are the cells around the segment's box; for a long segment that walks every cell anyway.
+		const XMFLOAT3 end{ origin.x + direction.x * max_distance, origin.y + direction.y * max_distance, origin.z + direction.z * max_distance };
+		for_each_candidate({ std::min<float>(origin.x, end.x), std::min<float>(origin.y, end.y), std::min<float>(origin.z, end.z) },
+			{ std::max<float>(origin.x, end.x), std::max<float>(origin.y, end.y), std::max<float>(origin.z, end.z) }, test);
+	}
+	else
+	{
+		for (const std::pair<const uint64_t, std::vector<size_t>>& cell : cells)
+		{
+			int32_t x, y, z;
+			unpack(cell.first, x, y, z);
+			const float margin{ cell_size * 0.5f };
+			const XMFLOAT3 minimum{ x * cell_size - margin, y * cell_size - margin, z * cell_size - margin };
+			const XMFLOAT3 maximum{ (x + 1) * cell_size + margin, (y + 1) * cell_size + margin, (z + 1) * cell_size + margin };
+			if (enter_box(origin, inverse_direction, minimum, maximum, max_distance) < 0.0f)
+			{
+				continue;
+			}
+			for (size_t id : cell.second)
+			{
+				test(id);
+			}
+		}
+		for (size_t id : oversized)
+		{
+			test(id);
+		}
+	}
+	std::sort(hits.begin(), hits.end());
+	return hits.size();
+}
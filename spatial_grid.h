@@ -0,0 +1,67 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// A loose hashed grid of world space boxes, for culling, proximity and picking queries over many scene objects.
+// Each object lives in the one cell that holds the center of its box, and a cell is treated as reaching half a cell
+// past its sides, so every object no larger than a cell is found through its cell alone. Larger objects are kept
+// in a separate list that every query checks. Moving an object only touches the cells it leaves and enters.
+// No Direct3D dependency.
+class spatial_grid
+{
+public:
+	explicit spatial_grid(float cell_size = 4.0f);
+
+	// Returns the id of the new object. Ids of removed objects are reused.
+	size_t add(const DirectX::XMFLOAT3 bounding_box[2]);
+	void remove(size_t id);
+	void move(size_t id, const DirectX::XMFLOAT3 bounding_box[2]);
+
+	// Replaces everything with boxes[0..count), whose ids become 0..count-1. Cells are computed on the thread pool.
+	void rebuild(const DirectX::XMFLOAT3 (*boxes)[2], size_t count);
+	void clear();
+
+	// Queries write the ids of the objects whose boxes pass the test to 'ids' (cleared first) and return how many there are.
+	size_t query_frustum(const DirectX::XMFLOAT4X4& view_projection, std::vector<size_t>& ids) const;
+	size_t query_sphere(const DirectX::XMFLOAT3& center, float radius, std::vector<size_t>& ids) const;
+	// Objects whose boxes the ray enters within 'max_distance', nearest entry first, with the entry distance.
+	size_t query_ray(const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float max_distance, std::vector<std::pair<float, size_t>>& hits) const;
+
+	size_t object_count() const { return objects.size() - free_ids.size(); }
+	size_t cell_count() const { return cells.size(); }
+	float cell_dimension() const { return cell_size; }
+
+private:
+	static constexpr uint64_t OVERSIZED{ ~0ull };
+
+	struct object
+	{
+		DirectX::XMFLOAT3 center;
+		DirectX::XMFLOAT3 extent;
+		uint64_t cell{ OVERSIZED };
+		uint32_t slot{ 0 }; // position in the id list of its cell
+		bool alive{ false };
+	};
+	std::vector<object> objects;
+	std::vector<size_t> free_ids;
+
+	// Cell coordinates packed 21 bits each.
+	std::unordered_map<uint64_t, std::vector<size_t>> cells;
+	std::vector<size_t> oversized;
+
+	float cell_size;
+
+	uint64_t cell_of(const object& object) const;
+	void link(size_t id);
+	void unlink(size_t id);
+
+	// Visits every non-empty cell whose loose box may overlap [minimum, maximum], then the oversized list.
+	template<class F>
+	void for_each_candidate(const DirectX::XMFLOAT3& minimum, const DirectX::XMFLOAT3& maximum, F&& visit) const;
+};
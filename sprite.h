@@ -1,46 +1,46 @@
-// UNIT.02
-#pragma once
-
-#include <d3d11.h>
-#include <directxmath.h>
-
-// UNIT.10
-#include <wrl.h>
-#include <string>
-
-class sprite
-{
-private:
-	// UNIT.10
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
-
-	// UNIT.05
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view;
-	D3D11_TEXTURE2D_DESC texture2d_desc;
-
-public:
-	struct vertex
-	{
-		DirectX::XMFLOAT3 position;
-		DirectX::XMFLOAT4 color;
-		// UNIT.05
-		DirectX::XMFLOAT2 texcoord;
-	};
-
-	sprite(ID3D11Device *device, const wchar_t* filename);
-	virtual ~sprite();
-
-	//void render(ID3D11DeviceContext* immediate_context);
-	// UNIT.03
-	//void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a);
-	// UNIT.04
-	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/);
-	// UNIT.06
-	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/, float sx, float sy, float sw, float sh);
-	// UNIT.10
-	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh);
-	void textout(ID3D11DeviceContext* immediate_context, std::string s, float x, float y, float w, float h, float r, float g, float b, float a);
-};
+// UNIT.02
+#pragma once
+
+#include <d3d11.h>
+#include <directxmath.h>
+
+// UNIT.10
+#include <wrl.h>
+#include <string>
+
+class sprite
+{
+private:
+	// UNIT.10
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
+
+	// UNIT.05
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+	D3D11_TEXTURE2D_DESC texture2d_desc;
+
+public:
+	struct vertex
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT4 color;
+		// UNIT.05
+		DirectX::XMFLOAT2 texcoord;
+	};
+
+	sprite(ID3D11Device *device, const wchar_t* filename);
+	virtual ~sprite();
+
+	//void render(ID3D11DeviceContext* immediate_context);
+	// UNIT.03
+	//void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a);
+	// UNIT.04
+	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/);
+	// UNIT.06
+	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/, float sx, float sy, float sw, float sh);
+	// UNIT.10
+	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh);
+	void textout(ID3D11DeviceContext* immediate_context, std::string s, float x, float y, float w, float h, float r, float g, float b, float a);
+};
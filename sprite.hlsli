@@ -1,7 +1,7 @@
-struct VS_OUT
-{
-	float4 position : SV_POSITION;
-	float4 color : COLOR;
-	// UNIT.05
-	float2 texcoord : TEXCOORD;
-};
+struct VS_OUT
+{
+	float4 position : SV_POSITION;
+	float4 color : COLOR;
+	// UNIT.05
+	float2 texcoord : TEXCOORD;
+};
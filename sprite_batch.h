@@ -1,70 +1,70 @@
-#pragma once
-
-#include <d3d11.h>
-// UNIT.10
-#include <wrl.h>
-#include <directxmath.h>
-
-// UNIT.09
-#include <vector>
-
-// UNIT.09
-class sprite_batch
-{
-private:
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
-	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view;
-	D3D11_TEXTURE2D_DESC texture2d_desc;
-
-public:
-	struct vertex
-	{
-		DirectX::XMFLOAT3 position;
-		DirectX::XMFLOAT4 color;
-		DirectX::XMFLOAT2 texcoord;
-	};
-private:
-	// UNIT.09
-	const size_t max_vertices;
-	std::vector<vertex> vertices;
-
-public:
-	sprite_batch(ID3D11Device *device, const wchar_t* filename, size_t max_sprites);
-	virtual ~sprite_batch();
-
-	//void render(ID3D11DeviceContext* immediate_context);
-	// UNIT.03
-	//void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a);
-	// UNIT.04
-	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/);
-	// UNIT.06
-	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/, float sx, float sy, float sw, float sh);
-	// UNIT.10
-	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh);
-
-	// UNIT.09
-	void begin(ID3D11DeviceContext* immediate_context, ID3D11PixelShader* replaced_pixel_shader = nullptr/*UNIT.10*/);
-	void end(ID3D11DeviceContext* immediate_context);
-
-private:
-	// UNIT.09
-	static void rotate(float& x, float& y, float cx, float cy, float sin, float cos)
-	{
-		x -= cx;
-		y -= cy;
-
-		float tx{ x }, ty{ y };
-		x = cos * tx + -sin * ty;
-		y = sin * tx + cos * ty;
-
-		x += cx;
-		y += cy;
-	}
-};
-
-
-
-
+#pragma once
+
+#include <d3d11.h>
+// UNIT.10
+#include <wrl.h>
+#include <directxmath.h>
+
+// UNIT.09
+#include <vector>
+
+#include "sprite_vertices.h"
+
+// UNIT.09
+class sprite_batch
+{
+private:
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
+	// Two triangles over the four corners of every sprite, built once for 'max_sprites' sprites ('SPRITE_INDEX_COUNT' indices each).
+	Microsoft::WRL::ComPtr<ID3D11Buffer> index_buffer;
+	Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+	D3D11_TEXTURE2D_DESC texture2d_desc;
+
+public:
+	using vertex = sprite_vertex;
+private:
+	// UNIT.09
+	const size_t max_vertices;
+	// Reserved for 'max_vertices' up front so that 'render' never reallocates.
+	std::vector<vertex> vertices;
+
+public:
+	sprite_batch(ID3D11Device *device, const wchar_t* filename, size_t max_sprites);
+	virtual ~sprite_batch();
+
+	//void render(ID3D11DeviceContext* immediate_context);
+	// UNIT.03
+	//void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a);
+	// UNIT.04
+	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/);
+	// UNIT.06
+	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh, float r, float g, float b, float a, float angle/*degree*/, float sx, float sy, float sw, float sh);
+	// UNIT.10
+	void render(ID3D11DeviceContext* immediate_context, float dx, float dy, float dw, float dh);
+
+	// UNIT.09
+	void begin(ID3D11DeviceContext* immediate_context, ID3D11PixelShader* replaced_pixel_shader = nullptr/*UNIT.10*/);
+	void end(ID3D11DeviceContext* immediate_context);
+
+private:
+	// UNIT.09
+	static void rotate(float& x, float& y, float cx, float cy, float sin, float cos)
+	{
+		x -= cx;
+		y -= cy;
+
+		float tx{ x }, ty{ y };
+		x = cos * tx + -sin * ty;
+		y = sin * tx + cos * ty;
+
+		x += cx;
+		y += cy;
+	}
+};
+
+
+
+
@@ -0,0 +1,122 @@
+#include "sprite_vertices.h"
+
+#include <algorithm>
+#include <cmath>
+
+uint32_t pack_sprite_color(float r, float g, float b, float a)
+{
+	auto unorm8 = [](float value) { return static_cast<uint32_t>(std::min<float>(std::max<float>(value, 0.0f), 1.0f) * 255.0f + 0.5f); };
+	return unorm8(r) | unorm8(g) << 8 | unorm8(b) << 16 | unorm8(a) << 24;
+}
+
+void append_sprite_vertices(std::vector<sprite_vertex>& vertices,
+	float dx, float dy, float dw, float dh,
+	float r, float g, float b, float a,
+	float angle/*degree*/,
+	float sx, float sy, float sw, float sh,
+	float viewport_width, float viewport_height, float texture_width, float texture_height)
+{
+	// Set each sprite's vertices coordinate to screen space
+	//
+	//  (x0, y0) *----* (x1, y1) 
+	//	         |   /|
+	//	         |  / |
+	//	         | /  |
+	//	         |/   |
+	//  (x2, y2) *----* (x3, y3) 
+
+	// left-top
+	float x0{ dx };
+	float y0{ dy };
+	// right-top
+	float x1{ dx + dw };
+	float y1{ dy };
+	// left-bottom
+	float x2{ dx };
+	float y2{ dy + dh };
+	// right-bottom
+	float x3{ dx + dw };
+	float y3{ dy + dh };
+
+	// UNIT.09
+	// Translate sprite's centre to origin (rotate centre)
+	float cx = dx + dw * 0.5f;
+	float cy = dy + dh * 0.5f;
+	x0 -= cx;
+	y0 -= cy;
+	x1 -= cx;
+	y1 -= cy;
+	x2 -= cx;
+	y2 -= cy;
+	x3 -= cx;
+	y3 -= cy;
+
+	// Rotate each sprite's vertices by angle
+	float tx, ty;
+	float cos{ cosf(DirectX::XMConvertToRadians(angle)) };
+	float sin{ sinf(DirectX::XMConvertToRadians(angle)) };
+	tx = x0;
+	ty = y0;
+	x0 = cos * tx + -sin * ty;
+	y0 = sin * tx + cos * ty;
+	tx = x1;
+	ty = y1;
+	x1 = cos * tx + -sin * ty;
+	y1 = sin * tx + cos * ty;
+	tx = x2;
+	ty = y2;
+	x2 = cos * tx + -sin * ty;
+	y2 = sin * tx + cos * ty;
+	tx = x3;
+	ty = y3;
+	x3 = cos * tx + -sin * ty;
+	y3 = sin * tx + cos * ty;
+
+	// Translate sprite's centre to original position
+	x0 += cx;
+	y0 += cy;
+	x1 += cx;
+	y1 += cy;
+	x2 += cx;
+	y2 += cy;
+	x3 += cx;
+	y3 += cy;
+
+	// Convert to NDC space
+	x0 = 2.0f * x0 / viewport_width - 1.0f;
+	y0 = 1.0f - 2.0f * y0 / viewport_height;
+	x1 = 2.0f * x1 / viewport_width - 1.0f;
+	y1 = 1.0f - 2.0f * y1 / viewport_height;
+	x2 = 2.0f * x2 / viewport_width - 1.0f;
+	y2 = 1.0f - 2.0f * y2 / viewport_height;
+	x3 = 2.0f * x3 / viewport_width - 1.0f;
+	y3 = 1.0f - 2.0f * y3 / viewport_height;
+
+	// UNIT.09
+	float u0{ sx / texture_width };
+	float v0{ sy / texture_height };
+	float u1{ (sx + sw) / texture_width };
+	float v1{ (sy + sh) / texture_height };
+	const uint32_t color{ pack_sprite_color(r, g, b, a) };
+	vertices.push_back({ { x0, y0 }, color, { u0, v0 } });
+	vertices.push_back({ { x1, y1 }, color, { u1, v0 } });
+	vertices.push_back({ { x2, y2 }, color, { u0, v1 } });
+	vertices.push_back({ { x3, y3 }, color, { u1, v1 } });
+}
+
+void build_sprite_indices(size_t sprite_count, std::vector<uint32_t>& indices)
+{
+	indices.resize(sprite_count * SPRITE_INDEX_COUNT);
+	for (size_t sprite = 0; sprite < sprite_count; ++sprite)
+	{
+		// (x0, x1, x2) and (x2, x1, x3), clockwise on screen.
+		const uint32_t base_vertex{ static_cast<uint32_t>(sprite * SPRITE_VERTEX_COUNT) };
+		uint32_t* sprite_indices{ &indices[sprite * SPRITE_INDEX_COUNT] };
+		sprite_indices[0] = base_vertex + 0;
+		sprite_indices[1] = base_vertex + 1;
+		sprite_indices[2] = base_vertex + 2;
+		sprite_indices[3] = base_vertex + 2;
+		sprite_indices[4] = base_vertex + 1;
+		sprite_indices[5] = base_vertex + 3;
+	}
+}
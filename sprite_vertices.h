@@ -0,0 +1,36 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// What sprite_batch writes to its vertex buffer for each sprite: four corners, drawn through a static index buffer
+// of two triangles per sprite (see build_sprite_indices).
+// No Direct3D dependency; sprite_batch supplies the viewport and texture sizes.
+struct sprite_vertex
+{
+	DirectX::XMFLOAT2 position; // NDC; the vertex shader's POSITION gets z = 0 and w = 1 from the input assembler
+	uint32_t color; // R8G8B8A8_UNORM, red in the lowest byte
+	DirectX::XMFLOAT2 texcoord;
+};
+constexpr size_t SPRITE_VERTEX_COUNT{ 4 };
+constexpr size_t SPRITE_INDEX_COUNT{ 6 };
+
+// 'r', 'g', 'b' and 'a' clamped to [0, 1] and rounded to 8 bits each.
+uint32_t pack_sprite_color(float r, float g, float b, float a);
+
+// UNIT.09
+// Appends the four corners of a sprite (left-top, right-top, left-bottom, right-bottom): the screen rectangle
+// (dx, dy, dw, dh) in pixels rotated by 'angle' degrees about its centre and mapped to NDC, textured with the source
+// rectangle (sx, sy, sw, sh) in texels.
+void append_sprite_vertices(std::vector<sprite_vertex>& vertices,
+	float dx, float dy, float dw, float dh,
+	float r, float g, float b, float a,
+	float angle/*degree*/,
+	float sx, float sy, float sw, float sh,
+	float viewport_width, float viewport_height, float texture_width, float texture_height);
+
+// The triangles of 'sprite_count' sprites written by append_sprite_vertices, SPRITE_INDEX_COUNT per sprite.
+void build_sprite_indices(size_t sprite_count, std::vector<uint32_t>& indices);
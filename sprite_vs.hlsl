@@ -1,14 +1,15 @@
-// UNIT.02
-#include "sprite.hlsli"
-
-VS_OUT main(float4 position : POSITION, float4 color : COLOR, float2 texcoord : TEXCOORD/*UNIT.05*/)
-{
-	VS_OUT vout;
-	vout.position = position;
-	vout.color = color;
-
-	// UNIT.05
-	vout.texcoord = texcoord;
-
-	return vout;
-}
+// UNIT.02
+#include "sprite.hlsli"
+
+// 'position' is read from R32G32_FLOAT, so the input assembler fills in z = 0 and w = 1, and 'color' from R8G8B8A8_UNORM.
+VS_OUT main(float4 position : POSITION, float4 color : COLOR, float2 texcoord : TEXCOORD/*UNIT.05*/)
+{
+	VS_OUT vout;
+	vout.position = position;
+	vout.color = color;
+
+	// UNIT.05
+	vout.texcoord = texcoord;
+
+	return vout;
+}
@@ -0,0 +1,136 @@
+#include "static_batch.h"
+#include "shader.h"
+#include "misc.h"
+#include "d3d11_render_context.h"
+
+#include <map>
+#include <tuple>
+
+using namespace DirectX;
+
+static_batch::static_batch(ID3D11Device* device, const instance* instances, size_t instance_count, float chunk_size)
+{
+	static_assert(sizeof(static_mesh::vertex) == sizeof(batch_vertex), "static_mesh::vertex and batch_vertex must share a layout.");
+
+	std::map<std::tuple<std::wstring, std::wstring, float, float, float, float>, uint32_t> material_keys;
+	std::vector<batch_source> sources(instance_count);
+	for (size_t instance_index = 0; instance_index < instance_count; ++instance_index)
+	{
+		const static_mesh& mesh{ *instances[instance_index].mesh };
+		_ASSERT_EXPR(mesh.vertices.size() > 0 || mesh.subsets.size() == 0, L"static_batch needs meshes constructed with 'retain_geometry'.");
+
+		batch_source& source{ sources.at(instance_index) };
+		source.vertices = reinterpret_cast<const batch_vertex*>(mesh.vertices.data());
+		source.vertex_count = mesh.vertices.size();
+		source.indices = mesh.indices.data();
+		source.world = instances[instance_index].world;
+		for (const static_mesh::subset& subset : mesh.subsets)
+		{
+			if (subset.material_index < 0 || subset.index_count == 0)
+			{
+				continue;
+			}
+			const static_mesh::material& material{ mesh.materials.at(static_cast<size_t>(subset.material_index)) };
+			const std::tuple<std::wstring, std::wstring, float, float, float, float> key{ material.texture_filenames[0], material.texture_filenames[1], material.Kd.x, material.Kd.y, material.Kd.z, material.Kd.w };
+			std::map<std::tuple<std::wstring, std::wstring, float, float, float, float>, uint32_t>::const_iterator it{ material_keys.find(key) };
+			if (it == material_keys.end())
+			{
+				it = material_keys.insert(std::make_pair(key, static_cast<uint32_t>(materials.size()))).first;
+				materials.push_back(&material);
+			}
+			source.ranges.push_back({ it->second, subset.index_start, subset.index_count });
+		}
+	}
+
+	batch_geometry geometry;
+	merge_static_batch(sources.data(), sources.size(), chunk_size, geometry);
+	chunks = std::move(geometry.chunks);
+	draws = std::move(geometry.draws);
+
+	HRESULT hr{ S_OK };
+
+	D3D11_BUFFER_DESC buffer_desc{};
+	D3D11_SUBRESOURCE_DATA subresource_data{};
+	if (geometry.vertices.size() > 0)
+	{
+		buffer_desc.ByteWidth = static_cast<UINT>(sizeof(batch_vertex) * geometry.vertices.size());
+		buffer_desc.Usage = D3D11_USAGE_IMMUTABLE;
+		buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+		subresource_data.pSysMem = geometry.vertices.data();
+		hr = device->CreateBuffer(&buffer_desc, &subresource_data, vertex_buffer.ReleaseAndGetAddressOf());
+		_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+
+		buffer_desc.ByteWidth = static_cast<UINT>(sizeof(uint32_t) * geometry.indices.size());
+		buffer_desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+		subresource_data.pSysMem = geometry.indices.data();
+		hr = device->CreateBuffer(&buffer_desc, &subresource_data, index_buffer.ReleaseAndGetAddressOf());
+		_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+	}
+
+	// The batch is drawn with the static_mesh shaders and an identity world matrix.
+	D3D11_INPUT_ELEMENT_DESC input_element_desc[]
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	create_vs_from_cso(device, "static_mesh_vs.cso", vertex_shader.GetAddressOf(), input_layout.GetAddressOf(), input_element_desc, ARRAYSIZE(input_element_desc));
+	create_ps_from_cso(device, "static_mesh_ps.cso", pixel_shader.GetAddressOf());
+
+	buffer_desc = {};
+	buffer_desc.ByteWidth = sizeof(static_mesh::constants);
+	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffer.GetAddressOf());
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+}
+
+void static_batch::render(ID3D11DeviceContext* immediate_context, const XMFLOAT4& material_color, const uint8_t* chunk_visibility, ID3D11PixelShader* replaced_pixel_shader)
+{
+	statistics = {};
+	if (!vertex_buffer)
+	{
+		return;
+	}
+
+	// State changes are counted as static_mesh counts them: the bind calls the context forwards to the device.
+	d3d11_render_context context{ immediate_context };
+	uint32_t stride{ sizeof(batch_vertex) };
+	uint32_t offset{ 0 };
+	context.IASetVertexBuffers(0, 1, vertex_buffer.GetAddressOf(), &stride, &offset);
+	context.IASetIndexBuffer(index_buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+	context.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context.IASetInputLayout(input_layout.Get());
+	context.VSSetShader(vertex_shader.Get());
+	context.PSSetShader(replaced_pixel_shader ? replaced_pixel_shader : pixel_shader.Get());
+	context.VSSetConstantBuffers(0, 1, constant_buffer.GetAddressOf());
+
+	// Consecutive draws of the same material (across chunks) keep their bindings.
+	uint32_t bound_material{ ~0u };
+	for (size_t chunk_index = 0; chunk_index < chunks.size(); ++chunk_index)
+	{
+		if (chunk_visibility && chunk_visibility[chunk_index] == 0)
+		{
+			continue;
+		}
+		const batch_geometry::chunk& chunk{ chunks.at(chunk_index) };
+		for (uint32_t draw_index = chunk.first_draw; draw_index < chunk.first_draw + chunk.draw_count; ++draw_index)
+		{
+			const batch_geometry::draw& draw{ draws.at(draw_index) };
+			if (draw.material != bound_material)
+			{
+				const static_mesh::material& material{ *materials.at(draw.material) };
+				ID3D11ShaderResourceView* shader_resource_views[2]{ material.shader_resource_views[0].Get(), material.shader_resource_views[1].Get() };
+				context.PSSetShaderResources(0, 2, shader_resource_views);
+
+				static_mesh::constants data{ { 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 }, material_color };
+				XMStoreFloat4(&data.material_color, XMLoadFloat4(&material_color) * XMLoadFloat4(&material.Kd));
+				context.UpdateSubresource(constant_buffer.Get(), 0, 0, &data, 0, 0);
+				bound_material = draw.material;
+			}
+			context.DrawIndexed(draw.index_count, draw.index_start, 0);
+			++statistics.draw_calls;
+		}
+	}
+	statistics.state_changes = static_cast<uint32_t>(context.state_calls);
+}
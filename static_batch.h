@@ -0,0 +1,52 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl.h>
+#include <directxmath.h>
+
+#include <vector>
+
+#include "static_mesh.h"
+#include "static_batcher.h"
+
+// Level geometry merged into one vertex and index buffer, drawn chunk by chunk.
+// The source meshes must be constructed with 'retain_geometry' and must outlive the batch: the batch draws with
+// their materials, whose textures the texture streamer may replace at any time.
+class static_batch
+{
+public:
+	struct instance
+	{
+		const static_mesh* mesh{ nullptr };
+		DirectX::XMFLOAT4X4 world{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+	};
+
+	// Materials with the same textures and diffuse color are shared between meshes.
+	std::vector<const static_mesh::material*> materials;
+	// Chunks hold world space bounds for culling; their draws index 'materials'.
+	std::vector<batch_geometry::chunk> chunks;
+	std::vector<batch_geometry::draw> draws;
+
+	static_mesh::render_statistics statistics;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> index_buffer;
+
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> constant_buffer;
+
+public:
+	// 'chunk_size' is the edge of the grid cells (world units) that instances are grouped by.
+	static_batch(ID3D11Device* device, const instance* instances, size_t instance_count, float chunk_size = 32.0f);
+	virtual ~static_batch() = default;
+	static_batch(const static_batch&) = delete;
+	static_batch& operator=(const static_batch&) = delete;
+	static_batch(static_batch&&) noexcept = delete;
+	static_batch& operator=(static_batch&&) noexcept = delete;
+
+	// 'chunk_visibility', if given, has one entry per chunk; chunks whose entry is 0 are skipped.
+	void render(ID3D11DeviceContext* immediate_context, const DirectX::XMFLOAT4& material_color, const uint8_t* chunk_visibility = nullptr, ID3D11PixelShader* replaced_pixel_shader = nullptr);
+};
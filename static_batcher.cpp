@@ -0,0 +1,131 @@
+#include "static_batcher.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <cmath>
+#include <map>
+#include <tuple>
+
+using namespace DirectX;
+
+void merge_static_batch(const batch_source* sources, size_t source_count, float chunk_size, batch_geometry& geometry)
+{
+	geometry = {};
+	thread_pool& pool{ default_thread_pool() };
+
+	// World bounds of every source decide its chunk.
+	std::vector<XMFLOAT3> bounds(source_count * 2);
+	pool.parallel_for(source_count, [&](size_t source_index)
+	{
+		const batch_source& source{ sources[source_index] };
+		const XMMATRIX W{ XMLoadFloat4x4(&source.world) };
+		XMVECTOR minimum{ XMVectorReplicate(FLT_MAX) };
+		XMVECTOR maximum{ XMVectorReplicate(-FLT_MAX) };
+		for (size_t vertex_index = 0; vertex_index < source.vertex_count; ++vertex_index)
+		{
+			const XMVECTOR position{ XMVector3TransformCoord(XMLoadFloat3(&source.vertices[vertex_index].position), W) };
+			minimum = XMVectorMin(minimum, position);
+			maximum = XMVectorMax(maximum, position);
+		}
+		XMStoreFloat3(&bounds.at(source_index * 2 + 0), minimum);
+		XMStoreFloat3(&bounds.at(source_index * 2 + 1), maximum);
+	});
+
+	// Cells are ordered by their coordinates so the result does not depend on thread timing or input order of cells.
+	std::map<std::tuple<int32_t, int32_t, int32_t>, std::vector<size_t>> cells;
+	for (size_t source_index = 0; source_index < source_count; ++source_index)
+	{
+		if (sources[source_index].vertex_count == 0)
+		{
+			continue;
+		}
+		const XMFLOAT3& minimum{ bounds.at(source_index * 2 + 0) };
+		const XMFLOAT3& maximum{ bounds.at(source_index * 2 + 1) };
+		auto cell = [chunk_size](float a, float b) { return static_cast<int32_t>(std::floor((a + b) * 0.5f / chunk_size)); };
+		cells[std::make_tuple(cell(minimum.x, maximum.x), cell(minimum.y, maximum.y), cell(minimum.z, maximum.z))].push_back(source_index);
+	}
+
+	// Layout: each source's vertices are copied once, its ranges are gathered into one draw per material of its chunk.
+	struct piece
+	{
+		size_t source_index;
+		size_t range_index;
+		uint32_t index_start; // in the merged index array
+	};
+	std::vector<uint32_t> first_vertices(source_count, 0);
+	std::vector<piece> pieces;
+	uint32_t vertex_count{ 0 };
+	uint32_t index_count{ 0 };
+	for (const std::pair<const std::tuple<int32_t, int32_t, int32_t>, std::vector<size_t>>& cell : cells)
+	{
+		batch_geometry::chunk chunk;
+		chunk.first_draw = static_cast<uint32_t>(geometry.draws.size());
+
+		std::vector<std::pair<uint32_t, std::pair<size_t, size_t>>> ranges;
+		for (size_t source_index : cell.second)
+		{
+			const batch_source& source{ sources[source_index] };
+			first_vertices.at(source_index) = vertex_count;
+			vertex_count += static_cast<uint32_t>(source.vertex_count);
+			for (size_t range_index = 0; range_index < source.ranges.size(); ++range_index)
+			{
+				ranges.push_back(std::make_pair(source.ranges.at(range_index).material, std::make_pair(source_index, range_index)));
+			}
+
+			const XMFLOAT3& minimum{ bounds.at(source_index * 2 + 0) };
+			const XMFLOAT3& maximum{ bounds.at(source_index * 2 + 1) };
+			XMStoreFloat3(&chunk.bounding_box[0], XMVectorMin(XMLoadFloat3(&chunk.bounding_box[0]), XMLoadFloat3(&minimum)));
+			XMStoreFloat3(&chunk.bounding_box[1], XMVectorMax(XMLoadFloat3(&chunk.bounding_box[1]), XMLoadFloat3(&maximum)));
+		}
+		std::stable_sort(ranges.begin(), ranges.end(), [](const std::pair<uint32_t, std::pair<size_t, size_t>>& a, const std::pair<uint32_t, std::pair<size_t, size_t>>& b) { return a.first < b.first; });
+
+		for (const std::pair<uint32_t, std::pair<size_t, size_t>>& range : ranges)
+		{
+			const uint32_t count{ sources[range.second.first].ranges.at(range.second.second).index_count };
+			if (count == 0)
+			{
+				continue;
+			}
+			if (geometry.draws.size() > chunk.first_draw && geometry.draws.back().material == range.first)
+			{
+				geometry.draws.back().index_count += count;
+			}
+			else
+			{
+				geometry.draws.push_back({ range.first, index_count, count });
+			}
+			pieces.push_back({ range.second.first, range.second.second, index_count });
+			index_count += count;
+		}
+		chunk.draw_count = static_cast<uint32_t>(geometry.draws.size()) - chunk.first_draw;
+		geometry.chunks.push_back(chunk);
+	}
+
+	geometry.vertices.resize(vertex_count);
+	geometry.indices.resize(index_count);
+	pool.parallel_for(source_count, [&](size_t source_index)
+	{
+		const batch_source& source{ sources[source_index] };
+		const XMMATRIX W{ XMLoadFloat4x4(&source.world) };
+		batch_vertex* destination{ geometry.vertices.data() + first_vertices.at(source_index) };
+		for (size_t vertex_index = 0; vertex_index < source.vertex_count; ++vertex_index)
+		{
+			const batch_vertex& vertex{ source.vertices[vertex_index] };
+			XMStoreFloat3(&destination[vertex_index].position, XMVector3TransformCoord(XMLoadFloat3(&vertex.position), W));
+			XMStoreFloat3(&destination[vertex_index].normal, XMVector3Normalize(XMVector3TransformNormal(XMLoadFloat3(&vertex.normal), W)));
+			destination[vertex_index].texcoord = vertex.texcoord;
+		}
+	});
+	pool.parallel_for(pieces.size(), [&](size_t piece_index)
+	{
+		const piece& piece{ pieces.at(piece_index) };
+		const batch_source& source{ sources[piece.source_index] };
+		const batch_source::range& range{ source.ranges.at(piece.range_index) };
+		const uint32_t first_vertex{ first_vertices.at(piece.source_index) };
+		uint32_t* destination{ geometry.indices.data() + piece.index_start };
+		for (uint32_t index = 0; index < range.index_count; ++index)
+		{
+			destination[index] = source.indices[range.index_start + index] + first_vertex;
+		}
+	}, 16);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// The CPU side of static batching: pre-transforms a set of mesh instances into world space and merges them
+// into one vertex/index array, grouped by material inside spatial chunks.
+// No Direct3D dependency; static_batch uploads the result and draws it.
+
+// The same layout as static_mesh::vertex.
+struct batch_vertex
+{
+	DirectX::XMFLOAT3 position{ 0, 0, 0 };
+	DirectX::XMFLOAT3 normal{ 0, 0, 0 };
+	DirectX::XMFLOAT2 texcoord{ 0, 0 };
+};
+
+struct batch_source
+{
+	struct range
+	{
+		uint32_t material{ 0 }; // any key; equal keys are merged into one draw per chunk
+		uint32_t index_start{ 0 };
+		uint32_t index_count{ 0 };
+	};
+
+	const batch_vertex* vertices{ nullptr };
+	size_t vertex_count{ 0 };
+	const uint32_t* indices{ nullptr };
+	std::vector<range> ranges;
+	DirectX::XMFLOAT4X4 world{ 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1, 0, 0, 0, 0, 1 };
+};
+
+struct batch_geometry
+{
+	struct draw
+	{
+		uint32_t material{ 0 };
+		uint32_t index_start{ 0 };
+		uint32_t index_count{ 0 };
+	};
+	struct chunk
+	{
+		DirectX::XMFLOAT3 bounding_box[2]{ { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } }; // world space
+		uint32_t first_draw{ 0 };
+		uint32_t draw_count{ 0 };
+	};
+
+	std::vector<batch_vertex> vertices;
+	std::vector<uint32_t> indices;
+	std::vector<draw> draws; // chunk by chunk, sorted by material within a chunk
+	std::vector<chunk> chunks;
+};
+
+// Instances are assigned to the cell of a uniform grid of 'chunk_size' (world units) that holds the centre of their world bounds.
+// Normals are transformed like the static_mesh vertex shader does: by 'world', then normalized.
+void merge_static_batch(const batch_source* sources, size_t source_count, float chunk_size, batch_geometry& geometry);
@@ -1,462 +1,537 @@
-// UNIT.13
-#include "shader.h"
-#include "misc.h"
-#include "static_mesh.h"
-
-#include <fstream>
-#include <vector>
-
-// UNIT.14
-#include <filesystem>
-#include "texture.h"
-
-// UNIT.13
-using namespace DirectX;
-static_mesh::static_mesh(ID3D11Device* device, const wchar_t* obj_filename, bool flipping_v_coordinates/*UNIT.14*/)
-{
-	std::vector<vertex> vertices;
-	std::vector<uint32_t> indices;
-	uint32_t current_index{ 0 };
-
-	std::vector<XMFLOAT3> positions;
-	std::vector<XMFLOAT3> normals;
-	// UNIT.14
-	std::vector<XMFLOAT2> texcoords;
-	std::vector<std::wstring> mtl_filenames;
-
-	std::wifstream fin(obj_filename);
-	_ASSERT_EXPR(fin, L"'OBJ file not found.");
-	wchar_t command[256];
-	while (fin)
-	{
-		fin >> command;
-		if (0 == wcscmp(command, L"v"))
-		{
-			// v x y z w
-			// 
-			// Specifies a geometric vertex and its x y z coordinates.Rational
-			// curves and surfaces require a fourth homogeneous coordinate, also
-			// called the weight.
-			// 
-			// x y z are the x, y, and z coordinates for the vertex.These are
-			// floating point numbers that define the position of the vertex in
-			// three dimensions.
-			// 
-			// w is the weight required for rational curves and surfaces.It is
-			// not required for non - rational curves and surfaces.If you do not
-			// specify a value for w, the default is 1.0.
-			float x, y, z;
-			fin >> x >> y >> z;
-			positions.push_back({ x, y, z });
-			fin.ignore(1024, L'\n');
-		}
-		// UNIT.14
-		else if (0 == wcscmp(command, L"vt"))
-		{
-			// vt u v w
-			// 
-			// Specifies a texture vertex and its coordinates.A 1D texture
-			// requires only u texture coordinates, a 2D texture requires both u
-			// and v texture coordinates, and a 3D texture requires all three
-			// coordinates.
-			// 
-			// u is the value for the horizontal direction of the texture.
-			// 
-			// v is an optional argument.
-			// 
-			// v is the value for the vertical direction of the texture.The
-			// default is 0.
-			// 
-			// w is an optional argument.
-			// 
-			// w is a value for the depth of the texture.The default is 0.
-			float u, v;
-			fin >> u >> v;
-			texcoords.push_back({ u, flipping_v_coordinates ? 1.0f - v : v });
-			fin.ignore(1024, L'\n');
-		}
-		else if (0 == wcscmp(command, L"vn"))
-		{
-			// vn i j k
-			// 
-			// Specifies a normal vector with components i, j, and k.
-			// 
-			// Vertex normals affect the smooth - shading and rendering of geometry.0
-			// For polygons, vertex normals are used in place of the actual facet
-			// normals.For surfaces, vertex normals are interpolated over the
-			// entire surface and replace the actual analytic surface normal.
-			// 
-			// When vertex normals are present, they supersede smoothing groups.
-			// 
-			// i j k are the i, j, and k coordinates for the vertex normal.They
-			// are floating point numbers.
-			FLOAT i, j, k;
-			fin >> i >> j >> k;
-			normals.push_back({ i, j, k });
-			fin.ignore(1024, L'\n');
-		}
-		else if (0 == wcscmp(command, L"f"))
-		{
-			//f  v1 / vt1 / vn1   v2 / vt2 / vn2   v3 / vt3 / vn3 . . .
-			//
-			// optionally include the texture vertex and vertex normal reference
-			// numbers.
-			// 
-			// The reference numbers for the vertices, texture vertices, and
-			// vertex normals must be separated by slashes(/ ).There is no space
-			// between the number and the slash.
-			// 
-			// v is the reference number for a vertex in the face element.A
-			// minimum of three vertices are required.
-			// 
-			// vt is an optional argument.
-			// 
-			// vt is the reference number for a texture vertex in the face
-			// element.It always follows the first slash.
-			// 
-			// vn is an optional argument.
-			// 
-			// vn is the reference number for a vertex normal in the face element.
-			// It must always follow the second slash.
-			// 
-			// Face elements use surface normals to indicate their orientation.If
-			// vertices are ordered counterclockwise around the face, both the
-			// face and the normal will point toward the viewer.If the vertex
-			// ordering is clockwise, both will point away from the viewer.If
-			// vertex normals are assigned, they should point in the general
-			// direction of the surface normal, otherwise unpredictable results
-			// may occur.
-			//
-			// If a face has a texture map assigned to it and no texture vertices
-			// are assigned in the f statement, the texture map is ignored when
-			// the element is rendered.
-			for (size_t i = 0; i < 3; i++)
-			{
-				vertex vertex;
-				size_t v, vt, vn;
-
-				fin >> v;
-				vertex.position = positions.at(v - 1);
-				if (L'/' == fin.peek())
-				{
-					fin.ignore(1);
-					if (L'/' != fin.peek())
-					{
-						fin >> vt;
-						// UNIT.14
-						vertex.texcoord = texcoords.at(vt - 1);
-					}
-					if (L'/' == fin.peek())
-					{
-						fin.ignore(1);
-						fin >> vn;
-						vertex.normal = normals.at(vn - 1);
-					}
-				}
-				vertices.push_back(vertex);
-				indices.push_back(current_index++);
-			}
-			fin.ignore(1024, L'\n');
-		}
-		// UNIT.14
-		else if (0 == wcscmp(command, L"mtllib"))
-		{
-			// mtllib filename1 filename2 . . .
-			// Specifies the material library file for the material definitions
-			// set with the usemtl statement.You can specify multiple filenames
-			// with mtllib.If multiple filenames are specified, the first file
-			// listed is searched first for the material definition, the second
-			// file is searched next, and so on.
-			wchar_t mtllib[256];
-			fin >> mtllib;
-			mtl_filenames.push_back(mtllib);
-		}
-		// UNIT.15
-		else if (0 == wcscmp(command, L"usemtl"))
-		{
-			wchar_t usemtl[MAX_PATH]{ 0 };
-			fin >> usemtl;
-			subsets.push_back({ usemtl, static_cast<uint32_t>(indices.size()), 0 });
-		}
-		else
-		{
-			fin.ignore(1024, L'\n');
-		}
-	}
-	fin.close();
-
-	// UNIT.15
-	std::vector<subset>::reverse_iterator iterator = subsets.rbegin();
-	iterator->index_count = static_cast<uint32_t>(indices.size()) - iterator->index_start;
-	for (iterator = subsets.rbegin() + 1; iterator != subsets.rend(); ++iterator)
-	{
-		iterator->index_count = (iterator - 1)->index_start - iterator->index_start;
-	}
-
-	// UNIT.14
-	std::filesystem::path mtl_filename(obj_filename);
-	mtl_filename.replace_filename(std::filesystem::path(mtl_filenames[0]).filename());
-
-	fin.open(mtl_filename);
-	// UNIT.16
-	//_ASSERT_EXPR(fin, L"'MTL file not found.");
-
-	while (fin)
-	{
-		fin >> command;
-		if (0 == wcscmp(command, L"map_Kd"))
-		{
-			// map_Kd - options args filename
-			//
-			// Specifies that a color texture file or color procedural texture file is
-			// linked to the diffuse reflectivity of the material.During rendering,
-			// the map_Kd value is multiplied by the Kd value.
-			//
-			// "filename" is the name of a color texture file(.mpc), a color
-			// procedural texture file(.cxc), or an image file.
-			fin.ignore();
-			wchar_t map_Kd[256];
-			fin >> map_Kd;
-
-			std::filesystem::path path(obj_filename);
-			path.replace_filename(std::filesystem::path(map_Kd).filename());
-			// UNIT.15
-			//texture_filename = path;
-			//materials.rbegin()->texture_filename = path;
-			// UNIT.16
-			materials.rbegin()->texture_filenames[0] = path;
-			fin.ignore(1024, L'\n');
-		}
-		// UNIT.16
-		else if (0 == wcscmp(command, L"map_bump") || 0 == wcscmp(command, L"bump"))
-		{
-			// map_bump - options args filename
-			//
-			// Specifies that a bump texture file or a bump procedural texture file is
-			// linked to the material.
-			//
-			// "filename" is the name of a bump texture file(.mpb), a bump procedural
-			// texture file(.cxb), or an image file.
-			fin.ignore();
-			wchar_t map_bump[256];
-			fin >> map_bump;
-			
-			std::filesystem::path path(obj_filename);
-			path.replace_filename(std::filesystem::path(map_bump).filename());
-			materials.rbegin()->texture_filenames[1] = path;
-			fin.ignore(1024, L'\n');
-		}
-		// UNIT.15
-		else if (0 == wcscmp(command, L"newmtl"))
-		{
-			// The folowing syntax describes the material name statement.
-			//
-			//	newmtl name
-			//
-			// Specifies the start of a material description and assigns a name to the
-			// material.An.mtl file must have one newmtl statement at the start of
-			// each material description.
-			// "name" is the name of the material.Names may be any length but
-			// cannot include blanks.Underscores may be used in material names.material material;
-			fin.ignore();
-			wchar_t newmtl[256];
-			material material;
-			fin >> newmtl;
-			material.name = newmtl;
-			materials.push_back(material);
-		}
-		// UNIT.15
-		else if (0 == wcscmp(command, L"Ka"))
-		{
-			// Ka r g b
-			//
-			// The Ka statement specifies the ambient reflectivity using RGB values.
-			// "r g b" are the values for the red, green, and blue components of the
-			// color.The g and b arguments are optional.If only r is specified,
-			// then g, and b are assumed to be equal to r.The r g b values are
-			// normally in the range of 0.0 to 1.0.Values outside this range increase
-			// or decrease the relectivity accordingly.
-			float r, g, b;
-			fin >> r >> g >> b;
-			materials.rbegin()->Ka = { r, g, b, 1 };
-			fin.ignore(1024, L'\n');
-		}
-		// UNIT.15
-		else if (0 == wcscmp(command, L"Kd"))
-		{
-			// Kd r g b
-			//
-			// The Kd statement specifies the diffuse reflectivity using RGB values.
-			// "r g b" are the values for the red, green, and blue components of the
-			// atmosphere.The g and b arguments are optional.If only r is
-			// specified, then g, and b are assumed to be equal to r.The r g b values
-			// are normally in the range of 0.0 to 1.0.Values outside this range
-			// increase or decrease the relectivity accordingly.
-			float r, g, b;
-			fin >> r >> g >> b;
-			materials.rbegin()->Kd = { r, g, b, 1 };
-			fin.ignore(1024, L'\n');
-		}
-		// UNIT.15
-		else if (0 == wcscmp(command, L"Ks"))
-		{
-			// Ks r g b
-			//
-			// The Ks statement specifies the specular reflectivity using RGB values.
-			// "r g b" are the values for the red, green, and blue components of the
-			// atmosphere.The g and b arguments are optional.If only r is
-			// specified, then g, and b are assumed to be equal to r.The r g b values
-			// are normally in the range of 0.0 to 1.0.Values outside this range
-			// increase or decrease the relectivity accordingly.
-			float r, g, b;
-			fin >> r >> g >> b;
-			materials.rbegin()->Ks = { r, g, b, 1 };
-			fin.ignore(1024, L'\n');
-		}
-		else
-		{
-			fin.ignore(1024, L'\n');
-		}
-	}
-	fin.close();
-
-	create_com_buffers(device, vertices.data(), vertices.size(), indices.data(), indices.size());
-
-	HRESULT hr{ S_OK };
-
-	D3D11_INPUT_ELEMENT_DESC input_element_desc[]
-	{
-		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-		// UNIT.14
-		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
-	};
-	create_vs_from_cso(device, "static_mesh_vs.cso", vertex_shader.GetAddressOf(), input_layout.GetAddressOf(), input_element_desc, ARRAYSIZE(input_element_desc));
-	create_ps_from_cso(device, "static_mesh_ps.cso", pixel_shader.GetAddressOf());
-
-	D3D11_BUFFER_DESC buffer_desc{};
-	buffer_desc.ByteWidth = sizeof(constants);
-	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
-	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffer.GetAddressOf());
-	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
-
-	// UNIT.16
-	if (materials.size() == 0)
-	{
-		for (const subset& subset : subsets)
-		{
-			materials.push_back({ subset.usemtl });
-		}
-	}
-
-	// UNIT.14
-	D3D11_TEXTURE2D_DESC texture2d_desc{};
-	// UNIT.15
-	//load_texture_from_file(device, texture_filename.c_str(), shader_resource_view.GetAddressOf(), &texture2d_desc);
-	for (material& material : materials)
-	{
-		//load_texture_from_file(device, material.texture_filename.c_str(), material.shader_resource_view.GetAddressOf(), &texture2d_desc);
-		// UNIT.16
-		if (material.texture_filenames[0].size() > 0)
-		{
-			load_texture_from_file(device, material.texture_filenames[0].c_str(), material.shader_resource_views[0].GetAddressOf(), &texture2d_desc);
-		}
-		else
-		{
-			make_dummy_texture(device, material.shader_resource_views[0].GetAddressOf(), 0xFFFFFFFF, 16);
-		}
-		if (material.texture_filenames[1].size() > 0)
-		{
-			load_texture_from_file(device, material.texture_filenames[1].c_str(), material.shader_resource_views[1].GetAddressOf(), &texture2d_desc);
-		}
-		else
-		{
-			make_dummy_texture(device, material.shader_resource_views[1].GetAddressOf(), 0xFFFF7F7F, 16);
-		}
-	}
-
-	// UNIT.16
-	for (const vertex& v : vertices)
-	{
-		bounding_box[0].x = std::min<float>(bounding_box[0].x, v.position.x);
-		bounding_box[0].y = std::min<float>(bounding_box[0].y, v.position.y);
-		bounding_box[0].z = std::min<float>(bounding_box[0].z, v.position.z);
-		bounding_box[1].x = std::max<float>(bounding_box[1].x, v.position.x);
-		bounding_box[1].y = std::max<float>(bounding_box[1].y, v.position.y);
-		bounding_box[1].z = std::max<float>(bounding_box[1].z, v.position.z);
-	}
-}
-
-// UNIT.13
-void static_mesh::render(ID3D11DeviceContext* immediate_context, const XMFLOAT4X4& world, const XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader/*UNIT.16*/)
-{
-	uint32_t stride{ sizeof(vertex) };
-	uint32_t offset{ 0 };
-	immediate_context->IASetVertexBuffers(0, 1, vertex_buffer.GetAddressOf(), &stride, &offset);
-	immediate_context->IASetIndexBuffer(index_buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
-	immediate_context->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	immediate_context->IASetInputLayout(input_layout.Get());
-
-	immediate_context->VSSetShader(vertex_shader.Get(), nullptr, 0);
-	//immediate_context->PSSetShader(pixel_shader.Get(), nullptr, 0);
-	// UNIT.16
-	replaced_pixel_shader ? immediate_context->PSSetShader(replaced_pixel_shader, nullptr, 0) : immediate_context->PSSetShader(pixel_shader.Get(), nullptr, 0);
-
-#if 0
-	// UNIT.14
-	immediate_context->PSSetShaderResources(0, 1, shader_resource_view.GetAddressOf());
-
-	D3D11_BUFFER_DESC buffer_desc{};
-	index_buffer->GetDesc(&buffer_desc);
-	immediate_context->DrawIndexed(buffer_desc.ByteWidth / sizeof(uint32_t), 0, 0);
-#else
-	// UNIT.15
-	for (const material& material : materials)
-	{
-		immediate_context->PSSetShaderResources(0, 1, material.shader_resource_views[0].GetAddressOf());
-		// UNIT.16
-		immediate_context->PSSetShaderResources(1, 1, material.shader_resource_views[1].GetAddressOf());
-
-		constants data{ world, material_color };
-		XMStoreFloat4(&data.material_color, XMLoadFloat4(&material_color) * XMLoadFloat4(&material.Kd));
-		immediate_context->UpdateSubresource(constant_buffer.Get(), 0, 0, &data, 0, 0);
-		immediate_context->VSSetConstantBuffers(0, 1, constant_buffer.GetAddressOf());
-
-		for (const subset& subset : subsets)
-		{
-			if (material.name == subset.usemtl)
-			{
-				immediate_context->DrawIndexed(subset.index_count, subset.index_start, 0);
-			}
-		}
-	}
-#endif
-}
-
-// UNIT.13
-void static_mesh::create_com_buffers(ID3D11Device* device, vertex* vertices, size_t vertex_count, uint32_t* indices, size_t index_count)
-{
-	HRESULT hr = S_OK;
-
-	D3D11_BUFFER_DESC buffer_desc{};
-	D3D11_SUBRESOURCE_DATA subresource_data{};
-	buffer_desc.ByteWidth = static_cast<UINT>(sizeof(vertex) * vertex_count);
-	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-	buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
-	buffer_desc.CPUAccessFlags = 0;
-	buffer_desc.MiscFlags = 0;
-	buffer_desc.StructureByteStride = 0;
-	subresource_data.pSysMem = vertices;
-	subresource_data.SysMemPitch = 0;
-	subresource_data.SysMemSlicePitch = 0;
-	hr = device->CreateBuffer(&buffer_desc, &subresource_data, vertex_buffer.ReleaseAndGetAddressOf());
-	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
-
-	buffer_desc.ByteWidth = static_cast<UINT>(sizeof(uint32_t) * index_count);
-	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
-	buffer_desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
-	subresource_data.pSysMem = indices;
-	hr = device->CreateBuffer(&buffer_desc, &subresource_data, index_buffer.ReleaseAndGetAddressOf());
-	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
-}
+// UNIT.13
+#include "shader.h"
+#include "misc.h"
+#include "static_mesh.h"
+#include "d3d11_render_context.h"
+#include "instance_buffer.h"
+
+#include <fstream>
+#include <vector>
+#include <cstdio>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+
+// UNIT.14
+#include <filesystem>
+#include "texture.h"
+#include "obj_parser.h"
+#include "mapped_file.h"
+#include "profiler.h"
+
+// UNIT.13
+using namespace DirectX;
+static_mesh::static_mesh(ID3D11Device* device, const wchar_t* obj_filename, bool flipping_v_coordinates/*UNIT.14*/, bool retain_geometry)
+{
+	PROFILE_SCOPE("import static_mesh");
+	memory_load_scope load("static_mesh " + std::filesystem::path(obj_filename).string());
+	memory_scope mesh_data(MEMORY_TAG::MESH_DATA);
+	// A valid cache is read instead of the OBJ and MTL text.
+	std::filesystem::path cereal_filename(obj_filename);
+	cereal_filename += L".cereal";
+	if (!load_cache(cereal_filename.c_str(), obj_filename, flipping_v_coordinates, vertices, indices))
+	{
+		memory_load_scope fetch("fetch_obj");
+		std::wstring mtl_filename;
+		fetch_obj(obj_filename, flipping_v_coordinates, vertices, indices, mtl_filename);
+		save_cache(cereal_filename.c_str(), obj_filename, flipping_v_coordinates, mtl_filename, vertices, indices);
+	}
+	// Shown with the load record in the Memory panel.
+	char detail[64];
+	std::snprintf(detail, sizeof(detail), "%zu vertices, %zu indices, vertex reuse %.2f", vertices.size(), indices.size(), vertex_reuse_ratio);
+	load.describe(detail);
+
+	// UNIT.16
+	if (materials.size() == 0)
+	{
+		for (const subset& subset : subsets)
+		{
+			materials.push_back({ subset.usemtl });
+		}
+	}
+
+	build_draw_list(indices);
+
+	create_com_buffers(device, vertices.data(), vertices.size(), indices.data(), indices.size());
+	if (retain_geometry)
+	{
+		bvh.build(&vertices.data()->position, sizeof(vertex), vertices.size(), indices.data(), indices.size());
+	}
+	else
+	{
+		vertices.clear();
+		vertices.shrink_to_fit();
+		indices.clear();
+		indices.shrink_to_fit();
+	}
+
+	HRESULT hr{ S_OK };
+
+	D3D11_INPUT_ELEMENT_DESC input_element_desc[]
+	{
+		{ "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		{ "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+		// UNIT.14
+		{ "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0 },
+	};
+	create_vs_from_cso(device, "static_mesh_vs.cso", vertex_shader.GetAddressOf(), input_layout.GetAddressOf(), input_element_desc, ARRAYSIZE(input_element_desc));
+	std::vector<D3D11_INPUT_ELEMENT_DESC> instanced_input_element_desc{ append_draw_instance_elements(input_element_desc, ARRAYSIZE(input_element_desc)) };
+	create_vs_from_cso(device, "static_mesh_instanced_vs.cso", instanced_vertex_shader.GetAddressOf(), instanced_input_layout.GetAddressOf(), instanced_input_element_desc.data(), static_cast<UINT>(instanced_input_element_desc.size()));
+	create_ps_from_cso(device, "static_mesh_ps.cso", pixel_shader.GetAddressOf());
+
+	D3D11_BUFFER_DESC buffer_desc{};
+	buffer_desc.ByteWidth = sizeof(constants);
+	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+	buffer_desc.BindFlags = D3D11_BIND_CONSTANT_BUFFER;
+	hr = device->CreateBuffer(&buffer_desc, nullptr, constant_buffer.GetAddressOf());
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+	gpu_buffer_bytes += sizeof(constants);
+	default_memory_tracker().allocate(MEMORY_TAG::GPU_BUFFERS, gpu_buffer_bytes);
+
+	// UNIT.16
+	// The material textures are decoded in parallel and uploaded serially.
+	// Streamed slots are named by material index, as 'materials' may be reallocated after loading.
+	std::vector<texture_load_request> texture_load_requests;
+	for (size_t material_index = 0; material_index < materials.size(); ++material_index)
+	{
+		material& material{ materials.at(material_index) };
+		for (uint32_t texture_index = 0; texture_index < 2; ++texture_index)
+		{
+			if (material.texture_filenames[texture_index].size() > 0)
+			{
+				texture_load_requests.push_back({ material.texture_filenames[texture_index], material.shader_resource_views[texture_index].ReleaseAndGetAddressOf(), nullptr, texture_index == 1 ? texture_role::normal : texture_role::albedo, this, material_index, texture_index });
+			}
+		}
+	}
+	load_textures_from_files(device, texture_load_requests.data(), texture_load_requests.size(), [this](uint64_t material_index, uint32_t texture_index)
+	{
+		return materials.at(static_cast<size_t>(material_index)).shader_resource_views[texture_index].GetAddressOf();
+	});
+	for (material& material : materials)
+	{
+		if (material.texture_filenames[0].size() == 0)
+		{
+			make_dummy_texture(device, material.shader_resource_views[0].GetAddressOf(), 0xFFFFFFFF, 16);
+		}
+		if (material.texture_filenames[1].size() == 0)
+		{
+			make_dummy_texture(device, material.shader_resource_views[1].GetAddressOf(), 0xFFFF7F7F, 16);
+		}
+	}
+}
+
+void static_mesh::fetch_obj(const wchar_t* obj_filename, bool flipping_v_coordinates, std::vector<vertex>& vertices, std::vector<uint32_t>& indices, std::wstring& mtl_filename)
+{
+	PROFILE_SCOPE("fetch obj");
+	// The OBJ text is parsed in parallel from a memory mapped file, see obj_parser.h.
+	obj_mesh mesh;
+	const bool parsed{ parse_obj(obj_filename, flipping_v_coordinates, mesh) };
+	_ASSERT_EXPR(parsed, L"'OBJ file not found.");
+
+	static_assert(sizeof(vertex) == sizeof(obj_mesh::vertex), "static_mesh::vertex and obj_mesh::vertex must share a layout.");
+	vertices.resize(mesh.vertices.size());
+	std::memcpy(vertices.data(), mesh.vertices.data(), sizeof(vertex) * vertices.size());
+	indices = std::move(mesh.indices);
+	// UNIT.15
+	for (const obj_mesh::subset& subset : mesh.subsets)
+	{
+		subsets.push_back({ subset.usemtl, subset.index_start, subset.index_count });
+	}
+	std::vector<std::wstring> mtl_filenames{ std::move(mesh.mtl_filenames) };
+	vertex_reuse_ratio = mesh.vertex_reuse_ratio();
+
+	// UNIT.16
+	for (const vertex& v : vertices)
+	{
+		bounding_box[0].x = std::min<float>(bounding_box[0].x, v.position.x);
+		bounding_box[0].y = std::min<float>(bounding_box[0].y, v.position.y);
+		bounding_box[0].z = std::min<float>(bounding_box[0].z, v.position.z);
+		bounding_box[1].x = std::max<float>(bounding_box[1].x, v.position.x);
+		bounding_box[1].y = std::max<float>(bounding_box[1].y, v.position.y);
+		bounding_box[1].z = std::max<float>(bounding_box[1].z, v.position.z);
+	}
+
+	// UNIT.14
+	if (mtl_filenames.size() == 0)
+	{
+		return;
+	}
+	std::filesystem::path mtl_path(obj_filename);
+	mtl_path.replace_filename(std::filesystem::path(mtl_filenames[0]).filename());
+	mtl_filename = mtl_path.wstring();
+
+	std::wifstream fin(mtl_path);
+	wchar_t command[256];
+	// UNIT.16
+	//_ASSERT_EXPR(fin, L"'MTL file not found.");
+
+	while (fin)
+	{
+		fin >> command;
+		if (0 == wcscmp(command, L"map_Kd"))
+		{
+			// map_Kd - options args filename
+			//
+			// Specifies that a color texture file or color procedural texture file is
+			// linked to the diffuse reflectivity of the material.During rendering,
+			// the map_Kd value is multiplied by the Kd value.
+			//
+			// "filename" is the name of a color texture file(.mpc), a color
+			// procedural texture file(.cxc), or an image file.
+			fin.ignore();
+			wchar_t map_Kd[256];
+			fin >> map_Kd;
+
+			std::filesystem::path path(obj_filename);
+			path.replace_filename(std::filesystem::path(map_Kd).filename());
+			// UNIT.15
+			//texture_filename = path;
+			//materials.rbegin()->texture_filename = path;
+			// UNIT.16
+			materials.rbegin()->texture_filenames[0] = path;
+			fin.ignore(1024, L'\n');
+		}
+		// UNIT.16
+		else if (0 == wcscmp(command, L"map_bump") || 0 == wcscmp(command, L"bump"))
+		{
+			// map_bump - options args filename
+			//
+			// Specifies that a bump texture file or a bump procedural texture file is
+			// linked to the material.
+			//
+			// "filename" is the name of a bump texture file(.mpb), a bump procedural
+			// texture file(.cxb), or an image file.
+			fin.ignore();
+			wchar_t map_bump[256];
+			fin >> map_bump;
+			
+			std::filesystem::path path(obj_filename);
+			path.replace_filename(std::filesystem::path(map_bump).filename());
+			materials.rbegin()->texture_filenames[1] = path;
+			fin.ignore(1024, L'\n');
+		}
+		// UNIT.15
+		else if (0 == wcscmp(command, L"newmtl"))
+		{
+			// The folowing syntax describes the material name statement.
+			//
+			//	newmtl name
+			//
+			// Specifies the start of a material description and assigns a name to the
+			// material.An.mtl file must have one newmtl statement at the start of
+			// each material description.
+			// "name" is the name of the material.Names may be any length but
+			// cannot include blanks.Underscores may be used in material names.material material;
+			fin.ignore();
+			wchar_t newmtl[256];
+			material material;
+			fin >> newmtl;
+			material.name = newmtl;
+			materials.push_back(material);
+		}
+		// UNIT.15
+		else if (0 == wcscmp(command, L"Ka"))
+		{
+			// Ka r g b
+			//
+			// The Ka statement specifies the ambient reflectivity using RGB values.
+			// "r g b" are the values for the red, green, and blue components of the
+			// color.The g and b arguments are optional.If only r is specified,
+			// then g, and b are assumed to be equal to r.The r g b values are
+			// normally in the range of 0.0 to 1.0.Values outside this range increase
+			// or decrease the relectivity accordingly.
+			float r, g, b;
+			fin >> r >> g >> b;
+			materials.rbegin()->Ka = { r, g, b, 1 };
+			fin.ignore(1024, L'\n');
+		}
+		// UNIT.15
+		else if (0 == wcscmp(command, L"Kd"))
+		{
+			// Kd r g b
+			//
+			// The Kd statement specifies the diffuse reflectivity using RGB values.
+			// "r g b" are the values for the red, green, and blue components of the
+			// atmosphere.The g and b arguments are optional.If only r is
+			// specified, then g, and b are assumed to be equal to r.The r g b values
+			// are normally in the range of 0.0 to 1.0.Values outside this range
+			// increase or decrease the relectivity accordingly.
+			float r, g, b;
+			fin >> r >> g >> b;
+			materials.rbegin()->Kd = { r, g, b, 1 };
+			fin.ignore(1024, L'\n');
+		}
+		// UNIT.15
+		else if (0 == wcscmp(command, L"Ks"))
+		{
+			// Ks r g b
+			//
+			// The Ks statement specifies the specular reflectivity using RGB values.
+			// "r g b" are the values for the red, green, and blue components of the
+			// atmosphere.The g and b arguments are optional.If only r is
+			// specified, then g, and b are assumed to be equal to r.The r g b values
+			// are normally in the range of 0.0 to 1.0.Values outside this range
+			// increase or decrease the relectivity accordingly.
+			float r, g, b;
+			fin >> r >> g >> b;
+			materials.rbegin()->Ks = { r, g, b, 1 };
+			fin.ignore(1024, L'\n');
+		}
+		else
+		{
+			fin.ignore(1024, L'\n');
+		}
+	}
+	fin.close();
+}
+
+bool static_mesh::load_cache(const wchar_t* cache_filename, const wchar_t* obj_filename, bool flipping_v_coordinates, std::vector<vertex>& vertices, std::vector<uint32_t>& indices)
+{
+	if (!std::filesystem::exists(cache_filename))
+	{
+		return false;
+	}
+	std::ifstream ifs(std::filesystem::path(cache_filename), std::ios::binary);
+	try
+	{
+		cereal::BinaryInputArchive deserialization(ifs);
+		cache_header header;
+		deserialization(header);
+		if (header.version != cache_version || header.flipping_v_coordinates != flipping_v_coordinates ||
+			header.obj_hash != hash_file(obj_filename) || (header.mtl_filename.size() > 0 && header.mtl_hash != hash_file(header.mtl_filename.c_str())))
+		{
+			return false;
+		}
+
+		uint64_t vertex_count{ 0 }, index_count{ 0 };
+		deserialization(subsets, materials, bounding_box[0], bounding_box[1], vertex_reuse_ratio, vertex_count, index_count);
+		// Counts read from a damaged file must not size the arrays: both have to fit in what is left of it.
+		const uint64_t remaining_bytes{ std::filesystem::file_size(cache_filename) - static_cast<uint64_t>(ifs.tellg()) };
+		if (vertex_count > remaining_bytes / sizeof(vertex) || index_count > (remaining_bytes - vertex_count * sizeof(vertex)) / sizeof(uint32_t))
+		{
+			throw cereal::Exception("The vertex and index counts exceed the cache file.");
+		}
+		// The vertex and index arrays are the bulk of the file and are read as they are.
+		vertices.resize(static_cast<size_t>(vertex_count));
+		indices.resize(static_cast<size_t>(index_count));
+		deserialization(cereal::binary_data(vertices.data(), sizeof(vertex) * vertices.size()), cereal::binary_data(indices.data(), sizeof(uint32_t) * indices.size()));
+	}
+	catch (const std::exception&)
+	{
+		// A truncated, damaged or foreign file is rebuilt like a stale one. Damaged lengths of the subset and material
+		// lists may also end in std::bad_alloc or std::length_error.
+		subsets.clear();
+		materials.clear();
+		vertices.clear();
+		indices.clear();
+		return false;
+	}
+	return true;
+}
+
+void static_mesh::save_cache(const wchar_t* cache_filename, const wchar_t* obj_filename, bool flipping_v_coordinates, const std::wstring& mtl_filename, const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices)
+{
+	cache_header header;
+	header.version = cache_version;
+	header.flipping_v_coordinates = flipping_v_coordinates;
+	header.obj_hash = hash_file(obj_filename);
+	header.mtl_filename = mtl_filename;
+	header.mtl_hash = mtl_filename.size() > 0 ? hash_file(mtl_filename.c_str()) : 0;
+
+	std::ofstream ofs(std::filesystem::path(cache_filename), std::ios::binary);
+	cereal::BinaryOutputArchive serialization(ofs);
+	const uint64_t vertex_count{ vertices.size() }, index_count{ indices.size() };
+	serialization(header, subsets, materials, bounding_box[0], bounding_box[1], vertex_reuse_ratio, vertex_count, index_count);
+	serialization(cereal::binary_data(vertices.data(), sizeof(vertex) * vertices.size()), cereal::binary_data(indices.data(), sizeof(uint32_t) * indices.size()));
+}
+
+static_mesh::~static_mesh()
+{
+	// The texture streamer must stop writing to our material slots.
+	release_texture_slots(this);
+	default_memory_tracker().release(MEMORY_TAG::GPU_BUFFERS, gpu_buffer_bytes);
+}
+
+memory_breakdown static_mesh::memory_usage() const
+{
+	memory_breakdown usage;
+	usage[MEMORY_TAG::MESH_DATA] += sizeof(vertex) * vertices.capacity() + sizeof(uint32_t) * indices.capacity()
+		+ sizeof(subset) * subsets.capacity() + sizeof(draw_range) * draw_ranges.capacity();
+	usage[MEMORY_TAG::SCENE] += sizeof(material) * materials.capacity();
+	usage[MEMORY_TAG::GPU_BUFFERS] += gpu_buffer_bytes;
+	return usage;
+}
+
+// UNIT.13
+bool static_mesh::raycast(const XMFLOAT4X4& world, const XMFLOAT3& origin, const XMFLOAT3& direction, float max_distance, triangle_bvh::hit& hit) const
+{
+	hit = {};
+	if (bvh.node_count() == 0)
+	{
+		return false;
+	}
+	const XMMATRIX inverse_world{ XMMatrixInverse(nullptr, XMLoadFloat4x4(&world)) };
+	triangle_bvh::ray ray;
+	XMStoreFloat3(&ray.origin, XMVector3TransformCoord(XMLoadFloat3(&origin), inverse_world));
+	XMStoreFloat3(&ray.direction, XMVector3TransformNormal(XMLoadFloat3(&direction), inverse_world));
+	ray.max_distance = max_distance;
+	return bvh.intersect(ray, hit);
+}
+
+void static_mesh::render(ID3D11DeviceContext* immediate_context, const XMFLOAT4X4& world, const XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader/*UNIT.16*/)
+{
+	d3d11_render_context context{ immediate_context };
+	bind_mesh(context);
+	bind_pipeline(context, replaced_pixel_shader);
+	statistics = {};
+
+#if 0
+	// UNIT.14
+	immediate_context->PSSetShaderResources(0, 1, shader_resource_view.GetAddressOf());
+
+	D3D11_BUFFER_DESC buffer_desc{};
+	index_buffer->GetDesc(&buffer_desc);
+	immediate_context->DrawIndexed(buffer_desc.ByteWidth / sizeof(uint32_t), 0, 0);
+#else
+	// UNIT.15
+	// The draw list was resolved at load: one material bind, one constant update and one draw per material.
+	for (const draw_range& draw_range : draw_ranges)
+	{
+		bind_material(context, draw_range.material_index);
+		XMFLOAT4 color;
+		XMStoreFloat4(&color, XMLoadFloat4(&material_color) * XMLoadFloat4(&materials.at(draw_range.material_index).Kd));
+		draw(context, draw_range, world, color);
+		++statistics.draw_calls;
+	}
+#endif
+	// The bind calls the context actually forwarded to the device.
+	statistics.state_changes = static_cast<uint32_t>(context.state_calls);
+}
+
+void static_mesh::bind_pipeline(render_context& context, ID3D11PixelShader* replaced_pixel_shader) const
+{
+	context.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context.IASetInputLayout(input_layout.Get());
+
+	context.VSSetShader(vertex_shader.Get());
+	//immediate_context->PSSetShader(pixel_shader.Get(), nullptr, 0);
+	// UNIT.16
+	context.PSSetShader(replaced_pixel_shader ? replaced_pixel_shader : pixel_shader.Get());
+	context.VSSetConstantBuffers(0, 1, constant_buffer.GetAddressOf());
+}
+
+void static_mesh::bind_mesh(render_context& context) const
+{
+	uint32_t stride{ sizeof(vertex) };
+	uint32_t offset{ 0 };
+	context.IASetVertexBuffers(0, 1, vertex_buffer.GetAddressOf(), &stride, &offset);
+	context.IASetIndexBuffer(index_buffer.Get(), DXGI_FORMAT_R32_UINT, 0);
+}
+
+void static_mesh::bind_material(render_context& context, uint32_t material_index) const
+{
+	const material& material{ materials.at(material_index) };
+	// UNIT.16
+	ID3D11ShaderResourceView* shader_resource_views[2]{ material.shader_resource_views[0].Get(), material.shader_resource_views[1].Get() };
+	context.PSSetShaderResources(0, 2, shader_resource_views);
+}
+
+void static_mesh::draw(render_context& context, const draw_range& draw_range, const XMFLOAT4X4& world, const XMFLOAT4& material_color) const
+{
+	constants data{ world, material_color };
+	context.UpdateSubresource(constant_buffer.Get(), 0, 0, &data, 0, 0);
+	context.DrawIndexed(draw_range.index_count, draw_range.index_start, 0);
+}
+
+void static_mesh::bind_instanced_pipeline(render_context& context, ID3D11PixelShader* replaced_pixel_shader) const
+{
+	context.IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+	context.IASetInputLayout(instanced_input_layout.Get());
+
+	context.VSSetShader(instanced_vertex_shader.Get());
+	context.PSSetShader(replaced_pixel_shader ? replaced_pixel_shader : pixel_shader.Get());
+}
+
+void static_mesh::draw_instanced(render_context& context, const draw_range& draw_range, uint32_t instance_count, uint32_t start_instance) const
+{
+	context.DrawIndexedInstanced(draw_range.index_count, instance_count, draw_range.index_start, 0, start_instance);
+}
+
+void static_mesh::build_draw_list(std::vector<uint32_t>& indices)
+{
+	// Names are compared once here instead of every frame. The first material with a name wins.
+	std::unordered_map<std::wstring, uint32_t> material_indices;
+	for (size_t material_index = 0; material_index < materials.size(); ++material_index)
+	{
+		material_indices.insert(std::make_pair(materials.at(material_index).name, static_cast<uint32_t>(material_index)));
+	}
+	for (subset& subset : subsets)
+	{
+		std::unordered_map<std::wstring, uint32_t>::const_iterator it{ material_indices.find(subset.usemtl) };
+		subset.material_index = it == material_indices.end() ? -1 : it->second;
+	}
+
+	// Subsets without a material were never drawn; they go to the end of the index buffer.
+	std::vector<size_t> order(subsets.size());
+	for (size_t subset_index = 0; subset_index < order.size(); ++subset_index)
+	{
+		order.at(subset_index) = subset_index;
+	}
+	std::stable_sort(order.begin(), order.end(), [this](size_t a, size_t b)
+	{
+		return static_cast<uint64_t>(subsets.at(a).material_index) < static_cast<uint64_t>(subsets.at(b).material_index);
+	});
+
+	std::vector<uint32_t> sorted_indices;
+	sorted_indices.reserve(indices.size());
+	draw_ranges.clear();
+	for (size_t subset_index : order)
+	{
+		subset& subset{ subsets.at(subset_index) };
+		const uint32_t index_start{ static_cast<uint32_t>(sorted_indices.size()) };
+		sorted_indices.insert(sorted_indices.end(), indices.begin() + subset.index_start, indices.begin() + subset.index_start + subset.index_count);
+		subset.index_start = index_start;
+
+		if (subset.material_index < 0 || subset.index_count == 0)
+		{
+			continue;
+		}
+		if (draw_ranges.size() > 0 && draw_ranges.back().material_index == subset.material_index)
+		{
+			draw_ranges.back().index_count += subset.index_count;
+		}
+		else
+		{
+			draw_ranges.push_back({ static_cast<uint32_t>(subset.material_index), index_start, subset.index_count });
+		}
+	}
+	indices = std::move(sorted_indices);
+}
+
+// UNIT.13
+void static_mesh::create_com_buffers(ID3D11Device* device, vertex* vertices, size_t vertex_count, uint32_t* indices, size_t index_count)
+{
+	HRESULT hr = S_OK;
+
+	D3D11_BUFFER_DESC buffer_desc{};
+	D3D11_SUBRESOURCE_DATA subresource_data{};
+	buffer_desc.ByteWidth = static_cast<UINT>(sizeof(vertex) * vertex_count);
+	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+	buffer_desc.BindFlags = D3D11_BIND_VERTEX_BUFFER;
+	buffer_desc.CPUAccessFlags = 0;
+	buffer_desc.MiscFlags = 0;
+	buffer_desc.StructureByteStride = 0;
+	subresource_data.pSysMem = vertices;
+	subresource_data.SysMemPitch = 0;
+	subresource_data.SysMemSlicePitch = 0;
+	hr = device->CreateBuffer(&buffer_desc, &subresource_data, vertex_buffer.ReleaseAndGetAddressOf());
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+
+	buffer_desc.ByteWidth = static_cast<UINT>(sizeof(uint32_t) * index_count);
+	buffer_desc.Usage = D3D11_USAGE_DEFAULT;
+	buffer_desc.BindFlags = D3D11_BIND_INDEX_BUFFER;
+	subresource_data.pSysMem = indices;
+	hr = device->CreateBuffer(&buffer_desc, &subresource_data, index_buffer.ReleaseAndGetAddressOf());
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+	gpu_buffer_bytes += sizeof(vertex) * vertex_count + sizeof(uint32_t) * index_count;
+}
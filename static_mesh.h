@@ -1,76 +1,177 @@
-#pragma once
-
-// UNIT.13
-#include <d3d11.h>
-#include <wrl.h>
-#include <directxmath.h>
-
-//UNIT.14
-#include <string>
-
-// UNIT.15
-#include <vector>
-
-// UNIT.13
-class static_mesh
-{
-public:
-	struct vertex
-	{
-		DirectX::XMFLOAT3 position;
-		DirectX::XMFLOAT3 normal;
-		// UNIT.14
-		DirectX::XMFLOAT2 texcoord;
-	};
-	struct constants
-	{
-		DirectX::XMFLOAT4X4 world;
-		DirectX::XMFLOAT4 material_color;
-	};
-
-	// UNIT.15
-	struct subset
-	{
-		std::wstring usemtl;
-		uint32_t index_start{ 0 }; 	// start position of index buffer
-		uint32_t index_count{ 0 }; 	// number of vertices (indices)
-	};
-	std::vector<subset> subsets;
-
-	//UNIT.14
-	//wstring texture_filename;
-	//ComPtr<ID3D11ShaderResourceView> shader_resource_view;
-	// UNIT.15
-	struct material
-	{
-		std::wstring name;
-		DirectX::XMFLOAT4 Ka{ 0.2f, 0.2f, 0.2f, 1.0f };
-		DirectX::XMFLOAT4 Kd{ 0.8f, 0.8f, 0.8f, 1.0f };
-		DirectX::XMFLOAT4 Ks{ 1.0f, 1.0f, 1.0f, 1.0f };
-		// UNIT.16
-		std::wstring texture_filenames[2];
-		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_views[2];
-	};
-	std::vector<material> materials;
-
-	// UNIT.16
-	DirectX::XMFLOAT3 bounding_box[2]{ { D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX }, { -D3D11_FLOAT32_MAX, -D3D11_FLOAT32_MAX, -D3D11_FLOAT32_MAX } };
-
-private:
-	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> index_buffer;
-
-	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
-	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
-	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
-	Microsoft::WRL::ComPtr<ID3D11Buffer> constant_buffer;
-
-public:
-	static_mesh(ID3D11Device* device, const wchar_t* obj_filename, bool flipping_v_coordinates/*UNIT.14*/);
-	virtual ~static_mesh() = default;
-
-	void render(ID3D11DeviceContext* immediate_context, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader = nullptr/*UNIT.16*/);
-
-protected:
-	void create_com_buffers(ID3D11Device* device, vertex* vertices, size_t vertex_count, uint32_t* indices, size_t index_count);
-};
+#pragma once
+
+// UNIT.13
+#include <d3d11.h>
+#include <wrl.h>
+#include <directxmath.h>
+
+//UNIT.14
+#include <string>
+
+// UNIT.15
+#include <vector>
+
+#include <cereal/archives/binary.hpp>
+#include <cereal/types/string.hpp>
+#include <cereal/types/vector.hpp>
+#include "cereal_directxmath.h"
+
+#include "triangle_bvh.h"
+#include "render_context.h"
+#include "memory_tracker.h"
+
+// UNIT.13
+class static_mesh
+{
+public:
+	struct vertex
+	{
+		DirectX::XMFLOAT3 position;
+		DirectX::XMFLOAT3 normal;
+		// UNIT.14
+		DirectX::XMFLOAT2 texcoord;
+	};
+	struct constants
+	{
+		DirectX::XMFLOAT4X4 world;
+		DirectX::XMFLOAT4 material_color;
+	};
+
+	// UNIT.15
+	struct subset
+	{
+		std::wstring usemtl;
+		uint32_t index_start{ 0 }; 	// start position of index buffer
+		uint32_t index_count{ 0 }; 	// number of vertices (indices)
+		// Index into 'materials' resolved from 'usemtl' when the draw list is built. -1 if there is no such material.
+		int64_t material_index{ -1 };
+
+		template<class T>
+		void serialize(T& archive)
+		{
+			archive(usemtl, index_start, index_count);
+		}
+	};
+	std::vector<subset> subsets;
+
+	//UNIT.14
+	//wstring texture_filename;
+	//ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+	// UNIT.15
+	struct material
+	{
+		std::wstring name;
+		DirectX::XMFLOAT4 Ka{ 0.2f, 0.2f, 0.2f, 1.0f };
+		DirectX::XMFLOAT4 Kd{ 0.8f, 0.8f, 0.8f, 1.0f };
+		DirectX::XMFLOAT4 Ks{ 1.0f, 1.0f, 1.0f, 1.0f };
+		// UNIT.16
+		std::wstring texture_filenames[2];
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_views[2];
+
+		template<class T>
+		void serialize(T& archive)
+		{
+			archive(name, Ka, Kd, Ks, texture_filenames[0], texture_filenames[1]);
+		}
+	};
+	std::vector<material> materials;
+
+	// UNIT.16
+	DirectX::XMFLOAT3 bounding_box[2]{ { D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX, D3D11_FLOAT32_MAX }, { -D3D11_FLOAT32_MAX, -D3D11_FLOAT32_MAX, -D3D11_FLOAT32_MAX } };
+
+	// Face corners per vertex after corners with identical references were merged by the OBJ parser.
+	float vertex_reuse_ratio{ 1.0f };
+
+	// A CPU copy of what was uploaded, kept only when the mesh is constructed with 'retain_geometry' (static batching, raycasts).
+	// The indices are in draw list order, 'subsets' refer to them.
+	std::vector<vertex> vertices;
+	std::vector<uint32_t> indices;
+	// Built over 'vertices' and 'indices' when they are retained. Hit triangles index 'indices' in draw list order.
+	triangle_bvh bvh;
+
+	// One entry per material. The index buffer is reordered at load so that all subsets of a material are contiguous.
+	struct draw_range
+	{
+		uint32_t material_index{ 0 };
+		uint32_t index_start{ 0 };
+		uint32_t index_count{ 0 };
+	};
+	const std::vector<draw_range>& draws() const { return draw_ranges; }
+
+	// What the last render call issued. State changes are the bind calls forwarded to the device; constant buffer
+	// updates and draws are not counted.
+	struct render_statistics
+	{
+		uint32_t draw_calls{ 0 };
+		uint32_t state_changes{ 0 };
+	};
+	render_statistics statistics;
+
+private:
+	Microsoft::WRL::ComPtr<ID3D11Buffer> vertex_buffer;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> index_buffer;
+
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> vertex_shader;
+	Microsoft::WRL::ComPtr<ID3D11PixelShader> pixel_shader;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> input_layout;
+	Microsoft::WRL::ComPtr<ID3D11Buffer> constant_buffer;
+	// Per-instance world and color from vertex buffer slot 1.
+	Microsoft::WRL::ComPtr<ID3D11VertexShader> instanced_vertex_shader;
+	Microsoft::WRL::ComPtr<ID3D11InputLayout> instanced_input_layout;
+
+	std::vector<draw_range> draw_ranges;
+	// Bytes of the vertex, index and constant buffers, counted as MEMORY_TAG::GPU_BUFFERS while the mesh lives.
+	size_t gpu_buffer_bytes{ 0 };
+
+public:
+	static_mesh(ID3D11Device* device, const wchar_t* obj_filename, bool flipping_v_coordinates/*UNIT.14*/, bool retain_geometry = false);
+	virtual ~static_mesh();
+	// What this mesh holds by tag: its retained geometry, subsets and materials, and the device buffers it created.
+	// Textures are shared through the texture cache and reported there (see texture_cache_usage).
+	memory_breakdown memory_usage() const;
+
+	void render(ID3D11DeviceContext* immediate_context, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color, ID3D11PixelShader* replaced_pixel_shader = nullptr/*UNIT.16*/);
+	// 'render' in pieces, for submission through render_queue (draw_list). 'draw' uploads the constants of one entry of
+	// 'draws()' and draws it; its material must be bound and 'material_color' already multiplied by the material's Kd,
+	// as draw_list records it for the instanced path too.
+	void bind_pipeline(render_context& context, ID3D11PixelShader* replaced_pixel_shader = nullptr) const;
+	void bind_mesh(render_context& context) const;
+	void bind_material(render_context& context, uint32_t material_index) const;
+	void draw(render_context& context, const draw_range& draw_range, const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& material_color) const;
+	// Instanced 'draw': 'instance_count' draw_instances from 'start_instance' in the buffer bound to vertex buffer slot 1.
+	void bind_instanced_pipeline(render_context& context, ID3D11PixelShader* replaced_pixel_shader = nullptr) const;
+	void draw_instanced(render_context& context, const draw_range& draw_range, uint32_t instance_count, uint32_t start_instance) const;
+
+	// Nearest triangle hit by a world space ray, for a mesh constructed with 'retain_geometry'. The ray is moved into
+	// model space without normalizing its direction, so 'hit.distance' is in the same units as the world space ray.
+	bool raycast(const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT3& origin, const DirectX::XMFLOAT3& direction, float max_distance, triangle_bvh::hit& hit) const;
+
+protected:
+	// Parses the OBJ file and its MTL file.
+	void fetch_obj(const wchar_t* obj_filename, bool flipping_v_coordinates, std::vector<vertex>& vertices, std::vector<uint32_t>& indices, std::wstring& mtl_filename);
+
+	// The parsed mesh is kept in '<obj_filename>.cereal'. The cache is rebuilt when its version, the OBJ or MTL contents,
+	// or 'flipping_v_coordinates' differ from those it was written with.
+	static constexpr uint32_t cache_version{ 1 };
+	struct cache_header
+	{
+		uint32_t version{ 0 };
+		bool flipping_v_coordinates{ false };
+		uint64_t obj_hash{ 0 };
+		std::wstring mtl_filename;
+		uint64_t mtl_hash{ 0 };
+
+		template<class T>
+		void serialize(T& archive)
+		{
+			archive(version, flipping_v_coordinates, obj_hash, mtl_filename, mtl_hash);
+		}
+	};
+	bool load_cache(const wchar_t* cache_filename, const wchar_t* obj_filename, bool flipping_v_coordinates, std::vector<vertex>& vertices, std::vector<uint32_t>& indices);
+	void save_cache(const wchar_t* cache_filename, const wchar_t* obj_filename, bool flipping_v_coordinates, const std::wstring& mtl_filename, const std::vector<vertex>& vertices, const std::vector<uint32_t>& indices);
+
+	// Resolves every subset to its material and sorts the index ranges by material into 'draw_ranges'.
+	void build_draw_list(std::vector<uint32_t>& indices);
+
+	void create_com_buffers(ID3D11Device* device, vertex* vertices, size_t vertex_count, uint32_t* indices, size_t index_count);
+};
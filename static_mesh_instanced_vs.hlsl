@@ -0,0 +1,24 @@
+#include "static_mesh.hlsli"
+
+// draw_instance (instance_buffer.h), from vertex buffer slot 1. Replaces 'world' and 'material_color' of
+// OBJECT_CONSTANT_BUFFER; the bone palette offset is not used.
+struct INSTANCE_IN
+{
+	row_major float4x4 world : INSTANCE_WORLD;
+	float4 color : INSTANCE_COLOR;
+};
+
+VS_OUT main(float4 position : POSITION, float4 normal : NORMAL, float2 texcoord : TEXCOORD, INSTANCE_IN instance)
+{
+	VS_OUT vout;
+	vout.position = mul(position, mul(instance.world, view_projection));
+
+	vout.world_position = mul(position, instance.world);
+	normal.w = 0;
+	vout.world_normal = normalize(mul(normal, instance.world));
+
+	vout.color = instance.color;
+	vout.texcoord = texcoord;
+
+	return vout;
+}
@@ -1,50 +1,52 @@
-#include "static_mesh.hlsli"
-
-// UNIT.14
-Texture2D color_map : register(t0);
-// UNIT.16
-Texture2D normal_map : register(t1);
-
-SamplerState point_sampler_state : register(s0);
-SamplerState linear_sampler_state : register(s1);
-SamplerState anisotropic_sampler_state : register(s2);
-
-// UNIT.16
-#if 0
-float4 main(VS_OUT pin) : SV_TARGET
-{
-	float4 color = color_map.Sample(anisotropic_sampler_state, pin.texcoord);
-	float alpha = color.a;
-	float3 N = normalize(pin.world_normal.xyz);
-
-	float3 L = normalize(-light_direction.xyz);
-	float3 diffuse = color.rgb * max(0, dot(N, L));
-
-	float3 V = normalize(camera_position.xyz - pin.world_position.xyz);
-	float3 specular = pow(max(0, dot(N, normalize(V + L))), 128);
-
-	return float4(diffuse + specular, alpha) * material_color;
-}
-#else
-float4 main(VS_OUT pin) : SV_TARGET
-{
-	float4 color = color_map.Sample(anisotropic_sampler_state, pin.texcoord);
-	float alpha = color.a;
-	float3 N = normalize(pin.world_normal.xyz);
-#if 1
-	float3 T = float3(1.0001, 0, 0);
-	float3 B = normalize(cross(N, T));
-	T = normalize(cross(B, N));
-	float4 normal = normal_map.Sample(linear_sampler_state, pin.texcoord);
-	normal = (normal * 2.0) - 1.0;
-	normal.w = 0;
-	N = normalize((normal.x * T) + (normal.y * B) + (normal.z * N));
-#endif
-	float3 L = normalize(-light_direction.xyz);
-	float3 diffuse = color.rgb * max(0, dot(N, L));
-	float3 V = normalize(camera_position.xyz - pin.world_position.xyz);
-	float3 specular = pow(max(0, dot(N, normalize(V + L))), 128);
-	return float4(diffuse + specular, alpha) * pin.color;
-}
-#endif
-
+#include "static_mesh.hlsli"
+
+// UNIT.14
+Texture2D color_map : register(t0);
+// UNIT.16
+Texture2D normal_map : register(t1);
+
+SamplerState point_sampler_state : register(s0);
+SamplerState linear_sampler_state : register(s1);
+SamplerState anisotropic_sampler_state : register(s2);
+
+// UNIT.16
+#if 0
+float4 main(VS_OUT pin) : SV_TARGET
+{
+	float4 color = color_map.Sample(anisotropic_sampler_state, pin.texcoord);
+	float alpha = color.a;
+	float3 N = normalize(pin.world_normal.xyz);
+
+	float3 L = normalize(-light_direction.xyz);
+	float3 diffuse = color.rgb * max(0, dot(N, L));
+
+	float3 V = normalize(camera_position.xyz - pin.world_position.xyz);
+	float3 specular = pow(max(0, dot(N, normalize(V + L))), 128);
+
+	return float4(diffuse + specular, alpha) * material_color;
+}
+#else
+float4 main(VS_OUT pin) : SV_TARGET
+{
+	float4 color = color_map.Sample(anisotropic_sampler_state, pin.texcoord);
+	float alpha = color.a;
+	float3 N = normalize(pin.world_normal.xyz);
+#if 1
+	float3 T = float3(1.0001, 0, 0);
+	float3 B = normalize(cross(N, T));
+	T = normalize(cross(B, N));
+	float4 normal = normal_map.Sample(linear_sampler_state, pin.texcoord);
+	normal = (normal * 2.0) - 1.0;
+	normal.w = 0;
+	// Cooked normal maps are BC5 and only keep x and y.
+	normal.z = sqrt(saturate(1.0 - dot(normal.xy, normal.xy)));
+	N = normalize((normal.x * T) + (normal.y * B) + (normal.z * N));
+#endif
+	float3 L = normalize(-light_direction.xyz);
+	float3 diffuse = color.rgb * max(0, dot(N, L));
+	float3 V = normalize(camera_position.xyz - pin.world_position.xyz);
+	float3 specular = pow(max(0, dot(N, normalize(V + L))), 128);
+	return float4(diffuse + specular, alpha) * pin.color;
+}
+#endif
+
@@ -1,153 +1,340 @@
-// UNIT.10
-#include "texture.h"
-#include "misc.h"
-
-#include <WICTextureLoader.h>
-using namespace DirectX;
-
-#include <wrl.h>
-using namespace Microsoft::WRL;
-
-#include <string>
-#include <map>
-using namespace std;
-
-// UNIT.16
-#include <sstream>
-#include <iomanip>
-
-// UNIT,31
-#include <filesystem>
-#include <DDSTextureLoader.h>
-
-static map<wstring, ComPtr<ID3D11ShaderResourceView>> resources;
-
-// vg^Cv錾imake_dummy_textureɌĂяo悤ɂj
-HRESULT make_dummy_texture(ID3D11Device* device, ID3D11ShaderResourceView** shader_resource_view, DWORD value, UINT dimension);
-
-HRESULT load_texture_from_file(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** shader_resource_view, D3D11_TEXTURE2D_DESC* texture2d_desc)
-{
-	HRESULT hr{ S_OK };
-	ComPtr<ID3D11Resource> resource;
-
-	auto it = resources.find(filename);
-	if (it != resources.end())
-	{
-		*shader_resource_view = it->second.Get();
-		(*shader_resource_view)->AddRef();
-	}
-	else
-	{
-		// UNIT.31
-		std::filesystem::path dds_filename(filename);
-		dds_filename.replace_extension("dds");
-		if (std::filesystem::exists(dds_filename.c_str()))
-		{
-			hr = CreateDDSTextureFromFile(device, dds_filename.c_str(), resource.GetAddressOf(), shader_resource_view);
-		}
-		else
-		{
-			hr = CreateWICTextureFromFile(device, filename, resource.GetAddressOf(), shader_resource_view);
-		}
-
-		// ydvzǂݍݎs͋IɃ_~[eNX`iFj쐬
-		// ɂG[~h܂
-		if (FAILED(hr))
-		{
-			make_dummy_texture(device, shader_resource_view, 0xFF0000FF, 16);
-		}
-
-		// i܂̓_~[쐬jĂΓo^
-		if (*shader_resource_view)
-		{
-			resources.insert(make_pair(filename, *shader_resource_view));
-		}
-	}
-
-	// \[X擾i_~[̏ꍇ܂߂ĈSɍsj
-	if (*shader_resource_view)
-	{
-		// SRV烊\[Xo
-		(*shader_resource_view)->GetResource(resource.ReleaseAndGetAddressOf());
-
-		if (resource)
-		{
-			ComPtr<ID3D11Texture2D> texture2d;
-			if (SUCCEEDED(resource.Get()->QueryInterface<ID3D11Texture2D>(texture2d.GetAddressOf())))
-			{
-				texture2d->GetDesc(texture2d_desc);
-			}
-		}
-	}
-
-	// sĂĂS_OKԂāAvO~߂Ȃ悤ɂ
-	return S_OK;
-}
-
-void release_all_textures()
-{
-	resources.clear();
-}
-
-// UNIT.16
-HRESULT make_dummy_texture(ID3D11Device* device, ID3D11ShaderResourceView** shader_resource_view, DWORD value/*0xAABBGGRR*/, UINT dimension)
-{
-	HRESULT hr{ S_OK };
-
-	wstringstream keyname;
-	keyname << setw(8) << setfill(L'0') << hex << uppercase << value << L"." << dec << dimension;
-	map<wstring, ComPtr<ID3D11ShaderResourceView>>::iterator it = resources.find(keyname.str().c_str());
-	if (it != resources.end())
-	{
-		*shader_resource_view = it->second.Get();
-		(*shader_resource_view)->AddRef();
-	}
-	else
-	{
-		D3D11_TEXTURE2D_DESC texture2d_desc{};
-		texture2d_desc.Width = dimension;
-		texture2d_desc.Height = dimension;
-		texture2d_desc.MipLevels = 1;
-		texture2d_desc.ArraySize = 1;
-		texture2d_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
-		texture2d_desc.SampleDesc.Count = 1;
-		texture2d_desc.SampleDesc.Quality = 0;
-		texture2d_desc.Usage = D3D11_USAGE_DEFAULT;
-		texture2d_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
-		texture2d_desc.CPUAccessFlags = 0;
-		texture2d_desc.MiscFlags = 0;
-
-		size_t texels = static_cast<size_t>(dimension) * dimension;
-		unique_ptr<DWORD[]> sysmem{ make_unique< DWORD[]>(texels) };
-		for (size_t i = 0; i < texels; ++i)
-		{
-			sysmem[i] = value;
-		}
-
-		D3D11_SUBRESOURCE_DATA subresource_data{};
-		subresource_data.pSysMem = sysmem.get();
-		subresource_data.SysMemPitch = sizeof(DWORD) * dimension;
-		subresource_data.SysMemSlicePitch = 0;
-
-		ComPtr<ID3D11Texture2D> texture2d;
-		hr = device->CreateTexture2D(&texture2d_desc, &subresource_data, &texture2d);
-		// _ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr)); // G[~𖳌
-
-		if (SUCCEEDED(hr))
-		{
-			D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc{};
-			shader_resource_view_desc.Format = texture2d_desc.Format;
-			shader_resource_view_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
-			shader_resource_view_desc.Texture2D.MipLevels = 1;
-
-			hr = device->CreateShaderResourceView(texture2d.Get(), &shader_resource_view_desc, shader_resource_view);
-			// _ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr)); // G[~𖳌
-
-			if (SUCCEEDED(hr))
-			{
-				resources.insert(std::make_pair(keyname.str().c_str(), *shader_resource_view));
-			}
-		}
-	}
-	return hr;
-}
\ No newline at end of file
+// UNIT.10
+#include "texture.h"
+#include "misc.h"
+
+#include <WICTextureLoader.h>
+using namespace DirectX;
+
+#include <wrl.h>
+using namespace Microsoft::WRL;
+
+#include <string>
+#include <map>
+using namespace std;
+
+// UNIT.16
+#include <sstream>
+#include <iomanip>
+
+// UNIT,31
+#include <filesystem>
+#include <DDSTextureLoader.h>
+
+#include <vector>
+#include "thread_pool.h"
+#include "texture_mipmap.h"
+#include "texture_streamer.h"
+#include "memory_tracker.h"
+
+static map<wstring, ComPtr<ID3D11ShaderResourceView>> resources;
+static texture_streamer* streamer{ nullptr };
+
+// Bytes of every level of the texture behind 'shader_resource_view'. Formats texture_image does not know are counted
+// at four bytes per texel.
+static size_t texture_bytes(ID3D11ShaderResourceView* shader_resource_view)
+{
+	ComPtr<ID3D11Resource> resource;
+	shader_resource_view->GetResource(resource.GetAddressOf());
+	ComPtr<ID3D11Texture2D> texture2d;
+	if (!resource || FAILED(resource.As(&texture2d)))
+	{
+		return 0;
+	}
+	D3D11_TEXTURE2D_DESC texture2d_desc{};
+	texture2d->GetDesc(&texture2d_desc);
+	const texture_format format{ static_cast<texture_format>(texture2d_desc.Format) };
+	size_t bytes{ 0 };
+	for (UINT level = 0; level < texture2d_desc.MipLevels; ++level)
+	{
+		const uint32_t width{ std::max<uint32_t>(1, texture2d_desc.Width >> level) };
+		const uint32_t height{ std::max<uint32_t>(1, texture2d_desc.Height >> level) };
+		bytes += bytes_per_element(format) ? compute_level_size(format, width, height) : static_cast<size_t>(width) * height * 4;
+	}
+	return bytes * texture2d_desc.ArraySize;
+}
+
+// Adds a texture to the cache, counted as MEMORY_TAG::TEXTURES until release_all_textures.
+static void cache_texture(const wstring& name, ID3D11ShaderResourceView* shader_resource_view)
+{
+	if (resources.insert(make_pair(name, shader_resource_view)).second)
+	{
+		default_memory_tracker().allocate(MEMORY_TAG::TEXTURES, texture_bytes(shader_resource_view));
+	}
+}
+
+// プロトタイプ宣言（make_dummy_textureを先に呼び出せるようにする）
+HRESULT make_dummy_texture(ID3D11Device* device, ID3D11ShaderResourceView** shader_resource_view, DWORD value, UINT dimension);
+
+HRESULT load_texture_from_file(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** shader_resource_view, D3D11_TEXTURE2D_DESC* texture2d_desc)
+{
+	HRESULT hr{ S_OK };
+	ComPtr<ID3D11Resource> resource;
+
+	auto it = resources.find(filename);
+	if (it != resources.end())
+	{
+		*shader_resource_view = it->second.Get();
+		(*shader_resource_view)->AddRef();
+	}
+	else
+	{
+		// UNIT.31
+		std::filesystem::path dds_filename(filename);
+		dds_filename.replace_extension("dds");
+		if (std::filesystem::exists(dds_filename.c_str()))
+		{
+			hr = CreateDDSTextureFromFile(device, dds_filename.c_str(), resource.GetAddressOf(), shader_resource_view);
+		}
+		else
+		{
+			hr = CreateWICTextureFromFile(device, filename, resource.GetAddressOf(), shader_resource_view);
+		}
+
+		// 【重要】読み込み失敗時は強制的にダミーテクスチャ（青色）を作成する
+		// これによりエラー停止を防ぎます
+		if (FAILED(hr))
+		{
+			make_dummy_texture(device, shader_resource_view, 0xFF0000FF, 16);
+		}
+
+		// 成功（またはダミー作成成功）していれば登録
+		if (*shader_resource_view)
+		{
+			cache_texture(filename, *shader_resource_view);
+		}
+	}
+
+	// リソース情報を取得（ダミーの場合も含めて安全に行う）
+	if (*shader_resource_view)
+	{
+		// SRVからリソースを取り出し直す
+		(*shader_resource_view)->GetResource(resource.ReleaseAndGetAddressOf());
+
+		if (resource)
+		{
+			ComPtr<ID3D11Texture2D> texture2d;
+			if (SUCCEEDED(resource.Get()->QueryInterface<ID3D11Texture2D>(texture2d.GetAddressOf())))
+			{
+				texture2d->GetDesc(texture2d_desc);
+			}
+		}
+	}
+
+	// 失敗していてもS_OKを返して、プログラムを止めないようにする
+	return S_OK;
+}
+
+void release_all_textures()
+{
+	for (const pair<const wstring, ComPtr<ID3D11ShaderResourceView>>& resource : resources)
+	{
+		default_memory_tracker().release(MEMORY_TAG::TEXTURES, texture_bytes(resource.second.Get()));
+	}
+	resources.clear();
+}
+
+void texture_cache_usage(std::vector<std::pair<std::wstring, size_t>>& textures)
+{
+	textures.clear();
+	for (const pair<const wstring, ComPtr<ID3D11ShaderResourceView>>& resource : resources)
+	{
+		textures.emplace_back(resource.first, texture_bytes(resource.second.Get()));
+	}
+}
+
+// UNIT.16
+HRESULT make_dummy_texture(ID3D11Device* device, ID3D11ShaderResourceView** shader_resource_view, DWORD value/*0xAABBGGRR*/, UINT dimension)
+{
+	HRESULT hr{ S_OK };
+
+	wstringstream keyname;
+	keyname << setw(8) << setfill(L'0') << hex << uppercase << value << L"." << dec << dimension;
+	map<wstring, ComPtr<ID3D11ShaderResourceView>>::iterator it = resources.find(keyname.str().c_str());
+	if (it != resources.end())
+	{
+		*shader_resource_view = it->second.Get();
+		(*shader_resource_view)->AddRef();
+	}
+	else
+	{
+		D3D11_TEXTURE2D_DESC texture2d_desc{};
+		texture2d_desc.Width = dimension;
+		texture2d_desc.Height = dimension;
+		texture2d_desc.MipLevels = 1;
+		texture2d_desc.ArraySize = 1;
+		texture2d_desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		texture2d_desc.SampleDesc.Count = 1;
+		texture2d_desc.SampleDesc.Quality = 0;
+		texture2d_desc.Usage = D3D11_USAGE_DEFAULT;
+		texture2d_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+		texture2d_desc.CPUAccessFlags = 0;
+		texture2d_desc.MiscFlags = 0;
+
+		size_t texels = static_cast<size_t>(dimension) * dimension;
+		unique_ptr<DWORD[]> sysmem{ make_unique< DWORD[]>(texels) };
+		for (size_t i = 0; i < texels; ++i)
+		{
+			sysmem[i] = value;
+		}
+
+		D3D11_SUBRESOURCE_DATA subresource_data{};
+		subresource_data.pSysMem = sysmem.get();
+		subresource_data.SysMemPitch = sizeof(DWORD) * dimension;
+		subresource_data.SysMemSlicePitch = 0;
+
+		ComPtr<ID3D11Texture2D> texture2d;
+		hr = device->CreateTexture2D(&texture2d_desc, &subresource_data, &texture2d);
+		// _ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr)); // エラー停止を無効化
+
+		if (SUCCEEDED(hr))
+		{
+			D3D11_SHADER_RESOURCE_VIEW_DESC shader_resource_view_desc{};
+			shader_resource_view_desc.Format = texture2d_desc.Format;
+			shader_resource_view_desc.ViewDimension = D3D11_SRV_DIMENSION_TEXTURE2D;
+			shader_resource_view_desc.Texture2D.MipLevels = 1;
+
+			hr = device->CreateShaderResourceView(texture2d.Get(), &shader_resource_view_desc, shader_resource_view);
+			// _ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr)); // エラー停止を無効化
+
+			if (SUCCEEDED(hr))
+			{
+				cache_texture(keyname.str(), *shader_resource_view);
+			}
+		}
+	}
+	return hr;
+}
+
+HRESULT create_texture_from_image(ID3D11Device* device, const texture_image& image, ID3D11ShaderResourceView** shader_resource_view, uint32_t first_level)
+{
+	HRESULT hr{ S_OK };
+	if (first_level >= image.levels.size())
+	{
+		return E_INVALIDARG;
+	}
+
+	D3D11_TEXTURE2D_DESC texture2d_desc{};
+	texture2d_desc.Width = image.levels.at(first_level).width;
+	texture2d_desc.Height = image.levels.at(first_level).height;
+	texture2d_desc.MipLevels = static_cast<UINT>(image.levels.size() - first_level);
+	texture2d_desc.ArraySize = 1;
+	texture2d_desc.Format = static_cast<DXGI_FORMAT>(image.format);
+	texture2d_desc.SampleDesc.Count = 1;
+	texture2d_desc.SampleDesc.Quality = 0;
+	texture2d_desc.Usage = D3D11_USAGE_DEFAULT;
+	texture2d_desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+	texture2d_desc.CPUAccessFlags = 0;
+	texture2d_desc.MiscFlags = 0;
+
+	vector<D3D11_SUBRESOURCE_DATA> subresource_data(texture2d_desc.MipLevels);
+	for (size_t level_index = first_level; level_index < image.levels.size(); ++level_index)
+	{
+		D3D11_SUBRESOURCE_DATA& data{ subresource_data.at(level_index - first_level) };
+		data.pSysMem = image.data(level_index);
+		data.SysMemPitch = image.levels.at(level_index).row_pitch;
+		data.SysMemSlicePitch = static_cast<UINT>(image.levels.at(level_index).size);
+	}
+
+	ComPtr<ID3D11Texture2D> texture2d;
+	hr = device->CreateTexture2D(&texture2d_desc, subresource_data.data(), texture2d.GetAddressOf());
+	if (FAILED(hr))
+	{
+		return hr;
+	}
+	return device->CreateShaderResourceView(texture2d.Get(), nullptr, shader_resource_view);
+}
+
+void set_texture_streamer(texture_streamer* texture_streamer)
+{
+	streamer = texture_streamer;
+}
+
+void release_texture_slots(const void* owner)
+{
+	if (streamer)
+	{
+		streamer->remove_owner(owner);
+	}
+}
+
+HRESULT load_textures_from_files(ID3D11Device* device, texture_load_request* requests, size_t request_count, const texture_slot_resolver& resolve)
+{
+	struct pending_texture
+	{
+		wstring filename;
+		texture_role role;
+		bool owned{ false };
+		texture_image image;
+		bool decoded{ false };
+		ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+	};
+	vector<pending_texture> pending_textures;
+	map<wstring, size_t> pending_indices;
+
+	// Cached textures are handed out immediately; every other file is decoded only once however many materials share it.
+	for (size_t request_index = 0; request_index < request_count; ++request_index)
+	{
+		const texture_load_request& request{ requests[request_index] };
+		if (resources.find(request.filename) != resources.end() || (streamer && streamer->contains(request.filename)))
+		{
+			continue;
+		}
+		const pair<map<wstring, size_t>::iterator, bool> inserted{ pending_indices.insert(make_pair(request.filename, pending_textures.size())) };
+		if (inserted.second)
+		{
+			pending_texture& pending{ pending_textures.emplace_back() };
+			pending.filename = request.filename;
+			pending.role = request.role;
+		}
+		pending_textures.at(inserted.first->second).owned |= request.owner != nullptr && resolve != nullptr;
+	}
+
+	// CPU decode on the thread pool. A sibling .dds is preferred as in load_texture_from_file.
+	default_thread_pool().parallel_for(pending_textures.size(), [&pending_textures](size_t pending_index)
+	{
+		// The decoded image is freed once it is uploaded.
+		memory_scope temporary(MEMORY_TAG::LOAD_TEMPORARY);
+		pending_texture& pending{ pending_textures.at(pending_index) };
+		std::filesystem::path dds_filename(pending.filename);
+		dds_filename.replace_extension("dds");
+		pending.decoded = std::filesystem::exists(dds_filename) ?
+			decode_texture_file(dds_filename.c_str(), pending.image) :
+			decode_texture_file(pending.filename.c_str(), pending.image);
+		// WIC images and uncompressed DDS files without mips get a full chain so distant meshes sample small levels.
+		if (pending.decoded && pending.image.levels.size() == 1 && !is_block_compressed(pending.image.format))
+		{
+			generate_mipmaps(pending.image, default_mipmap_options(pending.role));
+		}
+	});
+
+	// Device uploads, serially on this thread.
+	for (pending_texture& pending : pending_textures)
+	{
+		// Large textures with an owner start with their small levels only.
+		if (pending.decoded && pending.owned && streamer && streamer->add(pending.filename, pending.role, pending.image))
+		{
+			pending.image = {};
+			continue;
+		}
+		if (pending.decoded && SUCCEEDED(create_texture_from_image(device, pending.image, pending.shader_resource_view.GetAddressOf())))
+		{
+			cache_texture(pending.filename, pending.shader_resource_view.Get());
+		}
+		pending.image = {};
+	}
+
+	for (size_t request_index = 0; request_index < request_count; ++request_index)
+	{
+		const texture_load_request& request{ requests[request_index] };
+		if (request.owner && resolve && streamer && streamer->attach(request.filename, request.owner, request.material, request.texture_index, resolve))
+		{
+			continue;
+		}
+		D3D11_TEXTURE2D_DESC texture2d_desc{};
+		// Files the CPU decoder could not handle (cube maps, unusual DDS layouts...) go through the regular path,
+		// which also takes care of the cache and the dummy texture.
+		load_texture_from_file(device, request.filename.c_str(), request.shader_resource_view, request.texture2d_desc ? request.texture2d_desc : &texture2d_desc);
+	}
+
+	return S_OK;
+}
@@ -1,9 +1,45 @@
-#pragma once
-
-#include <d3d11.h>
-
-HRESULT load_texture_from_file(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** shader_resource_view, D3D11_TEXTURE2D_DESC* texture2d_desc);
-void release_all_textures();
-// UNIT.16
-HRESULT make_dummy_texture(ID3D11Device* device, ID3D11ShaderResourceView** shader_resource_view, DWORD value/*0xAABBGGRR*/, UINT dimension);
-
+#pragma once
+
+#include <d3d11.h>
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "texture_image.h"
+
+HRESULT load_texture_from_file(ID3D11Device* device, const wchar_t* filename, ID3D11ShaderResourceView** shader_resource_view, D3D11_TEXTURE2D_DESC* texture2d_desc);
+void release_all_textures();
+// Every texture in the cache with the bytes of its levels on the device. Streamed textures are not in the cache;
+// see texture_residency::resident_bytes.
+void texture_cache_usage(std::vector<std::pair<std::wstring, size_t>>& textures);
+// UNIT.16
+HRESULT make_dummy_texture(ID3D11Device* device, ID3D11ShaderResourceView** shader_resource_view, DWORD value/*0xAABBGGRR*/, UINT dimension);
+
+// Batched loading: every distinct file is decoded to system memory on the thread pool, given a complete mip chain,
+// then only the device uploads run serially on the calling thread.
+struct texture_load_request
+{
+	std::wstring filename;
+	ID3D11ShaderResourceView** shader_resource_view{ nullptr };
+	D3D11_TEXTURE2D_DESC* texture2d_desc{ nullptr }; // optional
+	texture_role role{ texture_role::albedo }; // decides how the mip chain is filtered when the file has none
+	const void* owner{ nullptr }; // the mesh holding the slot; only owned slots are streamed
+	// Names the slot as its owner does, so the streamer can find it again through the owner's texture_slot_resolver.
+	uint64_t material{ 0 };
+	uint32_t texture_index{ 0 };
+};
+// Returns where an owner currently keeps the view of texture 'texture_index' of 'material'. The streamer looks slots
+// up through it every time it replaces a view, so owners may move their material storage after loading.
+using texture_slot_resolver = std::function<ID3D11ShaderResourceView**(uint64_t material, uint32_t texture_index)>;
+
+class texture_streamer;
+// Textures of owned requests go through 'streamer' from then on; nullptr turns streaming off.
+void set_texture_streamer(texture_streamer* streamer);
+// Stops the streamer from updating the slots of 'owner'. Meshes call this when they are destroyed.
+void release_texture_slots(const void* owner);
+// Owned requests are streamed only when 'resolve' is given; it must stay valid until release_texture_slots(owner).
+HRESULT load_textures_from_files(ID3D11Device* device, texture_load_request* requests, size_t request_count, const texture_slot_resolver& resolve = nullptr);
+// 'first_level' becomes level 0 of the texture; the coarser levels follow it.
+HRESULT create_texture_from_image(ID3D11Device* device, const texture_image& image, ID3D11ShaderResourceView** shader_resource_view, uint32_t first_level = 0);
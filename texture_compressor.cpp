@@ -0,0 +1,990 @@
+#include "texture_compressor.h"
+#include "thread_pool.h"
+#include "texture_mipmap.h"
+
+#include <directxmath.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+
+using namespace DirectX;
+
+namespace
+{
+	const uint32_t BLOCK_TEXELS{ 16 };
+
+	int iteration_count(compression_quality quality)
+	{
+		return quality == compression_quality::fast ? 0 : quality == compression_quality::normal ? 1 : 4;
+	}
+
+	void fetch_block(const texture_image& image, size_t level_index, uint32_t block_x, uint32_t block_y, uint8_t texels[BLOCK_TEXELS][4])
+	{
+		const texture_image::level& level{ image.levels.at(level_index) };
+		const uint8_t* data{ image.data(level_index) };
+		const bool bgra{ image.format == texture_format::b8g8r8a8_unorm || image.format == texture_format::b8g8r8a8_unorm_srgb };
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			// Blocks that hang over the edge of small mips repeat the last row/column.
+			const uint32_t source_y{ std::min(block_y * 4 + y, level.height - 1) };
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				const uint32_t source_x{ std::min(block_x * 4 + x, level.width - 1) };
+				const uint8_t* texel{ data + static_cast<size_t>(source_y) * level.row_pitch + static_cast<size_t>(source_x) * 4 };
+				uint8_t* destination{ texels[y * 4 + x] };
+				destination[0] = texel[bgra ? 2 : 0];
+				destination[1] = texel[1];
+				destination[2] = texel[bgra ? 0 : 2];
+				destination[3] = texel[3];
+			}
+		}
+	}
+
+	struct bit_writer
+	{
+		uint8_t* bytes;
+		uint32_t position{ 0 };
+		void write(uint32_t value, uint32_t bit_count)
+		{
+			for (uint32_t bit = 0; bit < bit_count; ++bit, ++position)
+			{
+				if ((value >> bit) & 1)
+				{
+					bytes[position >> 3] |= static_cast<uint8_t>(1 << (position & 7));
+				}
+			}
+		}
+	};
+	struct bit_reader
+	{
+		const uint8_t* bytes;
+		uint32_t position{ 0 };
+		uint32_t read(uint32_t bit_count)
+		{
+			uint32_t value{ 0 };
+			for (uint32_t bit = 0; bit < bit_count; ++bit, ++position)
+			{
+				value |= static_cast<uint32_t>((bytes[position >> 3] >> (position & 7)) & 1) << bit;
+			}
+			return value;
+		}
+	};
+
+	// Principal axis of the points by power iteration on their covariance matrix.
+	// Returns a zero vector when all the points are (nearly) the same.
+	XMVECTOR principal_axis(const XMVECTOR* points, size_t count, FXMVECTOR mean)
+	{
+		XMMATRIX covariance{ XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero() };
+		XMVECTOR minimum{ points[0] };
+		XMVECTOR maximum{ points[0] };
+		for (size_t i = 0; i < count; ++i)
+		{
+			const XMVECTOR d{ XMVectorSubtract(points[i], mean) };
+			covariance.r[0] = XMVectorMultiplyAdd(d, XMVectorSplatX(d), covariance.r[0]);
+			covariance.r[1] = XMVectorMultiplyAdd(d, XMVectorSplatY(d), covariance.r[1]);
+			covariance.r[2] = XMVectorMultiplyAdd(d, XMVectorSplatZ(d), covariance.r[2]);
+			covariance.r[3] = XMVectorMultiplyAdd(d, XMVectorSplatW(d), covariance.r[3]);
+			minimum = XMVectorMin(minimum, points[i]);
+			maximum = XMVectorMax(maximum, points[i]);
+		}
+		XMVECTOR axis{ XMVectorSubtract(maximum, minimum) };
+		if (XMVectorGetX(XMVector4LengthSq(axis)) < 1e-4f)
+		{
+			return XMVectorZero();
+		}
+		axis = XMVector4Normalize(axis);
+		for (int iteration = 0; iteration < 8; ++iteration)
+		{
+			const XMVECTOR next{ XMVector4Transform(axis, covariance) };
+			if (XMVectorGetX(XMVector4LengthSq(next)) < 1e-8f)
+			{
+				break;
+			}
+			axis = XMVector4Normalize(next);
+		}
+		return axis;
+	}
+
+	void project_extremes(const XMVECTOR* points, size_t count, FXMVECTOR mean, FXMVECTOR axis, XMVECTOR& high, XMVECTOR& low)
+	{
+		float t_min{ +FLT_MAX };
+		float t_max{ -FLT_MAX };
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float t{ XMVectorGetX(XMVector4Dot(XMVectorSubtract(points[i], mean), axis)) };
+			t_min = std::min(t_min, t);
+			t_max = std::max(t_max, t);
+		}
+		const XMVECTOR zero{ XMVectorZero() };
+		const XMVECTOR one{ XMVectorReplicate(255.0f) };
+		high = XMVectorClamp(XMVectorMultiplyAdd(axis, XMVectorReplicate(t_max), mean), zero, one);
+		low = XMVectorClamp(XMVectorMultiplyAdd(axis, XMVectorReplicate(t_min), mean), zero, one);
+	}
+
+	// Endpoints minimising sum |(1 - w) * e0 + w * e1 - x|^2 for fixed weights w.
+	bool least_squares_endpoints(const XMVECTOR* points, const float* weights, size_t count, XMVECTOR& e0, XMVECTOR& e1)
+	{
+		float a{ 0 }, b{ 0 }, c{ 0 };
+		XMVECTOR x0{ XMVectorZero() };
+		XMVECTOR x1{ XMVectorZero() };
+		for (size_t i = 0; i < count; ++i)
+		{
+			const float w{ weights[i] };
+			a += (1 - w) * (1 - w);
+			b += (1 - w) * w;
+			c += w * w;
+			x0 = XMVectorMultiplyAdd(points[i], XMVectorReplicate(1 - w), x0);
+			x1 = XMVectorMultiplyAdd(points[i], XMVectorReplicate(w), x1);
+		}
+		const float determinant{ a * c - b * b };
+		if (std::fabs(determinant) < 1e-6f)
+		{
+			return false;
+		}
+		const XMVECTOR zero{ XMVectorZero() };
+		const XMVECTOR one{ XMVectorReplicate(255.0f) };
+		e0 = XMVectorClamp(XMVectorScale(XMVectorSubtract(XMVectorScale(x0, c), XMVectorScale(x1, b)), 1.0f / determinant), zero, one);
+		e1 = XMVectorClamp(XMVectorScale(XMVectorSubtract(XMVectorScale(x1, a), XMVectorScale(x0, b)), 1.0f / determinant), zero, one);
+		return true;
+	}
+
+	// BC1 / BC3 colour block
+
+	uint16_t pack_565(FXMVECTOR color)
+	{
+		XMFLOAT4 c;
+		XMStoreFloat4(&c, XMVectorClamp(color, XMVectorZero(), XMVectorReplicate(255.0f)));
+		const uint32_t r{ static_cast<uint32_t>(c.x * 31.0f / 255.0f + 0.5f) };
+		const uint32_t g{ static_cast<uint32_t>(c.y * 63.0f / 255.0f + 0.5f) };
+		const uint32_t b{ static_cast<uint32_t>(c.z * 31.0f / 255.0f + 0.5f) };
+		return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+	}
+	void unpack_565(uint16_t color, uint32_t rgb[3])
+	{
+		const uint32_t r{ static_cast<uint32_t>(color >> 11) & 31 };
+		const uint32_t g{ static_cast<uint32_t>(color >> 5) & 63 };
+		const uint32_t b{ static_cast<uint32_t>(color) & 31 };
+		rgb[0] = (r << 3) | (r >> 2);
+		rgb[1] = (g << 2) | (g >> 4);
+		rgb[2] = (b << 3) | (b >> 2);
+	}
+	void bc1_palette(uint16_t c0, uint16_t c1, bool four_colors, uint32_t palette[4][4])
+	{
+		unpack_565(c0, palette[0]);
+		unpack_565(c1, palette[1]);
+		palette[0][3] = palette[1][3] = 255;
+		for (int channel = 0; channel < 3; ++channel)
+		{
+			if (four_colors)
+			{
+				palette[2][channel] = (2 * palette[0][channel] + palette[1][channel] + 1) / 3;
+				palette[3][channel] = (palette[0][channel] + 2 * palette[1][channel] + 1) / 3;
+			}
+			else
+			{
+				palette[2][channel] = (palette[0][channel] + palette[1][channel]) / 2;
+				palette[3][channel] = 0;
+			}
+		}
+		palette[2][3] = 255;
+		palette[3][3] = four_colors ? 255 : 0;
+	}
+
+	float fit_bc1_indices(const XMVECTOR* texels, uint16_t c0, uint16_t c1, uint32_t& indices)
+	{
+		uint32_t palette[4][4];
+		bc1_palette(c0, c1, true, palette);
+		XMVECTOR colors[4];
+		for (int i = 0; i < 4; ++i)
+		{
+			colors[i] = XMVectorSet(static_cast<float>(palette[i][0]), static_cast<float>(palette[i][1]), static_cast<float>(palette[i][2]), 0.0f);
+		}
+		const int palette_size{ c0 == c1 ? 1 : 4 };
+		float error{ 0 };
+		indices = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			float best_distance{ FLT_MAX };
+			uint32_t best_index{ 0 };
+			for (int j = 0; j < palette_size; ++j)
+			{
+				const float distance{ XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(texels[i], colors[j]))) };
+				if (distance < best_distance)
+				{
+					best_distance = distance;
+					best_index = j;
+				}
+			}
+			indices |= best_index << (2 * i);
+			error += best_distance;
+		}
+		return error;
+	}
+
+	void encode_bc1_color(const uint8_t texels[BLOCK_TEXELS][4], compression_quality quality, uint8_t* block)
+	{
+		XMVECTOR points[BLOCK_TEXELS];
+		XMVECTOR mean{ XMVectorZero() };
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			points[i] = XMVectorSet(texels[i][0], texels[i][1], texels[i][2], 0.0f);
+			mean = XMVectorAdd(mean, points[i]);
+		}
+		mean = XMVectorScale(mean, 1.0f / BLOCK_TEXELS);
+
+		XMVECTOR e0{ mean };
+		XMVECTOR e1{ mean };
+		const XMVECTOR axis{ principal_axis(points, BLOCK_TEXELS, mean) };
+		if (XMVectorGetX(XMVector4LengthSq(axis)) > 0)
+		{
+			project_extremes(points, BLOCK_TEXELS, mean, axis, e0, e1);
+		}
+
+		uint16_t best_c0{ 0 }, best_c1{ 0 };
+		uint32_t best_indices{ 0 };
+		float best_error{ FLT_MAX };
+		auto attempt = [&](FXMVECTOR high, FXMVECTOR low)
+		{
+			uint16_t c0{ pack_565(high) };
+			uint16_t c1{ pack_565(low) };
+			if (c0 < c1)
+			{
+				std::swap(c0, c1);
+			}
+			uint32_t indices;
+			const float error{ fit_bc1_indices(points, c0, c1, indices) };
+			if (error < best_error)
+			{
+				best_error = error;
+				best_c0 = c0;
+				best_c1 = c1;
+				best_indices = indices;
+				return true;
+			}
+			return false;
+		};
+		attempt(e0, e1);
+		if (quality == compression_quality::high)
+		{
+			// Insetting the endpoints by 1/16 of the range often beats the raw extremes.
+			const XMVECTOR inset{ XMVectorScale(XMVectorSubtract(e0, e1), 1.0f / 16) };
+			attempt(XMVectorSubtract(e0, inset), XMVectorAdd(e1, inset));
+		}
+
+		const float index_weights[4]{ 0.0f, 1.0f, 1.0f / 3, 2.0f / 3 };
+		for (int iteration = 0; iteration < iteration_count(quality) && best_c0 != best_c1; ++iteration)
+		{
+			float weights[BLOCK_TEXELS];
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				weights[i] = index_weights[(best_indices >> (2 * i)) & 3];
+			}
+			XMVECTOR refined0, refined1;
+			if (!least_squares_endpoints(points, weights, BLOCK_TEXELS, refined0, refined1) || !attempt(refined0, refined1))
+			{
+				break;
+			}
+		}
+
+		memcpy(block + 0, &best_c0, 2);
+		memcpy(block + 2, &best_c1, 2);
+		memcpy(block + 4, &best_indices, 4);
+	}
+
+	// BC4 single channel block (also the alpha half of BC3 and both halves of BC5)
+
+	void bc4_palette(uint32_t a0, uint32_t a1, uint32_t palette[8])
+	{
+		palette[0] = a0;
+		palette[1] = a1;
+		if (a0 > a1)
+		{
+			for (uint32_t i = 1; i < 7; ++i)
+			{
+				palette[i + 1] = ((7 - i) * a0 + i * a1 + 3) / 7;
+			}
+		}
+		else
+		{
+			for (uint32_t i = 1; i < 5; ++i)
+			{
+				palette[i + 1] = ((5 - i) * a0 + i * a1 + 2) / 5;
+			}
+			palette[6] = 0;
+			palette[7] = 255;
+		}
+	}
+
+	float fit_bc4_indices(const float* values, uint32_t a0, uint32_t a1, uint64_t& indices)
+	{
+		uint32_t palette[8];
+		bc4_palette(a0, a1, palette);
+		const XMVECTOR palette_low{ XMVectorSet(static_cast<float>(palette[0]), static_cast<float>(palette[1]), static_cast<float>(palette[2]), static_cast<float>(palette[3])) };
+		const XMVECTOR palette_high{ XMVectorSet(static_cast<float>(palette[4]), static_cast<float>(palette[5]), static_cast<float>(palette[6]), static_cast<float>(palette[7])) };
+		float error{ 0 };
+		indices = 0;
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			// Distances to all 8 palette entries, 4 at a time.
+			const XMVECTOR value{ XMVectorReplicate(values[i]) };
+			XMFLOAT4 distances[2];
+			const XMVECTOR d0{ XMVectorSubtract(palette_low, value) };
+			const XMVECTOR d1{ XMVectorSubtract(palette_high, value) };
+			XMStoreFloat4(&distances[0], XMVectorMultiply(d0, d0));
+			XMStoreFloat4(&distances[1], XMVectorMultiply(d1, d1));
+			const float* distance{ &distances[0].x };
+			uint32_t best_index{ 0 };
+			for (uint32_t j = 1; j < 8; ++j)
+			{
+				if (distance[j] < distance[best_index])
+				{
+					best_index = j;
+				}
+			}
+			indices |= static_cast<uint64_t>(best_index) << (3 * i);
+			error += distance[best_index];
+		}
+		return error;
+	}
+
+	void encode_bc4(const float* values, compression_quality quality, uint8_t* block)
+	{
+		float minimum{ 255.0f }, maximum{ 0.0f };
+		float inner_minimum{ 255.0f }, inner_maximum{ 0.0f };
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			minimum = std::min(minimum, values[i]);
+			maximum = std::max(maximum, values[i]);
+			if (values[i] > 0.0f && values[i] < 255.0f)
+			{
+				inner_minimum = std::min(inner_minimum, values[i]);
+				inner_maximum = std::max(inner_maximum, values[i]);
+			}
+		}
+
+		uint32_t best_a0{ static_cast<uint32_t>(maximum) };
+		uint32_t best_a1{ static_cast<uint32_t>(minimum) };
+		uint64_t best_indices{ 0 };
+		float best_error{ FLT_MAX };
+		auto attempt = [&](uint32_t a0, uint32_t a1)
+		{
+			uint64_t indices;
+			const float error{ fit_bc4_indices(values, a0, a1, indices) };
+			if (error < best_error)
+			{
+				best_error = error;
+				best_a0 = a0;
+				best_a1 = a1;
+				best_indices = indices;
+				return true;
+			}
+			return false;
+		};
+		attempt(best_a0, best_a1);
+		if (best_error > 0 && quality != compression_quality::fast)
+		{
+			// Six value mode keeps exact 0 and 255, which suits masks with hard edges.
+			if (inner_minimum <= inner_maximum && (minimum == 0.0f || maximum == 255.0f))
+			{
+				attempt(static_cast<uint32_t>(inner_minimum), static_cast<uint32_t>(inner_maximum));
+			}
+			for (int iteration = 0; iteration < iteration_count(quality) && best_a0 > best_a1; ++iteration)
+			{
+				float weights[BLOCK_TEXELS];
+				for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+				{
+					const uint32_t index{ static_cast<uint32_t>((best_indices >> (3 * i)) & 7) };
+					weights[i] = index == 0 ? 0.0f : index == 1 ? 1.0f : (index - 1) / 7.0f;
+				}
+				XMVECTOR points[BLOCK_TEXELS];
+				for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+				{
+					points[i] = XMVectorReplicate(values[i]);
+				}
+				XMVECTOR e0, e1;
+				if (!least_squares_endpoints(points, weights, BLOCK_TEXELS, e0, e1))
+				{
+					break;
+				}
+				uint32_t a0{ static_cast<uint32_t>(XMVectorGetX(e0) + 0.5f) };
+				uint32_t a1{ static_cast<uint32_t>(XMVectorGetX(e1) + 0.5f) };
+				if (a0 <= a1)
+				{
+					break;
+				}
+				if (!attempt(a0, a1))
+				{
+					break;
+				}
+			}
+		}
+
+		block[0] = static_cast<uint8_t>(best_a0);
+		block[1] = static_cast<uint8_t>(best_a1);
+		for (int i = 0; i < 6; ++i)
+		{
+			block[2 + i] = static_cast<uint8_t>(best_indices >> (8 * i));
+		}
+	}
+
+	// BC7, mode 6 only: one subset, 7.7.7.7 RGBA endpoints with a p-bit each and 4 bit indices.
+	// It is the most generally useful mode and keeps the encoder fast enough to run at cook time.
+
+	const uint32_t BC7_WEIGHTS_4[16]{ 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	XMVECTOR quantize_bc7_mode6(FXMVECTOR endpoint, uint32_t p_bit)
+	{
+		// 8 bit value = (7 bit value << 1) | p
+		const XMVECTOR q{ XMVectorClamp(XMVectorRound(XMVectorScale(XMVectorSubtract(endpoint, XMVectorReplicate(static_cast<float>(p_bit))), 0.5f)), XMVectorZero(), XMVectorReplicate(127.0f)) };
+		return q;
+	}
+	XMVECTOR expand_bc7_mode6(FXMVECTOR quantized, uint32_t p_bit)
+	{
+		return XMVectorAdd(XMVectorScale(quantized, 2.0f), XMVectorReplicate(static_cast<float>(p_bit)));
+	}
+
+	float fit_bc7_indices(const XMVECTOR* texels, FXMVECTOR v0, FXMVECTOR v1, bool exhaustive, uint8_t indices[BLOCK_TEXELS])
+	{
+		XMVECTOR palette[16];
+		for (int i = 0; i < 16; ++i)
+		{
+			const XMVECTOR weighted{ XMVectorAdd(XMVectorAdd(XMVectorScale(v0, static_cast<float>(64 - BC7_WEIGHTS_4[i])), XMVectorScale(v1, static_cast<float>(BC7_WEIGHTS_4[i]))), XMVectorReplicate(32.0f)) };
+			palette[i] = XMVectorFloor(XMVectorScale(weighted, 1.0f / 64));
+		}
+		const XMVECTOR direction{ XMVectorSubtract(v1, v0) };
+		const float length_sq{ XMVectorGetX(XMVector4LengthSq(direction)) };
+
+		float error{ 0 };
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			int best_index{ 0 };
+			if (length_sq > 0)
+			{
+				const float t{ XMVectorGetX(XMVector4Dot(XMVectorSubtract(texels[i], v0), direction)) / length_sq };
+				best_index = std::clamp(static_cast<int>(t * 15.0f + 0.5f), 0, 15);
+			}
+			float best_distance{ XMVectorGetX(XMVector4LengthSq(XMVectorSubtract(texels[i], palette[best_index]))) };
+			if (exhaustive || length_sq == 0)
+			{
+				for (int j = 0; j < 16; ++j)
+				{
+					const float distance{ XMVectorGetX(XMVector4LengthSq(XMVectorSubtract(texels[i], palette[j]))) };
+					if (distance < best_distance)
+					{
+						best_distance = distance;
+						best_index = j;
+					}
+				}
+			}
+			else
+			{
+				// The weights are not exactly uniform, so check the neighbours of the projected index.
+				for (int j = std::max(0, best_index - 1); j <= std::min(15, best_index + 1); ++j)
+				{
+					const float distance{ XMVectorGetX(XMVector4LengthSq(XMVectorSubtract(texels[i], palette[j]))) };
+					if (distance < best_distance)
+					{
+						best_distance = distance;
+						best_index = j;
+					}
+				}
+			}
+			indices[i] = static_cast<uint8_t>(best_index);
+			error += best_distance;
+		}
+		return error;
+	}
+
+	void encode_bc7(const uint8_t texels[BLOCK_TEXELS][4], compression_quality quality, uint8_t* block)
+	{
+		XMVECTOR points[BLOCK_TEXELS];
+		XMVECTOR mean{ XMVectorZero() };
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			points[i] = XMVectorSet(texels[i][0], texels[i][1], texels[i][2], texels[i][3]);
+			mean = XMVectorAdd(mean, points[i]);
+		}
+		mean = XMVectorScale(mean, 1.0f / BLOCK_TEXELS);
+
+		XMVECTOR e0{ mean };
+		XMVECTOR e1{ mean };
+		const XMVECTOR axis{ principal_axis(points, BLOCK_TEXELS, mean) };
+		if (XMVectorGetX(XMVector4LengthSq(axis)) > 0)
+		{
+			project_extremes(points, BLOCK_TEXELS, mean, axis, e1, e0);
+		}
+
+		const bool exhaustive{ quality != compression_quality::fast };
+		XMVECTOR best_q[2]{};
+		uint32_t best_p[2]{};
+		uint8_t best_indices[BLOCK_TEXELS]{};
+		float best_error{ FLT_MAX };
+		auto attempt = [&](FXMVECTOR endpoint0, FXMVECTOR endpoint1)
+		{
+			bool improved{ false };
+			for (uint32_t p_bits = 0; p_bits < 4; ++p_bits)
+			{
+				const uint32_t p0{ p_bits & 1 };
+				const uint32_t p1{ p_bits >> 1 };
+				if (quality != compression_quality::high && p_bits != 0)
+				{
+					// Without the exhaustive search each p-bit is picked on its own endpoint error.
+					break;
+				}
+				uint32_t p[2]{ p0, p1 };
+				if (quality != compression_quality::high)
+				{
+					const XMVECTOR endpoints[2]{ endpoint0, endpoint1 };
+					for (int e = 0; e < 2; ++e)
+					{
+						const float error0{ XMVectorGetX(XMVector4LengthSq(XMVectorSubtract(endpoints[e], expand_bc7_mode6(quantize_bc7_mode6(endpoints[e], 0), 0)))) };
+						const float error1{ XMVectorGetX(XMVector4LengthSq(XMVectorSubtract(endpoints[e], expand_bc7_mode6(quantize_bc7_mode6(endpoints[e], 1), 1)))) };
+						p[e] = error1 < error0 ? 1 : 0;
+					}
+				}
+				const XMVECTOR q0{ quantize_bc7_mode6(endpoint0, p[0]) };
+				const XMVECTOR q1{ quantize_bc7_mode6(endpoint1, p[1]) };
+				uint8_t indices[BLOCK_TEXELS];
+				const float error{ fit_bc7_indices(points, expand_bc7_mode6(q0, p[0]), expand_bc7_mode6(q1, p[1]), exhaustive, indices) };
+				if (error < best_error)
+				{
+					best_error = error;
+					best_q[0] = q0;
+					best_q[1] = q1;
+					best_p[0] = p[0];
+					best_p[1] = p[1];
+					memcpy(best_indices, indices, sizeof(indices));
+					improved = true;
+				}
+			}
+			return improved;
+		};
+		attempt(e0, e1);
+
+		for (int iteration = 0; iteration < iteration_count(quality) && best_error > 0; ++iteration)
+		{
+			float weights[BLOCK_TEXELS];
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				weights[i] = BC7_WEIGHTS_4[best_indices[i]] / 64.0f;
+			}
+			XMVECTOR refined0, refined1;
+			if (!least_squares_endpoints(points, weights, BLOCK_TEXELS, refined0, refined1) || !attempt(refined0, refined1))
+			{
+				break;
+			}
+		}
+
+		// The anchor index (texel 0) is stored with its top bit implied zero.
+		if (best_indices[0] & 8)
+		{
+			std::swap(best_q[0], best_q[1]);
+			std::swap(best_p[0], best_p[1]);
+			for (uint8_t& index : best_indices)
+			{
+				index = static_cast<uint8_t>(15 - index);
+			}
+		}
+
+		XMFLOAT4 q[2];
+		XMStoreFloat4(&q[0], best_q[0]);
+		XMStoreFloat4(&q[1], best_q[1]);
+		memset(block, 0, 16);
+		bit_writer writer{ block };
+		writer.write(1 << 6, 7); // mode 6
+		const float* channels[2]{ &q[0].x, &q[1].x };
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			writer.write(static_cast<uint32_t>(channels[0][channel]), 7);
+			writer.write(static_cast<uint32_t>(channels[1][channel]), 7);
+		}
+		writer.write(best_p[0], 1);
+		writer.write(best_p[1], 1);
+		writer.write(best_indices[0], 3);
+		for (uint32_t i = 1; i < BLOCK_TEXELS; ++i)
+		{
+			writer.write(best_indices[i], 4);
+		}
+	}
+
+	void encode_block(texture_format format, compression_quality quality, const uint8_t texels[BLOCK_TEXELS][4], uint8_t* block)
+	{
+		float channel[2][BLOCK_TEXELS];
+		switch (format)
+		{
+		case texture_format::bc1_unorm:
+		case texture_format::bc1_unorm_srgb:
+			encode_bc1_color(texels, quality, block);
+			break;
+		case texture_format::bc3_unorm:
+		case texture_format::bc3_unorm_srgb:
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				channel[0][i] = texels[i][3];
+			}
+			encode_bc4(channel[0], quality, block);
+			encode_bc1_color(texels, quality, block + 8);
+			break;
+		case texture_format::bc4_unorm:
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				channel[0][i] = texels[i][0];
+			}
+			encode_bc4(channel[0], quality, block);
+			break;
+		case texture_format::bc5_unorm:
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				channel[0][i] = texels[i][0];
+				channel[1][i] = texels[i][1];
+			}
+			encode_bc4(channel[0], quality, block);
+			encode_bc4(channel[1], quality, block + 8);
+			break;
+		case texture_format::bc7_unorm:
+		case texture_format::bc7_unorm_srgb:
+			encode_bc7(texels, quality, block);
+			break;
+		default:
+			break;
+		}
+	}
+
+	void decode_bc1_color(const uint8_t* block, bool force_four_colors, uint8_t texels[BLOCK_TEXELS][4])
+	{
+		uint16_t c0, c1;
+		uint32_t indices;
+		memcpy(&c0, block + 0, 2);
+		memcpy(&c1, block + 2, 2);
+		memcpy(&indices, block + 4, 4);
+		uint32_t palette[4][4];
+		bc1_palette(c0, c1, force_four_colors || c0 > c1, palette);
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			const uint32_t* color{ palette[(indices >> (2 * i)) & 3] };
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				texels[i][channel] = static_cast<uint8_t>(color[channel]);
+			}
+		}
+	}
+
+	void decode_bc4(const uint8_t* block, uint8_t texels[BLOCK_TEXELS][4], int channel)
+	{
+		uint32_t palette[8];
+		bc4_palette(block[0], block[1], palette);
+		uint64_t indices{ 0 };
+		for (int i = 0; i < 6; ++i)
+		{
+			indices |= static_cast<uint64_t>(block[2 + i]) << (8 * i);
+		}
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			texels[i][channel] = static_cast<uint8_t>(palette[(indices >> (3 * i)) & 7]);
+		}
+	}
+
+	bool decode_bc7(const uint8_t* block, uint8_t texels[BLOCK_TEXELS][4])
+	{
+		bit_reader reader{ block };
+		if (reader.read(7) != (1 << 6))
+		{
+			memset(texels, 0, BLOCK_TEXELS * 4);
+			return false;
+		}
+		uint32_t endpoints[2][4];
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = reader.read(7);
+			endpoints[1][channel] = reader.read(7);
+		}
+		const uint32_t p0{ reader.read(1) };
+		const uint32_t p1{ reader.read(1) };
+		for (int channel = 0; channel < 4; ++channel)
+		{
+			endpoints[0][channel] = (endpoints[0][channel] << 1) | p0;
+			endpoints[1][channel] = (endpoints[1][channel] << 1) | p1;
+		}
+		for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+		{
+			const uint32_t weight{ BC7_WEIGHTS_4[reader.read(i == 0 ? 3 : 4)] };
+			for (int channel = 0; channel < 4; ++channel)
+			{
+				texels[i][channel] = static_cast<uint8_t>(((64 - weight) * endpoints[0][channel] + weight * endpoints[1][channel] + 32) >> 6);
+			}
+		}
+		return true;
+	}
+
+	bool decode_block(texture_format format, const uint8_t* block, uint8_t texels[BLOCK_TEXELS][4])
+	{
+		switch (format)
+		{
+		case texture_format::bc1_unorm:
+		case texture_format::bc1_unorm_srgb:
+			decode_bc1_color(block, false, texels);
+			return true;
+		case texture_format::bc3_unorm:
+		case texture_format::bc3_unorm_srgb:
+			decode_bc1_color(block + 8, true, texels);
+			decode_bc4(block, texels, 3);
+			return true;
+		case texture_format::bc4_unorm:
+			decode_bc4(block, texels, 0);
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				texels[i][1] = texels[i][2] = texels[i][0];
+				texels[i][3] = 255;
+			}
+			return true;
+		case texture_format::bc5_unorm:
+			decode_bc4(block, texels, 0);
+			decode_bc4(block + 8, texels, 1);
+			for (uint32_t i = 0; i < BLOCK_TEXELS; ++i)
+			{
+				texels[i][2] = 0;
+				texels[i][3] = 255;
+			}
+			return true;
+		case texture_format::bc7_unorm:
+		case texture_format::bc7_unorm_srgb:
+			return decode_bc7(block, texels);
+		default:
+			return false;
+		}
+	}
+
+	uint32_t stored_channel_mask(texture_format format)
+	{
+		switch (format)
+		{
+		case texture_format::bc1_unorm:
+		case texture_format::bc1_unorm_srgb:
+			return 0x7;
+		case texture_format::bc4_unorm:
+			return 0x1;
+		case texture_format::bc5_unorm:
+			return 0x3;
+		default:
+			return 0xF;
+		}
+	}
+
+	bool is_rgba8(texture_format format)
+	{
+		return format == texture_format::r8g8b8a8_unorm || format == texture_format::r8g8b8a8_unorm_srgb ||
+			format == texture_format::b8g8r8a8_unorm || format == texture_format::b8g8r8a8_unorm_srgb;
+	}
+}
+
+texture_format select_compressed_format(texture_role role, bool has_alpha, compression_quality quality)
+{
+	switch (role)
+	{
+	case texture_role::normal:
+		return texture_format::bc5_unorm;
+	case texture_role::mask:
+		return texture_format::bc4_unorm;
+	case texture_role::albedo:
+	default:
+		if (quality == compression_quality::fast)
+		{
+			return has_alpha ? texture_format::bc3_unorm : texture_format::bc1_unorm;
+		}
+		return texture_format::bc7_unorm;
+	}
+}
+
+bool has_transparent_texels(const texture_image& image)
+{
+	if (!is_rgba8(image.format) || image.levels.empty())
+	{
+		return false;
+	}
+	const texture_image::level& level{ image.levels.at(0) };
+	const uint8_t* data{ image.data(0) };
+	for (uint32_t y = 0; y < level.height; ++y)
+	{
+		for (uint32_t x = 0; x < level.width; ++x)
+		{
+			if (data[static_cast<size_t>(y) * level.row_pitch + static_cast<size_t>(x) * 4 + 3] < 255)
+			{
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+bool compress_texture(const texture_image& source, texture_format format, compression_quality quality, texture_image& destination, compression_statistics* statistics)
+{
+	const std::chrono::steady_clock::time_point start{ std::chrono::steady_clock::now() };
+
+	if (!is_rgba8(source.format) || source.levels.empty())
+	{
+		return false;
+	}
+	if (!is_block_compressed(format) || format == texture_format::bc2_unorm || format == texture_format::bc2_unorm_srgb ||
+		format == texture_format::bc4_snorm || format == texture_format::bc5_snorm)
+	{
+		return false;
+	}
+	if (source.width % 4 != 0 || source.height % 4 != 0)
+	{
+		return false;
+	}
+
+	destination.allocate(source.width, source.height, format, static_cast<uint32_t>(source.levels.size()));
+	const uint32_t block_size{ bytes_per_element(format) };
+	for (size_t level_index = 0; level_index < source.levels.size(); ++level_index)
+	{
+		const texture_image::level& level{ destination.levels.at(level_index) };
+		const uint32_t blocks_x{ std::max<uint32_t>(1, (level.width + 3) / 4) };
+		const uint32_t blocks_y{ std::max<uint32_t>(1, (level.height + 3) / 4) };
+		uint8_t* blocks{ destination.data(level_index) };
+		default_thread_pool().parallel_for(blocks_y, [&](size_t block_y)
+		{
+			uint8_t texels[BLOCK_TEXELS][4];
+			for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+			{
+				fetch_block(source, level_index, block_x, static_cast<uint32_t>(block_y), texels);
+				encode_block(format, quality, texels, blocks + block_y * level.row_pitch + static_cast<size_t>(block_x) * block_size);
+			}
+		});
+	}
+
+	if (statistics)
+	{
+		statistics->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		statistics->source_bytes = source.texels.size();
+		statistics->compressed_bytes = destination.texels.size();
+
+		texture_image reference;
+		reference.allocate(source.width, source.height, texture_format::r8g8b8a8_unorm, static_cast<uint32_t>(source.levels.size()));
+		for (size_t level_index = 0; level_index < source.levels.size(); ++level_index)
+		{
+			const texture_image::level& level{ source.levels.at(level_index) };
+			const bool bgra{ source.format == texture_format::b8g8r8a8_unorm || source.format == texture_format::b8g8r8a8_unorm_srgb };
+			for (uint32_t y = 0; y < level.height; ++y)
+			{
+				const uint8_t* s{ source.data(level_index) + static_cast<size_t>(y) * level.row_pitch };
+				uint8_t* d{ reference.data(level_index) + static_cast<size_t>(y) * reference.levels.at(level_index).row_pitch };
+				for (uint32_t x = 0; x < level.width; ++x, s += 4, d += 4)
+				{
+					d[0] = s[bgra ? 2 : 0];
+					d[1] = s[1];
+					d[2] = s[bgra ? 0 : 2];
+					d[3] = s[3];
+				}
+			}
+		}
+		texture_image decompressed;
+		decompress_texture(destination, decompressed);
+		statistics->psnr = compute_psnr(reference, decompressed, stored_channel_mask(format), &statistics->mse);
+	}
+	return true;
+}
+
+bool decompress_texture(const texture_image& source, texture_image& destination)
+{
+	if (!is_block_compressed(source.format))
+	{
+		return false;
+	}
+	destination.allocate(source.width, source.height, texture_format::r8g8b8a8_unorm, static_cast<uint32_t>(source.levels.size()));
+	const uint32_t block_size{ bytes_per_element(source.format) };
+	bool succeeded{ true };
+	for (size_t level_index = 0; level_index < source.levels.size(); ++level_index)
+	{
+		const texture_image::level& level{ destination.levels.at(level_index) };
+		const texture_image::level& source_level{ source.levels.at(level_index) };
+		const uint32_t blocks_x{ std::max<uint32_t>(1, (level.width + 3) / 4) };
+		const uint32_t blocks_y{ std::max<uint32_t>(1, (level.height + 3) / 4) };
+		for (uint32_t block_y = 0; block_y < blocks_y; ++block_y)
+		{
+			for (uint32_t block_x = 0; block_x < blocks_x; ++block_x)
+			{
+				uint8_t texels[BLOCK_TEXELS][4]{};
+				succeeded &= decode_block(source.format, source.data(level_index) + static_cast<size_t>(block_y) * source_level.row_pitch + static_cast<size_t>(block_x) * block_size, texels);
+				for (uint32_t y = 0; y < 4 && block_y * 4 + y < level.height; ++y)
+				{
+					for (uint32_t x = 0; x < 4 && block_x * 4 + x < level.width; ++x)
+					{
+						memcpy(destination.data(level_index) + static_cast<size_t>(block_y * 4 + y) * level.row_pitch + static_cast<size_t>(block_x * 4 + x) * 4, texels[y * 4 + x], 4);
+					}
+				}
+			}
+		}
+	}
+	return succeeded;
+}
+
+double compute_psnr(const texture_image& reference, const texture_image& test, uint32_t channel_mask, double* mse)
+{
+	double squared_error{ 0 };
+	size_t samples{ 0 };
+	const size_t level_count{ std::min(reference.levels.size(), test.levels.size()) };
+	for (size_t level_index = 0; level_index < level_count; ++level_index)
+	{
+		const texture_image::level& level{ reference.levels.at(level_index) };
+		for (uint32_t y = 0; y < level.height; ++y)
+		{
+			const uint8_t* a{ reference.data(level_index) + static_cast<size_t>(y) * level.row_pitch };
+			const uint8_t* b{ test.data(level_index) + static_cast<size_t>(y) * test.levels.at(level_index).row_pitch };
+			for (uint32_t x = 0; x < level.width * 4; ++x)
+			{
+				if (channel_mask & (1u << (x & 3)))
+				{
+					const double d{ static_cast<double>(a[x]) - static_cast<double>(b[x]) };
+					squared_error += d * d;
+					++samples;
+				}
+			}
+		}
+	}
+	const double mean_squared_error{ samples > 0 ? squared_error / samples : 0.0 };
+	if (mse)
+	{
+		*mse = mean_squared_error;
+	}
+	return mean_squared_error > 0 ? 10.0 * std::log10(255.0 * 255.0 / mean_squared_error) : std::numeric_limits<double>::infinity();
+}
+
+bool cook_texture(const wchar_t* source_filename, texture_role role, compression_quality quality, compression_statistics* statistics)
+{
+	texture_image source;
+	if (!decode_texture_file(source_filename, source))
+	{
+		return false;
+	}
+	const texture_format format{ select_compressed_format(role, has_transparent_texels(source), quality) };
+	return cook_texture(source_filename, source, role, format, quality, statistics);
+}
+
+bool cook_texture(const wchar_t* source_filename, texture_image& source, texture_role role, texture_format format, compression_quality quality, compression_statistics* statistics)
+{
+	std::filesystem::path dds_filename(source_filename);
+	dds_filename.replace_extension("dds");
+	if (dds_filename == std::filesystem::path(source_filename))
+	{
+		return false; // would overwrite the source
+	}
+
+	if (source.levels.size() == 1)
+	{
+		generate_mipmaps(source, default_mipmap_options(role));
+	}
+
+	texture_image compressed;
+	if (!compress_texture(source, format, quality, compressed, statistics))
+	{
+		return false;
+	}
+
+	return save_dds_file(dds_filename.wstring().c_str(), compressed);
+}
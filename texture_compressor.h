@@ -0,0 +1,40 @@
+#pragma once
+
+#include "texture_image.h"
+
+// CPU block compression for the asset cooker. No Direct3D dependency.
+enum class compression_quality
+{
+	fast,	// endpoints from the principal axis only
+	normal,	// plus one least squares refinement
+	high,	// plus several refinements and exhaustive index/p-bit search
+};
+
+struct compression_statistics
+{
+	double mse{ 0 };	// mean squared error per stored channel, in 8 bit units
+	double psnr{ 0 };	// in dB, +infinity when lossless
+	size_t source_bytes{ 0 };
+	size_t compressed_bytes{ 0 };
+	double seconds{ 0 };
+};
+
+// albedo: BC7 (BC1 with the fast preset when there is no alpha), normal: BC5, mask: BC4.
+texture_format select_compressed_format(texture_role role, bool has_alpha, compression_quality quality);
+bool has_transparent_texels(const texture_image& image);
+
+// 'source' must be R8G8B8A8 or B8G8R8A8 and level 0 must be a multiple of 4 in both directions, as Direct3D requires for BC formats.
+// Every level of 'source' is compressed; rows of blocks are spread over the thread pool.
+bool compress_texture(const texture_image& source, texture_format format, compression_quality quality, texture_image& destination, compression_statistics* statistics = nullptr);
+
+// Expands BC1/BC3/BC4/BC5 and the BC7 blocks written by compress_texture back to R8G8B8A8.
+bool decompress_texture(const texture_image& source, texture_image& destination);
+
+// PSNR over the channels selected by 'channel_mask' (bit 0:R, 1:G, 2:B, 3:A) of two R8G8B8A8 images with the same layout.
+double compute_psnr(const texture_image& reference, const texture_image& test, uint32_t channel_mask, double* mse = nullptr);
+
+// Decodes 'source_filename', completes its mip chain, compresses it for 'role' and writes the result next to it with a .dds extension,
+// which is where load_texture_from_file looks first.
+bool cook_texture(const wchar_t* source_filename, texture_role role, compression_quality quality, compression_statistics* statistics = nullptr);
+// The same for 'source', already decoded from 'source_filename', compressed to 'format'. A single level 'source' gets its mip chain in place.
+bool cook_texture(const wchar_t* source_filename, texture_image& source, texture_role role, texture_format format, compression_quality quality, compression_statistics* statistics = nullptr);
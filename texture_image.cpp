@@ -0,0 +1,403 @@
+#include "texture_image.h"
+
+#include <algorithm>
+#include <cstring>
+#include <cwctype>
+#include <string>
+#include <fstream>
+#include <filesystem>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <wincodec.h>
+#include <wrl.h>
+#endif
+
+bool is_block_compressed(texture_format format)
+{
+	switch (format)
+	{
+	case texture_format::bc1_unorm:
+	case texture_format::bc1_unorm_srgb:
+	case texture_format::bc2_unorm:
+	case texture_format::bc2_unorm_srgb:
+	case texture_format::bc3_unorm:
+	case texture_format::bc3_unorm_srgb:
+	case texture_format::bc4_unorm:
+	case texture_format::bc4_snorm:
+	case texture_format::bc5_unorm:
+	case texture_format::bc5_snorm:
+	case texture_format::bc7_unorm:
+	case texture_format::bc7_unorm_srgb:
+		return true;
+	default:
+		return false;
+	}
+}
+
+uint32_t bytes_per_element(texture_format format)
+{
+	switch (format)
+	{
+	case texture_format::r8g8b8a8_unorm:
+	case texture_format::r8g8b8a8_unorm_srgb:
+	case texture_format::b8g8r8a8_unorm:
+	case texture_format::b8g8r8a8_unorm_srgb:
+		return 4;
+	case texture_format::bc1_unorm:
+	case texture_format::bc1_unorm_srgb:
+	case texture_format::bc4_unorm:
+	case texture_format::bc4_snorm:
+		return 8;
+	case texture_format::bc2_unorm:
+	case texture_format::bc2_unorm_srgb:
+	case texture_format::bc3_unorm:
+	case texture_format::bc3_unorm_srgb:
+	case texture_format::bc5_unorm:
+	case texture_format::bc5_snorm:
+	case texture_format::bc7_unorm:
+	case texture_format::bc7_unorm_srgb:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+uint32_t compute_row_pitch(texture_format format, uint32_t width)
+{
+	if (is_block_compressed(format))
+	{
+		return std::max<uint32_t>(1, (width + 3) / 4) * bytes_per_element(format);
+	}
+	return width * bytes_per_element(format);
+}
+
+size_t compute_level_size(texture_format format, uint32_t width, uint32_t height)
+{
+	const size_t rows{ is_block_compressed(format) ? std::max<uint32_t>(1, (height + 3) / 4) : height };
+	return rows * compute_row_pitch(format, width);
+}
+
+uint32_t compute_full_mip_count(uint32_t width, uint32_t height)
+{
+	uint32_t mip_count{ 1 };
+	while (width > 1 || height > 1)
+	{
+		width = std::max<uint32_t>(1, width / 2);
+		height = std::max<uint32_t>(1, height / 2);
+		++mip_count;
+	}
+	return mip_count;
+}
+
+void texture_image::allocate(uint32_t width, uint32_t height, texture_format format, uint32_t level_count)
+{
+	this->width = width;
+	this->height = height;
+	this->format = format;
+
+	const uint32_t full_mip_count{ compute_full_mip_count(width, height) };
+	level_count = level_count == 0 ? full_mip_count : std::min(level_count, full_mip_count);
+
+	levels.resize(level_count);
+	size_t offset{ 0 };
+	for (level& level : levels)
+	{
+		level.width = width;
+		level.height = height;
+		level.row_pitch = compute_row_pitch(format, width);
+		level.offset = offset;
+		level.size = compute_level_size(format, width, height);
+		offset += level.size;
+
+		width = std::max<uint32_t>(1, width / 2);
+		height = std::max<uint32_t>(1, height / 2);
+	}
+	texels.resize(offset);
+}
+
+namespace
+{
+	const uint32_t DDS_MAGIC{ 0x20534444 }; // "DDS "
+	const uint32_t DDS_FOURCC{ 0x00000004 };
+	const uint32_t DDS_HEADER_FLAGS_TEXTURE{ 0x00001007 }; // CAPS | HEIGHT | WIDTH | PIXELFORMAT
+	const uint32_t DDS_HEADER_FLAGS_MIPMAP{ 0x00020000 };
+	const uint32_t DDS_HEADER_FLAGS_LINEARSIZE{ 0x00080000 };
+	const uint32_t DDS_HEADER_FLAGS_PITCH{ 0x00000008 };
+	const uint32_t DDS_SURFACE_FLAGS_TEXTURE{ 0x00001000 };
+	const uint32_t DDS_SURFACE_FLAGS_MIPMAP{ 0x00400008 }; // COMPLEX | MIPMAP
+	const uint32_t DDS_RGB{ 0x00000040 };
+	const uint32_t DDS_CAPS2_CUBEMAP{ 0x00000200 };
+	const uint32_t DDS_CAPS2_VOLUME{ 0x00200000 };
+	const uint32_t DDS_DIMENSION_TEXTURE2D{ 3 };
+
+	constexpr uint32_t make_fourcc(char c0, char c1, char c2, char c3)
+	{
+		return static_cast<uint32_t>(static_cast<uint8_t>(c0)) | (static_cast<uint32_t>(static_cast<uint8_t>(c1)) << 8) |
+			(static_cast<uint32_t>(static_cast<uint8_t>(c2)) << 16) | (static_cast<uint32_t>(static_cast<uint8_t>(c3)) << 24);
+	}
+
+#pragma pack(push, 1)
+	struct dds_pixel_format
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t fourcc;
+		uint32_t rgb_bit_count;
+		uint32_t r_bit_mask;
+		uint32_t g_bit_mask;
+		uint32_t b_bit_mask;
+		uint32_t a_bit_mask;
+	};
+	struct dds_header
+	{
+		uint32_t size;
+		uint32_t flags;
+		uint32_t height;
+		uint32_t width;
+		uint32_t pitch_or_linear_size;
+		uint32_t depth;
+		uint32_t mip_map_count;
+		uint32_t reserved1[11];
+		dds_pixel_format pixel_format;
+		uint32_t caps;
+		uint32_t caps2;
+		uint32_t caps3;
+		uint32_t caps4;
+		uint32_t reserved2;
+	};
+	struct dds_header_dxt10
+	{
+		uint32_t dxgi_format;
+		uint32_t resource_dimension;
+		uint32_t misc_flag;
+		uint32_t array_size;
+		uint32_t misc_flags2;
+	};
+#pragma pack(pop)
+	static_assert(sizeof(dds_header) == 124, "The size of DDS_HEADER must be 124 bytes.");
+	static_assert(sizeof(dds_header_dxt10) == 20, "The size of DDS_HEADER_DXT10 must be 20 bytes.");
+
+	texture_format format_from_pixel_format(const dds_pixel_format& pixel_format)
+	{
+		if (pixel_format.flags & DDS_FOURCC)
+		{
+			switch (pixel_format.fourcc)
+			{
+			case make_fourcc('D', 'X', 'T', '1'): return texture_format::bc1_unorm;
+			case make_fourcc('D', 'X', 'T', '2'):
+			case make_fourcc('D', 'X', 'T', '3'): return texture_format::bc2_unorm;
+			case make_fourcc('D', 'X', 'T', '4'):
+			case make_fourcc('D', 'X', 'T', '5'): return texture_format::bc3_unorm;
+			case make_fourcc('A', 'T', 'I', '1'):
+			case make_fourcc('B', 'C', '4', 'U'): return texture_format::bc4_unorm;
+			case make_fourcc('B', 'C', '4', 'S'): return texture_format::bc4_snorm;
+			case make_fourcc('A', 'T', 'I', '2'):
+			case make_fourcc('B', 'C', '5', 'U'): return texture_format::bc5_unorm;
+			case make_fourcc('B', 'C', '5', 'S'): return texture_format::bc5_snorm;
+			}
+			return texture_format::unknown;
+		}
+		if ((pixel_format.flags & DDS_RGB) && pixel_format.rgb_bit_count == 32)
+		{
+			if (pixel_format.r_bit_mask == 0x000000ff && pixel_format.g_bit_mask == 0x0000ff00 && pixel_format.b_bit_mask == 0x00ff0000)
+			{
+				return texture_format::r8g8b8a8_unorm;
+			}
+			if (pixel_format.r_bit_mask == 0x00ff0000 && pixel_format.g_bit_mask == 0x0000ff00 && pixel_format.b_bit_mask == 0x000000ff)
+			{
+				return texture_format::b8g8r8a8_unorm;
+			}
+		}
+		return texture_format::unknown;
+	}
+
+	bool read_file(const wchar_t* filename, std::vector<uint8_t>& bytes)
+	{
+		std::ifstream ifs(std::filesystem::path(filename), std::ios::binary | std::ios::ate);
+		if (!ifs)
+		{
+			return false;
+		}
+		const std::streamoff size{ ifs.tellg() };
+		if (size <= 0)
+		{
+			return false;
+		}
+		bytes.resize(static_cast<size_t>(size));
+		ifs.seekg(0, std::ios::beg);
+		return static_cast<bool>(ifs.read(reinterpret_cast<char*>(bytes.data()), size));
+	}
+
+#ifdef _WIN32
+	// WIC objects are free threaded, but every thread that creates them needs COM.
+	struct com_apartment
+	{
+		HRESULT hr{ CoInitializeEx(nullptr, COINIT_MULTITHREADED) };
+		~com_apartment()
+		{
+			if (SUCCEEDED(hr))
+			{
+				CoUninitialize();
+			}
+		}
+	};
+
+	bool decode_wic(const wchar_t* filename, texture_image& image)
+	{
+		thread_local com_apartment apartment;
+
+		using Microsoft::WRL::ComPtr;
+		HRESULT hr{ S_OK };
+
+		ComPtr<IWICImagingFactory> factory;
+		hr = CoCreateInstance(CLSID_WICImagingFactory, nullptr, CLSCTX_INPROC_SERVER, IID_PPV_ARGS(factory.GetAddressOf()));
+		if (FAILED(hr)) return false;
+
+		ComPtr<IWICBitmapDecoder> decoder;
+		hr = factory->CreateDecoderFromFilename(filename, nullptr, GENERIC_READ, WICDecodeMetadataCacheOnDemand, decoder.GetAddressOf());
+		if (FAILED(hr)) return false;
+
+		ComPtr<IWICBitmapFrameDecode> frame;
+		hr = decoder->GetFrame(0, frame.GetAddressOf());
+		if (FAILED(hr)) return false;
+
+		UINT width{ 0 }, height{ 0 };
+		hr = frame->GetSize(&width, &height);
+		if (FAILED(hr) || width == 0 || height == 0) return false;
+
+		ComPtr<IWICFormatConverter> converter;
+		hr = factory->CreateFormatConverter(converter.GetAddressOf());
+		if (FAILED(hr)) return false;
+		hr = converter->Initialize(frame.Get(), GUID_WICPixelFormat32bppRGBA, WICBitmapDitherTypeNone, nullptr, 0.0, WICBitmapPaletteTypeMediumCut);
+		if (FAILED(hr)) return false;
+
+		image.allocate(width, height, texture_format::r8g8b8a8_unorm, 1);
+		const texture_image::level& level{ image.levels.at(0) };
+		hr = converter->CopyPixels(nullptr, level.row_pitch, static_cast<UINT>(level.size), image.data(0));
+		return SUCCEEDED(hr);
+	}
+#endif
+}
+
+bool decode_dds(const uint8_t* data, size_t size, texture_image& image)
+{
+	if (size < sizeof(uint32_t) + sizeof(dds_header))
+	{
+		return false;
+	}
+	uint32_t magic;
+	memcpy(&magic, data, sizeof(magic));
+	if (magic != DDS_MAGIC)
+	{
+		return false;
+	}
+	dds_header header;
+	memcpy(&header, data + sizeof(magic), sizeof(header));
+	if (header.size != sizeof(dds_header) || header.pixel_format.size != sizeof(dds_pixel_format))
+	{
+		return false;
+	}
+	if (header.caps2 & (DDS_CAPS2_CUBEMAP | DDS_CAPS2_VOLUME))
+	{
+		return false;
+	}
+
+	size_t offset{ sizeof(magic) + sizeof(header) };
+	texture_format format{ texture_format::unknown };
+	if ((header.pixel_format.flags & DDS_FOURCC) && header.pixel_format.fourcc == make_fourcc('D', 'X', '1', '0'))
+	{
+		if (size < offset + sizeof(dds_header_dxt10))
+		{
+			return false;
+		}
+		dds_header_dxt10 header_dxt10;
+		memcpy(&header_dxt10, data + offset, sizeof(header_dxt10));
+		offset += sizeof(header_dxt10);
+		if (header_dxt10.resource_dimension != DDS_DIMENSION_TEXTURE2D || header_dxt10.array_size > 1 || (header_dxt10.misc_flag & 0x4/*TEXTURECUBE*/))
+		{
+			return false;
+		}
+		format = static_cast<texture_format>(header_dxt10.dxgi_format);
+	}
+	else
+	{
+		format = format_from_pixel_format(header.pixel_format);
+	}
+	if (bytes_per_element(format) == 0 || header.width == 0 || header.height == 0)
+	{
+		return false;
+	}
+
+	image.allocate(header.width, header.height, format, std::max<uint32_t>(1, header.mip_map_count));
+	if (size < offset + image.texels.size())
+	{
+		return false;
+	}
+	memcpy(image.texels.data(), data + offset, image.texels.size());
+	return true;
+}
+
+bool decode_texture_file(const wchar_t* filename, texture_image& image)
+{
+	std::wstring extension{ std::filesystem::path(filename).extension().wstring() };
+	std::transform(extension.begin(), extension.end(), extension.begin(), [](wchar_t c) { return static_cast<wchar_t>(towlower(c)); });
+	if (extension == L".dds")
+	{
+		std::vector<uint8_t> bytes;
+		return read_file(filename, bytes) && decode_dds(bytes.data(), bytes.size(), image);
+	}
+#ifdef _WIN32
+	return decode_wic(filename, image);
+#else
+	return false;
+#endif
+}
+
+bool encode_dds(const texture_image& image, std::vector<uint8_t>& bytes)
+{
+	if (bytes_per_element(image.format) == 0 || image.levels.empty())
+	{
+		return false;
+	}
+
+	dds_header header{};
+	header.size = sizeof(dds_header);
+	header.flags = DDS_HEADER_FLAGS_TEXTURE | (image.levels.size() > 1 ? DDS_HEADER_FLAGS_MIPMAP : 0) |
+		(is_block_compressed(image.format) ? DDS_HEADER_FLAGS_LINEARSIZE : DDS_HEADER_FLAGS_PITCH);
+	header.height = image.height;
+	header.width = image.width;
+	header.pitch_or_linear_size = is_block_compressed(image.format) ? static_cast<uint32_t>(image.levels.at(0).size) : image.levels.at(0).row_pitch;
+	header.mip_map_count = static_cast<uint32_t>(image.levels.size());
+	header.pixel_format.size = sizeof(dds_pixel_format);
+	header.pixel_format.flags = DDS_FOURCC;
+	header.pixel_format.fourcc = make_fourcc('D', 'X', '1', '0');
+	header.caps = DDS_SURFACE_FLAGS_TEXTURE | (image.levels.size() > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+	dds_header_dxt10 header_dxt10{};
+	header_dxt10.dxgi_format = static_cast<uint32_t>(image.format);
+	header_dxt10.resource_dimension = DDS_DIMENSION_TEXTURE2D;
+	header_dxt10.array_size = 1;
+
+	bytes.resize(sizeof(DDS_MAGIC) + sizeof(header) + sizeof(header_dxt10) + image.texels.size());
+	uint8_t* p{ bytes.data() };
+	memcpy(p, &DDS_MAGIC, sizeof(DDS_MAGIC));
+	p += sizeof(DDS_MAGIC);
+	memcpy(p, &header, sizeof(header));
+	p += sizeof(header);
+	memcpy(p, &header_dxt10, sizeof(header_dxt10));
+	p += sizeof(header_dxt10);
+	memcpy(p, image.texels.data(), image.texels.size());
+	return true;
+}
+
+bool save_dds_file(const wchar_t* filename, const texture_image& image)
+{
+	std::vector<uint8_t> bytes;
+	if (!encode_dds(image, bytes))
+	{
+		return false;
+	}
+	std::ofstream ofs(std::filesystem::path(filename), std::ios::binary);
+	return ofs && ofs.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+}
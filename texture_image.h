@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+// The values are those of DXGI_FORMAT so an image can be handed to Direct3D without translation,
+// but this header does not depend on any Windows header.
+enum class texture_format : uint32_t
+{
+	unknown = 0,
+	r8g8b8a8_unorm = 28,
+	r8g8b8a8_unorm_srgb = 29,
+	bc1_unorm = 71,
+	bc1_unorm_srgb = 72,
+	bc2_unorm = 74,
+	bc2_unorm_srgb = 75,
+	bc3_unorm = 77,
+	bc3_unorm_srgb = 78,
+	bc4_unorm = 80,
+	bc4_snorm = 81,
+	bc5_unorm = 83,
+	bc5_snorm = 84,
+	b8g8r8a8_unorm = 87,
+	b8g8r8a8_unorm_srgb = 91,
+	bc7_unorm = 98,
+	bc7_unorm_srgb = 99,
+};
+
+// How a material uses a texture. It decides the compressed format and how the mip chain is filtered.
+enum class texture_role
+{
+	albedo, // texture_filenames[0]
+	normal, // texture_filenames[1]
+	mask,
+};
+
+bool is_block_compressed(texture_format format);
+// Bytes per 4x4 block for block compressed formats, bytes per texel otherwise. 0 if the format is not supported.
+uint32_t bytes_per_element(texture_format format);
+uint32_t compute_row_pitch(texture_format format, uint32_t width);
+size_t compute_level_size(texture_format format, uint32_t width, uint32_t height);
+
+// A decoded 2D texture with its mip chain held in system memory.
+struct texture_image
+{
+	struct level
+	{
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint32_t row_pitch{ 0 }; // in bytes, a row of blocks for block compressed formats
+		size_t offset{ 0 }; // in bytes, from the start of 'texels'
+		size_t size{ 0 };
+	};
+
+	uint32_t width{ 0 };
+	uint32_t height{ 0 };
+	texture_format format{ texture_format::unknown };
+	std::vector<level> levels;
+	std::vector<uint8_t> texels;
+
+	// 'level_count' 0 allocates the complete chain down to 1x1.
+	void allocate(uint32_t width, uint32_t height, texture_format format, uint32_t level_count = 1);
+
+	uint8_t* data(size_t level_index) { return texels.data() + levels.at(level_index).offset; }
+	const uint8_t* data(size_t level_index) const { return texels.data() + levels.at(level_index).offset; }
+};
+
+uint32_t compute_full_mip_count(uint32_t width, uint32_t height);
+
+// Decodes a DDS file image held in memory. Only single 2D textures in the formats above are accepted;
+// cube maps, arrays and volume textures are rejected so the caller can fall back to DDSTextureLoader.
+bool decode_dds(const uint8_t* data, size_t size, texture_image& image);
+
+// Decodes 'filename' into system memory. DDS files are parsed directly, any other format goes through WIC
+// (Windows only) and is converted to R8G8B8A8_UNORM. Safe to call from any thread.
+bool decode_texture_file(const wchar_t* filename, texture_image& image);
+
+// Writes 'image' as a DDS file image with a DX10 header.
+bool encode_dds(const texture_image& image, std::vector<uint8_t>& bytes);
+bool save_dds_file(const wchar_t* filename, const texture_image& image);
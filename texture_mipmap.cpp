@@ -0,0 +1,283 @@
+#include "texture_mipmap.h"
+#include "thread_pool.h"
+
+#include <directxmath.h>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace DirectX;
+
+namespace
+{
+	const double KAISER_RADIUS{ 3.0 };	// in destination texels
+	const double KAISER_ALPHA{ 4.0 };
+	const uint32_t LINEAR_TO_SRGB_ENTRIES{ 16384 };
+
+	struct srgb_tables
+	{
+		float to_linear[256];
+		uint8_t to_srgb[LINEAR_TO_SRGB_ENTRIES];
+		srgb_tables()
+		{
+			for (uint32_t i = 0; i < 256; ++i)
+			{
+				const float c{ i / 255.0f };
+				to_linear[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+			}
+			for (uint32_t i = 0; i < LINEAR_TO_SRGB_ENTRIES; ++i)
+			{
+				const float c{ static_cast<float>(i) / (LINEAR_TO_SRGB_ENTRIES - 1) };
+				const float encoded{ c <= 0.0031308f ? c * 12.92f : 1.055f * std::pow(c, 1.0f / 2.4f) - 0.055f };
+				to_srgb[i] = static_cast<uint8_t>(std::clamp(encoded, 0.0f, 1.0f) * 255.0f + 0.5f);
+			}
+		}
+	};
+	const srgb_tables& get_srgb_tables()
+	{
+		static const srgb_tables tables;
+		return tables;
+	}
+
+	double bessel_i0(double x)
+	{
+		double sum{ 1.0 };
+		double term{ 1.0 };
+		for (int k = 1; k < 32; ++k)
+		{
+			term *= (x / (2.0 * k)) * (x / (2.0 * k));
+			sum += term;
+			if (term < sum * 1e-12)
+			{
+				break;
+			}
+		}
+		return sum;
+	}
+	double kaiser_sinc(double t)
+	{
+		if (std::fabs(t) >= KAISER_RADIUS)
+		{
+			return 0.0;
+		}
+		const double pi{ 3.14159265358979323846 };
+		const double sinc{ t == 0.0 ? 1.0 : std::sin(pi * t) / (pi * t) };
+		const double r{ t / KAISER_RADIUS };
+		return sinc * bessel_i0(KAISER_ALPHA * std::sqrt(1.0 - r * r)) / bessel_i0(KAISER_ALPHA);
+	}
+
+	// The source texels (and weights) that make up each destination texel along one axis.
+	struct filter_kernel
+	{
+		struct taps
+		{
+			uint32_t first;
+			uint32_t count;
+			size_t weight_offset;
+		};
+		std::vector<taps> texels;
+		std::vector<float> weights;
+	};
+	filter_kernel build_kernel(uint32_t source_size, uint32_t destination_size, mipmap_filter filter)
+	{
+		filter_kernel kernel;
+		kernel.texels.reserve(destination_size);
+		const double scale{ static_cast<double>(source_size) / destination_size };
+		const double support{ filter == mipmap_filter::box ? scale * 0.5 : KAISER_RADIUS * scale };
+		std::vector<double> raw(source_size);
+		for (uint32_t i = 0; i < destination_size; ++i)
+		{
+			const double center{ (i + 0.5) * scale };
+			const int64_t lowest{ static_cast<int64_t>(std::floor(center - support)) };
+			const int64_t highest{ static_cast<int64_t>(std::ceil(center + support)) };
+			uint32_t first{ source_size };
+			uint32_t last{ 0 };
+			for (int64_t j = lowest; j <= highest; ++j)
+			{
+				double weight;
+				if (filter == mipmap_filter::box)
+				{
+					weight = std::max(0.0, std::min(center + support, static_cast<double>(j + 1)) - std::max(center - support, static_cast<double>(j)));
+				}
+				else
+				{
+					weight = kaiser_sinc((j + 0.5 - center) / scale);
+				}
+				if (weight == 0.0)
+				{
+					continue;
+				}
+				// Clamp to edge.
+				const uint32_t texel{ static_cast<uint32_t>(std::clamp<int64_t>(j, 0, static_cast<int64_t>(source_size) - 1)) };
+				if (first > last)
+				{
+					first = last = texel;
+					raw.at(texel) = 0.0;
+				}
+				while (texel < first)
+				{
+					raw.at(--first) = 0.0;
+				}
+				while (texel > last)
+				{
+					raw.at(++last) = 0.0;
+				}
+				raw.at(texel) += weight;
+			}
+
+			double sum{ 0.0 };
+			for (uint32_t j = first; j <= last; ++j)
+			{
+				sum += raw.at(j);
+			}
+			kernel.texels.push_back({ first, last - first + 1, kernel.weights.size() });
+			for (uint32_t j = first; j <= last; ++j)
+			{
+				kernel.weights.push_back(static_cast<float>(raw.at(j) / sum));
+			}
+		}
+		return kernel;
+	}
+
+	// Separable resampling of a float RGBA level.
+	void resample(const std::vector<XMFLOAT4>& source, uint32_t source_width, uint32_t source_height,
+		std::vector<XMFLOAT4>& destination, uint32_t destination_width, uint32_t destination_height, mipmap_filter filter)
+	{
+		const filter_kernel horizontal{ build_kernel(source_width, destination_width, filter) };
+		const filter_kernel vertical{ build_kernel(source_height, destination_height, filter) };
+
+		std::vector<XMFLOAT4> intermediate(static_cast<size_t>(destination_width) * source_height);
+		default_thread_pool().parallel_for(source_height, [&](size_t y)
+		{
+			const XMFLOAT4* row{ source.data() + y * source_width };
+			XMFLOAT4* output{ intermediate.data() + y * destination_width };
+			for (uint32_t x = 0; x < destination_width; ++x)
+			{
+				const filter_kernel::taps& taps{ horizontal.texels.at(x) };
+				const float* weights{ horizontal.weights.data() + taps.weight_offset };
+				XMVECTOR sum{ XMVectorZero() };
+				for (uint32_t k = 0; k < taps.count; ++k)
+				{
+					sum = XMVectorMultiplyAdd(XMLoadFloat4(row + taps.first + k), XMVectorReplicate(weights[k]), sum);
+				}
+				XMStoreFloat4(output + x, sum);
+			}
+		});
+
+		destination.resize(static_cast<size_t>(destination_width) * destination_height);
+		default_thread_pool().parallel_for(destination_height, [&](size_t y)
+		{
+			const filter_kernel::taps& taps{ vertical.texels.at(y) };
+			const float* weights{ vertical.weights.data() + taps.weight_offset };
+			XMFLOAT4* output{ destination.data() + y * destination_width };
+			for (uint32_t x = 0; x < destination_width; ++x)
+			{
+				XMVECTOR sum{ XMVectorZero() };
+				for (uint32_t k = 0; k < taps.count; ++k)
+				{
+					sum = XMVectorMultiplyAdd(XMLoadFloat4(intermediate.data() + static_cast<size_t>(taps.first + k) * destination_width + x), XMVectorReplicate(weights[k]), sum);
+				}
+				// Kaiser lobes can overshoot.
+				XMStoreFloat4(output + x, XMVectorSaturate(sum));
+			}
+		});
+	}
+
+	void renormalize(std::vector<XMFLOAT4>& texels)
+	{
+		const XMVECTOR two{ XMVectorReplicate(2.0f) };
+		const XMVECTOR one{ XMVectorReplicate(1.0f) };
+		const XMVECTOR half{ XMVectorReplicate(0.5f) };
+		default_thread_pool().parallel_for(texels.size(), [&](size_t i)
+		{
+			const XMVECTOR texel{ XMLoadFloat4(&texels.at(i)) };
+			XMVECTOR normal{ XMVectorSubtract(XMVectorMultiply(texel, two), one) };
+			if (XMVectorGetX(XMVector3LengthSq(normal)) > 1e-8f)
+			{
+				normal = XMVector3Normalize(normal);
+			}
+			XMStoreFloat4(&texels.at(i), XMVectorSelect(texel, XMVectorMultiplyAdd(normal, half, half), g_XMSelect1110));
+		}, 4096);
+	}
+}
+
+mipmap_options default_mipmap_options(texture_role role)
+{
+	mipmap_options options;
+	options.srgb = role == texture_role::albedo;
+	options.normal_map = role == texture_role::normal;
+	return options;
+}
+
+bool generate_mipmaps(texture_image& image, const mipmap_options& options)
+{
+	if (image.format != texture_format::r8g8b8a8_unorm && image.format != texture_format::r8g8b8a8_unorm_srgb &&
+		image.format != texture_format::b8g8r8a8_unorm && image.format != texture_format::b8g8r8a8_unorm_srgb)
+	{
+		return false;
+	}
+	if (image.levels.empty())
+	{
+		return false;
+	}
+	const srgb_tables& tables{ get_srgb_tables() };
+	// sRGB formats are decoded by the sampler anyway, so honour them as well as the option.
+	const bool srgb{ options.srgb || image.format == texture_format::r8g8b8a8_unorm_srgb || image.format == texture_format::b8g8r8a8_unorm_srgb };
+
+	texture_image result;
+	result.allocate(image.width, image.height, image.format, 0);
+	const texture_image::level& base{ image.levels.at(0) };
+	for (uint32_t y = 0; y < base.height; ++y)
+	{
+		std::copy_n(image.data(0) + static_cast<size_t>(y) * base.row_pitch, static_cast<size_t>(base.width) * 4, result.data(0) + static_cast<size_t>(y) * result.levels.at(0).row_pitch);
+	}
+
+	// R, G and B are converted alike so B8G8R8A8 needs no swizzle.
+	std::vector<XMFLOAT4> source(static_cast<size_t>(base.width) * base.height);
+	default_thread_pool().parallel_for(base.height, [&](size_t y)
+	{
+		const uint8_t* texel{ image.data(0) + y * base.row_pitch };
+		XMFLOAT4* output{ source.data() + y * base.width };
+		for (uint32_t x = 0; x < base.width; ++x, texel += 4)
+		{
+			output[x].x = srgb ? tables.to_linear[texel[0]] : texel[0] / 255.0f;
+			output[x].y = srgb ? tables.to_linear[texel[1]] : texel[1] / 255.0f;
+			output[x].z = srgb ? tables.to_linear[texel[2]] : texel[2] / 255.0f;
+			output[x].w = texel[3] / 255.0f;
+		}
+	});
+
+	std::vector<XMFLOAT4> destination;
+	for (size_t level_index = 1; level_index < result.levels.size(); ++level_index)
+	{
+		const texture_image::level& upper{ result.levels.at(level_index - 1) };
+		const texture_image::level& level{ result.levels.at(level_index) };
+		resample(source, upper.width, upper.height, destination, level.width, level.height, options.filter);
+		if (options.normal_map)
+		{
+			renormalize(destination);
+		}
+
+		default_thread_pool().parallel_for(level.height, [&](size_t y)
+		{
+			const XMFLOAT4* texel{ destination.data() + y * level.width };
+			uint8_t* output{ result.data(level_index) + y * level.row_pitch };
+			for (uint32_t x = 0; x < level.width; ++x, ++texel, output += 4)
+			{
+				const float* channels{ &texel->x };
+				for (int channel = 0; channel < 3; ++channel)
+				{
+					output[channel] = srgb ?
+						tables.to_srgb[static_cast<uint32_t>(channels[channel] * (LINEAR_TO_SRGB_ENTRIES - 1) + 0.5f)] :
+						static_cast<uint8_t>(channels[channel] * 255.0f + 0.5f);
+				}
+				output[3] = static_cast<uint8_t>(texel->w * 255.0f + 0.5f);
+			}
+		});
+		source.swap(destination);
+	}
+
+	image = std::move(result);
+	return true;
+}
@@ -0,0 +1,26 @@
+#pragma once
+
+#include "texture_image.h"
+
+// CPU mip chain generation. No Direct3D dependency.
+enum class mipmap_filter
+{
+	box,	// exact area average
+	kaiser,	// Kaiser windowed sinc, sharper at a distance
+};
+
+struct mipmap_options
+{
+	mipmap_filter filter{ mipmap_filter::kaiser };
+	bool srgb{ false };			// RGB are sRGB encoded and are filtered in linear space. Alpha is always linear.
+	bool normal_map{ false };	// RGB hold a tangent space normal (x * 0.5 + 0.5) that is renormalized on every level.
+};
+
+// albedo: sRGB, normal: renormalized, mask: plain linear. The pipeline samples UNORM views and
+// applies the gamma in the pixel shader, so albedo is still stored sRGB encoded in every level.
+mipmap_options default_mipmap_options(texture_role role);
+
+// Replaces the chain of an R8G8B8A8 or B8G8R8A8 image with level 0 followed by a complete chain down to 1x1.
+// Every level is filtered from the one above it; the rows of a level are spread over the thread pool.
+// Returns false (and leaves the image alone) for other formats.
+bool generate_mipmaps(texture_image& image, const mipmap_options& options);
@@ -0,0 +1,223 @@
+#include "texture_residency.h"
+
+#include <algorithm>
+#include <cmath>
+#include <queue>
+
+using namespace DirectX;
+
+float compute_screen_diameter(const XMFLOAT3 bounding_box[2], const XMFLOAT4X4& world, const XMFLOAT4& camera_position, float projection_y_scale, float viewport_height)
+{
+	const XMVECTOR minimum{ XMLoadFloat3(&bounding_box[0]) };
+	const XMVECTOR maximum{ XMLoadFloat3(&bounding_box[1]) };
+	const XMMATRIX W{ XMLoadFloat4x4(&world) };
+
+	const XMVECTOR center{ XMVector3TransformCoord(XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f), W) };
+	const float scale{ std::max({ XMVectorGetX(XMVector3Length(W.r[0])), XMVectorGetX(XMVector3Length(W.r[1])), XMVectorGetX(XMVector3Length(W.r[2])) }) };
+	const float radius{ XMVectorGetX(XMVector3Length(XMVectorSubtract(maximum, minimum))) * 0.5f * scale };
+	const float distance{ XMVectorGetX(XMVector3Length(XMVectorSubtract(center, XMLoadFloat4(&camera_position)))) };
+	if (distance <= radius)
+	{
+		// The camera is inside the bounds: treat the object as filling the screen several times over.
+		return viewport_height * 4.0f;
+	}
+	return radius * projection_y_scale * viewport_height / distance;
+}
+
+uint32_t compute_desired_mip(uint32_t width, uint32_t height, uint32_t mip_count, float screen_diameter, float texel_density)
+{
+	if (mip_count == 0)
+	{
+		return 0;
+	}
+	if (screen_diameter <= 0.0f)
+	{
+		return mip_count - 1;
+	}
+	const float texels{ static_cast<float>(std::max(width, height)) * texel_density };
+	const float ratio{ texels / screen_diameter };
+	const uint32_t mip{ ratio > 1.0f ? static_cast<uint32_t>(std::floor(std::log2(ratio))) : 0 };
+	return std::min(mip, mip_count - 1);
+}
+
+texture_residency::texture_residency(size_t budget_bytes, uint32_t tail_dimension, uint32_t eviction_delay_frames) :
+	budget_bytes(budget_bytes), tail_dimension(tail_dimension), eviction_delay_frames(eviction_delay_frames)
+{
+}
+
+size_t texture_residency::add_texture(uint32_t width, uint32_t height, uint32_t mip_count, texture_format format)
+{
+	texture texture;
+	texture.active = true;
+	texture.width = width;
+	texture.height = height;
+	texture.mip_count = std::max<uint32_t>(mip_count, 1);
+	texture.format = format;
+
+	uint32_t tail_mip{ 0 };
+	while (tail_mip + 1 < texture.mip_count && std::max(width >> tail_mip, height >> tail_mip) > tail_dimension)
+	{
+		++tail_mip;
+	}
+	if (is_block_compressed(format))
+	{
+		// A texture starting at any of the streamed levels must still have a width and height that are multiples of 4.
+		while (tail_mip > 0 && (width % (4u << tail_mip) != 0 || height % (4u << tail_mip) != 0))
+		{
+			--tail_mip;
+		}
+	}
+	texture.tail_mip = tail_mip;
+	texture.resident_mip = tail_mip;
+	texture.target_mip = tail_mip;
+
+	textures.push_back(texture);
+	return textures.size() - 1;
+}
+
+void texture_residency::remove_texture(size_t id)
+{
+	textures.at(id).active = false;
+}
+
+void texture_residency::request(size_t id, uint32_t mip, float priority)
+{
+	texture& texture{ textures.at(id) };
+	if (texture.last_request_frame != frame)
+	{
+		texture.last_request_frame = frame;
+		texture.requested_mip = mip;
+		texture.priority = priority;
+	}
+	else
+	{
+		texture.requested_mip = std::min(texture.requested_mip, mip);
+		texture.priority = std::max(texture.priority, priority);
+	}
+}
+
+std::vector<texture_residency::change> texture_residency::update()
+{
+	struct step
+	{
+		size_t id;
+		uint32_t level;
+		uint32_t wanted;
+		float priority;
+		size_t cost;
+	};
+	auto comes_later = [](const step& a, const step& b)
+	{
+		// Coarser levels are handed out first, then the more important texture, then the cheaper level.
+		if (a.level != b.level)
+		{
+			return a.level < b.level;
+		}
+		if (a.priority != b.priority)
+		{
+			return a.priority < b.priority;
+		}
+		return a.cost > b.cost;
+	};
+	std::priority_queue<step, std::vector<step>, decltype(comes_later)> steps(comes_later);
+
+	size_t used_bytes{ 0 };
+	for (size_t id = 0; id < textures.size(); ++id)
+	{
+		texture& texture{ textures.at(id) };
+		if (!texture.active)
+		{
+			continue;
+		}
+		used_bytes += bytes_from(id, texture.tail_mip);
+		texture.target_mip = texture.tail_mip;
+
+		if (texture.requested_mip != NONE && frame - texture.last_request_frame > eviction_delay_frames)
+		{
+			texture.requested_mip = NONE;
+		}
+		if (texture.requested_mip != NONE && texture.requested_mip < texture.tail_mip)
+		{
+			const uint32_t level{ texture.tail_mip - 1 };
+			steps.push({ id, level, texture.requested_mip, texture.priority, level_bytes(texture, level) });
+		}
+	}
+
+	while (!steps.empty())
+	{
+		const step step{ steps.top() };
+		steps.pop();
+		if (used_bytes + step.cost > budget_bytes)
+		{
+			// Finer levels of this texture cost even more.
+			continue;
+		}
+		used_bytes += step.cost;
+		texture& texture{ textures.at(step.id) };
+		texture.target_mip = step.level;
+		if (step.level > step.wanted)
+		{
+			const uint32_t level{ step.level - 1 };
+			steps.push({ step.id, level, step.wanted, step.priority, level_bytes(texture, level) });
+		}
+	}
+
+	std::vector<change> changes;
+	for (size_t id = 0; id < textures.size(); ++id)
+	{
+		texture& texture{ textures.at(id) };
+		if (!texture.active)
+		{
+			continue;
+		}
+		if (texture.target_mip > texture.resident_mip)
+		{
+			changes.push_back({ id, texture.resident_mip, texture.target_mip });
+			texture.resident_mip = texture.target_mip;
+		}
+		else if (texture.target_mip < texture.resident_mip && texture.pending_mip == NONE)
+		{
+			changes.push_back({ id, texture.resident_mip, texture.target_mip });
+			texture.pending_mip = texture.target_mip;
+		}
+	}
+	++frame;
+	return changes;
+}
+
+void texture_residency::complete(size_t id, uint32_t mip)
+{
+	texture& texture{ textures.at(id) };
+	texture.resident_mip = std::min(mip, texture.tail_mip);
+	texture.pending_mip = NONE;
+}
+
+size_t texture_residency::resident_bytes() const
+{
+	size_t bytes{ 0 };
+	for (size_t id = 0; id < textures.size(); ++id)
+	{
+		const texture& texture{ textures.at(id) };
+		if (texture.active)
+		{
+			bytes += bytes_from(id, std::min(texture.resident_mip, texture.pending_mip));
+		}
+	}
+	return bytes;
+}
+
+size_t texture_residency::bytes_from(size_t id, uint32_t mip) const
+{
+	const texture& texture{ textures.at(id) };
+	size_t bytes{ 0 };
+	for (uint32_t level = mip; level < texture.mip_count; ++level)
+	{
+		bytes += level_bytes(texture, level);
+	}
+	return bytes;
+}
+
+size_t texture_residency::level_bytes(const texture& texture, uint32_t mip) const
+{
+	return compute_level_size(texture.format, std::max(1u, texture.width >> mip), std::max(1u, texture.height >> mip));
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "texture_image.h"
+
+// The CPU side of mip streaming: which mip each texture should have and what fits in the budget.
+// No Direct3D dependency; texture_streamer applies the decisions to the device.
+
+// Diameter in pixels of the bounding sphere of 'bounding_box' (object space) after 'world', seen from 'camera_position'.
+// 'projection_y_scale' is _22 of the projection matrix, i.e. 1 / tan(fovy / 2).
+float compute_screen_diameter(const DirectX::XMFLOAT3 bounding_box[2], const DirectX::XMFLOAT4X4& world, const DirectX::XMFLOAT4& camera_position, float projection_y_scale, float viewport_height);
+
+// The coarsest mip that still gives one texel per pixel when the texture spans the object 'texel_density' times.
+// 0 is the finest level.
+uint32_t compute_desired_mip(uint32_t width, uint32_t height, uint32_t mip_count, float screen_diameter, float texel_density = 1.0f);
+
+class texture_residency
+{
+public:
+	// Levels no larger than 'tail_dimension' are always resident. A texture nobody asks for keeps its mips
+	// for 'eviction_delay_frames' frames before it falls back to the tail.
+	explicit texture_residency(size_t budget_bytes, uint32_t tail_dimension = 128, uint32_t eviction_delay_frames = 60);
+
+	size_t add_texture(uint32_t width, uint32_t height, uint32_t mip_count, texture_format format);
+	void remove_texture(size_t id);
+
+	// Requests 'mip' for this frame. When a texture is requested several times the finest mip and the highest priority win.
+	void request(size_t id, uint32_t mip, float priority);
+
+	struct change
+	{
+		size_t id;
+		uint32_t from_mip;
+		uint32_t to_mip; // larger than from_mip: stream out, smaller: stream in
+	};
+	// Ends the frame: every texture gets its tail, then finer levels are handed out coarsest first (ties go to the higher priority)
+	// until the budget is spent. Stream outs take effect at once; a stream in stays pending until complete() is called.
+	std::vector<change> update();
+	// 'mip' is the level the texture actually got, which may be coarser than what was asked for.
+	void complete(size_t id, uint32_t mip);
+
+	uint32_t tail_mip(size_t id) const { return textures.at(id).tail_mip; }
+	uint32_t resident_mip(size_t id) const { return textures.at(id).resident_mip; }
+	uint32_t target_mip(size_t id) const { return textures.at(id).target_mip; }
+	bool is_streaming_in(size_t id) const { return textures.at(id).pending_mip != NONE; }
+
+	size_t budget() const { return budget_bytes; }
+	void set_budget(size_t bytes) { budget_bytes = bytes; }
+	// Bytes of the resident levels, counting stream ins in flight at their final size.
+	size_t resident_bytes() const;
+	// Bytes of levels [mip, mip_count).
+	size_t bytes_from(size_t id, uint32_t mip) const;
+
+private:
+	static constexpr uint32_t NONE{ ~0u };
+	struct texture
+	{
+		bool active{ false };
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint32_t mip_count{ 0 };
+		texture_format format{ texture_format::unknown };
+		uint32_t tail_mip{ 0 };
+		uint32_t resident_mip{ 0 };
+		uint32_t pending_mip{ NONE };
+		uint32_t target_mip{ 0 };
+		uint32_t requested_mip{ NONE };
+		float priority{ 0 };
+		uint64_t last_request_frame{ 0 };
+	};
+	size_t level_bytes(const texture& texture, uint32_t mip) const;
+
+	std::vector<texture> textures;
+	size_t budget_bytes;
+	uint32_t tail_dimension;
+	uint32_t eviction_delay_frames;
+	uint64_t frame{ 1 };
+};
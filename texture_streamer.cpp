@@ -0,0 +1,233 @@
+#include "texture_streamer.h"
+#include "texture.h"
+#include "texture_mipmap.h"
+#include "thread_pool.h"
+#include "misc.h"
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+
+using namespace Microsoft::WRL;
+
+texture_streamer::texture_streamer(ID3D11Device* device, size_t budget_bytes) : device(device), mip_residency(budget_bytes)
+{
+}
+
+texture_streamer::~texture_streamer()
+{
+	// Loads still running on the thread pool only write to their own futures, but let them finish before the pool is torn down.
+	for (streamed_texture& texture : textures)
+	{
+		if (texture.loading.valid())
+		{
+			texture.loading.wait();
+		}
+	}
+}
+
+bool texture_streamer::add(const std::wstring& filename, texture_role role, const texture_image& image)
+{
+	if (contains(filename))
+	{
+		return true;
+	}
+	if (image.levels.empty())
+	{
+		return false;
+	}
+	const size_t id{ mip_residency.add_texture(image.width, image.height, static_cast<uint32_t>(image.levels.size()), image.format) };
+	const uint32_t tail_mip{ mip_residency.tail_mip(id) };
+	ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+	if (tail_mip == 0 || FAILED(create_texture_from_image(device.Get(), image, shader_resource_view.GetAddressOf(), tail_mip)))
+	{
+		mip_residency.remove_texture(id);
+		return false;
+	}
+
+	if (textures.size() <= id)
+	{
+		textures.resize(id + 1);
+	}
+	streamed_texture& texture{ textures.at(id) };
+	texture.filename = filename;
+	texture.role = role;
+	texture.width = image.width;
+	texture.height = image.height;
+	texture.mip_count = static_cast<uint32_t>(image.levels.size());
+	texture.format = image.format;
+	texture.shader_resource_view = shader_resource_view;
+	ids.insert(std::make_pair(filename, id));
+	return true;
+}
+
+bool texture_streamer::attach(const std::wstring& filename, const void* owner, uint64_t material, uint32_t texture_index, const texture_slot_resolver& resolve)
+{
+	std::map<std::wstring, size_t>::const_iterator it{ ids.find(filename) };
+	if (it == ids.end())
+	{
+		return false;
+	}
+	slot_owner& registered{ owners[owner] };
+	if (!registered.resolve)
+	{
+		registered.resolve = resolve;
+	}
+	streamed_texture& texture{ textures.at(it->second) };
+	ID3D11ShaderResourceView** view{ registered.resolve(material, texture_index) };
+	if (*view)
+	{
+		(*view)->Release();
+	}
+	*view = texture.shader_resource_view.Get();
+	(*view)->AddRef();
+	texture.slots.push_back({ owner, material, texture_index });
+
+	std::vector<size_t>& owned_ids{ registered.ids };
+	if (std::find(owned_ids.begin(), owned_ids.end(), it->second) == owned_ids.end())
+	{
+		owned_ids.push_back(it->second);
+	}
+	return true;
+}
+
+void texture_streamer::remove_owner(const void* owner)
+{
+	std::unordered_map<const void*, slot_owner>::iterator it{ owners.find(owner) };
+	if (it == owners.end())
+	{
+		return;
+	}
+	for (size_t id : it->second.ids)
+	{
+		std::vector<slot>& slots{ textures.at(id).slots };
+		slots.erase(std::remove_if(slots.begin(), slots.end(), [owner](const slot& slot) { return slot.owner == owner; }), slots.end());
+	}
+	owners.erase(it);
+}
+
+void texture_streamer::request(const void* owner, float screen_diameter, float texel_density)
+{
+	std::unordered_map<const void*, slot_owner>::const_iterator it{ owners.find(owner) };
+	if (it == owners.end())
+	{
+		return;
+	}
+	for (size_t id : it->second.ids)
+	{
+		const streamed_texture& texture{ textures.at(id) };
+		mip_residency.request(id, compute_desired_mip(texture.width, texture.height, texture.mip_count, screen_diameter, texel_density), screen_diameter);
+	}
+}
+
+void texture_streamer::update(ID3D11DeviceContext* immediate_context)
+{
+	// Finished stream ins. The texture may have been asked to shrink while its file was loading.
+	for (size_t id = 0; id < textures.size(); ++id)
+	{
+		streamed_texture& texture{ textures.at(id) };
+		if (!texture.loading.valid() || texture.loading.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+		{
+			continue;
+		}
+		const texture_image image{ texture.loading.get() };
+		const uint32_t first_level{ mip_residency.target_mip(id) };
+		uint32_t resident_mip{ mip_residency.resident_mip(id) };
+		if (first_level < resident_mip && image.levels.size() == texture.mip_count && image.format == texture.format)
+		{
+			ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+			if (SUCCEEDED(create_texture_from_image(device.Get(), image, shader_resource_view.GetAddressOf(), first_level)))
+			{
+				replace_view(texture, shader_resource_view);
+				resident_mip = first_level;
+			}
+		}
+		mip_residency.complete(id, resident_mip);
+	}
+
+	for (const texture_residency::change& change : mip_residency.update())
+	{
+		if (change.to_mip > change.from_mip)
+		{
+			stream_out(immediate_context, change.id, change.to_mip);
+			continue;
+		}
+
+		// The source is decoded again rather than kept in system memory. A sibling .dds is preferred as in load_texture_from_file.
+		streamed_texture& texture{ textures.at(change.id) };
+		const std::wstring filename{ texture.filename };
+		const texture_role role{ texture.role };
+		texture.loading = default_thread_pool().submit([filename, role]()
+		{
+			texture_image image;
+			std::filesystem::path dds_filename(filename);
+			dds_filename.replace_extension("dds");
+			const bool decoded{ std::filesystem::exists(dds_filename) ?
+				decode_texture_file(dds_filename.c_str(), image) :
+				decode_texture_file(filename.c_str(), image) };
+			if (decoded && image.levels.size() == 1 && !is_block_compressed(image.format))
+			{
+				generate_mipmaps(image, default_mipmap_options(role));
+			}
+			return image;
+		});
+	}
+}
+
+void texture_streamer::replace_view(streamed_texture& texture, ComPtr<ID3D11ShaderResourceView>& shader_resource_view)
+{
+	texture.shader_resource_view = shader_resource_view;
+	for (const slot& slot : texture.slots)
+	{
+		ID3D11ShaderResourceView** view{ owners.at(slot.owner).resolve(slot.material, slot.texture_index) };
+		if (*view)
+		{
+			(*view)->Release();
+		}
+		*view = shader_resource_view.Get();
+		(*view)->AddRef();
+	}
+}
+
+void texture_streamer::stream_out(ID3D11DeviceContext* immediate_context, size_t id, uint32_t to_mip)
+{
+	HRESULT hr{ S_OK };
+	streamed_texture& texture{ textures.at(id) };
+
+	// The coarser levels are already on the device, so they are copied across instead of being loaded again.
+	ComPtr<ID3D11Resource> resource;
+	texture.shader_resource_view->GetResource(resource.GetAddressOf());
+	ComPtr<ID3D11Texture2D> source;
+	hr = resource.As(&source);
+	_ASSERT_EXPR(SUCCEEDED(hr), hr_trace(hr));
+
+	D3D11_TEXTURE2D_DESC texture2d_desc;
+	source->GetDesc(&texture2d_desc);
+	if (texture2d_desc.MipLevels <= texture.mip_count - to_mip)
+	{
+		return;
+	}
+	// Every version of the texture ends at the same 1x1 level.
+	const UINT skipped_levels{ texture2d_desc.MipLevels - (texture.mip_count - to_mip) };
+	texture2d_desc.Width = std::max<UINT>(1, texture.width >> to_mip);
+	texture2d_desc.Height = std::max<UINT>(1, texture.height >> to_mip);
+	texture2d_desc.MipLevels = texture.mip_count - to_mip;
+
+	ComPtr<ID3D11Texture2D> destination;
+	hr = device->CreateTexture2D(&texture2d_desc, nullptr, destination.GetAddressOf());
+	if (FAILED(hr))
+	{
+		return;
+	}
+	for (UINT level = 0; level < texture2d_desc.MipLevels; ++level)
+	{
+		immediate_context->CopySubresourceRegion(destination.Get(), level, 0, 0, 0, source.Get(), level + skipped_levels, nullptr);
+	}
+
+	ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+	hr = device->CreateShaderResourceView(destination.Get(), nullptr, shader_resource_view.GetAddressOf());
+	if (SUCCEEDED(hr))
+	{
+		replace_view(texture, shader_resource_view);
+	}
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <d3d11.h>
+#include <wrl.h>
+
+#include <cstdint>
+#include <future>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "texture.h"
+#include "texture_image.h"
+#include "texture_residency.h"
+
+// Mip streaming for material textures. A streamed texture starts with only its small levels (the tail) on the device.
+// Each frame the scene reports how large its meshes appear on screen, and update() streams finer levels in from the
+// source file on the thread pool, or drops them again, within the budget of texture_residency.
+// The views in the registered material slots are replaced whenever the texture changes. Slots are held as owner,
+// material and texture index and looked up through the owner's resolver on every write, never as raw addresses.
+class texture_streamer
+{
+public:
+	texture_streamer(ID3D11Device* device, size_t budget_bytes);
+	virtual ~texture_streamer();
+	texture_streamer(const texture_streamer&) = delete;
+	texture_streamer& operator=(const texture_streamer&) = delete;
+	texture_streamer(texture_streamer&&) noexcept = delete;
+	texture_streamer& operator=(texture_streamer&&) noexcept = delete;
+
+	// Takes a decoded image with its complete chain and uploads the tail only. Returns false when the image
+	// is already small enough to live in the tail, in which case the caller should load it as usual.
+	bool add(const std::wstring& filename, texture_role role, const texture_image& image);
+	bool contains(const std::wstring& filename) const { return ids.find(filename) != ids.end(); }
+	// Points the slot of 'material' and 'texture_index' of 'owner' at the current view of 'filename' and keeps it updated
+	// until remove_owner('owner'). The first resolver given for an owner is the one used.
+	bool attach(const std::wstring& filename, const void* owner, uint64_t material, uint32_t texture_index, const texture_slot_resolver& resolve);
+	void remove_owner(const void* owner);
+
+	// Asks for the mips every texture of 'owner' needs at 'screen_diameter' pixels (see compute_screen_diameter).
+	void request(const void* owner, float screen_diameter, float texel_density = 1.0f);
+	// Applies the requests of this frame. Call once per frame on the thread that owns 'immediate_context'.
+	void update(ID3D11DeviceContext* immediate_context);
+
+	const texture_residency& residency() const { return mip_residency; }
+	void set_budget(size_t bytes) { mip_residency.set_budget(bytes); }
+
+private:
+	struct slot
+	{
+		const void* owner;
+		uint64_t material;
+		uint32_t texture_index;
+	};
+	struct streamed_texture
+	{
+		std::wstring filename;
+		texture_role role{ texture_role::albedo };
+		uint32_t width{ 0 };
+		uint32_t height{ 0 };
+		uint32_t mip_count{ 0 };
+		texture_format format{ texture_format::unknown };
+		Microsoft::WRL::ComPtr<ID3D11ShaderResourceView> shader_resource_view;
+		std::vector<slot> slots;
+		std::future<texture_image> loading;
+	};
+	void replace_view(streamed_texture& texture, Microsoft::WRL::ComPtr<ID3D11ShaderResourceView>& shader_resource_view);
+	void stream_out(ID3D11DeviceContext* immediate_context, size_t id, uint32_t to_mip);
+
+	Microsoft::WRL::ComPtr<ID3D11Device> device;
+	texture_residency mip_residency;
+	std::vector<streamed_texture> textures;
+	std::map<std::wstring, size_t> ids;
+	struct slot_owner
+	{
+		texture_slot_resolver resolve;
+		std::vector<size_t> ids;
+	};
+	std::unordered_map<const void*, slot_owner> owners;
+};
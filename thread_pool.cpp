@@ -0,0 +1,144 @@
+#include "thread_pool.h"
+
+#include <atomic>
+#include <algorithm>
+#include <exception>
+
+thread_pool::thread_pool(size_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		const size_t hardware_threads{ std::thread::hardware_concurrency() };
+		thread_count = hardware_threads > 1 ? hardware_threads - 1 : 1;
+	}
+	workers.reserve(thread_count);
+	for (size_t thread_index = 0; thread_index < thread_count; ++thread_index)
+	{
+		workers.emplace_back([this]() { work(); });
+	}
+}
+
+thread_pool::~thread_pool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	condition.notify_all();
+	for (std::thread& worker : workers)
+	{
+		worker.join();
+	}
+}
+
+void thread_pool::enqueue(std::function<void()> task)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		tasks.emplace_back(std::move(task));
+	}
+	condition.notify_one();
+}
+
+void thread_pool::work()
+{
+	for (;;)
+	{
+		std::function<void()> task;
+		{
+			std::unique_lock<std::mutex> lock(mutex);
+			condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+			if (stopping && tasks.empty())
+			{
+				return;
+			}
+			task = std::move(tasks.front());
+			tasks.pop_front();
+		}
+		task();
+	}
+}
+
+void thread_pool::parallel_for(size_t count, const std::function<void(size_t)>& function, size_t grain)
+{
+	if (count == 0)
+	{
+		return;
+	}
+	grain = std::max<size_t>(grain, 1);
+	const size_t chunk_count{ (count + grain - 1) / grain };
+	if (chunk_count == 1 || workers.empty())
+	{
+		for (size_t index = 0; index < count; ++index)
+		{
+			function(index);
+		}
+		return;
+	}
+
+	// Helpers may still be queued after this call returns, so everything they touch lives in a shared block.
+	// They only dereference 'function' after claiming a chunk, and no chunk is left once we have returned.
+	struct shared_state
+	{
+		std::atomic<size_t> next_chunk{ 0 };
+		std::atomic<size_t> finished_chunks{ 0 };
+		std::mutex mutex;
+		std::condition_variable finished;
+		std::exception_ptr exception;
+	};
+	std::shared_ptr<shared_state> state{ std::make_shared<shared_state>() };
+	const std::function<void(size_t)>* body{ &function };
+
+	auto run_chunks = [state, body, count, grain, chunk_count]()
+	{
+		for (;;)
+		{
+			const size_t chunk{ state->next_chunk.fetch_add(1) };
+			if (chunk >= chunk_count)
+			{
+				return;
+			}
+			try
+			{
+				const size_t last{ std::min(count, (chunk + 1) * grain) };
+				for (size_t index = chunk * grain; index < last; ++index)
+				{
+					(*body)(index);
+				}
+			}
+			catch (...)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (!state->exception)
+				{
+					state->exception = std::current_exception();
+				}
+			}
+			if (state->finished_chunks.fetch_add(1) + 1 == chunk_count)
+			{
+				std::lock_guard<std::mutex> lock(state->mutex);
+				state->finished.notify_all();
+			}
+		}
+	};
+
+	const size_t helper_count{ std::min(workers.size(), chunk_count - 1) };
+	for (size_t helper_index = 0; helper_index < helper_count; ++helper_index)
+	{
+		enqueue(run_chunks);
+	}
+	run_chunks();
+
+	std::unique_lock<std::mutex> lock(state->mutex);
+	state->finished.wait(lock, [&state, chunk_count]() { return state->finished_chunks.load() == chunk_count; });
+	if (state->exception)
+	{
+		std::rethrow_exception(state->exception);
+	}
+}
+
+thread_pool& default_thread_pool()
+{
+	static thread_pool pool;
+	return pool;
+}
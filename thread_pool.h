@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+
+// A fixed set of worker threads fed from a single task queue.
+// Nothing in this class depends on Windows or Direct3D so the CPU side of the asset pipeline can run (and be tested) anywhere.
+class thread_pool
+{
+public:
+	explicit thread_pool(size_t thread_count = 0/*0:one less than the number of hardware threads*/);
+	virtual ~thread_pool();
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+	thread_pool(thread_pool&&) noexcept = delete;
+	thread_pool& operator=(thread_pool&&) noexcept = delete;
+
+	size_t thread_count() const { return workers.size(); }
+
+	template<class F>
+	auto submit(F&& task) -> std::future<decltype(task())>
+	{
+		using result_type = decltype(task());
+		std::shared_ptr<std::packaged_task<result_type()>> packaged_task{ std::make_shared<std::packaged_task<result_type()>>(std::forward<F>(task)) };
+		std::future<result_type> future{ packaged_task->get_future() };
+		enqueue([packaged_task]() { (*packaged_task)(); });
+		return future;
+	}
+
+	// Calls 'function(index)' for every index in [0, count) and returns when all of them have finished.
+	// The calling thread works on the range too, so parallel_for may be nested inside a task without deadlocking.
+	// 'grain' is the number of consecutive indices handed out at once.
+	void parallel_for(size_t count, const std::function<void(size_t)>& function, size_t grain = 1);
+
+private:
+	void enqueue(std::function<void()> task);
+	void work();
+
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks;
+	std::mutex mutex;
+	std::condition_variable condition;
+	bool stopping{ false };
+};
+
+// The pool shared by the loaders. It is created on first use.
+thread_pool& default_thread_pool();
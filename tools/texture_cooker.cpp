@@ -0,0 +1,90 @@
+// Offline texture cooker. Compresses source images to BC formats and writes them next to the sources as .dds,
+// which load_texture_from_file picks up in preference to the original.
+//
+// usage: texture_cooker [--quality fast|normal|high] [--role albedo|normal|mask] file...
+// --role applies to the files that follow it, so one command line can cook a whole material.
+
+#include "../texture_compressor.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+namespace
+{
+	const wchar_t* format_name(texture_format format)
+	{
+		switch (format)
+		{
+		case texture_format::bc1_unorm: return L"BC1";
+		case texture_format::bc3_unorm: return L"BC3";
+		case texture_format::bc4_unorm: return L"BC4";
+		case texture_format::bc5_unorm: return L"BC5";
+		case texture_format::bc7_unorm: return L"BC7";
+		default: return L"?";
+		}
+	}
+
+	int cook(const std::vector<std::wstring>& arguments)
+	{
+		compression_quality quality{ compression_quality::normal };
+		texture_role role{ texture_role::albedo };
+		int failures{ 0 };
+		for (size_t i = 0; i < arguments.size(); ++i)
+		{
+			const std::wstring& argument{ arguments.at(i) };
+			if (argument == L"--quality" && i + 1 < arguments.size())
+			{
+				const std::wstring& value{ arguments.at(++i) };
+				quality = value == L"fast" ? compression_quality::fast : value == L"high" ? compression_quality::high : compression_quality::normal;
+			}
+			else if (argument == L"--role" && i + 1 < arguments.size())
+			{
+				const std::wstring& value{ arguments.at(++i) };
+				role = value == L"normal" ? texture_role::normal : value == L"mask" ? texture_role::mask : texture_role::albedo;
+			}
+			else
+			{
+				texture_image source;
+				if (!decode_texture_file(argument.c_str(), source))
+				{
+					fwprintf(stderr, L"%ls: cannot decode\n", argument.c_str());
+					++failures;
+					continue;
+				}
+				const texture_format format{ select_compressed_format(role, has_transparent_texels(source), quality) };
+				compression_statistics statistics;
+				if (!cook_texture(argument.c_str(), source, role, format, quality, &statistics))
+				{
+					fwprintf(stderr, L"%ls: cannot compress (BC formats need a width and height that are multiples of 4)\n", argument.c_str());
+					++failures;
+					continue;
+				}
+				fwprintf(stdout, L"%ls: %ls %ux%u, PSNR %.2f dB, %zu -> %zu bytes, %.3f s\n", argument.c_str(), format_name(format), source.width, source.height,
+					std::isinf(statistics.psnr) ? 99.99 : statistics.psnr, statistics.source_bytes, statistics.compressed_bytes, statistics.seconds);
+			}
+		}
+		return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+	}
+}
+
+#ifdef _WIN32
+int wmain(int argc, wchar_t* argv[])
+{
+	return cook(std::vector<std::wstring>(argv + 1, argv + argc));
+}
+#else
+int main(int argc, char* argv[])
+{
+	std::vector<std::wstring> arguments;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::wstring argument(mbstowcs(nullptr, argv[i], 0), L'\0');
+		mbstowcs(argument.data(), argv[i], argument.size());
+		arguments.emplace_back(std::move(argument));
+	}
+	return cook(arguments);
+}
+#endif
@@ -0,0 +1,703 @@
+#include "triangle_bvh.h"
+#include "thread_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+using namespace DirectX;
+
+namespace
+{
+	constexpr uint32_t BIN_COUNT{ 16 };
+	// Subtrees with more triangles than this are built as a separate task.
+	constexpr uint32_t PARALLEL_BUILD_THRESHOLD{ 8192 };
+	// Below this depth SAH may split as unevenly as it likes; beyond it splits are forced to halve the node,
+	// which keeps the depth (and the traversal stack) bounded.
+	constexpr uint32_t MAX_SAH_DEPTH{ 32 };
+	constexpr size_t TRAVERSAL_STACK_SIZE{ 64 };
+
+	struct bounds
+	{
+		XMVECTOR minimum{ XMVectorReplicate(FLT_MAX) };
+		XMVECTOR maximum{ XMVectorReplicate(-FLT_MAX) };
+
+		void grow(FXMVECTOR point_minimum, FXMVECTOR point_maximum)
+		{
+			minimum = XMVectorMin(minimum, point_minimum);
+			maximum = XMVectorMax(maximum, point_maximum);
+		}
+		float area() const
+		{
+			XMFLOAT3 extent;
+			XMStoreFloat3(&extent, XMVectorMax(XMVectorSubtract(maximum, minimum), XMVectorZero()));
+			return 2.0f * (extent.x * extent.y + extent.y * extent.z + extent.z * extent.x);
+		}
+	};
+
+	struct build_primitive
+	{
+		XMFLOAT3 minimum;
+		XMFLOAT3 maximum;
+		XMFLOAT3 centroid;
+	};
+
+	inline float component(const XMFLOAT3& v, int axis)
+	{
+		return axis == 0 ? v.x : axis == 1 ? v.y : v.z;
+	}
+
+	class builder
+	{
+	public:
+		builder(std::vector<triangle_bvh::node>& nodes, std::vector<build_primitive>& primitives, std::vector<uint32_t>& ids, uint32_t max_leaf_size) :
+			nodes(nodes), primitives(primitives), ids(ids), max_leaf_size(max_leaf_size)
+		{
+		}
+
+		uint32_t build()
+		{
+			node_count = 1;
+			build_node(0, 0, static_cast<uint32_t>(ids.size()), 0);
+			return node_count.load();
+		}
+
+	private:
+		std::vector<triangle_bvh::node>& nodes;
+		std::vector<build_primitive>& primitives;
+		std::vector<uint32_t>& ids;
+		const uint32_t max_leaf_size;
+		std::atomic<uint32_t> node_count{ 0 };
+
+		void build_node(uint32_t node_index, uint32_t first, uint32_t count, uint32_t depth)
+		{
+			bounds node_bounds;
+			bounds centroid_bounds;
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const build_primitive& primitive{ primitives[ids[i]] };
+				node_bounds.grow(XMLoadFloat3(&primitive.minimum), XMLoadFloat3(&primitive.maximum));
+				const XMVECTOR centroid{ XMLoadFloat3(&primitive.centroid) };
+				centroid_bounds.grow(centroid, centroid);
+			}
+			triangle_bvh::node& node{ nodes[node_index] };
+			XMStoreFloat3(&node.minimum, node_bounds.minimum);
+			XMStoreFloat3(&node.maximum, node_bounds.maximum);
+			node.first = first;
+			node.count = count;
+			if (count <= max_leaf_size)
+			{
+				return;
+			}
+
+			XMFLOAT3 centroid_minimum, centroid_maximum;
+			XMStoreFloat3(&centroid_minimum, centroid_bounds.minimum);
+			XMStoreFloat3(&centroid_maximum, centroid_bounds.maximum);
+
+			// Binned SAH: the cost of a split is the area of each side times its triangle count.
+			int best_axis{ -1 };
+			uint32_t best_split{ 0 };
+			float best_cost{ FLT_MAX };
+			if (depth < MAX_SAH_DEPTH)
+			{
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					const float minimum{ component(centroid_minimum, axis) };
+					const float extent{ component(centroid_maximum, axis) - minimum };
+					if (extent <= 0.0f)
+					{
+						continue;
+					}
+					const float scale{ BIN_COUNT / extent };
+					bounds bins[BIN_COUNT];
+					uint32_t bin_counts[BIN_COUNT]{};
+					for (uint32_t i = first; i < first + count; ++i)
+					{
+						const build_primitive& primitive{ primitives[ids[i]] };
+						const uint32_t bin{ std::min<uint32_t>(BIN_COUNT - 1, static_cast<uint32_t>((component(primitive.centroid, axis) - minimum) * scale)) };
+						bins[bin].grow(XMLoadFloat3(&primitive.minimum), XMLoadFloat3(&primitive.maximum));
+						++bin_counts[bin];
+					}
+
+					float left_areas[BIN_COUNT - 1];
+					uint32_t left_counts[BIN_COUNT - 1];
+					bounds left;
+					uint32_t left_count{ 0 };
+					for (uint32_t bin = 0; bin < BIN_COUNT - 1; ++bin)
+					{
+						left.grow(bins[bin].minimum, bins[bin].maximum);
+						left_count += bin_counts[bin];
+						left_areas[bin] = left.area();
+						left_counts[bin] = left_count;
+					}
+					bounds right;
+					uint32_t right_count{ 0 };
+					for (uint32_t bin = BIN_COUNT - 1; bin > 0; --bin)
+					{
+						right.grow(bins[bin].minimum, bins[bin].maximum);
+						right_count += bin_counts[bin];
+						if (left_counts[bin - 1] == 0 || right_count == 0)
+						{
+							continue;
+						}
+						const float cost{ left_areas[bin - 1] * left_counts[bin - 1] + right.area() * right_count };
+						if (cost < best_cost)
+						{
+							best_cost = cost;
+							best_axis = axis;
+							best_split = bin;
+						}
+					}
+				}
+			}
+
+			uint32_t left_count{ 0 };
+			if (best_axis >= 0)
+			{
+				// Traversing the children costs about one triangle test.
+				const float split_cost{ 1.0f + best_cost / std::max<float>(node_bounds.area(), FLT_MIN) };
+				if (split_cost >= static_cast<float>(count) && count <= max_leaf_size * 4)
+				{
+					return;
+				}
+				const float minimum{ component(centroid_minimum, best_axis) };
+				const float scale{ BIN_COUNT / (component(centroid_maximum, best_axis) - minimum) };
+				const int axis{ best_axis };
+				const uint32_t split{ best_split };
+				left_count = static_cast<uint32_t>(std::partition(ids.begin() + first, ids.begin() + first + count, [&](uint32_t id)
+				{
+					return std::min<uint32_t>(BIN_COUNT - 1, static_cast<uint32_t>((component(primitives[id].centroid, axis) - minimum) * scale)) < split;
+				}) - (ids.begin() + first));
+			}
+			if (left_count == 0 || left_count == count)
+			{
+				// No useful SAH split (identical centroids, or too deep): halve along the widest centroid axis.
+				const XMFLOAT3 extent{ centroid_maximum.x - centroid_minimum.x, centroid_maximum.y - centroid_minimum.y, centroid_maximum.z - centroid_minimum.z };
+				const int axis{ extent.x > extent.y && extent.x > extent.z ? 0 : extent.y > extent.z ? 1 : 2 };
+				left_count = count / 2;
+				std::nth_element(ids.begin() + first, ids.begin() + first + left_count, ids.begin() + first + count, [&](uint32_t a, uint32_t b)
+				{
+					return component(primitives[a].centroid, axis) < component(primitives[b].centroid, axis);
+				});
+			}
+
+			const uint32_t left_child{ node_count.fetch_add(2) };
+			node.first = left_child;
+			node.count = 0;
+			if (count > PARALLEL_BUILD_THRESHOLD)
+			{
+				default_thread_pool().parallel_for(2, [&](size_t child)
+				{
+					child == 0 ? build_node(left_child, first, left_count, depth + 1) : build_node(left_child + 1, first + left_count, count - left_count, depth + 1);
+				});
+			}
+			else
+			{
+				build_node(left_child, first, left_count, depth + 1);
+				build_node(left_child + 1, first + left_count, count - left_count, depth + 1);
+			}
+		}
+	};
+
+	// Per-lane entry distances of four rays into a node; lanes that miss get +infinity.
+	inline XMVECTOR XM_CALLCONV intersect_box(const triangle_bvh::node& node, const XMVECTOR origin[3], const XMVECTOR inverse_direction[3], FXMVECTOR best, FXMVECTOR active)
+	{
+		XMVECTOR entry{ XMVectorZero() };
+		XMVECTOR exit{ best };
+		const float minimum[3]{ node.minimum.x, node.minimum.y, node.minimum.z };
+		const float maximum[3]{ node.maximum.x, node.maximum.y, node.maximum.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			const XMVECTOR t0{ XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(minimum[axis]), origin[axis]), inverse_direction[axis]) };
+			const XMVECTOR t1{ XMVectorMultiply(XMVectorSubtract(XMVectorReplicate(maximum[axis]), origin[axis]), inverse_direction[axis]) };
+			entry = XMVectorMax(entry, XMVectorMin(t0, t1));
+			exit = XMVectorMin(exit, XMVectorMax(t0, t1));
+		}
+		const XMVECTOR hit{ XMVectorAndInt(XMVectorLessOrEqual(entry, exit), active) };
+		return XMVectorSelect(XMVectorSplatInfinity(), entry, hit);
+	}
+
+	// Moller-Trumbore, two sided, for the ray in each lane against the triangle p0, p0 + e1, p0 + e2. Returns the mask of
+	// the active lanes that hit it in front of 'best', with the distance and barycentric coordinates of every lane.
+	// The single ray traversal runs its ray in all four lanes, so both traversals round every edge test the same way.
+	inline XMVECTOR XM_CALLCONV intersect_triangle(const XMFLOAT3& p0, const XMFLOAT3& edge1, const XMFLOAT3& edge2, const XMVECTOR origin[3], const XMVECTOR direction[3],
+		FXMVECTOR best, FXMVECTOR active, XMVECTOR& t, XMVECTOR& u, XMVECTOR& v)
+	{
+		const XMVECTOR e1[3]{ XMVectorReplicate(edge1.x), XMVectorReplicate(edge1.y), XMVectorReplicate(edge1.z) };
+		const XMVECTOR e2[3]{ XMVectorReplicate(edge2.x), XMVectorReplicate(edge2.y), XMVectorReplicate(edge2.z) };
+		const XMVECTOR p[3]
+		{
+			XMVectorSubtract(XMVectorMultiply(direction[1], e2[2]), XMVectorMultiply(direction[2], e2[1])),
+			XMVectorSubtract(XMVectorMultiply(direction[2], e2[0]), XMVectorMultiply(direction[0], e2[2])),
+			XMVectorSubtract(XMVectorMultiply(direction[0], e2[1]), XMVectorMultiply(direction[1], e2[0])),
+		};
+		const XMVECTOR determinant{ XMVectorMultiplyAdd(e1[0], p[0], XMVectorMultiplyAdd(e1[1], p[1], XMVectorMultiply(e1[2], p[2]))) };
+		const XMVECTOR inverse_determinant{ XMVectorReciprocal(determinant) };
+		const XMVECTOR s[3]
+		{
+			XMVectorSubtract(origin[0], XMVectorReplicate(p0.x)),
+			XMVectorSubtract(origin[1], XMVectorReplicate(p0.y)),
+			XMVectorSubtract(origin[2], XMVectorReplicate(p0.z)),
+		};
+		u = XMVectorMultiply(XMVectorMultiplyAdd(s[0], p[0], XMVectorMultiplyAdd(s[1], p[1], XMVectorMultiply(s[2], p[2]))), inverse_determinant);
+		const XMVECTOR q[3]
+		{
+			XMVectorSubtract(XMVectorMultiply(s[1], e1[2]), XMVectorMultiply(s[2], e1[1])),
+			XMVectorSubtract(XMVectorMultiply(s[2], e1[0]), XMVectorMultiply(s[0], e1[2])),
+			XMVectorSubtract(XMVectorMultiply(s[0], e1[1]), XMVectorMultiply(s[1], e1[0])),
+		};
+		v = XMVectorMultiply(XMVectorMultiplyAdd(direction[0], q[0], XMVectorMultiplyAdd(direction[1], q[1], XMVectorMultiply(direction[2], q[2]))), inverse_determinant);
+		t = XMVectorMultiply(XMVectorMultiplyAdd(e2[0], q[0], XMVectorMultiplyAdd(e2[1], q[1], XMVectorMultiply(e2[2], q[2]))), inverse_determinant);
+
+		const XMVECTOR zero{ XMVectorZero() };
+		XMVECTOR mask{ XMVectorAndInt(active, XMVectorGreater(XMVectorAbs(determinant), XMVectorReplicate(1e-12f))) };
+		mask = XMVectorAndInt(mask, XMVectorAndInt(XMVectorGreaterOrEqual(u, zero), XMVectorGreaterOrEqual(v, zero)));
+		mask = XMVectorAndInt(mask, XMVectorLessOrEqual(XMVectorAdd(u, v), XMVectorSplatOne()));
+		return XMVectorAndInt(mask, XMVectorAndInt(XMVectorGreaterOrEqual(t, zero), XMVectorLess(t, best)));
+	}
+
+	// Closest point of the triangle p0, p0 + e1, p0 + e2 to 'point', by the Voronoi regions of its vertices and edges.
+	XMVECTOR closest_point_on_triangle(FXMVECTOR point, const XMFLOAT3& p0, const XMFLOAT3& e1, const XMFLOAT3& e2)
+	{
+		const XMVECTOR a{ XMLoadFloat3(&p0) };
+		const XMVECTOR ab{ XMLoadFloat3(&e1) };
+		const XMVECTOR ac{ XMLoadFloat3(&e2) };
+		const XMVECTOR ap{ XMVectorSubtract(point, a) };
+		const float d1{ XMVectorGetX(XMVector3Dot(ab, ap)) };
+		const float d2{ XMVectorGetX(XMVector3Dot(ac, ap)) };
+		if (d1 <= 0.0f && d2 <= 0.0f)
+		{
+			return a;
+		}
+		const XMVECTOR bp{ XMVectorSubtract(ap, ab) };
+		const float d3{ XMVectorGetX(XMVector3Dot(ab, bp)) };
+		const float d4{ XMVectorGetX(XMVector3Dot(ac, bp)) };
+		if (d3 >= 0.0f && d4 <= d3)
+		{
+			return XMVectorAdd(a, ab);
+		}
+		const float vc{ d1 * d4 - d3 * d2 };
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			return XMVectorAdd(a, XMVectorScale(ab, d1 / (d1 - d3)));
+		}
+		const XMVECTOR cp{ XMVectorSubtract(ap, ac) };
+		const float d5{ XMVectorGetX(XMVector3Dot(ab, cp)) };
+		const float d6{ XMVectorGetX(XMVector3Dot(ac, cp)) };
+		if (d6 >= 0.0f && d5 <= d6)
+		{
+			return XMVectorAdd(a, ac);
+		}
+		const float vb{ d5 * d2 - d1 * d6 };
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			return XMVectorAdd(a, XMVectorScale(ac, d2 / (d2 - d6)));
+		}
+		const float va{ d3 * d6 - d5 * d4 };
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			return XMVectorAdd(XMVectorAdd(a, ab), XMVectorScale(XMVectorSubtract(ac, ab), (d4 - d3) / ((d4 - d3) + (d5 - d6))));
+		}
+		const float denominator{ 1.0f / (va + vb + vc) };
+		return XMVectorAdd(a, XMVectorAdd(XMVectorScale(ab, vb * denominator), XMVectorScale(ac, vc * denominator)));
+	}
+
+	inline float horizontal_min(FXMVECTOR v)
+	{
+		XMFLOAT4 lanes;
+		XMStoreFloat4(&lanes, v);
+		return std::min<float>(std::min<float>(lanes.x, lanes.y), std::min<float>(lanes.z, lanes.w));
+	}
+}
+
+void triangle_bvh::build(const void* positions, size_t stride, size_t vertex_count, const uint32_t* indices, size_t index_count, uint32_t max_leaf_size)
+{
+	clear();
+	const uint32_t count{ static_cast<uint32_t>(index_count / 3) };
+	if (count == 0)
+	{
+		return;
+	}
+	auto position = [positions, stride, vertex_count](uint32_t index)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(static_cast<const uint8_t*>(positions) + stride * std::min<size_t>(index, vertex_count - 1)));
+	};
+
+	std::vector<build_primitive> primitives(count);
+	std::vector<triangle> source_triangles(count);
+	default_thread_pool().parallel_for(count, [&](size_t triangle_index)
+	{
+		const XMVECTOR p0{ position(indices[triangle_index * 3 + 0]) };
+		const XMVECTOR p1{ position(indices[triangle_index * 3 + 1]) };
+		const XMVECTOR p2{ position(indices[triangle_index * 3 + 2]) };
+		build_primitive& primitive{ primitives.at(triangle_index) };
+		XMStoreFloat3(&primitive.minimum, XMVectorMin(p0, XMVectorMin(p1, p2)));
+		XMStoreFloat3(&primitive.maximum, XMVectorMax(p0, XMVectorMax(p1, p2)));
+		XMStoreFloat3(&primitive.centroid, XMVectorScale(XMVectorAdd(p0, XMVectorAdd(p1, p2)), 1.0f / 3.0f));
+		triangle& triangle{ source_triangles.at(triangle_index) };
+		XMStoreFloat3(&triangle.p0, p0);
+		XMStoreFloat3(&triangle.e1, XMVectorSubtract(p1, p0));
+		XMStoreFloat3(&triangle.e2, XMVectorSubtract(p2, p0));
+	}, 1024);
+
+	triangle_ids.resize(count);
+	for (uint32_t triangle_index = 0; triangle_index < count; ++triangle_index)
+	{
+		triangle_ids.at(triangle_index) = triangle_index;
+	}
+	nodes.resize(static_cast<size_t>(count) * 2 - 1);
+	builder builder(nodes, primitives, triangle_ids, std::max<uint32_t>(max_leaf_size, 1));
+	nodes.resize(builder.build());
+
+	triangles.resize(count);
+	triangle_indices.resize(static_cast<size_t>(count) * 3);
+	for (uint32_t triangle_index = 0; triangle_index < count; ++triangle_index)
+	{
+		const uint32_t id{ triangle_ids.at(triangle_index) };
+		triangles.at(triangle_index) = source_triangles.at(id);
+		for (size_t corner = 0; corner < 3; ++corner)
+		{
+			triangle_indices.at(triangle_index * 3 + corner) = std::min<uint32_t>(indices[id * 3 + corner], static_cast<uint32_t>(vertex_count - 1));
+		}
+	}
+}
+
+void triangle_bvh::refit(const void* positions, size_t stride, size_t vertex_count)
+{
+	if (nodes.empty() || vertex_count == 0)
+	{
+		return;
+	}
+	auto position = [positions, stride, vertex_count](uint32_t index)
+	{
+		return XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(static_cast<const uint8_t*>(positions) + stride * std::min<size_t>(index, vertex_count - 1)));
+	};
+	for (size_t triangle_index = 0; triangle_index < triangles.size(); ++triangle_index)
+	{
+		const uint32_t* corners{ triangle_indices.data() + triangle_index * 3 };
+		const XMVECTOR p0{ position(corners[0]) };
+		triangle& triangle{ triangles[triangle_index] };
+		XMStoreFloat3(&triangle.p0, p0);
+		XMStoreFloat3(&triangle.e1, XMVectorSubtract(position(corners[1]), p0));
+		XMStoreFloat3(&triangle.e2, XMVectorSubtract(position(corners[2]), p0));
+	}
+
+	// Children are always allocated after their parent, so walking the array backwards visits children first.
+	for (size_t node_index = nodes.size(); node_index-- > 0;)
+	{
+		node& node{ nodes[node_index] };
+		bounds node_bounds;
+		if (node.count > 0)
+		{
+			for (uint32_t triangle_index = node.first; triangle_index < node.first + node.count; ++triangle_index)
+			{
+				const triangle& triangle{ triangles[triangle_index] };
+				const XMVECTOR p0{ XMLoadFloat3(&triangle.p0) };
+				const XMVECTOR p1{ XMVectorAdd(p0, XMLoadFloat3(&triangle.e1)) };
+				const XMVECTOR p2{ XMVectorAdd(p0, XMLoadFloat3(&triangle.e2)) };
+				node_bounds.grow(XMVectorMin(p0, XMVectorMin(p1, p2)), XMVectorMax(p0, XMVectorMax(p1, p2)));
+			}
+		}
+		else
+		{
+			for (uint32_t child = node.first; child < node.first + 2; ++child)
+			{
+				node_bounds.grow(XMLoadFloat3(&nodes[child].minimum), XMLoadFloat3(&nodes[child].maximum));
+			}
+		}
+		XMStoreFloat3(&node.minimum, node_bounds.minimum);
+		XMStoreFloat3(&node.maximum, node_bounds.maximum);
+	}
+}
+
+void triangle_bvh::clear()
+{
+	nodes.clear();
+	triangles.clear();
+	triangle_ids.clear();
+	triangle_indices.clear();
+}
+
+template<bool any_hit>
+bool triangle_bvh::trace(const ray& ray, hit& hit) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+	// The ray is splatted across the lanes and tested with the packet routines, so it gets exactly the answer it would get in a packet.
+	const XMVECTOR origin[3]{ XMVectorReplicate(ray.origin.x), XMVectorReplicate(ray.origin.y), XMVectorReplicate(ray.origin.z) };
+	const XMVECTOR direction[3]{ XMVectorReplicate(ray.direction.x), XMVectorReplicate(ray.direction.y), XMVectorReplicate(ray.direction.z) };
+	const XMVECTOR inverse_direction[3]{ XMVectorReciprocal(direction[0]), XMVectorReciprocal(direction[1]), XMVectorReciprocal(direction[2]) };
+	const XMVECTOR active{ XMVectorTrueInt() };
+	XMVECTOR best{ XMVectorReplicate(ray.max_distance) };
+	bool found{ false };
+
+	if (!(XMVectorGetX(intersect_box(nodes[0], origin, inverse_direction, best, active)) < FLT_MAX))
+	{
+		return false;
+	}
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	size_t stack_size{ 0 };
+	uint32_t node_index{ 0 };
+	for (;;)
+	{
+		const node& node{ nodes[node_index] };
+		if (node.count > 0)
+		{
+			for (uint32_t triangle_index = node.first; triangle_index < node.first + node.count; ++triangle_index)
+			{
+				const triangle& triangle{ triangles[triangle_index] };
+				XMVECTOR t, u, v;
+				if (XMVectorGetIntX(intersect_triangle(triangle.p0, triangle.e1, triangle.e2, origin, direction, best, active, t, u, v)) == 0)
+				{
+					continue;
+				}
+				best = t;
+				found = true;
+				hit.distance = XMVectorGetX(t);
+				hit.triangle = triangle_ids[triangle_index];
+				hit.u = XMVectorGetX(u);
+				hit.v = XMVectorGetX(v);
+				if (any_hit)
+				{
+					return true;
+				}
+			}
+		}
+		else
+		{
+			const float left{ XMVectorGetX(intersect_box(nodes[node.first], origin, inverse_direction, best, active)) };
+			const float right{ XMVectorGetX(intersect_box(nodes[node.first + 1], origin, inverse_direction, best, active)) };
+			const bool left_hit{ left < FLT_MAX };
+			const bool right_hit{ right < FLT_MAX };
+			if (left_hit && right_hit)
+			{
+				// Nearer child first; the other waits on the stack.
+				const bool left_first{ left <= right };
+				stack[stack_size++] = left_first ? node.first + 1 : node.first;
+				node_index = left_first ? node.first : node.first + 1;
+				continue;
+			}
+			if (left_hit || right_hit)
+			{
+				node_index = left_hit ? node.first : node.first + 1;
+				continue;
+			}
+		}
+		if (stack_size == 0)
+		{
+			break;
+		}
+		node_index = stack[--stack_size];
+	}
+	return found;
+}
+
+template<bool any_hit>
+void triangle_bvh::trace_packet(const ray* rays, hit* hits, size_t count) const
+{
+	// Lane i carries rays[i]; unused lanes repeat ray 0 and stay inactive.
+	XMFLOAT4 origin_lanes[3], direction_lanes[3];
+	float best_lanes[4];
+	uint32_t active_lanes[4];
+	for (size_t lane = 0; lane < 4; ++lane)
+	{
+		const ray& ray{ rays[lane < count ? lane : 0] };
+		(&origin_lanes[0].x)[lane] = ray.origin.x;
+		(&origin_lanes[1].x)[lane] = ray.origin.y;
+		(&origin_lanes[2].x)[lane] = ray.origin.z;
+		(&direction_lanes[0].x)[lane] = ray.direction.x;
+		(&direction_lanes[1].x)[lane] = ray.direction.y;
+		(&direction_lanes[2].x)[lane] = ray.direction.z;
+		best_lanes[lane] = ray.max_distance;
+		active_lanes[lane] = lane < count ? ~0u : 0u;
+		if (lane < count)
+		{
+			hits[lane] = {};
+		}
+	}
+	XMVECTOR origin[3], direction[3], inverse_direction[3];
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		origin[axis] = XMLoadFloat4(&origin_lanes[axis]);
+		direction[axis] = XMLoadFloat4(&direction_lanes[axis]);
+		inverse_direction[axis] = XMVectorReciprocal(direction[axis]);
+	}
+	XMVECTOR best{ XMVectorSet(best_lanes[0], best_lanes[1], best_lanes[2], best_lanes[3]) };
+	XMVECTOR active{ XMLoadInt4(active_lanes) };
+	if (nodes.empty())
+	{
+		return;
+	}
+
+	const XMVECTOR infinity{ XMVectorSplatInfinity() };
+	auto any_lane = [](FXMVECTOR mask) { return !XMVector4EqualInt(mask, XMVectorZero()); };
+	if (!any_lane(XMVectorLess(intersect_box(nodes[0], origin, inverse_direction, best, active), infinity)))
+	{
+		return;
+	}
+
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	size_t stack_size{ 0 };
+	uint32_t node_index{ 0 };
+	for (;;)
+	{
+		const node& node{ nodes[node_index] };
+		if (node.count > 0)
+		{
+			for (uint32_t triangle_index = node.first; triangle_index < node.first + node.count; ++triangle_index)
+			{
+				const triangle& triangle{ triangles[triangle_index] };
+				XMVECTOR t, u, v;
+				const XMVECTOR mask{ intersect_triangle(triangle.p0, triangle.e1, triangle.e2, origin, direction, best, active, t, u, v) };
+				if (!any_lane(mask))
+				{
+					continue;
+				}
+				best = XMVectorSelect(best, t, mask);
+
+				uint32_t hit_lanes[4];
+				XMFLOAT4 t_lanes, u_lanes, v_lanes;
+				XMStoreInt4(hit_lanes, mask);
+				XMStoreFloat4(&t_lanes, t);
+				XMStoreFloat4(&u_lanes, u);
+				XMStoreFloat4(&v_lanes, v);
+				for (size_t lane = 0; lane < count && lane < 4; ++lane)
+				{
+					if (hit_lanes[lane])
+					{
+						hits[lane].distance = (&t_lanes.x)[lane];
+						hits[lane].triangle = triangle_ids[triangle_index];
+						hits[lane].u = (&u_lanes.x)[lane];
+						hits[lane].v = (&v_lanes.x)[lane];
+					}
+				}
+				if (any_hit)
+				{
+					// A lane that hit anything is done.
+					active = XMVectorAndCInt(active, mask);
+					if (!any_lane(active))
+					{
+						return;
+					}
+				}
+			}
+		}
+		else
+		{
+			const XMVECTOR left{ intersect_box(nodes[node.first], origin, inverse_direction, best, active) };
+			const XMVECTOR right{ intersect_box(nodes[node.first + 1], origin, inverse_direction, best, active) };
+			const float left_entry{ horizontal_min(left) };
+			const float right_entry{ horizontal_min(right) };
+			const bool left_hit{ left_entry < FLT_MAX };
+			const bool right_hit{ right_entry < FLT_MAX };
+			if (left_hit && right_hit)
+			{
+				const bool left_first{ left_entry <= right_entry };
+				stack[stack_size++] = left_first ? node.first + 1 : node.first;
+				node_index = left_first ? node.first : node.first + 1;
+				continue;
+			}
+			if (left_hit || right_hit)
+			{
+				node_index = left_hit ? node.first : node.first + 1;
+				continue;
+			}
+		}
+		if (stack_size == 0)
+		{
+			break;
+		}
+		node_index = stack[--stack_size];
+	}
+}
+
+bool triangle_bvh::intersect(const ray& ray, hit& hit) const
+{
+	hit = {};
+	return trace<false>(ray, hit);
+}
+
+bool triangle_bvh::occluded(const ray& ray) const
+{
+	hit hit;
+	return trace<true>(ray, hit);
+}
+
+bool triangle_bvh::overlaps(const XMFLOAT3& center, float radius, std::vector<uint32_t>* triangles_found) const
+{
+	if (nodes.empty())
+	{
+		return false;
+	}
+	const XMVECTOR c{ XMLoadFloat3(&center) };
+	const float radius_squared{ radius * radius };
+	auto box_overlaps = [&](const node& node)
+	{
+		const XMVECTOR closest{ XMVectorClamp(c, XMLoadFloat3(&node.minimum), XMLoadFloat3(&node.maximum)) };
+		return XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(closest, c))) <= radius_squared;
+	};
+
+	bool found{ false };
+	uint32_t stack[TRAVERSAL_STACK_SIZE];
+	size_t stack_size{ 0 };
+	if (box_overlaps(nodes[0]))
+	{
+		stack[stack_size++] = 0;
+	}
+	while (stack_size > 0)
+	{
+		const node& node{ nodes[stack[--stack_size]] };
+		if (node.count == 0)
+		{
+			for (uint32_t child = node.first; child < node.first + 2; ++child)
+			{
+				if (box_overlaps(nodes[child]))
+				{
+					stack[stack_size++] = child;
+				}
+			}
+			continue;
+		}
+		for (uint32_t triangle_index = node.first; triangle_index < node.first + node.count; ++triangle_index)
+		{
+			const triangle& triangle{ triangles[triangle_index] };
+			if (XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(closest_point_on_triangle(c, triangle.p0, triangle.e1, triangle.e2), c))) > radius_squared)
+			{
+				continue;
+			}
+			found = true;
+			if (!triangles_found)
+			{
+				return true;
+			}
+			triangles_found->push_back(triangle_ids[triangle_index]);
+		}
+	}
+	return found;
+}
+
+void triangle_bvh::intersect(const ray* rays, hit* hits, size_t count) const
+{
+	default_thread_pool().parallel_for((count + 3) / 4, [&](size_t packet)
+	{
+		const size_t first{ packet * 4 };
+		trace_packet<false>(rays + first, hits + first, std::min<size_t>(4, count - first));
+	}, 64);
+}
+
+void triangle_bvh::occluded(const ray* rays, uint8_t* results, size_t count) const
+{
+	default_thread_pool().parallel_for((count + 3) / 4, [&](size_t packet)
+	{
+		const size_t first{ packet * 4 };
+		const size_t lanes{ std::min<size_t>(4, count - first) };
+		hit hits[4];
+		trace_packet<true>(rays + first, hits, lanes);
+		for (size_t lane = 0; lane < lanes; ++lane)
+		{
+			results[first + lane] = hits[lane].is_hit() ? 1 : 0;
+		}
+	}, 64);
+}
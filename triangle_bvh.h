@@ -0,0 +1,85 @@
+#pragma once
+
+#include <directxmath.h>
+
+#include <cfloat>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// A bounding volume hierarchy over the triangles of a mesh, for raycasts (picking, line of sight).
+// Built with binned SAH splits; the two halves of a large node are built in parallel on default_thread_pool().
+// Traversal tests boxes and triangles with DirectXMath vectors, one ray at a time or four rays (one per lane) at a time.
+// No Direct3D dependency.
+class triangle_bvh
+{
+public:
+	static constexpr uint32_t NONE{ ~0u };
+
+	struct node
+	{
+		DirectX::XMFLOAT3 minimum;
+		uint32_t first; // interior: index of the left child, the right child follows it. leaf: first triangle
+		DirectX::XMFLOAT3 maximum;
+		uint32_t count; // number of triangles; 0 for an interior node
+	};
+	static_assert(sizeof(node) == 32, "A node must stay 32 bytes.");
+
+	struct ray
+	{
+		DirectX::XMFLOAT3 origin{ 0, 0, 0 };
+		DirectX::XMFLOAT3 direction{ 0, 0, 1 }; // need not be normalized; distances are in units of its length
+		float max_distance{ FLT_MAX };
+	};
+	struct hit
+	{
+		float distance{ FLT_MAX };
+		uint32_t triangle{ NONE }; // index of the triangle in the index array given to build, i.e. index / 3
+		float u{ 0 }, v{ 0 }; // barycentric coordinates of the hit point: (1 - u - v) * p0 + u * p1 + v * p2
+		bool is_hit() const { return triangle != NONE; }
+	};
+
+	// 'positions' points at the first position and 'stride' is the distance in bytes between two vertices,
+	// so a vertex array of any layout can be used directly.
+	void build(const void* positions, size_t stride, size_t vertex_count, const uint32_t* indices, size_t index_count, uint32_t max_leaf_size = 4);
+	void clear();
+	// Moves the triangles to new vertex positions (same layout and indices as given to build) and recomputes the boxes
+	// bottom-up without changing the tree. Much cheaper than build, but the tree fits worse the further the mesh deforms
+	// from the shape it was built for.
+	void refit(const void* positions, size_t stride, size_t vertex_count);
+
+	// Nearest hit; returns false if there is none.
+	bool intersect(const ray& ray, hit& hit) const;
+	// True if anything is hit within 'max_distance'. Stops at the first hit.
+	bool occluded(const ray& ray) const;
+
+	// True if any triangle comes within 'radius' of 'center'. Every such triangle is appended to 'triangles' when it is
+	// given (as build index / 3), otherwise the query stops at the first one.
+	bool overlaps(const DirectX::XMFLOAT3& center, float radius, std::vector<uint32_t>* triangles = nullptr) const;
+
+	// Batched queries. Rays are traced four at a time and the groups are spread over the thread pool.
+	void intersect(const ray* rays, hit* hits, size_t count) const;
+	void occluded(const ray* rays, uint8_t* results, size_t count) const;
+
+	size_t node_count() const { return nodes.size(); }
+	size_t triangle_count() const { return triangles.size(); }
+	const node& root() const { return nodes.at(0); }
+
+private:
+	// Triangles are stored in leaf order as one vertex and two edges, ready for the Moller-Trumbore test.
+	struct triangle
+	{
+		DirectX::XMFLOAT3 p0;
+		DirectX::XMFLOAT3 e1;
+		DirectX::XMFLOAT3 e2;
+	};
+	std::vector<node> nodes;
+	std::vector<triangle> triangles;
+	std::vector<uint32_t> triangle_ids;
+	std::vector<uint32_t> triangle_indices; // three vertex indices per triangle in leaf order, for refit
+
+	template<bool any_hit>
+	bool trace(const ray& ray, hit& hit) const;
+	template<bool any_hit>
+	void trace_packet(const ray* rays, hit* hits, size_t count) const;
+};